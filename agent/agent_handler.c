@@ -27,6 +27,22 @@
 
 #include <net-snmp/agent/bulk_to_next.h>
 
+#if defined(NETSNMP_REENTRANT) && defined(HAVE_PTHREAD_H)
+#include <pthread.h>
+/*
+ * only taken to allocate a registration's timing on its first call
+ */
+static pthread_mutex_t _timing_lock = PTHREAD_MUTEX_INITIALIZER;
+#define NETSNMP_HANDLER_TIMING_THREADS 1
+#ifdef __GNUC__
+#define TIMING_ADD(var, n)  __sync_fetch_and_add(&(var), (n))
+#endif
+#endif
+
+#ifndef TIMING_ADD
+#define TIMING_ADD(var, n)  ((var) += (n))
+#endif
+
 netsnmp_feature_child_of(agent_handler, libnetsnmpagent);
 
 netsnmp_feature_child_of(handler_mark_requests_as_delegated, agent_handler);
@@ -566,6 +582,134 @@ netsnmp_call_handler(netsnmp_mib_handler *next_handler,
     return ret;
 }
 
+/*
+ * Maps a time to its histogram bucket; see netsnmp_handler_timing.
+ */
+static int
+_timing_bucket(u_long usec)
+{
+    u_long          v = usec;
+    int             msb = 0, shift;
+
+    if (v > 0xffffffffUL)
+        v = 0xffffffffUL;
+    if (v < NETSNMP_HANDLER_TIMING_SUB)
+        return (int) v;
+    while (v >> (msb + 1))
+        msb++;
+    shift = msb - 3;
+    return NETSNMP_HANDLER_TIMING_SUB + shift * NETSNMP_HANDLER_TIMING_SUB +
+        (int) ((v >> shift) & (NETSNMP_HANDLER_TIMING_SUB - 1));
+}
+
+/*
+ * The largest time that falls into a histogram bucket.
+ */
+static u_long
+_timing_bucket_limit(int i)
+{
+    int             shift;
+
+    if (i < NETSNMP_HANDLER_TIMING_SUB)
+        return i;
+    shift = (i - NETSNMP_HANDLER_TIMING_SUB) / NETSNMP_HANDLER_TIMING_SUB;
+    return ((u_long) (NETSNMP_HANDLER_TIMING_SUB +
+                      i % NETSNMP_HANDLER_TIMING_SUB + 1) << shift) - 1;
+}
+
+static void
+_timing_add(netsnmp_handler_registration *reginfo, u_long usec)
+{
+    netsnmp_handler_timing *timing = reginfo->timing;
+
+    if (NULL == timing) {
+#ifdef NETSNMP_HANDLER_TIMING_THREADS
+        pthread_mutex_lock(&_timing_lock);
+        if (NULL == reginfo->timing)
+            reginfo->timing = SNMP_MALLOC_TYPEDEF(netsnmp_handler_timing);
+        pthread_mutex_unlock(&_timing_lock);
+#else
+        reginfo->timing = SNMP_MALLOC_TYPEDEF(netsnmp_handler_timing);
+#endif
+        timing = reginfo->timing;
+        if (NULL == timing)
+            return;
+    }
+
+    TIMING_ADD(timing->calls, 1);
+    TIMING_ADD(timing->total_usec, usec);
+    if (usec > timing->max_usec)
+        timing->max_usec = usec;
+    TIMING_ADD(timing->buckets[_timing_bucket(usec)], 1);
+}
+
+/**
+ *  Estimates a percentile of the times recorded in a handler timing.
+ *
+ *  @param timing the timing of a registration
+ *  @param percent 0 to 100
+ *
+ *  @return the upper bound of the bucket holding the percentile, in
+ *  microseconds, but no more than the longest time seen; 0 if nothing
+ *  has been recorded.
+ */
+u_long
+netsnmp_handler_timing_percentile(const netsnmp_handler_timing *timing,
+                                  int percent)
+{
+    u_long          rank, seen = 0, limit;
+    int             i;
+
+    if (NULL == timing || 0 == timing->calls)
+        return 0;
+    if (percent < 0)
+        percent = 0;
+    if (percent > 100)
+        percent = 100;
+
+    /*
+     * ceil(calls * percent / 100), without overflowing calls * percent
+     */
+    rank = timing->calls / 100 * percent +
+        (timing->calls % 100 * percent + 99) / 100;
+    if (0 == rank)
+        rank = 1;
+
+    for (i = 0; i < NETSNMP_HANDLER_TIMING_BUCKETS; i++) {
+        seen += timing->buckets[i];
+        if (seen >= rank) {
+            limit = _timing_bucket_limit(i);
+            return limit < timing->max_usec ? limit : timing->max_usec;
+        }
+    }
+    return timing->max_usec;
+}
+
+/*
+ * netsnmp_call_handler() with its time accounted to the registration
+ * and/or the statistics segment.
+ */
+static int
+_call_handler_timed(netsnmp_handler_registration *reginfo,
+                    netsnmp_agent_request_info *reqinfo,
+                    netsnmp_request_info *requests, int timing)
+{
+    struct timeval  start, now, diff;
+    u_long          usec;
+    int             status;
+
+    netsnmp_get_monotonic_clock(&start);
+    status = netsnmp_call_handler(reginfo->handler, reginfo, reqinfo, requests);
+    netsnmp_get_monotonic_clock(&now);
+    NETSNMP_TIMERSUB(&now, &start, &diff);
+    usec = diff.tv_sec * 1000000 + diff.tv_usec;
+
+    if (timing)
+        _timing_add(reginfo, usec);
+    netsnmp_stats_segment_handler(reginfo->handlerName, usec);
+    return status;
+}
+
 /** @private
  *  Calls all the MIB Handlers in registration struct for a given mode.
  *
@@ -577,7 +721,7 @@ netsnmp_call_handlers(netsnmp_handler_registration *reginfo,
                       netsnmp_request_info *requests)
 {
     netsnmp_request_info *request;
-    int             status;
+    int             status, timing;
 
     if (reginfo == NULL || reqinfo == NULL || requests == NULL) {
         snmp_log(LOG_ERR, "netsnmp_call_handlers() called illegally\n");
@@ -628,7 +772,13 @@ netsnmp_call_handlers(netsnmp_handler_registration *reginfo,
         request->processed = 0;
     }
 
-    status = netsnmp_call_handler(reginfo->handler, reginfo, reqinfo, requests);
+    timing = netsnmp_ds_get_boolean(NETSNMP_DS_APPLICATION_ID,
+                                    NETSNMP_DS_AGENT_HANDLER_TIMING);
+    if (timing || netsnmp_stats_segment_get())
+        status = _call_handler_timed(reginfo, reqinfo, requests, timing);
+    else
+        status = netsnmp_call_handler(reginfo->handler, reginfo, reqinfo,
+                                      requests);
 
     return status;
 }
@@ -787,6 +937,7 @@ netsnmp_handler_registration_free(netsnmp_handler_registration *reginfo)
         SNMP_FREE(reginfo->contextName);
         SNMP_FREE(reginfo->rootoid);
         reginfo->rootoid_len = 0;
+        SNMP_FREE(reginfo->timing);
         SNMP_FREE(reginfo);
     }
 }
@@ -283,6 +283,15 @@ init_agent_read_config(const char *app)
     netsnmp_ds_register_config(ASN_INTEGER, app, "avgBulkVarbindSize",
                                NETSNMP_DS_APPLICATION_ID,
                                NETSNMP_DS_AGENT_AVG_BULKVARBINDSIZE);
+    netsnmp_ds_register_config(ASN_INTEGER, app, "agentWorkerThreads",
+                               NETSNMP_DS_APPLICATION_ID,
+                               NETSNMP_DS_AGENT_WORKER_THREADS);
+    netsnmp_ds_register_config(ASN_OCTET_STR, app, "statsSegment",
+                               NETSNMP_DS_APPLICATION_ID,
+                               NETSNMP_DS_AGENT_STATS_SEGMENT);
+    netsnmp_ds_register_config(ASN_BOOLEAN, app, "handlerTiming",
+                               NETSNMP_DS_APPLICATION_ID,
+                               NETSNMP_DS_AGENT_HANDLER_TIMING);
 #ifndef NETSNMP_NO_PDU_STATS
     netsnmp_ds_register_config(ASN_INTEGER, app, "pduStatsMax",
                                NETSNMP_DS_APPLICATION_ID,
@@ -95,16 +95,49 @@ typedef struct lookup_cache_s {
    netsnmp_subtree *previous;
 } lookup_cache;
 
+/*
+ * One node of the per-context subtree index.  The index is a trie keyed
+ * on the sub-identifiers of the start OID of every subtree in the
+ * context's (top-level) subtree list.  Children are kept sorted by subid
+ * so that the predecessor of an arbitrary OID can be found by a binary
+ * search at each level.
+ */
+typedef struct subtree_index_node_s {
+   oid subid;
+   netsnmp_subtree *subtree;    /* list entry starting here, if any */
+   size_t children_len;
+   size_t children_max;
+   struct subtree_index_node_s **children;
+} subtree_index_node;
+
 typedef struct lookup_cache_context_s {
    char *context;
    struct lookup_cache_context_s *next;
    int thecachecount;
    int currentpos;
    lookup_cache cache[SUBTREE_MAX_CACHE_SIZE];
+   subtree_index_node *index;
+   u_int index_generation;
 } lookup_cache_context;
 
 static lookup_cache_context *thecontextcache = NULL;
 
+/*
+ * Bumped each time the linkage of any subtree list changes; an index
+ * built for an older generation is stale and gets rebuilt on demand.
+ */
+static u_int subtree_generation = 1;
+/*
+ * Non-zero while netsnmp_subtree_load() is splicing the list.  Its
+ * linkage changes then leave the generation alone: the load itself adds
+ * each subtree it puts at the head of a list position to the index, so
+ * the index stays current and loading n subtrees one after the other
+ * costs O(n log n) rather than a rebuild per load.
+ */
+static int   subtree_index_hold = 0;
+
+static void subtree_index_free(subtree_index_node *node);
+
 /** Set the lookup cache size for optimized agent registration performance.
  * Note that it is only used by master agent - sub-agent doesn't need the cache.
  * The rough guide is that the cache size should be equal to the maximum
@@ -271,6 +304,7 @@ clear_lookup_cache(void) {
     ptr = thecontextcache;
     while (ptr) {
 	next = ptr->next;
+	subtree_index_free(ptr->index);
 	SNMP_FREE(ptr->context);
 	SNMP_FREE(ptr);
 	ptr = next;
@@ -281,6 +315,197 @@ clear_lookup_cache(void) {
 /**  @} */
 /* End of Lookup cache code */
 
+/** @defgroup agent_subtree_index Subtree index, an OID trie over the registry.
+ *     Locate the subtree covering an OID in time proportional to the
+ *     length of the OID rather than the number of registrations.
+ *   @ingroup agent_registry
+ *
+ * @{
+ */
+
+/** @private
+ *  Frees an index node and everything below it.
+ */
+static void
+subtree_index_free(subtree_index_node *node)
+{
+    size_t i;
+
+    if (node == NULL)
+        return;
+    for (i = 0; i < node->children_len; i++)
+        subtree_index_free(node->children[i]);
+    SNMP_FREE(node->children);
+    SNMP_FREE(node);
+}
+
+/** @private
+ *  Returns the position of the first child whose subid is >= subid.
+ */
+NETSNMP_STATIC_INLINE size_t
+subtree_index_lower_bound(const subtree_index_node *node, oid subid)
+{
+    size_t lo = 0, hi = node->children_len, mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (node->children[mid]->subid < subid)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/** @private
+ *  Adds a subtree to the index under its start OID.  A later entry with
+ *  the same start OID replaces an earlier one, which mirrors the linear
+ *  search that returns the last match.
+ *
+ *  @return 0 on success, -1 on memory allocation failure.
+ */
+static int
+subtree_index_insert(subtree_index_node *root, netsnmp_subtree *subtree)
+{
+    subtree_index_node *node = root, *child, **children;
+    size_t i, pos;
+
+    for (i = 0; i < subtree->start_len; i++) {
+        pos = subtree_index_lower_bound(node, subtree->start_a[i]);
+        if (pos < node->children_len &&
+            node->children[pos]->subid == subtree->start_a[i]) {
+            node = node->children[pos];
+            continue;
+        }
+        if (node->children_len == node->children_max) {
+            size_t newmax = node->children_max ? node->children_max * 2 : 4;
+            children = (subtree_index_node **)
+                realloc(node->children, newmax * sizeof(*children));
+            if (children == NULL)
+                return -1;
+            node->children = children;
+            node->children_max = newmax;
+        }
+        child = SNMP_MALLOC_TYPEDEF(subtree_index_node);
+        if (child == NULL)
+            return -1;
+        child->subid = subtree->start_a[i];
+        memmove(&node->children[pos + 1], &node->children[pos],
+                (node->children_len - pos) * sizeof(*node->children));
+        node->children[pos] = child;
+        node->children_len++;
+        node = child;
+    }
+    node->subtree = subtree;
+    return 0;
+}
+
+/** @private
+ *  (Re)builds the index of a context from its subtree list.
+ *
+ *  @return 0 on success, -1 if the index could not be built.
+ */
+static int
+subtree_index_build(lookup_cache_context *cptr)
+{
+    netsnmp_subtree *s;
+    size_t count = 0;
+
+    subtree_index_free(cptr->index);
+    cptr->index = SNMP_MALLOC_TYPEDEF(subtree_index_node);
+    if (cptr->index == NULL)
+        return -1;
+
+    for (s = netsnmp_subtree_find_first(cptr->context); s; s = s->next) {
+        if (subtree_index_insert(cptr->index, s) < 0) {
+            subtree_index_free(cptr->index);
+            cptr->index = NULL;
+            return -1;
+        }
+        count++;
+    }
+    cptr->index_generation = subtree_generation;
+    DEBUGMSGTL(("subtree:index", "built index for context \"%s\" "
+                "(%lu subtrees)\n", cptr->context, (unsigned long)count));
+    return 0;
+}
+
+/** @private
+ *  Finds the last subtree in the list of a context whose start OID is
+ *  lexicographically less than or equal to name.
+ *
+ *  @param found Set to 1 if the index could be used, 0 if the caller
+ *               must fall back to walking the list.
+ *
+ *  @return the matching subtree, or NULL if name precedes all of them.
+ */
+static netsnmp_subtree *
+subtree_index_find_prev(const char *context_name, const oid *name,
+                        size_t len, int *found)
+{
+    lookup_cache_context *cptr;
+    subtree_index_node *node, *left;
+    netsnmp_subtree *best = NULL;
+    size_t i, pos;
+
+    *found = 0;
+    if ((cptr = get_context_lookup_cache(context_name)) == NULL)
+        return NULL;
+    if ((cptr->index == NULL ||
+         cptr->index_generation != subtree_generation) &&
+        subtree_index_build(cptr) < 0)
+        return NULL;
+    *found = 1;
+
+    /*
+     * Walk down along name.  At each level the entry of the node itself
+     * precedes everything below it, and everything below a smaller
+     * sibling of the next subid follows the node but precedes name; the
+     * deepest such candidate wins.
+     */
+    node = cptr->index;
+    for (i = 0; ; i++) {
+        if (node->subtree)
+            best = node->subtree;
+        if (i == len)
+            break;
+        pos = subtree_index_lower_bound(node, name[i]);
+        if (pos > 0) {
+            for (left = node->children[pos - 1]; left->children_len;
+                 left = left->children[left->children_len - 1])
+                ;
+            best = left->subtree;
+        }
+        if (pos == node->children_len || node->children[pos]->subid != name[i])
+            break;
+        node = node->children[pos];
+    }
+    return best;
+}
+
+/** @private
+ *  Records that subtree is now the list entry at its start OID, after a
+ *  load has split the list or put a new registration in front.  An index
+ *  which is already stale is left to be rebuilt.
+ */
+static void
+subtree_index_note(const char *context_name, netsnmp_subtree *subtree)
+{
+    lookup_cache_context *cptr;
+
+    if (subtree == NULL ||
+        (cptr = get_context_lookup_cache(context_name)) == NULL ||
+        cptr->index == NULL || cptr->index_generation != subtree_generation)
+        return;
+    if (subtree_index_insert(cptr->index, subtree) < 0) {
+        subtree_index_free(cptr->index);
+        cptr->index = NULL;
+    }
+}
+
+/**  @} */
+/* End of Subtree index code */
+
 /** @defgroup agent_context_cache Context cache, storing the OIDs under their contexts.
  *     Maintain the cache used for locating sub-trees registered under different contexts.
  *   @ingroup agent_registry
@@ -358,6 +583,7 @@ add_subtree(netsnmp_subtree *new_tree, const char *context_name)
     ptr->first_subtree = new_tree;
     ptr->context_name = strdup(context_name);
     context_subtrees = ptr;
+    subtree_generation++;
 
     return ptr->first_subtree;
 }
@@ -379,6 +605,7 @@ netsnmp_remove_subtree(netsnmp_subtree *tree)
 
     if (tree->next)
         tree->next->prev = tree->prev;
+    subtree_generation++;
 }
 
 /** Replaces first subtree registered under given context name.
@@ -405,6 +632,7 @@ netsnmp_subtree_replace_first(netsnmp_subtree *new_tree,
         if (ptr->context_name != NULL &&
 	    strcmp(ptr->context_name, context_name) == 0) {
             ptr->first_subtree = new_tree;
+            subtree_generation++;
             return ptr->first_subtree;
         }
     }
@@ -439,6 +667,7 @@ clear_context(void) {
 	ptr = next;
     }
     context_subtrees = NULL; /* !!! */
+    subtree_generation++;
     clear_lookup_cache();
 }
 
@@ -538,6 +767,8 @@ NETSNMP_STATIC_INLINE void
 netsnmp_subtree_change_next(netsnmp_subtree *ptr, netsnmp_subtree *thenext)
 {
     ptr->next = thenext;
+    if (!subtree_index_hold)
+        subtree_generation++;
     if (thenext)
         netsnmp_oid_compare_ll(ptr->start_a,
                                ptr->start_len,
@@ -553,6 +784,8 @@ NETSNMP_STATIC_INLINE void
 netsnmp_subtree_change_prev(netsnmp_subtree *ptr, netsnmp_subtree *theprev)
 {
     ptr->prev = theprev;
+    if (!subtree_index_hold)
+        subtree_generation++;
     if (theprev)
         netsnmp_oid_compare_ll(theprev->start_a,
                                theprev->start_len,
@@ -746,16 +979,11 @@ netsnmp_subtree_split(netsnmp_subtree *current, oid name[], int name_len)
     return new_sub;
 }
 
-/** Loads the subtree under given context name.
- *
- *  @param new_sub The subtree to be loaded into current subtree.
- *
- *  @param context_name Text name of the context we're searching for.
- *
- *  @return gives MIB_REGISTERED_OK on success, error code otherwise.
+/** @private
+ *  Does the work of netsnmp_subtree_load().
  */
-int
-netsnmp_subtree_load(netsnmp_subtree *new_sub, const char *context_name)
+static int
+_subtree_load(netsnmp_subtree *new_sub, const char *context_name)
 {
     netsnmp_subtree *tree1, *tree2;
     netsnmp_subtree *prev, *next;
@@ -811,6 +1039,7 @@ netsnmp_subtree_load(netsnmp_subtree *new_sub, const char *context_name)
 	/*  Link the new subtree (less any overlapping region) with the list of
 	    existing registrations.  */
 
+	subtree_generation++;   /* not tracked in the index */
 	if (tree2) {
             netsnmp_subtree_change_prev(new_sub, tree2->prev);
             netsnmp_subtree_change_prev(tree2, new_sub);
@@ -846,6 +1075,7 @@ netsnmp_subtree_load(netsnmp_subtree *new_sub, const char *context_name)
 			     tree1->start_a,   tree1->start_len) != 0) {
 	    tree1 = netsnmp_subtree_split(tree1, new_sub->start_a, 
 					  new_sub->start_len);
+            subtree_index_note(context_name, tree1);
 	}
 
         if (tree1 == NULL) {
@@ -868,7 +1098,9 @@ netsnmp_subtree_load(netsnmp_subtree *new_sub, const char *context_name)
 
 	case -1:
 	    /*  Existing subtree contains new one.  */
-	    netsnmp_subtree_split(tree1, new_sub->end_a, new_sub->end_len);
+	    subtree_index_note(context_name,
+                               netsnmp_subtree_split(tree1, new_sub->end_a,
+                                                     new_sub->end_len));
 	    /* Fall Through */
 
 	case  0:
@@ -930,6 +1162,7 @@ netsnmp_subtree_load(netsnmp_subtree *new_sub, const char *context_name)
 		for (prev = new_sub->prev; prev != NULL;prev = prev->children){
                     netsnmp_subtree_change_next(prev, new_sub);
 		}
+                subtree_index_note(context_name, new_sub);
 	    }
 	    break;
 
@@ -938,19 +1171,40 @@ netsnmp_subtree_load(netsnmp_subtree *new_sub, const char *context_name)
             {
                 netsnmp_subtree *new2 =
                     netsnmp_subtree_split(new_sub, tree1->end_a,tree1->end_len);
-                int res = netsnmp_subtree_load(new_sub, context_name);
+                int res = _subtree_load(new_sub, context_name);
                 if (res != MIB_REGISTERED_OK) {
                     netsnmp_remove_subtree(new2);
                     netsnmp_subtree_free(new2);
                     return res;
                 }
-                return netsnmp_subtree_load(new2, context_name);
+                return _subtree_load(new2, context_name);
             }
         }
     }
     return 0;
 }
 
+/** Loads the subtree under given context name.
+ *
+ *  @param new_sub The subtree to be loaded into current subtree.
+ *
+ *  @param context_name Text name of the context we're searching for.
+ *
+ *  @return gives MIB_REGISTERED_OK on success, error code otherwise.
+ */
+int
+netsnmp_subtree_load(netsnmp_subtree *new_sub, const char *context_name)
+{
+    int res;
+
+    subtree_index_hold++;
+    res = _subtree_load(new_sub, context_name);
+    subtree_index_hold--;
+    if (res != MIB_REGISTERED_OK)
+        subtree_generation++;   /* may have split the list before failing */
+    return res;
+}
+
 /** Free the given subtree and all its children.
  *
  *  @param sub Subtree branch to be cleared and freed.
@@ -985,6 +1239,12 @@ netsnmp_subtree_find_prev(const oid *name, size_t len, netsnmp_subtree *subtree,
     if (subtree) {
         myptr = subtree;
     } else {
+        int indexed;
+
+        previous = subtree_index_find_prev(context_name, name, len, &indexed);
+        if (indexed)
+            return previous;
+
 	/* look through everything */
         if (lookup_cache_size) {
             lookup_cache = lookup_cache_find(context_name, name, len, &cmp);
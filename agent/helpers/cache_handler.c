@@ -26,6 +26,12 @@
 #include <net-snmp/agent/net-snmp-agent-includes.h>
 
 #include <net-snmp/agent/cache_handler.h>
+#include <net-snmp/agent/stats_segment.h>
+
+#if defined(NETSNMP_REENTRANT) && defined(HAVE_PTHREAD_H)
+#include <pthread.h>
+#define NETSNMP_CACHE_THREADS 1
+#endif
 
 netsnmp_feature_child_of(cache_handler, mib_helpers);
 
@@ -35,6 +41,8 @@ netsnmp_feature_child_of(cache_get_head, cache_handler);
 static netsnmp_cache  *cache_head = NULL;
 static int             cache_outstanding_valid = 0;
 static int             _cache_load( netsnmp_cache *cache );
+static void            _cache_load_background( netsnmp_cache *cache );
+static void            _cache_bg_cancel( netsnmp_cache *cache );
 
 #define CACHE_RELEASE_FREQUENCY 60      /* Check for expired caches every 60s */
 
@@ -98,6 +106,19 @@ void            release_cached_resources(unsigned int regNo,
  *  not be used if cache is not synchronized automatically as it would
  *  result in stale cache information when if polling happens too fast.
  *
+ *  If NETSNMP_CACHE_BACKGROUND_LOAD is set, a request that finds the
+ *  cache expired (but still valid) is answered from the old data, and
+ *  the reload happens off the request path. If the cache also has
+ *  build_cache and swap_cache hooks and the agent was configured with
+ *  --enable-reentrant, build_cache runs in its own thread and swap_cache
+ *  installs the result from the main loop. Otherwise the reload runs
+ *  from an alarm once the current request has been answered, which
+ *  still holds up the main loop for as long as the load takes (the agent
+ *  logs this once when built without --enable-reentrant). A SET does
+ *  not wait for a reload in progress, so this is meant for read-only
+ *  data. The periodic auto-release does not free such a cache when it
+ *  expires, as the next request would then have to load it inline.
+ *
  *
  *  Here are some suggestions for some common situations.
  *
@@ -261,6 +282,8 @@ netsnmp_cache_free(netsnmp_cache *cache)
     if(0 != cache->timer_id)
         netsnmp_cache_timer_stop(cache);
 
+    _cache_bg_cancel(cache);
+
     if (cache->valid)
         _cache_free(cache);
 
@@ -315,7 +338,10 @@ _timer_reload(unsigned int regNo, void *clientargs)
 
     cache->expired = 1;
 
-    _cache_load(cache);
+    if (cache->valid && (cache->flags & NETSNMP_CACHE_BACKGROUND_LOAD))
+        _cache_load_background(cache);
+    else
+        _cache_load(cache);
 }
 
 /** starts the recurring cache_load callback */
@@ -573,9 +599,19 @@ netsnmp_cache_check_and_reload(netsnmp_cache * cache)
         DEBUGMSGT(("helper:cache_handler", " no cache\n"));
         return 0;	/* ?? or -1 */
     }
-    if (!cache->valid || netsnmp_cache_check_expired(cache))
+    if (!cache->valid)
         return _cache_load( cache );
-    else {
+    if (netsnmp_cache_check_expired(cache)) {
+        if (!(cache->flags & NETSNMP_CACHE_BACKGROUND_LOAD))
+            return _cache_load( cache );
+        /*
+         * serve the stale data, and refresh it after this request
+         */
+        DEBUGMSGT(("helper:cache_handler", " stale (%d)\n",
+                   cache->timeout));
+        _cache_load_background(cache);
+        return 0;
+    } else {
         DEBUGMSGT(("helper:cache_handler", " cached (%d)\n",
                    cache->timeout));
         return 0;
@@ -719,9 +755,62 @@ _cache_free( netsnmp_cache *cache )
     }
 }
 
+static u_long
+_cache_elapsed_usec(const struct timeval *start)
+{
+    struct timeval  now, diff;
+
+    netsnmp_get_monotonic_clock(&now);
+    NETSNMP_TIMERSUB(&now, start, &diff);
+    return diff.tv_sec * 1000000 + diff.tv_usec;
+}
+
+/*
+ * account for one run of a load (or build) hook
+ */
+static void
+_cache_load_record(netsnmp_cache *cache, u_long usec, int ok)
+{
+    u_long          limit = 1000;
+    int             i;
+
+    cache->load_count++;
+    if (!ok)
+        cache->load_failures++;
+    cache->load_last_usec = usec;
+    for (i = 0; i < NETSNMP_CACHE_LOAD_BUCKETS - 1 && usec >= limit; i++)
+        limit *= 10;
+    cache->load_hist[i]++;
+    netsnmp_stats_segment_cache_load(usec, ok);
+}
+
+/*
+ * mark the cache as freshly loaded
+ */
+static void
+_cache_loaded( netsnmp_cache *cache )
+{
+    cache->valid = 1;
+    cache->expired = 0;
+    cache->generation++;
+
+    /*
+     * If we didn't previously have any valid caches outstanding,
+     *   then schedule a pass of the auto-release routine.
+     */
+    if ((!cache_outstanding_valid) &&
+        (! (cache->flags & NETSNMP_CACHE_DONT_FREE_EXPIRED))) {
+        snmp_alarm_register(CACHE_RELEASE_FREQUENCY,
+                            0, release_cached_resources, NULL);
+        cache_outstanding_valid = 1;
+    }
+    netsnmp_set_monotonic_marker(&cache->timestampM);
+}
+
 static int
 _cache_load( netsnmp_cache *cache )
 {
+    struct timeval start;
     int ret = -1;
 
     /*
@@ -731,32 +820,217 @@ _cache_load( netsnmp_cache *cache )
         (! (cache->flags & NETSNMP_CACHE_DONT_FREE_BEFORE_LOAD)))
         _cache_free(cache);
 
-    if ( cache->load_cache)
+    if ( cache->load_cache) {
+        netsnmp_get_monotonic_clock(&start);
         ret = cache->load_cache(cache, cache->magic);
+        _cache_load_record(cache, _cache_elapsed_usec(&start), ret >= 0);
+    }
     if (ret < 0) {
         DEBUGMSGT(("helper:cache_handler", " load failed (%d)\n", ret));
         cache->valid = 0;
         return ret;
     }
-    cache->valid = 1;
-    cache->expired = 0;
-
-    /*
-     * If we didn't previously have any valid caches outstanding,
-     *   then schedule a pass of the auto-release routine.
-     */
-    if ((!cache_outstanding_valid) &&
-        (! (cache->flags & NETSNMP_CACHE_DONT_FREE_EXPIRED))) {
-        snmp_alarm_register(CACHE_RELEASE_FREQUENCY,
-                            0, release_cached_resources, NULL);
-        cache_outstanding_valid = 1;
-    }
-    netsnmp_set_monotonic_marker(&cache->timestampM);
+    _cache_loaded(cache);
     DEBUGMSGT(("helper:cache_handler", " loaded (%d)\n", cache->timeout));
 
     return ret;
 }
 
+/*
+ * Reloads running off the request path (NETSNMP_CACHE_BACKGROUND_LOAD).
+ * The cache points at its reload through bg_load until the new data has
+ * been swapped in.
+ */
+typedef struct cache_bg_load_s {
+#ifdef NETSNMP_CACHE_THREADS
+    netsnmp_done_item done;     /* must be first */
+#endif
+    netsnmp_cache  *cache;
+    void           *snapshot;
+    u_long          usec;
+    unsigned int    alarm_id;
+#ifdef NETSNMP_CACHE_THREADS
+    int             threaded;
+    pthread_t       thread;
+#endif
+} cache_bg_load;
+
+#ifdef NETSNMP_CACHE_THREADS
+static netsnmp_done_queue _cache_bg_done = NETSNMP_DONE_QUEUE_INITIALIZER;
+#endif
+
+/*
+ * main thread: install the result of a reload
+ */
+static void
+_cache_bg_finish(cache_bg_load *bg)
+{
+    netsnmp_cache  *cache = bg->cache;
+
+#ifdef NETSNMP_CACHE_THREADS
+    if (bg->threaded)
+        pthread_join(bg->thread, NULL);
+#endif
+    cache->bg_load = NULL;
+    _cache_load_record(cache, bg->usec, NULL != bg->snapshot);
+    if (bg->snapshot) {
+        cache->swap_cache(cache, cache->magic, bg->snapshot);
+        _cache_loaded(cache);
+        DEBUGMSGT(("helper:cache_handler", " swapped in (%d)\n",
+                   cache->timeout));
+    } else {
+        /*
+         * keep serving the old data; the next request tries again
+         */
+        DEBUGMSGT(("helper:cache_handler", " background load failed\n"));
+    }
+    free(bg);
+}
+
+static void
+_cache_bg_alarm(unsigned int regNo, void *clientargs)
+{
+    cache_bg_load  *bg = (cache_bg_load *) clientargs;
+    netsnmp_cache  *cache = bg->cache;
+    struct timeval  start;
+
+    if (cache->build_cache && cache->swap_cache) {
+        netsnmp_get_monotonic_clock(&start);
+        bg->snapshot = cache->build_cache(cache, cache->magic);
+        bg->usec = _cache_elapsed_usec(&start);
+        _cache_bg_finish(bg);
+    } else {
+        cache->bg_load = NULL;
+        free(bg);
+        (void)_cache_load(cache);
+    }
+}
+
+#ifdef NETSNMP_CACHE_THREADS
+static void    *
+_cache_bg_run(void *arg)
+{
+    cache_bg_load  *bg = (cache_bg_load *) arg;
+    struct timeval  start;
+
+    netsnmp_get_monotonic_clock(&start);
+    bg->snapshot = bg->cache->build_cache(bg->cache, bg->cache->magic);
+    bg->usec = _cache_elapsed_usec(&start);
+
+    netsnmp_done_queue_push(&_cache_bg_done, &bg->done);
+    return NULL;
+}
+
+/*
+ * main thread: swap in every reload whose thread has finished
+ */
+static void
+_cache_bg_finished(int fd, void *data)
+{
+    cache_bg_load  *bg;
+
+    netsnmp_done_queue_ack(&_cache_bg_done);
+    while ((bg = (cache_bg_load *)
+            netsnmp_done_queue_pop(&_cache_bg_done)) != NULL)
+        _cache_bg_finish(bg);
+}
+
+static int
+_cache_bg_match(netsnmp_done_item *item, void *bg)
+{
+    return item == bg;
+}
+
+static int
+_cache_bg_queue_open(void)
+{
+    if (_cache_bg_done.fd[0] >= 0)
+        return 1;
+    if (!netsnmp_done_queue_open(&_cache_bg_done))
+        return 0;
+    if (register_readfd(_cache_bg_done.fd[0], _cache_bg_finished, NULL) !=
+        FD_REGISTERED_OK) {
+        snmp_log(LOG_ERR, "cache_handler: cannot watch reload pipe\n");
+        netsnmp_done_queue_close(&_cache_bg_done);
+        return 0;
+    }
+    return 1;
+}
+#endif /* NETSNMP_CACHE_THREADS */
+
+/*
+ * start reloading an expired cache without holding up the request
+ */
+static void
+_cache_load_background( netsnmp_cache *cache )
+{
+    cache_bg_load  *bg;
+
+    if (cache->bg_load) {
+        DEBUGMSGT(("helper:cache_handler", " reload already running\n"));
+        return;
+    }
+    bg = SNMP_MALLOC_TYPEDEF(cache_bg_load);
+    if (NULL == bg) {
+        (void)_cache_load(cache);
+        return;
+    }
+    bg->cache = cache;
+    cache->bg_load = bg;
+    cache->load_background++;
+
+#ifdef NETSNMP_CACHE_THREADS
+    if (cache->build_cache && cache->swap_cache && _cache_bg_queue_open()) {
+        bg->threaded = 1;
+        if (0 == pthread_create(&bg->thread, NULL, _cache_bg_run, bg)) {
+            DEBUGMSGT(("helper:cache_handler", " reloading in a thread\n"));
+            return;
+        }
+        bg->threaded = 0;
+    }
+#else
+    NETSNMP_LOGONCE((LOG_WARNING, "cache_handler: background reloads "
+                     "still block the main loop in an agent built without "
+                     "--enable-reentrant\n"));
+#endif
+    bg->alarm_id = snmp_alarm_register(0, 0, _cache_bg_alarm, bg);
+    if (0 == bg->alarm_id) {
+        cache->bg_load = NULL;
+        free(bg);
+        (void)_cache_load(cache);
+        return;
+    }
+    DEBUGMSGT(("helper:cache_handler", " reload deferred\n"));
+}
+
+/*
+ * drop a reload in progress; used when the cache itself goes away
+ */
+static void
+_cache_bg_cancel( netsnmp_cache *cache )
+{
+    cache_bg_load  *bg = (cache_bg_load *) cache->bg_load;
+
+    if (NULL == bg)
+        return;
+    cache->bg_load = NULL;
+#ifdef NETSNMP_CACHE_THREADS
+    if (bg->threaded) {
+        pthread_join(bg->thread, NULL);
+        netsnmp_done_queue_purge(&_cache_bg_done, _cache_bg_match, bg,
+                                 NULL);
+        if (bg->snapshot) {
+            /*
+             * install it so that the free hook releases it
+             */
+            cache->swap_cache(cache, cache->magic, bg->snapshot);
+            cache->valid = 1;
+        }
+    } else
+#endif
+        snmp_alarm_unregister(bg->alarm_id);
+    free(bg);
+}
 
 
 /** run regularly to automatically release cached resources.
@@ -776,6 +1050,10 @@ release_cached_resources(unsigned int regNo, void *clientargs)
     for (cache = cache_head; cache; cache = cache->next) {
         DEBUGMSGTL(("helper:cache_handler"," checking %p (flags 0x%x)\n",
                      cache, cache->flags));
+        if (cache->bg_load) {
+            cache_outstanding_valid = 1;
+            continue;
+        }
         if (cache->valid &&
             ! (cache->flags & NETSNMP_CACHE_DONT_AUTO_RELEASE)) {
             DEBUGMSGTL(("helper:cache_handler","  releasing %p\n", cache));
@@ -786,7 +1064,8 @@ release_cached_resources(unsigned int regNo, void *clientargs)
              *   least one active cache.
              */
             if (netsnmp_cache_check_expired(cache)) {
-                if(! (cache->flags & NETSNMP_CACHE_DONT_FREE_EXPIRED))
+                if(! (cache->flags & (NETSNMP_CACHE_DONT_FREE_EXPIRED |
+                                      NETSNMP_CACHE_BACKGROUND_LOAD)))
                     _cache_free(cache);
             } else {
                 cache_outstanding_valid = 1;
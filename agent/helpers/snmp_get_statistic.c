@@ -75,6 +75,8 @@ netsnmp_register_statistic_handler(netsnmp_handler_registration *reginfo,
         netsnmp_handler_registration_free(reginfo);
         return MIB_REGISTRATION_FAILED;
     }
+    /* the counters are only read, so any thread may serve them */
+    reginfo->modes |= HANDLER_CAN_THREADSAFE;
     return netsnmp_register_scalar_group(reginfo, start,
                                          start + (end - begin));
 }
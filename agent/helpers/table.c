@@ -369,7 +369,8 @@ table_helper_handler(netsnmp_mib_handler *handler,
             tmp_len = reginfo->rootoid_len;
         if (snmp_oid_compare(reginfo->rootoid, reginfo->rootoid_len,
                              var->name, tmp_len) > 0) {
-            if (reqinfo->mode == MODE_GETNEXT) {
+            if (reqinfo->mode == MODE_GETNEXT ||
+                reqinfo->mode == MODE_GETBULK) {
                 if (var->name != var->name_loc)
                     SNMP_FREE(var->name);
                 snmp_set_var_objid(var, reginfo->rootoid,
@@ -386,7 +387,8 @@ table_helper_handler(netsnmp_mib_handler *handler,
         else if ((var->name_length > reginfo->rootoid_len) &&
                  (var->name[reginfo->rootoid_len] != 1)) {
             if ((var->name[reginfo->rootoid_len] < 1) &&
-                (reqinfo->mode == MODE_GETNEXT)) {
+                (reqinfo->mode == MODE_GETNEXT ||
+                 reqinfo->mode == MODE_GETBULK)) {
                 var->name[reginfo->rootoid_len] = 1;
                 var->name_length = reginfo->rootoid_len;
             } else {
@@ -461,7 +463,8 @@ table_helper_handler(netsnmp_mib_handler *handler,
                 DEBUGMSGTL(("helper:table:col",
                             "    but it's less than min (%d)\n",
                             tbl_info->min_column));
-                if (reqinfo->mode == MODE_GETNEXT) {
+                if (reqinfo->mode == MODE_GETNEXT ||
+                    reqinfo->mode == MODE_GETBULK) {
                     /*
                      * fix column, truncate useless column info 
                      */
@@ -683,6 +686,7 @@ table_helper_handler(netsnmp_mib_handler *handler,
          */
 
         if ((reqinfo->mode != MODE_GETNEXT) &&
+            (reqinfo->mode != MODE_GETBULK) &&
             ((tbl_req_info->number_indexes != tbl_info->number_indexes) ||
              (tmp_len != -1))) {
 
@@ -730,7 +734,7 @@ table_helper_handler(netsnmp_mib_handler *handler,
     /*
      * check for sparse tables
      */
-    if (reqinfo->mode == MODE_GETNEXT)
+    if (reqinfo->mode == MODE_GETNEXT || reqinfo->mode == MODE_GETBULK)
         sparse_table_helper_handler( handler, reginfo, reqinfo, requests );
 
     return status;
@@ -779,7 +783,7 @@ sparse_table_helper_handler(netsnmp_mib_handler *handler,
         }
     }
 
-    if (reqinfo->mode == MODE_GETNEXT) {
+    if (reqinfo->mode == MODE_GETNEXT || reqinfo->mode == MODE_GETBULK) {
         for(request = requests ; request; request = request->next) {
             if ((request->requestvb->type == ASN_NULL && request->processed) ||
                 request->delegated)
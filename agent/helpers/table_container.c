@@ -27,6 +27,7 @@
 #endif
 
 #include <net-snmp/agent/table.h>
+#include <net-snmp/agent/bulk_to_next.h>
 #include <net-snmp/library/container.h>
 #include <net-snmp/library/snmp_assert.h>
 
@@ -39,6 +40,8 @@ netsnmp_feature_child_of(table_container_row_remove, table_container_all);
 netsnmp_feature_child_of(table_container_row_insert, table_container_all);
 netsnmp_feature_child_of(table_container_all, mib_helpers);
 
+netsnmp_feature_require(netsnmp_call_next_handler_one_request);
+
 #ifndef NETSNMP_FEATURE_REMOVE_TABLE_CONTAINER
 
 /*
@@ -139,6 +142,16 @@ typedef struct container_table_data_s {
  *    request. The agent will notice this unsatisfied request, and attempt to
  *    pass it to the next appropriate handler.
  *
+ *    A GET-BULK request only reaches this handler if the registration
+ *    advertised HANDLER_CAN_GETBULK (otherwise the bulk_to_next helper
+ *    turns it into a series of GET-NEXT requests). In that case the
+ *    repetitions are served in a single call: each repeating request
+ *    walks forward through the container, calling the sub-handler in
+ *    GET mode once per row, until the repeat count, the table or the
+ *    message size budget is exhausted. The sub-handler must therefore
+ *    cope with being called several times for the same request, with
+ *    a different row each time.
+ *
  *  SET
  *    If the hander did not register with the HANDLER_CAN_NOT_CREATE flag
  *    set in the registration modes, it is assumed that this is a row
@@ -698,6 +711,90 @@ _data_lookup(netsnmp_handler_registration *reginfo,
     }
 }
 
+/*
+ * Serve the remaining repetitions of a GETBULK request whose first row
+ * has already been looked up, calling the sub-handler in GET mode for
+ * one row at a time. Answers are screened against the view and the
+ * range end just as the agent would between GETNEXT passes, so the
+ * agent only has to carry on from the last varbind we leave behind.
+ */
+static int
+_data_lookup_bulk(netsnmp_mib_handler *handler,
+                  netsnmp_handler_registration *reginfo,
+                  netsnmp_agent_request_info *agtreq_info,
+                  netsnmp_request_info *request, container_table_data * tad,
+                  int *budget)
+{
+    netsnmp_table_request_info *tblreq_info;
+    netsnmp_variable_list *var;
+    netsnmp_pdu    *pdu = agtreq_info->asp ? agtreq_info->asp->pdu : NULL;
+    int             rc;
+
+    tblreq_info = netsnmp_extract_table_info(request);
+
+    while (1) {
+        agtreq_info->mode = MODE_GET;
+        rc = netsnmp_call_next_handler_one_request(handler, reginfo,
+                                                   agtreq_info, request);
+        agtreq_info->mode = MODE_GETBULK;
+        if ((rc != SNMP_ERR_NOERROR) || request->delegated ||
+            (request->status != SNMP_ERR_NOERROR))
+            return rc;
+
+        var = request->requestvb;
+        if ((var->type == SNMP_NOSUCHINSTANCE) || (var->type == ASN_NULL)) {
+            /*
+             * sparse row, try the next one
+             */
+            var->type = ASN_PRIV_RETRY;
+        }
+        else if (var->type == SNMP_NOSUCHOBJECT) {
+            /*
+             * nothing in this column, start over with the next one
+             */
+            tblreq_info->colnum = netsnmp_table_next_column(tblreq_info);
+            if (0 == tblreq_info->colnum) {
+                var->type = ASN_NULL;
+                return rc;
+            }
+            tblreq_info->index_oid_len = 0;
+            tblreq_info->number_indexes = 0;
+            var->type = ASN_PRIV_RETRY;
+        }
+        else if (snmp_oid_compare(var->name, var->name_length,
+                                  request->range_end,
+                                  request->range_end_len) >= 0) {
+            return rc;
+        }
+        else if (pdu && (in_a_view(var->name, &var->name_length, pdu,
+                                   var->type) != VACM_SUCCESS)) {
+            var->type = ASN_PRIV_RETRY;
+            request->inclusive = 0;
+        }
+        else {
+            /*
+             * a keeper. Stop once it would overflow the response, much
+             * like handle_getnext_loop does between passes.
+             */
+            *budget -= var->name_length + var->val_len;
+            if ((*budget < 0) || !netsnmp_bulk_to_next_fix_request(request))
+                return rc;
+        }
+
+        /*
+         * look up the row after the one just answered
+         */
+        if (tblreq_info->index_oid_len)
+            tblreq_info->number_indexes = tad->tblreg_info->number_indexes;
+        netsnmp_request_remove_list_data(request, TABLE_CONTAINER_ROW);
+        netsnmp_request_remove_list_data(request, TABLE_CONTAINER_CONTAINER);
+        request->processed = 0;
+        _data_lookup(reginfo, agtreq_info, request, tad);
+        if (request->processed)
+            return rc;
+    }
+}
+
 /**********************************************************************
  **********************************************************************
  *                                                                    *
@@ -771,6 +868,31 @@ _container_table_handler(netsnmp_mib_handler *handler,
         } /** for ( ... requests ... ) */
     }
     
+    /*
+     * serve all repetitions of a native GETBULK before returning
+     */
+    if ((oldmode == MODE_GETBULK) && (handler->next)) {
+        netsnmp_request_info *curr_request;
+        int budget = SNMP_MAX_MSG_SIZE;
+
+        if (agtreq_info->asp && agtreq_info->asp->pdu)
+            budget = agtreq_info->asp->pdu->msgMaxSize;
+
+        handler->flags |= MIB_HANDLER_AUTO_NEXT_OVERRIDE_ONCE;
+        for (curr_request = requests; curr_request;
+             curr_request = curr_request->next) {
+            if (curr_request->processed)
+                continue;
+            rc = _data_lookup_bulk(handler, reginfo, agtreq_info,
+                                   curr_request, tad, &budget);
+            if (rc != SNMP_ERR_NOERROR) {
+                DEBUGMSGTL(("table_container",
+                            "next handler returned %d\n", rc));
+                break;
+            }
+        }
+    }
+
     /*
      * send GET instead of GETNEXT to sub-handlers
      * xxx-rks: again, this should be handled further up.
@@ -83,6 +83,17 @@
         then the free_loop_context_at_end pointer should be set, which
         is more efficient since a malloc/free will only be performed
         once for every iteration.
+
+    Walking the whole table for every request makes a full walk of a
+    large table quadratic.  A table whose rows only change when its
+    cache (registered with the table's OID) is reloaded can set
+    NETSNMP_ITERATOR_FLAG_INDEX_CACHE.  The helper then iterates once
+    per cache load, keeps a sorted snapshot of the row indexes along
+    with their data contexts, and answers GET and GETNEXT requests
+    with a binary search.  The data contexts must stay valid until the
+    cache is reloaded; the snapshot owns them from then on and releases
+    them through free_data_context.  Without a valid cache the helper
+    falls back to iterating as usual.
  *
  *  @{
  */
@@ -104,6 +115,7 @@
 #include <net-snmp/agent/table.h>
 #include <net-snmp/agent/serialize.h>
 #include <net-snmp/agent/stash_cache.h>
+#include <net-snmp/agent/cache_handler.h>
 
 netsnmp_feature_child_of(table_iterator_all, mib_helpers);
 
@@ -112,11 +124,15 @@ netsnmp_feature_child_of(table_iterator_create_table, table_iterator_all);
 netsnmp_feature_child_of(table_iterator_row_first, table_iterator_all);
 netsnmp_feature_child_of(table_iterator_row_count, table_iterator_all);
 
+netsnmp_feature_require(cache_find_by_oid);
+
 #ifdef NETSNMP_FEATURE_REQUIRE_STASH_CACHE
 netsnmp_feature_require(data_list_get_list_node);
 netsnmp_feature_require(oid_stash_add_data);
 #endif /* NETSNMP_FEATURE_REQUIRE_STASH_CACHE */
 
+static void _ti_index_cache_free(netsnmp_iterator_info *iinfo);
+
 /* ==================================
  *
  * Iterator API: Table maintenance
@@ -169,6 +185,7 @@ netsnmp_iterator_delete_table( netsnmp_iterator_info *iinfo )
         snmp_free_varbind( iinfo->indexes );
         iinfo->indexes = NULL;
     }
+    _ti_index_cache_free(iinfo);
     netsnmp_table_registration_info_free(iinfo->table_reginfo);
     SNMP_FREE( iinfo );
 }
@@ -446,6 +463,263 @@ netsnmp_iterator_remember(netsnmp_request_info *request,
     return ti_info;
 }    
 
+/*
+ * Sorted snapshot of the row indexes (NETSNMP_ITERATOR_FLAG_INDEX_CACHE),
+ * valid for one load of the table's cache.
+ */
+typedef struct ti_index_row_s {
+    oid            *index;
+    size_t          index_len;
+    void           *data_context;
+} ti_index_row;
+
+typedef struct ti_index_cache_s {
+    ti_index_row   *rows;
+    size_t          count;
+    u_int           generation;
+} ti_index_cache;
+
+static int
+_ti_index_row_compare(const void *a, const void *b)
+{
+    const ti_index_row *ra = (const ti_index_row *) a;
+    const ti_index_row *rb = (const ti_index_row *) b;
+
+    return snmp_oid_compare(ra->index, ra->index_len,
+                            rb->index, rb->index_len);
+}
+
+static void
+_ti_index_cache_release(ti_index_cache *ic, netsnmp_iterator_info *iinfo)
+{
+    size_t          i;
+
+    for (i = 0; i < ic->count; i++) {
+        if (ic->rows[i].data_context && iinfo->free_data_context)
+            (iinfo->free_data_context)(ic->rows[i].data_context, iinfo);
+        free(ic->rows[i].index);
+    }
+    free(ic->rows);
+    free(ic);
+}
+
+static void
+_ti_index_cache_free(netsnmp_iterator_info *iinfo)
+{
+    if (iinfo->index_cache) {
+        _ti_index_cache_release((ti_index_cache *) iinfo->index_cache, iinfo);
+        iinfo->index_cache = NULL;
+    }
+}
+
+/* iterates over the whole table once, and sorts what it found */
+static ti_index_cache *
+_ti_index_cache_build(netsnmp_iterator_info *iinfo, u_int generation)
+{
+    ti_index_cache *ic;
+    ti_index_row   *rows;
+    netsnmp_variable_list *index_search, *free_this_index_search;
+    void           *loop_context = NULL, *last_loop_context;
+    void           *data_context = NULL;
+    oid             index[MAX_OID_LEN];
+    size_t          index_len, size = 0;
+    int             failed = 0;
+
+    ic = SNMP_MALLOC_TYPEDEF(ti_index_cache);
+    index_search = snmp_clone_varbind(iinfo->indexes);
+    if (!ic || !index_search) {
+        SNMP_FREE(ic);
+        snmp_free_varbind(index_search);
+        return NULL;
+    }
+    ic->generation = generation;
+    free_this_index_search = index_search;
+
+    index_search = (iinfo->get_first_data_point) (&loop_context,
+                                                  &data_context,
+                                                  index_search, iinfo);
+    while (index_search) {
+        free_this_index_search = index_search;
+
+        if (iinfo->make_data_context && !data_context)
+            data_context = (iinfo->make_data_context)(loop_context, iinfo);
+        if (ic->count == size) {
+            size = size ? 2 * size : 64;
+            rows = (ti_index_row *) realloc(ic->rows, size * sizeof(*rows));
+            if (!rows)
+                failed = 1;
+            else
+                ic->rows = rows;
+        }
+        index_len = 0;
+        if (failed ||
+            build_oid_noalloc(index, MAX_OID_LEN, &index_len, NULL, 0,
+                              index_search) != SNMPERR_SUCCESS ||
+            !(ic->rows[ic->count].index =
+              (oid *) netsnmp_memdup(index, index_len * sizeof(oid)))) {
+            if (data_context && iinfo->free_data_context)
+                (iinfo->free_data_context)(data_context, iinfo);
+            failed = 1;
+            break;
+        }
+        ic->rows[ic->count].index_len = index_len;
+        ic->rows[ic->count].data_context = data_context;
+        ic->count++;
+        data_context = NULL;
+
+        last_loop_context = loop_context;
+        index_search = (iinfo->get_next_data_point) (&loop_context,
+                                                     &data_context,
+                                                     index_search, iinfo);
+        if (iinfo->free_loop_context && last_loop_context &&
+            data_context != last_loop_context)
+            (iinfo->free_loop_context) (last_loop_context, iinfo);
+    }
+
+    if (loop_context && iinfo->free_loop_context_at_end)
+        (iinfo->free_loop_context_at_end) (loop_context, iinfo);
+    snmp_free_varbind(free_this_index_search);
+
+    if (failed) {
+        snmp_log(LOG_WARNING, "table_iterator: could not build index cache\n");
+        _ti_index_cache_release(ic, iinfo);
+        return NULL;
+    }
+    if (ic->count > 1)
+        qsort(ic->rows, ic->count, sizeof(ti_index_row),
+              _ti_index_row_compare);
+    return ic;
+}
+
+/* returns the first row at or (if after is set) beyond key */
+static size_t
+_ti_index_cache_search(ti_index_cache *ic, ti_index_row *key, int after)
+{
+    size_t          lo = 0, hi = ic->count, mid;
+    int             cmp;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        cmp = _ti_index_row_compare(&ic->rows[mid], key);
+        if (cmp < 0 || (after && cmp == 0))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/*
+ * Finds the rows for GET and GETNEXT requests in the index snapshot,
+ * rebuilding it first if the table's cache has been reloaded since.
+ * Returns 0 if there is no valid cache to tie the snapshot to, in which
+ * case nothing has been touched and the caller should iterate instead.
+ */
+static int
+_ti_index_cache_lookup(netsnmp_handler_registration *reginfo,
+                       netsnmp_agent_request_info *reqinfo,
+                       netsnmp_request_info *requests,
+                       netsnmp_iterator_info *iinfo)
+{
+    netsnmp_cache  *cache;
+    ti_index_cache *ic;
+    ti_index_row    key, *row;
+    netsnmp_request_info *request;
+    netsnmp_table_request_info *table_info;
+    netsnmp_variable_list *var;
+    oid             name[MAX_OID_LEN];
+    size_t          idx_pos = reginfo->rootoid_len + 2;
+    size_t          pos;
+    oid             nc;
+
+    cache = netsnmp_cache_find_by_oid(reginfo->rootoid, reginfo->rootoid_len);
+    if (!cache || !cache->valid) {
+        DEBUGMSGTL(("table_iterator:index_cache",
+                    "no valid cache for %s\n", reginfo->handlerName));
+        return 0;
+    }
+
+    ic = (ti_index_cache *) iinfo->index_cache;
+    if (ic && ic->generation != cache->generation) {
+        _ti_index_cache_free(iinfo);
+        ic = NULL;
+    }
+    if (!ic) {
+        ic = _ti_index_cache_build(iinfo, cache->generation);
+        if (!ic)
+            return 0;
+        iinfo->index_cache = ic;
+        DEBUGMSGTL(("table_iterator:index_cache", "%s: %lu rows\n",
+                    reginfo->handlerName, (unsigned long)ic->count));
+    }
+
+    memcpy(name, reginfo->rootoid, reginfo->rootoid_len * sizeof(oid));
+    name[reginfo->rootoid_len] = 1;     /* table.entry node */
+
+    for (request = requests; request; request = request->next) {
+        if (request->processed)
+            continue;
+        table_info = netsnmp_extract_table_info(request);
+        if (!table_info) {
+            netsnmp_set_request_error(reqinfo, request, SNMP_ERR_GENERR);
+            continue;
+        }
+        var = request->requestvb;
+
+        key.index = NULL;
+        key.index_len = 0;
+        if (var->name_length > idx_pos &&
+            var->name[idx_pos - 1] == table_info->colnum) {
+            key.index = var->name + idx_pos;
+            key.index_len = var->name_length - idx_pos;
+        }
+
+        if (reqinfo->mode == MODE_GET) {
+            pos = _ti_index_cache_search(ic, &key, 0);
+            if (pos == ic->count ||
+                _ti_index_row_compare(&ic->rows[pos], &key) != 0)
+                continue;
+            row = &ic->rows[pos];
+        } else {
+            pos = _ti_index_cache_search(ic, &key, 1);
+            if (pos == ic->count) {
+                /*
+                 * off the end of this column, go on to the next one
+                 */
+                nc = netsnmp_table_next_column(table_info);
+                if (0 == nc || 0 == ic->count) {
+                    name[idx_pos - 1] = table_info->reg_info->max_column + 1;
+                    snmp_set_var_objid(var, name, idx_pos);
+                    request->processed = 1;
+                    continue;
+                }
+                table_info->colnum = nc;
+                pos = 0;
+            }
+            row = &ic->rows[pos];
+            if (idx_pos + row->index_len > MAX_OID_LEN) {
+                netsnmp_set_request_error(reqinfo, request, SNMP_ERR_GENERR);
+                continue;
+            }
+            name[idx_pos - 1] = table_info->colnum;
+            memcpy(name + idx_pos, row->index, row->index_len * sizeof(oid));
+            snmp_set_var_objid(var, name, idx_pos + row->index_len);
+
+            memcpy(table_info->index_oid, row->index,
+                   row->index_len * sizeof(oid));
+            table_info->index_oid_len = row->index_len;
+            netsnmp_update_variable_list_from_index(table_info);
+        }
+
+        if (row->data_context)
+            netsnmp_request_add_list_data(request,
+                                          netsnmp_create_data_list
+                                          (TABLE_ITERATOR_NAME,
+                                           row->data_context, NULL));
+    }
+    return 1;
+}
+
 #define TABLE_ITERATOR_NOTAGAIN 255
 /* implements the table_iterator helper */
 int
@@ -503,6 +777,19 @@ netsnmp_table_iterator_helper_handler(netsnmp_mib_handler *handler,
         return SNMP_ERR_GENERR;
     }
 
+    /*
+     * serve GET and GETNEXT from the index snapshot, if asked to
+     */
+    if ((iinfo->flags & NETSNMP_ITERATOR_FLAG_INDEX_CACHE) &&
+        (reqinfo->mode == MODE_GET || reqinfo->mode == MODE_GETNEXT) &&
+        _ti_index_cache_lookup(reginfo, reqinfo, requests, iinfo)) {
+        oldmode = reqinfo->mode;
+        reqinfo->mode = MODE_GET;
+        ret = netsnmp_call_next_handler(handler, reginfo, reqinfo, requests);
+        reqinfo->mode = oldmode;
+        return ret;
+    }
+
     /* preliminary analysis */
     switch (reqinfo->mode) {
 #ifndef NETSNMP_FEATURE_REMOVE_STASH_CACHE
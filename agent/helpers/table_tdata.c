@@ -350,6 +350,10 @@ netsnmp_get_tdata_handler(netsnmp_tdata *table)
  * table (and converting GETNEXT requests into an equivalent GET request)
  * So all we need to do here is make sure that the row is accessible
  * using tdata-style retrieval techniques as well.
+ *
+ * Registrations which add HANDLER_CAN_GETBULK to their modes have
+ * GETBULK requests served natively by the table_container helper,
+ * which calls us (and the module below us) once per returned row.
  */
 int
 _netsnmp_tdata_helper_handler(netsnmp_mib_handler *handler,
@@ -387,6 +391,11 @@ _netsnmp_tdata_helper_handler(netsnmp_mib_handler *handler,
                 continue;           /* eek */
             }
             ++need_processing;
+            /*
+             * a native GETBULK brings each request back once per row
+             */
+            netsnmp_request_remove_list_data(request, TABLE_TDATA_TABLE);
+            netsnmp_request_remove_list_data(request, TABLE_TDATA_ROW);
             netsnmp_request_add_list_data(request,
                                       netsnmp_create_data_list(
                                           TABLE_TDATA_TABLE, table, NULL));
@@ -39,6 +39,12 @@ extern netsnmp_cache *netsnmp_cache_get_head(void);
 
 #define  NSCACHE_TIMEOUT	2
 #define  NSCACHE_STATUS		3
+#define  NSCACHE_LOADS		4
+#define  NSCACHE_LOAD_FAILURES	5
+#define  NSCACHE_BACKGROUND_LOADS	6
+#define  NSCACHE_LAST_LOAD_TIME	7
+#define  NSCACHE_LOADS_HIST	8	/* ... one column per bucket */
+#define  NSCACHE_LAST_COLUMN	(NSCACHE_LOADS_HIST + NETSNMP_CACHE_LOAD_BUCKETS - 1)
 
 #define NSCACHE_STATUS_ENABLED  1
 #define NSCACHE_STATUS_DISABLED 2
@@ -88,7 +94,7 @@ init_nsCache(void)
     }
     netsnmp_table_helper_add_indexes(table_info, ASN_PRIV_IMPLIED_OBJECT_ID, 0);
     table_info->min_column = NSCACHE_TIMEOUT;
-    table_info->max_column = NSCACHE_STATUS;
+    table_info->max_column = NSCACHE_LAST_COLUMN;
 
 
     /*
@@ -273,6 +279,7 @@ handle_nsCacheTable(netsnmp_mib_handler *handler,
                 netsnmp_request_info *requests)
 {
     long status;
+    u_long counter;
     netsnmp_request_info       *request     = NULL;
     netsnmp_table_request_info *table_info  = NULL;
     netsnmp_cache              *cache_entry = NULL;
@@ -316,7 +323,43 @@ handle_nsCacheTable(netsnmp_mib_handler *handler,
                                          (u_char*)&status, sizeof(status));
 	        break;
 
+            case NSCACHE_LOADS:
+            case NSCACHE_LOAD_FAILURES:
+            case NSCACHE_BACKGROUND_LOADS:
+            case NSCACHE_LAST_LOAD_TIME:
+                if (!cache_entry) {
+                    netsnmp_set_request_error(reqinfo, request, SNMP_NOSUCHINSTANCE);
+                    continue;
+		}
+                if (table_info->colnum == NSCACHE_LOADS)
+                    counter = cache_entry->load_count;
+                else if (table_info->colnum == NSCACHE_LOAD_FAILURES)
+                    counter = cache_entry->load_failures;
+                else if (table_info->colnum == NSCACHE_BACKGROUND_LOADS)
+                    counter = cache_entry->load_background;
+                else {
+                    counter = cache_entry->load_last_usec & 0xffffffff;
+	            snmp_set_var_typed_value(request->requestvb, ASN_GAUGE,
+                                             (u_char*)&counter, sizeof(counter));
+                    break;
+                }
+	        snmp_set_var_typed_value(request->requestvb, ASN_COUNTER,
+                                         (u_char*)&counter, sizeof(counter));
+	        break;
+
             default:
+                if (table_info->colnum >= NSCACHE_LOADS_HIST &&
+                    table_info->colnum <= NSCACHE_LAST_COLUMN) {
+                    if (!cache_entry) {
+                        netsnmp_set_request_error(reqinfo, request, SNMP_NOSUCHINSTANCE);
+                        continue;
+                    }
+                    counter = cache_entry->load_hist[table_info->colnum -
+                                                     NSCACHE_LOADS_HIST];
+	            snmp_set_var_typed_value(request->requestvb, ASN_COUNTER,
+                                             (u_char*)&counter, sizeof(counter));
+                    break;
+                }
                 netsnmp_set_request_error(reqinfo, request, SNMP_NOSUCHOBJECT);
                 continue;
 	    }
@@ -370,6 +413,11 @@ handle_nsCacheTable(netsnmp_mib_handler *handler,
 	        break;
 
             default:
+                if (table_info->colnum >= NSCACHE_LOADS &&
+                    table_info->colnum <= NSCACHE_LAST_COLUMN) {
+                    netsnmp_set_request_error(reqinfo, request, SNMP_ERR_NOTWRITABLE);
+                    return SNMP_ERR_NOTWRITABLE;
+                }
                 netsnmp_set_request_error(reqinfo, request, SNMP_ERR_NOCREATION);
                 return SNMP_ERR_NOCREATION;	/* XXX - is this right ? */
 	    }
@@ -78,6 +78,54 @@ initialize_table_nsModuleTable(void)
     netsnmp_register_table_iterator2(my_handler, iinfo);
 }
 
+/** Initialize the nsModuleTimingTable table, which augments nsModuleTable */
+void
+initialize_table_nsModuleTimingTable(void)
+{
+    const oid nsModuleTimingTable_oid[] = { 1, 3, 6, 1, 4, 1, 8072, 1, 2, 2 };
+    netsnmp_table_registration_info *table_info;
+    netsnmp_handler_registration *my_handler;
+    netsnmp_iterator_info *iinfo;
+
+    table_info = SNMP_MALLOC_TYPEDEF(netsnmp_table_registration_info);
+    iinfo = SNMP_MALLOC_TYPEDEF(netsnmp_iterator_info);
+
+    my_handler = netsnmp_create_handler_registration("nsModuleTimingTable",
+                                                     nsModuleTimingTable_handler,
+                                                     nsModuleTimingTable_oid,
+                                                     OID_LENGTH
+                                                     (nsModuleTimingTable_oid),
+                                                     HANDLER_CAN_RONLY);
+
+    if (!my_handler || !table_info || !iinfo) {
+        if (my_handler)
+            netsnmp_handler_registration_free(my_handler);
+        SNMP_FREE(table_info);
+        SNMP_FREE(iinfo);
+        return;                 /* mallocs failed */
+    }
+
+    /*
+     * the same rows, and so the same indexes, as nsModuleTable
+     */
+    netsnmp_table_helper_add_indexes(table_info, ASN_OCTET_STR, /* context name */
+                                     ASN_OBJECT_ID,     /* reg point */
+                                     ASN_INTEGER,       /* priority */
+                                     0);
+
+    table_info->min_column = COLUMN_NSMODULECALLS;
+    table_info->max_column = COLUMN_NSMODULETIME99;
+
+    iinfo->get_first_data_point = nsModuleTable_get_first_data_point;
+    iinfo->get_next_data_point = nsModuleTable_get_next_data_point;
+    iinfo->free_loop_context_at_end = nsModuleTable_free;
+    iinfo->table_reginfo = table_info;
+
+    DEBUGMSGTL(("initialize_table_nsModuleTimingTable",
+                "Registering table nsModuleTimingTable as a table iterator\n"));
+    netsnmp_register_table_iterator2(my_handler, iinfo);
+}
+
 /** Initializes the nsModuleTable module */
 void
 init_nsModuleTable(void)
@@ -87,6 +135,7 @@ init_nsModuleTable(void)
      * here we initialize all the tables we're planning on supporting 
      */
     initialize_table_nsModuleTable();
+    initialize_table_nsModuleTimingTable();
 }
 
 /** returns the first data point within the nsModuleTable table data.
@@ -320,3 +369,84 @@ nsModuleTable_handler(netsnmp_mib_handler *handler,
     }
     return SNMP_ERR_NOERROR;
 }
+
+/** handles requests for the nsModuleTimingTable table */
+int
+nsModuleTimingTable_handler(netsnmp_mib_handler *handler,
+                            netsnmp_handler_registration *reginfo,
+                            netsnmp_agent_request_info *reqinfo,
+                            netsnmp_request_info *requests)
+{
+    static const netsnmp_handler_timing no_timing;
+    const netsnmp_handler_timing *timing;
+    netsnmp_table_request_info *table_info;
+    netsnmp_request_info *request;
+    netsnmp_variable_list *var;
+    netsnmp_subtree *tree;
+    struct counter64 c64;
+    u_long          ultmp;
+
+    if (reqinfo->mode != MODE_GET) {
+        snmp_log(LOG_ERR,
+                 "problem encountered in nsModuleTimingTable_handler: unsupported mode\n");
+        return SNMP_ERR_NOERROR;
+    }
+
+    for (request = requests; request; request = request->next) {
+        var = request->requestvb;
+        if (request->processed != 0)
+            continue;
+
+        tree = (netsnmp_subtree *)netsnmp_extract_iterator_context(request);
+        table_info = netsnmp_extract_table_info(request);
+        if (tree == NULL || table_info == NULL) {
+            netsnmp_set_request_error(reqinfo, request, SNMP_NOSUCHINSTANCE);
+            continue;
+        }
+
+        /*
+         * a registration which has not been timed reports zeroes
+         */
+        timing = tree->reginfo->timing ? tree->reginfo->timing : &no_timing;
+
+        switch (table_info->colnum) {
+        case COLUMN_NSMODULECALLS:
+            ultmp = timing->calls & 0xffffffff;
+            snmp_set_var_typed_value(var, ASN_COUNTER,
+                                     (u_char *) & ultmp, sizeof(ultmp));
+            break;
+
+        case COLUMN_NSMODULETOTALTIME:
+            /*
+             * shifted in two steps, as u_long may only have 32 bits
+             */
+            c64.high = (timing->total_usec >> 16 >> 16) & 0xffffffff;
+            c64.low = timing->total_usec & 0xffffffff;
+            snmp_set_var_typed_value(var, ASN_COUNTER64,
+                                     (u_char *) & c64, sizeof(c64));
+            break;
+
+        case COLUMN_NSMODULEMAXTIME:
+        case COLUMN_NSMODULETIME50:
+        case COLUMN_NSMODULETIME90:
+        case COLUMN_NSMODULETIME99:
+            if (table_info->colnum == COLUMN_NSMODULEMAXTIME)
+                ultmp = timing->max_usec;
+            else
+                ultmp = netsnmp_handler_timing_percentile(timing,
+                            table_info->colnum == COLUMN_NSMODULETIME50 ? 50 :
+                            table_info->colnum == COLUMN_NSMODULETIME90 ? 90 :
+                            99);
+            if (ultmp > 0xffffffff)
+                ultmp = 0xffffffff;
+            snmp_set_var_typed_value(var, ASN_UNSIGNED,
+                                     (u_char *) & ultmp, sizeof(ultmp));
+            break;
+
+        default:
+            snmp_log(LOG_ERR,
+                     "problem encountered in nsModuleTimingTable_handler: unknown column\n");
+        }
+    }
+    return SNMP_ERR_NOERROR;
+}
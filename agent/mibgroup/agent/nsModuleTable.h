@@ -11,6 +11,8 @@
 void            init_nsModuleTable(void);
 void            initialize_table_nsModuleTable(void);
 Netsnmp_Node_Handler nsModuleTable_handler;
+void            initialize_table_nsModuleTimingTable(void);
+Netsnmp_Node_Handler nsModuleTimingTable_handler;
 
 Netsnmp_First_Data_Point nsModuleTable_get_first_data_point;
 Netsnmp_Next_Data_Point nsModuleTable_get_next_data_point;
@@ -24,4 +26,14 @@ Netsnmp_Next_Data_Point nsModuleTable_get_next_data_point;
 #define COLUMN_NSMODULENAME		4
 #define COLUMN_NSMODULEMODES		5
 #define COLUMN_NSMODULETIMEOUT		6
+
+/*
+ * column number definitions for table nsModuleTimingTable
+ */
+#define COLUMN_NSMODULECALLS		1
+#define COLUMN_NSMODULETOTALTIME	2
+#define COLUMN_NSMODULEMAXTIME		3
+#define COLUMN_NSMODULETIME50		4
+#define COLUMN_NSMODULETIME90		5
+#define COLUMN_NSMODULETIME99		6
 #endif                          /* NSMODULETABLE_H */
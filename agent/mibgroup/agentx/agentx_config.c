@@ -138,6 +138,19 @@ agentx_parse_agentx_retries(const char *token, char *cptr)
     netsnmp_ds_set_int(NETSNMP_DS_APPLICATION_ID,
                        NETSNMP_DS_AGENT_AGENTX_RETRIES, x);
 }
+
+void
+agentx_parse_agentx_window(const char *token, char *cptr)
+{
+    int x = atoi(cptr);
+    DEBUGMSGTL(("agentx/config/window", "%s\n", cptr));
+    if (x < 0) {
+        config_perror("Invalid window size");
+        return;
+    }
+    netsnmp_ds_set_int(NETSNMP_DS_APPLICATION_ID,
+                       NETSNMP_DS_AGENT_AGENTX_WINDOW, x);
+}
 #endif                          /* USING_AGENTX_MASTER_MODULE */
 
 #ifdef USING_AGENTX_SUBAGENT_MODULE
@@ -229,6 +242,12 @@ agentx_config_init(void)
     agentx_register_config_handler("agentxperms",
                                   agentx_parse_agentx_perms, NULL,
                                   "AgentX socket permissions: socket_perms [directory_perms [username|userid [groupname|groupid]]]");
+    agentx_register_config_handler("agentxWindow",
+                                  agentx_parse_agentx_window, NULL,
+                                  "AgentX requests in flight per subagent (0 for no limit)");
+    /* default to 16 requests */
+    netsnmp_ds_set_int(NETSNMP_DS_APPLICATION_ID,
+                       NETSNMP_DS_AGENT_AGENTX_WINDOW, 16);
     }
 #endif                          /* USING_AGENTX_MASTER_MODULE */
 
@@ -101,6 +101,86 @@ agentx_synch_response(netsnmp_session * ss, netsnmp_pdu *pdu,
          * AgentX PofE convenience functions
          */
 
+/*
+ * While a registration batch is open, agentx_register() sends its
+ * Register PDU and returns without waiting for the response.  At most
+ * AGENTX_REGISTER_BATCH of them are outstanding at once, so that neither
+ * side blocks writing while the other is not reading; the master answers
+ * in order, so the response to a Ping means that all the registrations
+ * sent before it have been answered.
+ */
+#define AGENTX_REGISTER_BATCH 64
+
+static int      _register_batch = 0;
+static int      _register_outstanding = 0;
+static int      _register_failed = 0;
+static struct timeval _register_start;
+
+static int
+agentx_register_response(int op, netsnmp_session * session,
+                         int reqid, netsnmp_pdu *pdu, void *magic)
+{
+    _register_outstanding--;
+    if (op != NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE) {
+        DEBUGMSGTL(("agentx/subagent", "registering failed!\n"));
+        _register_failed++;
+    } else if (pdu->errstat != SNMP_ERR_NOERROR) {
+        snmp_log(LOG_ERR,"registering pdu failed: %ld!\n", pdu->errstat);
+        _register_failed++;
+    }
+    return 1;
+}
+
+/*
+ * Waits for the answers to the registrations sent so far.
+ */
+static int
+agentx_register_wait(netsnmp_session * ss)
+{
+    if (_register_outstanding > 0 && !agentx_send_ping(ss)) {
+        DEBUGMSGTL(("agentx/subagent", "registration batch lost\n"));
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Opens (start != 0) or closes a batch of registrations on session ss.
+ * Closing the batch waits for the master to answer all of them.
+ *
+ * @return when closing, the number of registrations which failed
+ */
+int
+agentx_register_batch(netsnmp_session * ss, int start)
+{
+    int             failed;
+
+    if (start) {
+        _register_batch = 1;
+        _register_outstanding = 0;
+        _register_failed = 0;
+        netsnmp_get_monotonic_clock(&_register_start);
+        return 0;
+    }
+    _register_batch = 0;
+    if (!agentx_register_wait(ss))
+        _register_failed += _register_outstanding;
+    _register_outstanding = 0;
+    failed = _register_failed;
+    _register_failed = 0;
+    DEBUGIF("agentx/subagent") {
+        struct timeval  now, diff;
+
+        netsnmp_get_monotonic_clock(&now);
+        NETSNMP_TIMERSUB(&now, &_register_start, &diff);
+        DEBUGMSGTL(("agentx/subagent",
+                    "registration batch done, %d failed in %ld ms\n",
+                    failed, (long) (diff.tv_sec * 1000 +
+                                    diff.tv_usec / 1000)));
+    }
+    return failed;
+}
+
 int
 agentx_open_session(netsnmp_session * ss)
 {
@@ -207,6 +287,19 @@ agentx_register(netsnmp_session * ss, oid start[], size_t startlen,
         snmp_add_null_var(pdu, start, startlen);
     }
 
+    if (_register_batch) {
+        if (snmp_async_send(ss, pdu, agentx_register_response, NULL) == 0) {
+            snmp_free_pdu(pdu);
+            DEBUGMSGTL(("agentx/subagent", "registering failed!\n"));
+            return 0;
+        }
+        if (++_register_outstanding >= AGENTX_REGISTER_BATCH &&
+            !agentx_register_wait(ss))
+            return 0;
+        DEBUGMSGTL(("agentx/subagent", "registration sent\n"));
+        return 1;
+    }
+
     if (agentx_synch_response(ss, pdu, &response) != STAT_SUCCESS) {
         DEBUGMSGTL(("agentx/subagent", "registering failed!\n"));
         return 0;
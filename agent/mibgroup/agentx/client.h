@@ -16,6 +16,7 @@ extern          "C" {
     int             agentx_close_session(netsnmp_session *, int);
     int             agentx_register(netsnmp_session *, oid *, size_t, int,
                                     int, oid, int, u_char, const char *);
+    int             agentx_register_batch(netsnmp_session *, int);
     int             agentx_unregister(netsnmp_session *, oid *, size_t,
                                       int, int, oid, const char *);
     netsnmp_variable_list *agentx_register_index(netsnmp_session *,
@@ -50,6 +50,7 @@
 #include "snmpd.h"
 #include "agentx/protocol.h"
 #include "agentx/master_admin.h"
+#include "agentx/master.h"
 
 netsnmp_feature_require(handler_mark_requests_as_delegated);
 netsnmp_feature_require(unix_socket_paths);
@@ -203,6 +204,256 @@ real_init_master(void)
     DEBUGMSGTL(("agentx/master", "initializing...   DONE\n"));
 }
 
+/*
+ * A request to a subagent, from being built until its answer is merged
+ * back.  It waits on its session's queue, with its PDU, while the
+ * session's window is full; once sent, it is the callback data of the
+ * PDU, which snmp_async_send() matches to the response by packetID.
+ * cache is NULL for a CleanupSet, which gets no response.
+ */
+typedef struct agentx_master_request_s {
+    netsnmp_delegated_cache *cache;
+    netsnmp_pdu    *pdu;
+    struct timeval  sent;
+    struct agentx_master_request_s *next;
+} agentx_master_request;
+
+/*
+ * requests waiting on the queues of all sessions
+ */
+static u_long   _agentx_queued = 0;
+
+static void
+_agentx_queued_changed(int n)
+{
+    netsnmp_stats_segment *seg = netsnmp_stats_segment_get();
+
+    _agentx_queued += n;
+    if (seg)
+        netsnmp_stats_segment_queue(&seg->agentx_queued, _agentx_queued);
+}
+
+/**
+ * @return the master's state for the subagent connection session,
+ * created on first use, or NULL if it cannot be allocated
+ */
+agentx_master_session *
+agentx_master_session_get(netsnmp_session *session)
+{
+    agentx_master_session *state =
+        (agentx_master_session *) session->myvoid;
+
+    if (state == NULL) {
+        state = SNMP_MALLOC_TYPEDEF(agentx_master_session);
+        if (state == NULL)
+            return NULL;
+        state->cacheid = netsnmp_allocate_globalcacheid();
+        session->myvoid = state;
+    }
+    return state;
+}
+
+/**
+ * Frees the master's state for the subagent connection session.  The
+ * requests still waiting for a window slot are failed with genErr;
+ * those already sent are answered by the session's own timeout or
+ * close.
+ */
+void
+agentx_master_session_free(netsnmp_session *session)
+{
+    agentx_master_session *state =
+        (agentx_master_session *) session->myvoid;
+    agentx_master_request *req;
+    netsnmp_delegated_cache *cache;
+
+    if (state == NULL)
+        return;
+    session->myvoid = NULL;
+
+    DEBUGMSGTL(("agentx/master/stats",
+                "session %8p: %lu sent, %lu timed out, %lu answered in "
+                "%lu us on average, %lu us at most; at most %d outstanding, "
+                "%d queued\n", session, state->sent, state->timeouts,
+                state->latency.count,
+                state->latency.count ?
+                    state->latency.total_usec / state->latency.count : 0,
+                state->latency.max_usec, state->max_outstanding,
+                state->max_queued));
+
+    while ((req = state->queue) != NULL) {
+        state->queue = req->next;
+        cache = netsnmp_handler_check_cache(req->cache);
+        if (cache) {
+            netsnmp_handler_mark_requests_as_delegated(cache->requests,
+                                                   REQUEST_IS_NOT_DELEGATED);
+            netsnmp_set_request_error(cache->reqinfo, cache->requests,
+                                      SNMP_ERR_GENERR);
+        }
+        netsnmp_free_delegated_cache(req->cache);
+        snmp_free_pdu(req->pdu);
+        free(req);
+    }
+    if (state->queued)
+        _agentx_queued_changed(-state->queued);
+    free(state);
+}
+
+/*
+ * Sends a request to the subagent.  Its response (or failure) comes back
+ * through agentx_got_response(), which may already have been called,
+ * and may have closed the session, by the time this returns.
+ */
+static void
+_agentx_send(netsnmp_session *ax_session, agentx_master_request *req)
+{
+    agentx_master_session *state =
+        (agentx_master_session *) ax_session->myvoid;
+    netsnmp_pdu    *pdu = req->pdu;
+    int             result;
+
+    req->pdu = NULL;
+    DEBUGMSGTL(("agentx/master", "sending pdu (req=0x%x,trans=0x%x,sess=0x%x)\n",
+                (unsigned)pdu->reqid, (unsigned)pdu->transid, (unsigned)pdu->sessid));
+    if (req->cache == NULL) {
+        free(req);
+        result = snmp_async_send(ax_session, pdu, NULL, NULL);
+    } else {
+        if (state) {
+            state->sent++;
+            if (++state->outstanding > state->max_outstanding)
+                state->max_outstanding = state->outstanding;
+        }
+        netsnmp_get_monotonic_clock(&req->sent);
+        result = snmp_async_send(ax_session, pdu, agentx_got_response, req);
+    }
+    if (result == 0) {
+        snmp_free_pdu(pdu);
+    }
+}
+
+/*
+ * Sends the requests waiting on the session's queue while its window
+ * has room.
+ */
+static void
+_agentx_send_queued(netsnmp_session *ax_session)
+{
+    agentx_master_session *state;
+    agentx_master_request *req;
+    int             window = netsnmp_ds_get_int(NETSNMP_DS_APPLICATION_ID,
+                                                NETSNMP_DS_AGENT_AGENTX_WINDOW);
+
+    while ((state = (agentx_master_session *) ax_session->myvoid) &&
+           (req = state->queue) != NULL &&
+           (window <= 0 || state->outstanding < window)) {
+        state->queue = req->next;
+        if (state->queue == NULL)
+            state->queue_end = NULL;
+        state->queued--;
+        _agentx_queued_changed(-1);
+        if (req->cache && !netsnmp_handler_check_cache(req->cache)) {
+            /*
+             * the request it was for has gone while it waited
+             */
+            netsnmp_free_delegated_cache(req->cache);
+            snmp_free_pdu(req->pdu);
+            free(req);
+            continue;
+        }
+        _agentx_send(ax_session, req);
+    }
+}
+
+/*
+ * Accounts for the end of a request which was sent, successfully or not,
+ * and frees it.
+ */
+static void
+_agentx_request_done(netsnmp_session *ax_session,
+                     agentx_master_request *req, int ok)
+{
+    agentx_master_session *state =
+        (agentx_master_session *) ax_session->myvoid;
+    struct timeval  now, diff;
+    u_long          usec;
+
+    netsnmp_get_monotonic_clock(&now);
+    NETSNMP_TIMERSUB(&now, &req->sent, &diff);
+    usec = diff.tv_sec * 1000000 + diff.tv_usec;
+    netsnmp_stats_segment_agentx(usec, ok);
+    if (state) {
+        if (state->outstanding > 0)
+            state->outstanding--;
+        if (ok)
+            netsnmp_stats_hist_add(&state->latency, usec);
+        else
+            state->timeouts++;
+    }
+    free(req);
+}
+
+/*
+ * Merges the answer to an AgentX GetBulk into the requests it was sent
+ * for.  The varbinds come one repetition after another, with one varbind
+ * for each request in every repetition (the last repetition may be cut
+ * short).  A request takes its repetitions in turn until it has no
+ * repeats left, an answer falls outside its search range or the
+ * subagent runs out of values for it.
+ *
+ * @return 0 if there are fewer varbinds than requests
+ */
+static int
+_agentx_merge_bulk(netsnmp_request_info *requests,
+                   netsnmp_variable_list *vars)
+{
+    netsnmp_request_info *request;
+    netsnmp_variable_list *var, *column;
+    int             nreq = 0, nvar = 0, first, i;
+
+    for (request = requests; request; request = request->next)
+        nreq++;
+    for (var = vars; var; var = var->next_variable)
+        nvar++;
+    if (nvar < nreq)
+        return 0;
+
+    for (request = requests, column = vars; request;
+         request = request->next, column = column->next_variable) {
+        request->delegated = REQUEST_IS_NOT_DELEGATED;
+        for (var = column, first = 1; var; first = 0) {
+            DEBUGMSGTL(("agentx/master", "  bulk response for %d: ",
+                        request->index));
+            DEBUGMSGOID(("agentx/master", var->name, var->name_length));
+            DEBUGMSG(("agentx/master", "\n"));
+
+            if (var->type == SNMP_ENDOFMIBVIEW) {
+                /*
+                 * nothing more in this subagent: a request which has
+                 * moved on to a new repetition carries on in the next
+                 * subtree, rather than asking the subagent again
+                 */
+                if (!first)
+                    request->requestvb->type = ASN_NULL;
+                break;
+            }
+            snmp_set_var_typed_value(request->requestvb, var->type,
+                                     var->val.string, var->val_len);
+            snmp_set_var_objid(request->requestvb, var->name,
+                               var->name_length);
+
+            /*
+             * move on to the request's next repetition, if it has one
+             */
+            if (!netsnmp_bulk_to_next_fix_request(request))
+                break;
+            for (i = 0; var && i < nreq; i++)
+                var = var->next_variable;
+        }
+    }
+    return 1;
+}
+
         /*
          * Handle the response from an AgentX subagent,
          *   merging the answers back into the original query
@@ -212,12 +463,29 @@ agentx_got_response(int operation,
                     netsnmp_session * session,
                     int reqid, netsnmp_pdu *pdu, void *magic)
 {
-    netsnmp_delegated_cache *cache = (netsnmp_delegated_cache *) magic;
+    agentx_master_request *req = (agentx_master_request *) magic;
+    netsnmp_delegated_cache *cache;
     int             i, ret;
     netsnmp_request_info *requests, *request;
     netsnmp_variable_list *var;
     netsnmp_session *ax_session;
 
+    if (!req)
+        return 1;
+    if (operation == NETSNMP_CALLBACK_OP_RESEND) {
+        DEBUGMSGTL(("agentx/master", "resend on session %8p req=0x%x\n",
+                    session, (unsigned)reqid));
+        return 0;
+    }
+
+    /*
+     * the request no longer holds a slot in the session's window
+     */
+    cache = req->cache;
+    _agentx_request_done(session, req,
+                         operation == NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE);
+
+    magic = cache;
     cache = netsnmp_handler_check_cache(cache);
     if (!cache) {
         DEBUGMSGTL(("agentx/master", "response too late on session %8p\n",
@@ -225,6 +493,8 @@ agentx_got_response(int operation,
         /* response is too late, free the cache */
         if (magic)
             netsnmp_free_delegated_cache((netsnmp_delegated_cache*) magic);
+        if (operation == NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE)
+            _agentx_send_queued(session);
         return 1;
     }
     requests = cache->requests;
@@ -254,7 +524,7 @@ agentx_got_response(int operation,
 
                 if (t != NULL) {
                     DEBUGMSGTL(("agentx/master", "close transport\n"));
-                    t->f_close(t);
+                    snmp_sess_transport_close(s);
                 } else {
                     DEBUGMSGTL(("agentx/master", "NULL transport??\n"));
                 }
@@ -284,11 +554,6 @@ agentx_got_response(int operation,
         netsnmp_free_delegated_cache(cache);
         return 0;
 
-    case NETSNMP_CALLBACK_OP_RESEND:
-        DEBUGMSGTL(("agentx/master", "resend on session %8p req=0x%x\n",
-                    session, (unsigned)reqid));
-        return 0;
-
     case NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE:
         /*
          * This session is alive 
@@ -363,10 +628,21 @@ agentx_got_response(int operation,
         }
         netsnmp_free_delegated_cache(cache);
         DEBUGMSGTL(("agentx/master", "end error branch\n"));
+        _agentx_send_queued(session);
         return 1;
+    } else if (cache->reqinfo->mode == MODE_GETBULK) {
+        DEBUGMSGTL(("agentx/master",
+                    "agentx_got_response() merging bulk response\n"));
+        if (!_agentx_merge_bulk(requests, pdu->variables)) {
+            snmp_log(LOG_ERR,
+                     "response to agentx request illegal.  bailing out.\n");
+            netsnmp_handler_mark_requests_as_delegated(requests,
+                                                       REQUEST_IS_NOT_DELEGATED);
+            netsnmp_set_request_error(cache->reqinfo, requests,
+                                      SNMP_ERR_GENERR);
+        }
     } else if (cache->reqinfo->mode == MODE_GET ||
-               cache->reqinfo->mode == MODE_GETNEXT ||
-               cache->reqinfo->mode == MODE_GETBULK) {
+               cache->reqinfo->mode == MODE_GETNEXT) {
         /*
          * Replace varbinds for data request types, but not SETs.  
          */
@@ -409,9 +685,6 @@ agentx_got_response(int operation,
             netsnmp_set_request_error(cache->reqinfo, requests,
                                       SNMP_ERR_GENERR);
         }
-
-        if (cache->reqinfo->mode == MODE_GETBULK)
-            netsnmp_bulk_to_next_fix_requests(requests);
     } else {
         /*
          * mark set requests as handled 
@@ -423,6 +696,7 @@ agentx_got_response(int operation,
     DEBUGMSGTL(("agentx/master",
                 "handle_agentx_response() finishing...\n"));
     netsnmp_free_delegated_cache(cache);
+    _agentx_send_queued(session);
     return 1;
 }
 
@@ -448,8 +722,9 @@ agentx_master_handler(netsnmp_mib_handler *handler,
     netsnmp_session *ax_session = (netsnmp_session *) handler->myvoid;
     netsnmp_request_info *request = requests;
     netsnmp_pdu    *pdu;
-    void           *cb_data;
-    int             result;
+    agentx_master_session *state;
+    agentx_master_request *req;
+    int             window, repeats = 0;
 
     DEBUGMSGTL(("agentx/master",
                 "agentx master handler starting, mode = 0x%02x\n",
@@ -472,8 +747,30 @@ agentx_master_handler(netsnmp_mib_handler *handler,
         pdu = snmp_pdu_create(AGENTX_MSG_GETNEXT);
         break;
 
-    case MODE_GETBULK:         /* WWWXXX */
-        pdu = snmp_pdu_create(AGENTX_MSG_GETNEXT);
+    case MODE_GETBULK:
+        /*
+         * Ask for as many repetitions as the request with the most
+         * repeats left still wants; the others ignore what they do
+         * not need.  The search range of each varbind keeps the
+         * subagent within this registration.  With no repeats left
+         * anywhere, a GetNext does the same job.
+         */
+        for (request = requests; request; request = request->next)
+            if (request->repeat > repeats)
+                repeats = request->repeat;
+        if (repeats > 0xfffe)
+            repeats = 0xfffe;
+        if (repeats > 0) {
+            pdu = snmp_pdu_create(AGENTX_MSG_GETBULK);
+            if (pdu) {
+                pdu->non_repeaters = 0;
+                pdu->max_repetitions = repeats + 1;
+            }
+            DEBUGMSGTL(("agentx/master", "getbulk, %d repetitions\n",
+                        repeats + 1));
+        } else
+            pdu = snmp_pdu_create(AGENTX_MSG_GETNEXT);
+        request = requests;
         break;
 
 #ifndef NETSNMP_NO_WRITE_SUPPORT
@@ -517,6 +814,13 @@ agentx_master_handler(netsnmp_mib_handler *handler,
     pdu->reqid = snmp_get_next_transid();
     pdu->transid = reqinfo->asp->pdu->transid;
     pdu->sessid = ax_session->subsession->sessid;
+    if (reginfo->timeout > 0) {
+        /*
+         * the subagent's own timeout, in seconds, rather than agentxTimeout
+         */
+        pdu->time = reginfo->timeout;
+        pdu->flags |= UCD_MSG_FLAG_PDU_TIMEOUT;
+    }
     if (reginfo->contextName) {
         pdu->community = (u_char *) strdup(reginfo->contextName);
         pdu->community_len = strlen(reginfo->contextName);
@@ -597,27 +901,48 @@ agentx_master_handler(netsnmp_mib_handler *handler,
         request = request->next;
     }
 
+    req = SNMP_MALLOC_TYPEDEF(agentx_master_request);
+    if (!req) {
+        snmp_free_pdu(pdu);
+        netsnmp_handler_mark_requests_as_delegated(requests,
+                                                   REQUEST_IS_NOT_DELEGATED);
+        netsnmp_set_request_error(reqinfo, requests, SNMP_ERR_GENERR);
+        return SNMP_ERR_NOERROR;
+    }
+    req->pdu = pdu;
+
     /*
      * When the master sends a CleanupSet PDU, it will never get a response
      * back from the subagent. So we shouldn't allocate the
      * netsnmp_delegated_cache structure in this case.
      */
     if (pdu->command != AGENTX_MSG_CLEANUPSET)
-        cb_data = netsnmp_create_delegated_cache(handler, reginfo,
-                                                 reqinfo, requests,
-                                                 (void *) ax_session);
-    else
-        cb_data = NULL;
+        req->cache = netsnmp_create_delegated_cache(handler, reginfo,
+                                                    reqinfo, requests,
+                                                    (void *) ax_session);
 
     /*
-     * send the requests out.
+     * Send the request out, unless the subagent already has a window
+     * full of them: then it waits behind any others already waiting,
+     * which keeps the phases of a SET in order.
      */
-    DEBUGMSGTL(("agentx/master", "sending pdu (req=0x%x,trans=0x%x,sess=0x%x)\n",
-                (unsigned)pdu->reqid, (unsigned)pdu->transid, (unsigned)pdu->sessid));
-    result = snmp_async_send(ax_session, pdu, agentx_got_response, cb_data);
-    if (result == 0) {
-        snmp_free_pdu(pdu);
-    }
+    state = (agentx_master_session *) ax_session->myvoid;
+    window = netsnmp_ds_get_int(NETSNMP_DS_APPLICATION_ID,
+                                NETSNMP_DS_AGENT_AGENTX_WINDOW);
+    if (state && (state->queue ||
+                  (window > 0 && state->outstanding >= window))) {
+        DEBUGMSGTL(("agentx/master", "queueing pdu (req=0x%x), %d outstanding\n",
+                    (unsigned)pdu->reqid, state->outstanding));
+        if (state->queue_end)
+            state->queue_end->next = req;
+        else
+            state->queue = req;
+        state->queue_end = req;
+        if (++state->queued > state->max_queued)
+            state->max_queued = state->queued;
+        _agentx_queued_changed(1);
+    } else
+        _agentx_send(ax_session, req);
 
     return SNMP_ERR_NOERROR;
 }
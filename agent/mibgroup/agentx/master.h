@@ -7,8 +7,33 @@ config_require(agentx/protocol)
 config_require(agentx/master_admin)
 config_require(agentx/agentx_config)
 
+/*
+ * The master's state for one subagent connection, kept in the
+ * transport session's myvoid.  At most agentxWindow requests are
+ * outstanding at once; later ones wait on the queue, in order.
+ */
+typedef struct agentx_master_session_s {
+    int             cacheid;
+    int             outstanding;
+    int             queued;
+    struct agentx_master_request_s *queue, *queue_end;
+
+    /*
+     * statistics
+     */
+    u_long          sent;
+    u_long          timeouts;
+    int             max_outstanding;
+    int             max_queued;
+    netsnmp_stats_hist latency;
+} agentx_master_session;
+
      void            init_master(void);
      void            real_init_master(void);
      Netsnmp_Node_Handler agentx_master_handler;
+     int             agentx_got_response(int, netsnmp_session *, int,
+                                         netsnmp_pdu *, void *);
+     agentx_master_session *agentx_master_session_get(netsnmp_session *);
+     void            agentx_master_session_free(netsnmp_session *);
 
 #endif                          /* _AGENTX_MASTER_H */
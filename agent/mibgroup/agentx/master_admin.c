@@ -152,7 +152,7 @@ close_agentx_session(netsnmp_session * session, int sessid)
         unregister_mibs_by_session(session);
         unregister_index_by_session(session);
         unregister_sysORTable_by_session(session);
-	SNMP_FREE(session->myvoid);
+        agentx_master_session_free(session);
         return AGENTX_ERR_NOERROR;
     }
 
@@ -197,8 +197,8 @@ register_agentx_list(netsnmp_session * session, netsnmp_pdu *pdu)
     oid             ubound = 0;
     u_long          flags = 0;
     netsnmp_handler_registration *reg;
+    agentx_master_session *state;
     int             rc = 0;
-    int             cacheid;
 
     DEBUGMSGTL(("agentx/master", "in register_agentx_list\n"));
 
@@ -209,8 +209,7 @@ register_agentx_list(netsnmp_session * session, netsnmp_pdu *pdu)
     sprintf(buf, "AgentX subagent %ld, session %8p, subsession %8p",
             sp->sessid, session, sp);
     /*
-     * * TODO: registration timeout
-     * *   registration context
+     * * TODO: registration context
      */
     if (pdu->range_subid) {
         ubound = pdu->variables->val.objid[pdu->range_subid - 1];
@@ -220,17 +219,17 @@ register_agentx_list(netsnmp_session * session, netsnmp_pdu *pdu)
         flags = FULLY_QUALIFIED_INSTANCE;
     }
 
-    reg = netsnmp_create_handler_registration(buf, agentx_master_handler, pdu->variables->name, pdu->variables->name_length, HANDLER_CAN_RWRITE | HANDLER_CAN_GETBULK); /* fake it */
-    if (!session->myvoid) {
-        session->myvoid = malloc(sizeof(cacheid));
-        cacheid = netsnmp_allocate_globalcacheid();
-        *((int *) session->myvoid) = cacheid;
-    } else {
-        cacheid = *((int *) session->myvoid);
-    }
+    state = agentx_master_session_get(session);
+    if (state == NULL)
+        return AGENTX_ERR_PROCESSING_ERROR;
 
+    reg = netsnmp_create_handler_registration(buf, agentx_master_handler, pdu->variables->name, pdu->variables->name_length, HANDLER_CAN_RWRITE | HANDLER_CAN_GETBULK); /* fake it */
     reg->handler->myvoid = session;
-    reg->global_cacheid = cacheid;
+    reg->global_cacheid = state->cacheid;
+    /*
+     * the registration's timeout, else the session's [RFC 2741 6.2.3]
+     */
+    reg->timeout = pdu->time ? pdu->time : sp->timeout;
     if (NULL != pdu->community)
         reg->contextName = strdup((char *)pdu->community);
 
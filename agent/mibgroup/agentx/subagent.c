@@ -75,6 +75,7 @@ typedef struct _net_snmpsubagent_magic_s {
     int             original_command;
     netsnmp_session *session;
     netsnmp_variable_list *ovars;
+    long            non_repeaters;      /* of a GetBulk */
 } ns_subagent_magic;
 
 struct agent_netsnmp_set_info {
@@ -382,9 +383,6 @@ handle_agentx_packet(int operation, netsnmp_session * session, int reqid,
         break;
 
     case AGENTX_MSG_GETBULK:
-        /*
-         * WWWXXX 
-         */
         DEBUGMSGTL(("agentx/subagent", "  -> getbulk\n"));
         pdu->command = SNMP_MSG_GETBULK;
 
@@ -395,6 +393,7 @@ handle_agentx_packet(int operation, netsnmp_session * session, int reqid,
          */
 
         smagic->ovars = snmp_clone_varbind(pdu->variables);
+        smagic->non_repeaters = pdu->non_repeaters;
         DEBUGMSGTL(("agentx/subagent", "saved variables at %p\n",
                     smagic->ovars));
         mycallback = handle_subagent_response;
@@ -536,13 +535,106 @@ _invalid_op_and_magic(int op, ns_subagent_magic *smagic)
     return invalid;
 }
 
+/*
+ * The master agent may have limited the search for u to a range (the end
+ * of which is u's value).  If the answer v is at or beyond the end, it
+ * is out of scope.  From RFC2741, p. 66: "If the subagent cannot locate
+ * an appropriate variable, v.name is set to the starting OID, and the
+ * VarBind is set to `endOfMibView'".
+ *
+ * Returns 1 if v is (now) endOfMibView.
+ */
+static int
+_subagent_scope_var(netsnmp_variable_list *u, netsnmp_variable_list *v,
+                    const oid *start, size_t start_len)
+{
+    int             rc;
+
+    if (v->type == SNMP_ENDOFMIBVIEW)
+        return 1;
+    if (snmp_oid_compare(u->val.objid, u->val_len / sizeof(oid), nullOid,
+                         nullOidLen / sizeof(oid)) == 0) {
+        DEBUGMSGTL(("agentx/subagent", "unscoped var\n"));
+        return 0;
+    }
+
+    rc = snmp_oid_compare(v->name, v->name_length,
+                          u->val.objid, u->val_len / sizeof(oid));
+    DEBUGMSGTL(("agentx/subagent", "result "));
+    DEBUGMSGOID(("agentx/subagent", v->name, v->name_length));
+    DEBUGMSG(("agentx/subagent", " scope to "));
+    DEBUGMSGOID(("agentx/subagent", u->val.objid, u->val_len / sizeof(oid)));
+    DEBUGMSG(("agentx/subagent", " result %d\n", rc));
+    if (rc < 0)
+        return 0;
+
+    snmp_set_var_objid(v, start, start_len);
+    snmp_set_var_typed_value(v, SNMP_ENDOFMIBVIEW, NULL, 0);
+    DEBUGMSGTL(("agentx/subagent", "scope violation -- return endOfMibView\n"));
+    return 1;
+}
+
+/*
+ * Scopes the answer to a GetBulk.  The non-repeaters are answered first,
+ * then the repeaters one repetition after another.  A repetition starts
+ * from the answer to the one before, so that is what it is named after
+ * if it is out of scope; once a repeater has run out of scope, every
+ * later repetition of it is endOfMibView too.  Nothing follows the first
+ * repetition which is entirely endOfMibView.
+ */
+static void
+_subagent_scope_bulk(ns_subagent_magic *smagic, netsnmp_pdu *pdu)
+{
+    netsnmp_variable_list *u, *v, *repeaters, *first, *back = NULL;
+    int             i, r = 0, all_ended = 1;
+
+    for (i = 0, u = smagic->ovars, v = pdu->variables;
+         i < smagic->non_repeaters && u && v;
+         i++, u = u->next_variable, v = v->next_variable)
+        _subagent_scope_var(u, v, u->name, u->name_length);
+
+    for (repeaters = u; u; u = u->next_variable)
+        r++;
+    if (0 == r)
+        return;
+
+    for (i = 0, u = repeaters, first = v; v; i++, v = v->next_variable) {
+        if (i >= r)
+            back = back ? back->next_variable : first;
+
+        if (back && back->type == SNMP_ENDOFMIBVIEW) {
+            snmp_set_var_objid(v, back->name, back->name_length);
+            snmp_set_var_typed_value(v, SNMP_ENDOFMIBVIEW, NULL, 0);
+        } else if (!_subagent_scope_var(u, v,
+                                        back ? back->name : u->name,
+                                        back ? back->name_length :
+                                        u->name_length))
+            all_ended = 0;
+
+        u = u->next_variable;
+        if (NULL == u) {
+            /*
+             * the end of a repetition
+             */
+            if (all_ended && v->next_variable) {
+                DEBUGMSGTL(("agentx/subagent",
+                            "repetition %d ended every repeater\n", i / r));
+                snmp_free_varbind(v->next_variable);
+                v->next_variable = NULL;
+                break;
+            }
+            u = repeaters;
+            all_ended = 1;
+        }
+    }
+}
+
 int
 handle_subagent_response(int op, netsnmp_session * session, int reqid,
                          netsnmp_pdu *pdu, void *magic)
 {
     ns_subagent_magic *smagic = (ns_subagent_magic *) magic;
     netsnmp_variable_list *u = NULL, *v = NULL;
-    int             rc = 0;
 
     if (_invalid_op_and_magic(op, magic)) {
         return 1;
@@ -569,46 +661,15 @@ handle_subagent_response(int op, netsnmp_session * session, int reqid,
                     "do getNext scope processing %p %p\n", smagic->ovars,
                     pdu->variables));
         for (u = smagic->ovars, v = pdu->variables; u != NULL && v != NULL;
-             u = u->next_variable, v = v->next_variable) {
-            if (snmp_oid_compare
-                (u->val.objid, u->val_len / sizeof(oid), nullOid,
-                 nullOidLen/sizeof(oid)) != 0) {
-                /*
-                 * The master agent requested scoping for this variable.  
-                 */
-                rc = snmp_oid_compare(v->name, v->name_length,
-                                      u->val.objid,
-                                      u->val_len / sizeof(oid));
-                DEBUGMSGTL(("agentx/subagent", "result "));
-                DEBUGMSGOID(("agentx/subagent", v->name, v->name_length));
-                DEBUGMSG(("agentx/subagent", " scope to "));
-                DEBUGMSGOID(("agentx/subagent",
-                             u->val.objid, u->val_len / sizeof(oid)));
-                DEBUGMSG(("agentx/subagent", " result %d\n", rc));
-
-                if (rc >= 0) {
-                    /*
-                     * The varbind is out of scope.  From RFC2741, p. 66: "If
-                     * the subagent cannot locate an appropriate variable,
-                     * v.name is set to the starting OID, and the VarBind is
-                     * set to `endOfMibView'".  
-                     */
-                    snmp_set_var_objid(v, u->name, u->name_length);
-                    snmp_set_var_typed_value(v, SNMP_ENDOFMIBVIEW, NULL, 0);
-                    DEBUGMSGTL(("agentx/subagent",
-                                "scope violation -- return endOfMibView\n"));
-                }
-            } else {
-                DEBUGMSGTL(("agentx/subagent", "unscoped var\n"));
-            }
-        }
+             u = u->next_variable, v = v->next_variable)
+            _subagent_scope_var(u, v, u->name, u->name_length);
+    } else if (smagic->original_command == AGENTX_MSG_GETBULK) {
+        DEBUGMSGTL(("agentx/subagent",
+                    "do getBulk scope processing %p %p\n", smagic->ovars,
+                    pdu->variables));
+        _subagent_scope_bulk(smagic, pdu);
     }
 
-    /*
-     * XXXJBPN: similar for GETBULK but the varbinds can get re-ordered I
-     * think which makes it er more difficult.  
-     */
-
     if (smagic->ovars != NULL) {
         snmp_free_varbind(smagic->ovars);
     }
@@ -962,9 +1023,12 @@ agentx_reopen_session(unsigned int clientreg, void *clientarg)
         }
 
         /*
-         * Reregister all our nodes.  
+         * Reregister all our nodes, without waiting for the master to
+         * answer each one in turn.
          */
+        agentx_register_batch(main_session, 1);
         register_mib_reattach();
+        agentx_register_batch(main_session, 0);
 
         /*
          * Reregister all our sysOREntries
@@ -49,7 +49,8 @@ init_schedTable(void)
                                             schedTable_handler,
                                             schedTable_oid,
                                             schedTable_oid_len,
-                                            HANDLER_CAN_RWRITE);
+                                            HANDLER_CAN_RWRITE |
+                                            HANDLER_CAN_GETBULK);
 
     table_info = SNMP_MALLOC_TYPEDEF(netsnmp_table_registration_info);
     netsnmp_table_helper_add_indexes(table_info,
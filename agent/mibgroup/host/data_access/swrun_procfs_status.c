@@ -23,6 +23,17 @@
 #ifdef HAVE_LINUX_TASKS_H
 #include <linux/tasks.h>
 #endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#include <errno.h>
+#if defined(HAVE_LINUX_CONNECTOR_H) && defined(HAVE_LINUX_CN_PROC_H)
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+#define NETSNMP_SWRUN_PROC_EVENTS 1
+#endif
 
 #include <net-snmp/net-snmp-includes.h>
 #include <net-snmp/agent/net-snmp-agent-includes.h>
@@ -30,9 +41,34 @@
 #include <net-snmp/library/snmp_debug.h>
 #include <net-snmp/data_access/swrun.h>
 #include "swrun_private.h"
+#include "swrun.h"
 
 static long pagesize;
 static long sc_clk_tck;
+static u_int generation;
+
+#ifdef NETSNMP_SWRUN_PROC_EVENTS
+/*
+ * proc connector socket, or -1 when events are not available
+ * (they need CAP_NET_ADMIN)
+ */
+static int _proc_events = -1;
+static int _proc_events_lost = 0;
+
+static void _proc_events_open(void);
+static void _proc_events_read(netsnmp_container *container);
+#endif
+
+/*
+ * the fields of /proc/{pid}/stat used here
+ */
+typedef struct _swrun_stat_s {
+    char                comm[sizeof(((netsnmp_swrun_entry *)0)->hrSWRunName)];
+    char                state;
+    unsigned long       utime, stime;
+    unsigned long long  starttime;
+    long                rss;
+} _swrun_stat;
 
 /* ---------------------------------------------------------------------
  */
@@ -42,24 +78,176 @@ netsnmp_arch_swrun_init(void)
 #ifdef HAVE_LINUX_TASKS_H
     extern int _swrun_max = NR_TASKS;   /* from <linux/tasks.h> */
 #endif
+    netsnmp_cache *cache;
     
     pagesize = getpagesize();
     sc_clk_tck = sysconf(_SC_CLK_TCK);
+
+    /*
+     * rows are updated in place, so keep them across reloads
+     */
+    cache = netsnmp_swrun_cache();
+    if (cache)
+        cache->flags |= NETSNMP_CACHE_DONT_FREE_BEFORE_LOAD |
+                        NETSNMP_CACHE_DONT_FREE_EXPIRED;
+
+#ifdef NETSNMP_SWRUN_PROC_EVENTS
+    _proc_events_open();
+#endif
     return;
 }
 
+/**
+ * @internal
+ * read and split /proc/{pid}/stat
+ *
+ *   PID (COMM) STATUS  {xxx}*10  UTIME STIME  {xxx}*6 STARTTIME {xxx} RSS
+ *
+ * @retval  0 success
+ * @retval -1 the process probably went away
+ */
+static int
+_swrun_stat_get(int pid, _swrun_stat *st)
+{
+    char                buf[BUFSIZ], *cp, *cp1;
+    int                 fd, len;
+    size_t              comm_len;
+
+    snprintf(buf, sizeof(buf), "/proc/%d/stat", pid);
+    fd = open(buf, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0)
+        return -1;
+    buf[len] = '\0';
+
+    /*
+     * the name may itself contain ')', so look for the last one
+     */
+    cp = strchr(buf, '(');
+    cp1 = strrchr(buf, ')');
+    if (NULL == cp || NULL == cp1 || cp1 < cp)
+        return -1;
+    comm_len = cp1 - (cp + 1);
+    if (comm_len >= sizeof(st->comm))
+        comm_len = sizeof(st->comm) - 1;
+    memcpy(st->comm, cp + 1, comm_len);
+    st->comm[comm_len] = '\0';
+
+    if (5 != sscanf(cp1 + 2,
+                    "%c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu"
+                    " %*d %*d %*d %*d %*d %*d %llu %*u %ld",
+                    &st->state, &st->utime, &st->stime, &st->starttime,
+                    &st->rss))
+        return -1;
+
+    return 0;
+}
+
+/**
+ * @internal
+ * fill in the columns that only change when the process execs:
+ * name, path, parameters and type
+ *
+ * @retval  0 success
+ * @retval -1 the process probably went away
+ */
+static int
+_swrun_identity_get(netsnmp_swrun_entry *entry, const _swrun_stat *st)
+{
+    FILE                *fp;
+    char                 buf[BUFSIZ], buf2[BUFSIZ], *cp;
+    int                  ret;
+
+    /*
+     *   Name:  process name, as in /proc/{PID}/status
+     */
+    entry->hrSWRunName_len = snprintf(entry->hrSWRunName,
+                               sizeof(entry->hrSWRunName)-1, "%s", st->comm);
+
+    /*
+     *  Command Line:
+     *     argv[0] '\0' argv[1] '\0' ....
+     */
+    snprintf( buf2, BUFSIZ, "/proc/%d/cmdline", (int)entry->hrSWRunIndex );
+    fp = fopen( buf2, "r" );
+    if (!fp)
+        return -1; /* file (process) probably went away */
+    entry->hrSWRunType = HRSWRUNTYPE_APPLICATION;
+    memset(buf, 0, sizeof(buf));
+    cp = fgets( buf, BUFSIZ-1, fp );
+    fclose(fp);
+    if (cp != NULL) {
+        /*
+         *     argv[0]   is hrSWRunPath
+         */
+        ret = snprintf(entry->hrSWRunPath, sizeof(entry->hrSWRunPath),
+                       "%s", buf);
+
+        if (ret < sizeof(entry->hrSWRunPath))
+            entry->hrSWRunPath_len = ret;
+        else
+            entry->hrSWRunPath_len = sizeof(entry->hrSWRunPath) - 1;
+
+        /*
+         * Stitch together argv[1..] to construct hrSWRunParameters
+         */
+        for (cp = buf + ret; ! (*cp == '\0' && *(cp + 1) == '\0'); cp++)
+                if (*cp == '\0')
+                        *cp = ' ';
+
+        entry->hrSWRunParameters_len
+            = sprintf(entry->hrSWRunParameters, "%.*s",
+                      (int)sizeof(entry->hrSWRunParameters) - 1,
+                      buf + ret + 1);
+    } else {
+        /* empty /proc/PID/cmdline, it's probably a kernel thread */
+        entry->hrSWRunPath[0] = '\0';
+        entry->hrSWRunPath_len = 0;
+        entry->hrSWRunParameters[0] = '\0';
+        entry->hrSWRunParameters_len = 0;
+        entry->hrSWRunType = HRSWRUNTYPE_OPERATINGSYSTEM;
+    }
+
+    entry->start_time = st->starttime;
+    return 0;
+}
+
+typedef struct {
+    u_int               generation;
+    netsnmp_container  *to_delete;
+} _collect_ctx;
+
+/**
+ * @internal
+ * put rows not seen by this load on the deletion list
+ */
+static void
+_collect_gone(netsnmp_swrun_entry *entry, _collect_ctx *gc)
+{
+    if (entry->generation != gc->generation)
+        CONTAINER_INSERT(gc->to_delete, entry);
+}
+
 /* ---------------------------------------------------------------------
+ *
+ * The container is kept from one load to the next. A process which is
+ * still there with the same start time and name only has its status
+ * and perf columns refreshed from /proc/{PID}/stat; cmdline is read for
+ * new processes and ones which exec'd. Rows of processes which are gone
+ * are removed at the end.
  */
 int
 netsnmp_arch_swrun_container_load( netsnmp_container *container, u_int flags)
 {
     DIR                 *procdir = NULL;
     struct dirent       *procentry_p;
-    FILE                *fp;
-    int                  pid, i, ret;
-    unsigned long long   cpu;
-    char                 buf[BUFSIZ], buf2[BUFSIZ], *cp, *cp1;
+    int                  pid, created, reread = 0;
+    _swrun_stat          st;
     netsnmp_swrun_entry *entry;
+    _collect_ctx         gc;
     
     procdir = opendir("/proc");
     if ( NULL == procdir ) {
@@ -67,6 +255,11 @@ netsnmp_arch_swrun_container_load( netsnmp_container *container, u_int flags)
         return -1;
     }
 
+#ifdef NETSNMP_SWRUN_PROC_EVENTS
+    _proc_events_read(container);
+#endif
+    ++generation;
+
     /*
      * Walk through the list of processes in the /proc tree
      */
@@ -75,114 +268,33 @@ netsnmp_arch_swrun_container_load( netsnmp_container *container, u_int flags)
         if ( 0 == pid )
             continue;   /* Presumably '.' or '..' */
 
-        entry = netsnmp_swrun_entry_create(pid);
-        if (NULL == entry)
-            continue;   /* error already logged by function */
-
-        /*
-         * Now extract the interesting information
-         *   from the various /proc{PID}/ interface files
-         */
+        if (_swrun_stat_get(pid, &st) < 0)
+            continue;   /* process probably went away */
 
-        /*
-         *   Name:  process name
-         */
-        snprintf( buf2, BUFSIZ, "/proc/%d/status", pid );
-        fp = fopen( buf2, "r" );
-        if (!fp) {
-            netsnmp_swrun_entry_free(entry);
-            continue; /* file (process) probably went away */
-	}
-        memset(buf, 0, sizeof(buf));
-        if (fgets( buf, BUFSIZ-1, fp ) == NULL) {
-            fclose(fp);
-            netsnmp_swrun_entry_free(entry);
-            continue;
-        }
-        fclose(fp);
-
-        for ( cp = buf; *cp != ':'; cp++ )
-            ;
-        while (isspace(*(++cp)))	/* Skip ':' and following spaces */
-            ;
-        entry->hrSWRunName_len = snprintf(entry->hrSWRunName,
-                                   sizeof(entry->hrSWRunName)-1, "%s", cp);
-        if ( '\n' == entry->hrSWRunName[ entry->hrSWRunName_len-1 ]) {
-            entry->hrSWRunName[ entry->hrSWRunName_len-1 ] = '\0';
-            entry->hrSWRunName_len--;           /* Stamp on trailing newline */
+        created = 0;
+        entry = netsnmp_swrun_entry_get_by_index(container, pid);
+        if (NULL == entry) {
+            entry = netsnmp_swrun_entry_create(pid);
+            if (NULL == entry)
+                continue;   /* error already logged by function */
+            created = 1;
         }
 
         /*
-         *  Command Line:
-         *     argv[0] '\0' argv[1] '\0' ....
+         * a different start time means the pid was reused; a different
+         * name means an exec. Either way, reread the whole row.
          */
-        snprintf( buf2, BUFSIZ, "/proc/%d/cmdline", pid );
-        fp = fopen( buf2, "r" );
-        if (!fp) {
-            netsnmp_swrun_entry_free(entry);
-            continue; /* file (process) probably went away */
+        if (created || entry->start_time != st.starttime ||
+            0 != strcmp(entry->hrSWRunName, st.comm)) {
+            ++reread;
+            if (_swrun_identity_get(entry, &st) < 0) {
+                if (created)
+                    netsnmp_swrun_entry_free(entry);
+                continue; /* the row of a vanished process is swept below */
+            }
         }
-        entry->hrSWRunType = HRSWRUNTYPE_APPLICATION;
-        memset(buf, 0, sizeof(buf));
-        cp = fgets( buf, BUFSIZ-1, fp );
-        fclose(fp);
-        if (cp != NULL) {
-            /*
-             *     argv[0]   is hrSWRunPath
-             */
-            ret = snprintf(entry->hrSWRunPath, sizeof(entry->hrSWRunPath),
-                           "%s", buf);
-
-            if (ret < sizeof(entry->hrSWRunPath))
-                entry->hrSWRunPath_len = ret;
-            else
-                entry->hrSWRunPath_len = sizeof(entry->hrSWRunPath) - 1;
-
-            /*
-             * Stitch together argv[1..] to construct hrSWRunParameters
-             */
-            for (cp = buf + ret; ! (*cp == '\0' && *(cp + 1) == '\0'); cp++)
-                    if (*cp == '\0')
-                            *cp = ' ';
-
-            entry->hrSWRunParameters_len
-                = sprintf(entry->hrSWRunParameters, "%.*s",
-                          (int)sizeof(entry->hrSWRunParameters) - 1,
-                          buf + ret + 1);
-        } else {
-            /* empty /proc/PID/cmdline, it's probably a kernel thread */
-            entry->hrSWRunPath_len = 0;
-            entry->hrSWRunParameters_len = 0;
-            entry->hrSWRunType = HRSWRUNTYPE_OPERATINGSYSTEM;
-        }
-
-        /*
-         *   {xxx} {xxx} STATUS  {xxx}*10  UTIME STIME  {xxx}*8 RSS
-         */
-        snprintf( buf, BUFSIZ, "/proc/%d/stat", pid );
-        fp = fopen( buf, "r" );
-        if (!fp) {
-            netsnmp_swrun_entry_free(entry);
-            continue; /* file (process) probably went away */
-	}
-        if (fgets( buf, BUFSIZ-1, fp ) == NULL) {
-            fclose(fp);
-            netsnmp_swrun_entry_free(entry);
-            continue;
-        }
-        fclose(fp);
-
-        cp = buf;
-        while ( ' ' != *(cp++))    /* Skip first field */
-            ;
-        cp1 = cp;                  /* Skip second field */
-        while (*cp1) {
-            if (*cp1 == ')') cp = cp1;
-            cp1++;
-        }
-        cp += 2;
         
-        switch (*cp) {
+        switch (st.state) {
         case 'R':  entry->hrSWRunStatus = HRSWRUNSTATUS_RUNNING;
                    break;
         case 'S':  entry->hrSWRunStatus = HRSWRUNSTATUS_RUNNABLE;
@@ -194,30 +306,175 @@ netsnmp_arch_swrun_container_load( netsnmp_container *container, u_int flags)
         default:   entry->hrSWRunStatus = HRSWRUNSTATUS_INVALID;
                    break;
         }
-        for (i=11; i; i--) {   /* Skip STATUS + 10 fields */
-            while (' ' != *(++cp))
-                ;
-            cp++;
-        }
-        cpu  = atol( cp );                     /*  utime */
-        while ( ' ' != *(++cp))
-            ;
-        cpu += atol( cp );                     /* +stime */
-        entry->hrSWRunPerfCPU  = cpu * 100 / sc_clk_tck;
-
-        for (i=9; i; i--) {   /* Skip stime + 8 fields */
-            while (' ' != *(++cp))
-                ;
-            cp++;
-        }
-        entry->hrSWRunPerfMem  = atol( cp );       /* rss   */
+        entry->hrSWRunPerfCPU  = ((unsigned long long)st.utime + st.stime)
+                                 * 100 / sc_clk_tck;
+        entry->hrSWRunPerfMem  = st.rss;
         entry->hrSWRunPerfMem *= (pagesize/1024);  /* in kB */
-        CONTAINER_INSERT(container, entry);
+        entry->generation = generation;
+
+        if (created && CONTAINER_INSERT(container, entry) != 0)
+            netsnmp_swrun_entry_free(entry);
     }
     closedir( procdir );
 
-    DEBUGMSGTL(("swrun:load:arch"," loaded %" NETSNMP_PRIz "d entries\n",
-                CONTAINER_SIZE(container)));
+    /*
+     * sweep the rows of processes which have exited
+     */
+    gc.to_delete = netsnmp_container_find("lifo");
+    gc.generation = generation;
+    if (gc.to_delete) {
+        CONTAINER_FOR_EACH(container,
+                           (netsnmp_container_obj_func *) _collect_gone,
+                           &gc);
+        DEBUGMSGTL(("swrun:load:arch"," removing %" NETSNMP_PRIz "d entries\n",
+                    CONTAINER_SIZE(gc.to_delete)));
+        while (CONTAINER_SIZE(gc.to_delete)) {
+            entry = (netsnmp_swrun_entry *) CONTAINER_FIRST(gc.to_delete);
+            CONTAINER_REMOVE(container, entry);
+            netsnmp_swrun_entry_free(entry);
+            CONTAINER_REMOVE(gc.to_delete, NULL);
+        }
+        CONTAINER_FREE(gc.to_delete);
+    }
+
+    DEBUGMSGTL(("swrun:load:arch"," loaded %" NETSNMP_PRIz "d entries,"
+                " %d read in full\n", CONTAINER_SIZE(container), reread));
 
     return 0;
 }
+
+#ifdef NETSNMP_SWRUN_PROC_EVENTS
+/* ---------------------------------------------------------------------
+ *
+ * proc connector: the kernel reports exec, name changes and exits, so
+ * rows can be fixed up even when the start time and name have not
+ * changed. Events queue up on the socket between loads.
+ */
+static void
+_proc_events_open(void)
+{
+    struct sockaddr_nl  sa;
+    struct {
+        struct nlmsghdr         nlh;
+        struct cn_msg           cn;
+        enum proc_cn_mcast_op   op;
+    } __attribute__((packed)) req;
+    int                 fd, rcvbuf = 1024 * 1024;
+
+    fd = socket(PF_NETLINK, SOCK_DGRAM, NETLINK_CONNECTOR);
+    if (fd < 0) {
+        DEBUGMSGTL(("swrun:events", "socket: %s\n", strerror(errno)));
+        return;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.nl_family = AF_NETLINK;
+    sa.nl_groups = CN_IDX_PROC;
+    if (bind(fd, (struct sockaddr *) &sa, sizeof(sa)) < 0) {
+        DEBUGMSGTL(("swrun:events", "bind: %s\n", strerror(errno)));
+        close(fd);
+        return;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_len = sizeof(req);
+    req.nlh.nlmsg_type = NLMSG_DONE;
+    req.cn.id.idx = CN_IDX_PROC;
+    req.cn.id.val = CN_VAL_PROC;
+    req.cn.len = sizeof(req.op);
+    req.op = PROC_CN_MCAST_LISTEN;
+    if (send(fd, &req, sizeof(req), 0) < 0) {
+        DEBUGMSGTL(("swrun:events", "listen: %s\n", strerror(errno)));
+        close(fd);
+        return;
+    }
+
+    DEBUGMSGTL(("swrun:events", "listening for process events\n"));
+    _proc_events = fd;
+}
+
+/**
+ * @internal
+ * mark every row for a full reread; used when events were dropped
+ */
+static void
+_proc_events_reread(netsnmp_swrun_entry *entry, void *unused)
+{
+    entry->start_time = 0;
+}
+
+static void
+_proc_events_read(netsnmp_container *container)
+{
+    char                buf[8192];
+    struct nlmsghdr    *h;
+    struct cn_msg      *cn;
+    struct proc_event  *ev;
+    netsnmp_swrun_entry *entry;
+    int                 len;
+    pid_t               pid;
+
+    if (_proc_events < 0)
+        return;
+
+    for (;;) {
+        len = recv(_proc_events, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len < 0) {
+            if (EINTR == errno)
+                continue;
+            if (ENOBUFS == errno) {
+                _proc_events_lost = 1;
+                continue;
+            }
+            break;  /* EAGAIN: drained */
+        }
+
+        for (h = (struct nlmsghdr *) buf; NLMSG_OK(h, len);
+             h = NLMSG_NEXT(h, len)) {
+            if (NLMSG_DONE != h->nlmsg_type)
+                continue;
+            cn = (struct cn_msg *) NLMSG_DATA(h);
+            if (cn->id.idx != CN_IDX_PROC || cn->id.val != CN_VAL_PROC ||
+                cn->len < sizeof(struct proc_event))
+                continue;
+            ev = (struct proc_event *) cn->data;
+
+            switch (ev->what) {
+            case PROC_EVENT_EXEC:
+                pid = ev->event_data.exec.process_tgid;
+                break;
+            case PROC_EVENT_COMM:
+                pid = ev->event_data.comm.process_tgid;
+                break;
+            case PROC_EVENT_EXIT:
+                /* only the exit of the main thread ends the process */
+                if (ev->event_data.exit.process_pid !=
+                    ev->event_data.exit.process_tgid)
+                    continue;
+                pid = ev->event_data.exit.process_tgid;
+                entry = netsnmp_swrun_entry_get_by_index(container, pid);
+                if (entry) {
+                    CONTAINER_REMOVE(container, entry);
+                    netsnmp_swrun_entry_free(entry);
+                }
+                continue;
+            default:
+                continue;
+            }
+
+            entry = netsnmp_swrun_entry_get_by_index(container, pid);
+            if (entry)
+                entry->start_time = 0;
+        }
+    }
+
+    if (_proc_events_lost) {
+        DEBUGMSGTL(("swrun:events", "events lost, rereading all rows\n"));
+        CONTAINER_FOR_EACH(container,
+                           (netsnmp_container_obj_func *) _proc_events_reread,
+                           NULL);
+        _proc_events_lost = 0;
+    }
+}
+#endif /* NETSNMP_SWRUN_PROC_EVENTS */
@@ -26,6 +26,13 @@ int
 netsnmp_access_interface_ioctl_flags_get(int fd,
                                          netsnmp_interface_entry *ifentry);
 
+void
+netsnmp_access_interface_ioctl_flags_apply(netsnmp_interface_entry *ifentry,
+                                           u_int os_flags);
+
+int
+netsnmp_access_interface_ioctl_arphrd_type(int family);
+
 int
 netsnmp_access_interface_ioctl_flags_set(int fd,
                                          netsnmp_interface_entry *ifentry,
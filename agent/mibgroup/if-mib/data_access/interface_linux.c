@@ -101,6 +101,11 @@ typedef __u8 u8;           /* ditto */
 #define SIOCGMIIREG 0x8948
 #endif
 
+#ifdef HAVE_LINUX_RTNETLINK_H
+#include <linux/rtnetlink.h>
+#define NETSNMP_INTERFACE_NETLINK 1
+#endif
+
 #ifdef NETSNMP_ENABLE_IPV6
 #if defined(HAVE_LINUX_RTNETLINK_H)
 #include <linux/rtnetlink.h>
@@ -472,6 +477,58 @@ _arch_interface_flags_v6_get(netsnmp_interface_entry *entry)
 }
 #endif /* NETSNMP_ENABLE_IPV6 */
 
+/**
+ * @internal
+ * store the counters of an interface
+ */
+static void
+_arch_interface_stats_set(netsnmp_interface_entry *entry,
+                          uintmax_t rec_pkt, uintmax_t rec_oct,
+                          uintmax_t rec_err, uintmax_t rec_drop,
+                          uintmax_t rec_mcast, uintmax_t snd_pkt,
+                          uintmax_t snd_oct, uintmax_t snd_err,
+                          uintmax_t snd_drop, uintmax_t coll)
+{
+    entry->ns_flags |= NETSNMP_INTERFACE_FLAGS_ACTIVE;
+    
+    /*
+     * linux previous to 1.3.~13 may miss transmitted loopback pkts: 
+     */
+    if (!strcmp(entry->name, "lo") && rec_pkt > 0 && !snd_pkt)
+        snd_pkt = rec_pkt;
+    
+    /*
+     * subtract out multicast packets from rec_pkt before
+     * we store it as unicast counter.
+     */
+    entry->ns_flags |= NETSNMP_INTERFACE_FLAGS_CALCULATE_UCAST;
+    entry->stats.ibytes.low = rec_oct & 0xffffffff;
+    entry->stats.iall.low = rec_pkt & 0xffffffff;
+    entry->stats.imcast.low = rec_mcast & 0xffffffff;
+    entry->stats.obytes.low = snd_oct & 0xffffffff;
+    entry->stats.oucast.low = snd_pkt & 0xffffffff;
+    entry->stats.ibytes.high = rec_oct >> 32;
+    entry->stats.iall.high = rec_pkt >> 32;
+    entry->stats.imcast.high = rec_mcast >> 32;
+    entry->stats.obytes.high = snd_oct >> 32;
+    entry->stats.oucast.high = snd_pkt >> 32;
+    entry->stats.ierrors   = rec_err;
+    entry->stats.idiscards = rec_drop;
+    entry->stats.oerrors   = snd_err;
+    entry->stats.odiscards = snd_drop;
+    entry->stats.collisions = coll;
+    
+    /*
+     * calculated stats.
+     *
+     *  we have imcast, but not ibcast.
+     */
+    entry->stats.inucast = entry->stats.imcast.low +
+        entry->stats.ibcast.low;
+    entry->stats.onucast = entry->stats.omcast.low +
+        entry->stats.obcast.low;
+}
+
 /**
  * @internal
  */
@@ -554,48 +611,687 @@ _parse_stats(netsnmp_interface_entry *entry, char *stats, int expected)
                  expected, scan_count);
         return scan_count;
     }
-    entry->ns_flags |= NETSNMP_INTERFACE_FLAGS_ACTIVE;
+    _arch_interface_stats_set(entry, rec_pkt, rec_oct, rec_err, rec_drop,
+                              rec_mcast, snd_pkt, snd_oct, snd_err,
+                              snd_drop, coll);
     
+    return 0;
+}
+
+/**
+ * @internal
+ * guess the type from the name, if the hardware type did not tell,
+ * and derive the interface identifier
+ */
+static void
+_arch_interface_type_fixup(netsnmp_interface_entry *entry)
+{
     /*
-     * linux previous to 1.3.~13 may miss transmitted loopback pkts: 
+     * physaddr should have set type. make some guesses (based
+     * on name) if not.
      */
-    if (!strcmp(entry->name, "lo") && rec_pkt > 0 && !snd_pkt)
-        snd_pkt = rec_pkt;
-    
+    if(0 == entry->type) {
+        typedef struct _match_if {
+           int             mi_type;
+           const char     *mi_name;
+        }              *pmatch_if, match_if;
+        
+        static match_if lmatch_if[] = {
+            {IANAIFTYPE_SOFTWARELOOPBACK, "lo"},
+            {IANAIFTYPE_ETHERNETCSMACD, "eth"},
+            {IANAIFTYPE_ETHERNETCSMACD, "vmnet"},
+            {IANAIFTYPE_ISO88025TOKENRING, "tr"},
+            {IANAIFTYPE_FASTETHER, "feth"},
+            {IANAIFTYPE_GIGABITETHERNET,"gig"},
+            {IANAIFTYPE_INFINIBAND,"ib"},
+            {IANAIFTYPE_PPP, "ppp"},
+            {IANAIFTYPE_SLIP, "sl"},
+            {IANAIFTYPE_TUNNEL, "sit"},
+            {IANAIFTYPE_BASICISDN, "ippp"},
+            {IANAIFTYPE_PROPVIRTUAL, "bond"}, /* Bonding driver find fastest slave */
+            {IANAIFTYPE_PROPVIRTUAL, "vad"},  /* ANS driver - ?speed? */
+            {0, NULL}                  /* end of list */
+        };
+
+        int             len;
+        register pmatch_if pm;
+        
+        for (pm = lmatch_if; pm->mi_name; pm++) {
+            len = strlen(pm->mi_name);
+            if (0 == strncmp(entry->name, pm->mi_name, len)) {
+                entry->type = pm->mi_type;
+                break;
+            }
+        }
+        if(NULL == pm->mi_name)
+            entry->type = IANAIFTYPE_OTHER;
+    }
+
     /*
-     * subtract out multicast packets from rec_pkt before
-     * we store it as unicast counter.
+     * interface identifier is specified based on physaddr and type
      */
-    entry->ns_flags |= NETSNMP_INTERFACE_FLAGS_CALCULATE_UCAST;
-    entry->stats.ibytes.low = rec_oct & 0xffffffff;
-    entry->stats.iall.low = rec_pkt & 0xffffffff;
-    entry->stats.imcast.low = rec_mcast & 0xffffffff;
-    entry->stats.obytes.low = snd_oct & 0xffffffff;
-    entry->stats.oucast.low = snd_pkt & 0xffffffff;
-    entry->stats.ibytes.high = rec_oct >> 32;
-    entry->stats.iall.high = rec_pkt >> 32;
-    entry->stats.imcast.high = rec_mcast >> 32;
-    entry->stats.obytes.high = snd_oct >> 32;
-    entry->stats.oucast.high = snd_pkt >> 32;
-    entry->stats.ierrors   = rec_err;
-    entry->stats.idiscards = rec_drop;
-    entry->stats.oerrors   = snd_err;
-    entry->stats.odiscards = snd_drop;
-    entry->stats.collisions = coll;
-    
+    switch (entry->type) {
+    case IANAIFTYPE_ETHERNETCSMACD:
+    case IANAIFTYPE_ETHERNET3MBIT:
+    case IANAIFTYPE_FASTETHER:
+    case IANAIFTYPE_FASTETHERFX:
+    case IANAIFTYPE_GIGABITETHERNET:
+    case IANAIFTYPE_FDDI:
+    case IANAIFTYPE_ISO88025TOKENRING:
+        if (NULL != entry->paddr && ETH_ALEN != entry->paddr_len)
+            break;
+
+        entry->v6_if_id_len = entry->paddr_len + 2;
+        memcpy(entry->v6_if_id, entry->paddr, 3);
+        memcpy(entry->v6_if_id + 5, entry->paddr + 3, 3);
+        entry->v6_if_id[0] ^= 2;
+        entry->v6_if_id[3] = 0xFF;
+        entry->v6_if_id[4] = 0xFE;
+
+        entry->ns_flags |= NETSNMP_INTERFACE_FLAGS_HAS_V6_IFID;
+        break;
+
+    case IANAIFTYPE_SOFTWARELOOPBACK:
+        entry->v6_if_id_len = 0;
+        entry->ns_flags |= NETSNMP_INTERFACE_FLAGS_HAS_V6_IFID;
+        break;
+    }
+}
+
+/**
+ * @internal
+ */
+static void
+_arch_interface_speed_get(int fd, netsnmp_interface_entry *entry)
+{
+    if (IANAIFTYPE_ETHERNETCSMACD == entry->type) {
+        unsigned long long speed;
+        unsigned long long defaultspeed = NOMINAL_LINK_SPEED;
+        if (!(entry->os_flags & IFF_RUNNING)) {
+            /*
+             * use speed 0 if the if speed cannot be determined *and* the
+             * interface is down
+             */
+            defaultspeed = 0;
+        }
+        speed = netsnmp_linux_interface_get_if_speed(fd,
+                entry->name, defaultspeed);
+        if (speed > 0xffffffffL) {
+            entry->speed = 0xffffffff;
+        } else
+            entry->speed = speed;
+        entry->speed_high = speed / 1000000LL;
+    }
+#ifdef APPLIED_PATCH_836390   /* xxx-rks ifspeed fixes */
+    else if (IANAIFTYPE_PROPVIRTUAL == entry->type)
+        entry->speed = _get_bonded_if_speed(entry);
+#endif
+    else
+        netsnmp_access_interface_entry_guess_speed(entry);
+}
+
+/**
+ * @internal
+ * the settings that follow from what has been read so far
+ */
+static void
+_arch_interface_entry_finish(netsnmp_interface_entry *entry)
+{
     /*
-     * calculated stats.
-     *
-     *  we have imcast, but not ibcast.
+     * Zero speed means link problem.
+     * - i'm not sure this is always true...
      */
-    entry->stats.inucast = entry->stats.imcast.low +
-        entry->stats.ibcast.low;
-    entry->stats.onucast = entry->stats.omcast.low +
-        entry->stats.obcast.low;
-    
+    if((entry->speed == 0) && (entry->os_flags & IFF_UP)) {
+        entry->os_flags &= ~IFF_RUNNING;
+    }
+
+    /*
+     * check for promiscuous mode.
+     *  NOTE: there are 2 ways to set promiscuous mode in Linux
+     *  (kernels later than 2.2.something) - using ioctls and
+     *  using setsockopt. The ioctl method tested here does not
+     *  detect if an interface was set using setsockopt. google
+     *  on IFF_PROMISC and linux to see lots of arguments about it.
+     */
+    if(entry->os_flags & IFF_PROMISC) {
+        entry->promiscuous = 1; /* boolean */
+    }
+
+    /*
+     * hardcoded max packet size
+     * (see ip_frag_reasm: if(len > 65535) goto out_oversize;)
+     */
+    entry->reasm_max_v4 = entry->reasm_max_v6 = 65535;
+    entry->ns_flags |= 
+        NETSNMP_INTERFACE_FLAGS_HAS_V4_REASMMAX |
+        NETSNMP_INTERFACE_FLAGS_HAS_V6_REASMMAX;
+
+    netsnmp_access_interface_entry_overrides(entry);
+}
+
+#ifdef NETSNMP_INTERFACE_NETLINK
+/*
+ * Netlink loader
+ *
+ * One RTM_GETADDR and one RTM_GETLINK dump return the addresses, flags,
+ * MTU, hardware address and counters of every interface at once.  The
+ * rest (link speed, PCI description and the /proc/sys/net settings)
+ * costs an ioctl or a file read per interface, so it is kept per
+ * ifIndex between loads.  It is only read again for an interface that
+ * a link notification reported as changed, or after
+ * IF_DETAILS_MAX_AGE seconds, as sysctl changes are not notified.
+ */
+#define IF_DETAILS_MAX_AGE 60
+#define NL_BUFSIZE         65536
+
+typedef struct _if_details_s {
+    netsnmp_index   oid_index;
+    oid             index;
+    char            name[IF_NAMESIZE];
+    u_int           ip_flags;       /* from this load's address dump */
+    char            seen;           /* listed by this load's link dump */
+
+    char            cached;         /* the fields below are current */
+    time_t          fetched;
+    u_int           cached_ip_flags;
+    u_int           ns_flags;
+    u_int           speed;
+    u_int           speed_high;
+    u_int           retransmit_v4;
+    u_int           retransmit_v6;
+    u_int           reachable_time;
+    char            forwarding_v6;
+    char           *descr;
+} _if_details;
+
+#define IF_DETAILS_NS_FLAGS (NETSNMP_INTERFACE_FLAGS_HAS_V4_RETRANSMIT | \
+                             NETSNMP_INTERFACE_FLAGS_HAS_V6_RETRANSMIT | \
+                             NETSNMP_INTERFACE_FLAGS_HAS_V6_REACHABLE | \
+                             NETSNMP_INTERFACE_FLAGS_HAS_V6_FORWARDING)
+
+typedef struct _nl_load_ctx_s {
+    u_int           load_flags;
+    int             fd;             /* for ioctls, opened when needed */
+    time_t          now;
+    netsnmp_interface_entry **entries;
+    int             count;
+    int             size;
+} _nl_load_ctx;
+
+static netsnmp_container *_if_details_container = NULL;
+static int      _nl_events = -1;    /* link notifications */
+static int      _nl_unavailable = 0;
+
+static void
+_if_details_free(_if_details *d, void *context)
+{
+    SNMP_FREE(d->descr);
+    free(d);
+}
+
+static _if_details *
+_if_details_get(oid index, int create)
+{
+    _if_details    *d, key;
+
+    key.index = index;
+    key.oid_index.len = 1;
+    key.oid_index.oids = &key.index;
+    d = (_if_details *) CONTAINER_FIND(_if_details_container, &key);
+    if (d || !create)
+        return d;
+
+    d = SNMP_MALLOC_TYPEDEF(_if_details);
+    if (NULL == d)
+        return NULL;
+    d->index = index;
+    d->oid_index.len = 1;
+    d->oid_index.oids = &d->index;
+    if (CONTAINER_INSERT(_if_details_container, d) != 0) {
+        free(d);
+        return NULL;
+    }
+    return d;
+}
+
+static void
+_if_details_reset(_if_details *d, void *context)
+{
+    d->ip_flags = 0;
+    d->seen = 0;
+    if (context)
+        d->cached = 0;
+}
+
+/*
+ * forget cached details for the interfaces that changed since the last
+ * load
+ */
+static void
+_nl_events_read(void)
+{
+    char            buf[8192];
+    struct nlmsghdr *h;
+    struct ifinfomsg *ifi;
+    _if_details    *d;
+    int             len;
+
+    for (;;) {
+        len = recv(_nl_events, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len < 0) {
+            if (EINTR == errno)
+                continue;
+            if (ENOBUFS == errno) {
+                /*
+                 * notifications were lost
+                 */
+                DEBUGMSGTL(("access:interface:netlink",
+                            "link notifications overflowed\n"));
+                CONTAINER_FOR_EACH(_if_details_container,
+                                   (netsnmp_container_obj_func *)
+                                   _if_details_reset, (void *) 1);
+                continue;
+            }
+            break;
+        }
+        for (h = (struct nlmsghdr *) buf; NLMSG_OK(h, len);
+             h = NLMSG_NEXT(h, len)) {
+            if (RTM_NEWLINK != h->nlmsg_type && RTM_DELLINK != h->nlmsg_type)
+                continue;
+            if (h->nlmsg_len < NLMSG_LENGTH(sizeof(*ifi)))
+                continue;
+            ifi = (struct ifinfomsg *) NLMSG_DATA(h);
+            d = _if_details_get(ifi->ifi_index, 0);
+            if (d) {
+                DEBUGMSGTL(("access:interface:netlink",
+                            "interface %d changed\n", ifi->ifi_index));
+                d->cached = 0;
+            }
+        }
+    }
+}
+
+static int
+_nl_open(void)
+{
+    struct sockaddr_nl addr;
+
+    if (NULL == _if_details_container) {
+        _if_details_container =
+            netsnmp_container_find("access_interface_details:table_container");
+        if (NULL == _if_details_container)
+            return -1;
+    }
+
+    if (_nl_events < 0) {
+        _nl_events = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+        if (_nl_events < 0)
+            return -1;
+        memset(&addr, 0, sizeof(addr));
+        addr.nl_family = AF_NETLINK;
+        addr.nl_groups = RTMGRP_LINK;
+        if (bind(_nl_events, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+            close(_nl_events);
+            _nl_events = -1;
+            return -1;
+        }
+    }
     return 0;
 }
 
+/*
+ * send a dump request, and hand each message of the answer to process()
+ *
+ * @retval  0 : success
+ * @retval -1 : failure
+ */
+static int
+_nl_dump(int sd, int type,
+         int (*process)(struct nlmsghdr *, _nl_load_ctx *),
+         _nl_load_ctx *ctx)
+{
+    static unsigned int seq = 0;
+    struct {
+        struct nlmsghdr  n;
+        struct ifinfomsg i;
+    } req;
+    struct nlmsghdr *h;
+    char           *buf;
+    int             len, done = 0, rc = 0;
+
+    memset(&req, 0, sizeof(req));
+    if (RTM_GETLINK == type)
+        req.n.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    else
+        req.n.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifaddrmsg));
+    req.n.nlmsg_type = type;
+    req.n.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.n.nlmsg_seq = ++seq;
+    req.i.ifi_family = AF_UNSPEC;
+
+    if (send(sd, &req, req.n.nlmsg_len, 0) < 0) {
+        DEBUGMSGTL(("access:interface:netlink", "send failed (%d)\n",
+                    errno));
+        return -1;
+    }
+
+    buf = (char *) malloc(NL_BUFSIZE);
+    if (NULL == buf)
+        return -1;
+
+    while (!done && 0 == rc) {
+        len = recv(sd, buf, NL_BUFSIZE, 0);
+        if (len < 0 && EINTR == errno)
+            continue;
+        if (len <= 0) {
+            DEBUGMSGTL(("access:interface:netlink", "recv failed (%d)\n",
+                        errno));
+            rc = -1;
+            break;
+        }
+        for (h = (struct nlmsghdr *) buf; NLMSG_OK(h, len);
+             h = NLMSG_NEXT(h, len)) {
+            if (h->nlmsg_seq != seq)
+                continue;
+            if (NLMSG_DONE == h->nlmsg_type) {
+                done = 1;
+                break;
+            }
+            if (NLMSG_ERROR == h->nlmsg_type || process(h, ctx) < 0) {
+                rc = -1;
+                break;
+            }
+        }
+    }
+    free(buf);
+    return rc;
+}
+
+static int
+_nl_process_addr(struct nlmsghdr *h, _nl_load_ctx *ctx)
+{
+    struct ifaddrmsg *ifa;
+    _if_details    *d;
+
+    if (RTM_NEWADDR != h->nlmsg_type)
+        return 0;
+    if (h->nlmsg_len < NLMSG_LENGTH(sizeof(*ifa)))
+        return -1;
+    ifa = (struct ifaddrmsg *) NLMSG_DATA(h);
+
+    d = _if_details_get(ifa->ifa_index, 1);
+    if (NULL == d)
+        return -1;
+    if (AF_INET == ifa->ifa_family)
+        d->ip_flags |= NETSNMP_INTERFACE_FLAGS_HAS_IPV4;
+#ifdef NETSNMP_ENABLE_IPV6
+    else if (AF_INET6 == ifa->ifa_family)
+        d->ip_flags |= NETSNMP_INTERFACE_FLAGS_HAS_IPV6;
+#endif
+    return 0;
+}
+
+/*
+ * fill in what the link dump does not tell, from the cache if possible
+ */
+static void
+_nl_details_get(netsnmp_interface_entry *entry, _if_details *d,
+                _nl_load_ctx *ctx)
+{
+    if (d->cached && d->cached_ip_flags == d->ip_flags &&
+        0 == strcmp(d->name, entry->name) &&
+        ctx->now - d->fetched < IF_DETAILS_MAX_AGE) {
+        if (d->descr) {
+            free(entry->descr);
+            entry->descr = strdup(d->descr);
+        }
+        entry->speed = d->speed;
+        entry->speed_high = d->speed_high;
+        entry->retransmit_v4 = d->retransmit_v4;
+        entry->retransmit_v6 = d->retransmit_v6;
+        entry->reachable_time = d->reachable_time;
+        entry->forwarding_v6 = d->forwarding_v6;
+        entry->ns_flags |= d->ns_flags;
+        return;
+    }
+
+    DEBUGMSGTL(("9:access:interface:netlink", "reading details of %s\n",
+                entry->name));
+#ifdef HAVE_PCI_LOOKUP_NAME
+    _arch_interface_description_get(entry);
+#endif
+    if (ctx->fd < 0)
+        ctx->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    _arch_interface_speed_get(ctx->fd, entry);
+    if (d->ip_flags & NETSNMP_INTERFACE_FLAGS_HAS_IPV4)
+        _arch_interface_flags_v4_get(entry);
+#ifdef NETSNMP_ENABLE_IPV6
+    if (d->ip_flags & NETSNMP_INTERFACE_FLAGS_HAS_IPV6)
+        _arch_interface_flags_v6_get(entry);
+#endif
+
+    SNMP_FREE(d->descr);
+    if (entry->descr && strcmp(entry->descr, entry->name))
+        d->descr = strdup(entry->descr);
+    strlcpy(d->name, entry->name, sizeof(d->name));
+    d->speed = entry->speed;
+    d->speed_high = entry->speed_high;
+    d->retransmit_v4 = entry->retransmit_v4;
+    d->retransmit_v6 = entry->retransmit_v6;
+    d->reachable_time = entry->reachable_time;
+    d->forwarding_v6 = entry->forwarding_v6;
+    d->ns_flags = entry->ns_flags & IF_DETAILS_NS_FLAGS;
+    d->cached_ip_flags = d->ip_flags;
+    d->fetched = ctx->now;
+    d->cached = 1;
+}
+
+static int
+_nl_process_link(struct nlmsghdr *h, _nl_load_ctx *ctx)
+{
+    struct ifinfomsg *ifi;
+    struct rtattr  *rta, *tb[IFLA_MAX + 1];
+    netsnmp_interface_entry *entry;
+    _if_details    *d;
+    char            name[IF_NAMESIZE];
+    int             len;
+
+    if (RTM_NEWLINK != h->nlmsg_type)
+        return 0;
+    len = h->nlmsg_len - NLMSG_LENGTH(sizeof(*ifi));
+    if (len < 0)
+        return -1;
+    ifi = (struct ifinfomsg *) NLMSG_DATA(h);
+
+    memset(tb, 0, sizeof(tb));
+    for (rta = IFLA_RTA(ifi); RTA_OK(rta, len); rta = RTA_NEXT(rta, len))
+        if (rta->rta_type <= IFLA_MAX)
+            tb[rta->rta_type] = rta;
+    if (NULL == tb[IFLA_IFNAME])
+        return 0;
+    strlcpy(name, (char *) RTA_DATA(tb[IFLA_IFNAME]),
+            RTA_PAYLOAD(tb[IFLA_IFNAME]) < sizeof(name) ?
+            RTA_PAYLOAD(tb[IFLA_IFNAME]) : sizeof(name));
+
+    DEBUGMSGTL(("9:access:ifcontainer", "processing '%s'\n", name));
+
+    if (!netsnmp_access_interface_include(name))
+        return 0;
+    if (netsnmp_access_interface_max_reached(name))
+        return 0;
+
+    d = _if_details_get(ifi->ifi_index, 1);
+    if (NULL == d)
+        return -1;
+    d->seen = 1;
+
+    /*
+     * do we only want one address type?
+     */
+    if (((ctx->load_flags & NETSNMP_ACCESS_INTERFACE_LOAD_IP4_ONLY) &&
+         ((d->ip_flags & NETSNMP_INTERFACE_FLAGS_HAS_IPV4) == 0)) ||
+        ((ctx->load_flags & NETSNMP_ACCESS_INTERFACE_LOAD_IP6_ONLY) &&
+         ((d->ip_flags & NETSNMP_INTERFACE_FLAGS_HAS_IPV6) == 0))) {
+        DEBUGMSGTL(("9:access:ifcontainer",
+                    "interface '%s' excluded by ip version\n", name));
+        return 0;
+    }
+
+    if (ctx->count == ctx->size) {
+        netsnmp_interface_entry **entries;
+
+        entries = (netsnmp_interface_entry **)
+            realloc(ctx->entries, (ctx->size + 64) * sizeof(*entries));
+        if (NULL == entries)
+            return -1;
+        ctx->entries = entries;
+        ctx->size += 64;
+    }
+    entry = netsnmp_access_interface_entry_create(name, ifi->ifi_index);
+    if (NULL == entry)
+        return -1;
+    ctx->entries[ctx->count++] = entry;
+    entry->ns_flags = d->ip_flags;
+
+    /*
+     * same layout as SIOCGIFHWADDR gives
+     */
+    entry->paddr = (char *) calloc(1, IFHWADDRLEN);
+    if (entry->paddr) {
+        entry->paddr_len = IFHWADDRLEN;
+        if (tb[IFLA_ADDRESS])
+            memcpy(entry->paddr, RTA_DATA(tb[IFLA_ADDRESS]),
+                   RTA_PAYLOAD(tb[IFLA_ADDRESS]) < IFHWADDRLEN ?
+                   RTA_PAYLOAD(tb[IFLA_ADDRESS]) : IFHWADDRLEN);
+    }
+    entry->type = netsnmp_access_interface_ioctl_arphrd_type(ifi->ifi_type);
+    _arch_interface_type_fixup(entry);
+
+    /*
+     * like the /proc/net/dev path, the speed is looked up before the
+     * flags are known
+     */
+    _nl_details_get(entry, d, ctx);
+
+    netsnmp_access_interface_ioctl_flags_apply(entry, ifi->ifi_flags);
+    if (tb[IFLA_MTU] && RTA_PAYLOAD(tb[IFLA_MTU]) >= sizeof(uint32_t))
+        entry->mtu = *(uint32_t *) RTA_DATA(tb[IFLA_MTU]);
+
+    _arch_interface_entry_finish(entry);
+
+    if (ctx->load_flags & NETSNMP_ACCESS_INTERFACE_LOAD_NO_STATS)
+        return 0;
+    if (tb[IFLA_STATS64] &&
+        RTA_PAYLOAD(tb[IFLA_STATS64]) >= sizeof(struct rtnl_link_stats64)) {
+        struct rtnl_link_stats64 st;
+
+        /*
+         * attribute payloads are only 4-byte aligned
+         */
+        memcpy(&st, RTA_DATA(tb[IFLA_STATS64]), sizeof(st));
+        _arch_interface_stats_set(entry, st.rx_packets, st.rx_bytes,
+                                  st.rx_errors,
+                                  st.rx_dropped + st.rx_missed_errors,
+                                  st.multicast, st.tx_packets, st.tx_bytes,
+                                  st.tx_errors, st.tx_dropped,
+                                  st.collisions);
+    } else if (tb[IFLA_STATS] &&
+               RTA_PAYLOAD(tb[IFLA_STATS]) >= sizeof(struct rtnl_link_stats)) {
+        struct rtnl_link_stats *st =
+            (struct rtnl_link_stats *) RTA_DATA(tb[IFLA_STATS]);
+
+        _arch_interface_stats_set(entry, st->rx_packets, st->rx_bytes,
+                                  st->rx_errors,
+                                  st->rx_dropped + st->rx_missed_errors,
+                                  st->multicast, st->tx_packets,
+                                  st->tx_bytes, st->tx_errors,
+                                  st->tx_dropped, st->collisions);
+    } else
+        return 0;
+    entry->ns_flags |= NETSNMP_INTERFACE_FLAGS_HAS_BYTES |
+        NETSNMP_INTERFACE_FLAGS_HAS_DROPS |
+        NETSNMP_INTERFACE_FLAGS_HAS_MCAST_PKTS |
+        NETSNMP_INTERFACE_FLAGS_HAS_HIGH_SPEED |
+        NETSNMP_INTERFACE_FLAGS_HAS_HIGH_BYTES |
+        NETSNMP_INTERFACE_FLAGS_HAS_HIGH_PACKETS;
+    return 0;
+}
+
+/*
+ * @retval  0 success
+ * @retval -2 netlink could not be used
+ */
+static int
+_arch_interface_netlink_load(netsnmp_container *container, u_int load_flags)
+{
+    _if_details    *d, *next;
+    _nl_load_ctx    ctx;
+    struct timeval  now;
+    int             sd, i, rc = 0;
+
+    if (_nl_open() < 0) {
+        DEBUGMSGTL(("access:interface:netlink",
+                    "netlink not available, using /proc/net/dev\n"));
+        _nl_unavailable = 1;
+        return -2;
+    }
+    sd = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+    if (sd < 0)
+        return -2;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.load_flags = load_flags;
+    ctx.fd = -1;
+    netsnmp_get_monotonic_clock(&now);
+    ctx.now = now.tv_sec;
+
+    _nl_events_read();
+    CONTAINER_FOR_EACH(_if_details_container,
+                       (netsnmp_container_obj_func *) _if_details_reset,
+                       NULL);
+
+    if (_nl_dump(sd, RTM_GETADDR, _nl_process_addr, &ctx) < 0 ||
+        _nl_dump(sd, RTM_GETLINK, _nl_process_link, &ctx) < 0)
+        rc = -2;
+    close(sd);
+    if (ctx.fd >= 0)
+        close(ctx.fd);
+
+    if (rc < 0) {
+        for (i = 0; i < ctx.count; i++)
+            netsnmp_access_interface_entry_free(ctx.entries[i]);
+        free(ctx.entries);
+        /*
+         * start from scratch next time
+         */
+        CONTAINER_CLEAR(_if_details_container,
+                        (netsnmp_container_obj_func *) _if_details_free,
+                        NULL);
+        return -2;
+    }
+
+    for (i = 0; i < ctx.count; i++)
+        CONTAINER_INSERT(container, ctx.entries[i]);
+    free(ctx.entries);
+
+    /*
+     * drop the details of interfaces that went away
+     */
+    for (d = (_if_details *) CONTAINER_FIRST(_if_details_container); d;
+         d = next) {
+        next = (_if_details *) CONTAINER_NEXT(_if_details_container, d);
+        if (d->seen)
+            continue;
+        CONTAINER_REMOVE(_if_details_container, d);
+        _if_details_free(d, NULL);
+    }
+
+    DEBUGMSGTL(("access:interface:netlink", "loaded %d interfaces\n",
+                ctx.count));
+    return 0;
+}
+#endif /* NETSNMP_INTERFACE_NETLINK */
+
 /*
  *
  * @retval  0 success
@@ -626,6 +1322,12 @@ netsnmp_arch_interface_container_load(netsnmp_container* container,
         return -1;
     }
 
+#ifdef NETSNMP_INTERFACE_NETLINK
+    if (!_nl_unavailable &&
+        0 == _arch_interface_netlink_load(container, load_flags))
+        return 0;
+#endif
+
     if (!(devin = fopen("/proc/net/dev", "r"))) {
         DEBUGMSGTL(("access:interface",
                     "Failed to load Interface Table (linux1)\n"));
@@ -777,136 +1479,15 @@ netsnmp_arch_interface_container_load(netsnmp_container* container,
          */
         netsnmp_access_interface_ioctl_physaddr_get(fd, entry);
 
-        /*
-         * physaddr should have set type. make some guesses (based
-         * on name) if not.
-         */
-        if(0 == entry->type) {
-            typedef struct _match_if {
-               int             mi_type;
-               const char     *mi_name;
-            }              *pmatch_if, match_if;
-            
-            static match_if lmatch_if[] = {
-                {IANAIFTYPE_SOFTWARELOOPBACK, "lo"},
-                {IANAIFTYPE_ETHERNETCSMACD, "eth"},
-                {IANAIFTYPE_ETHERNETCSMACD, "vmnet"},
-                {IANAIFTYPE_ISO88025TOKENRING, "tr"},
-                {IANAIFTYPE_FASTETHER, "feth"},
-                {IANAIFTYPE_GIGABITETHERNET,"gig"},
-                {IANAIFTYPE_INFINIBAND,"ib"},
-                {IANAIFTYPE_PPP, "ppp"},
-                {IANAIFTYPE_SLIP, "sl"},
-                {IANAIFTYPE_TUNNEL, "sit"},
-                {IANAIFTYPE_BASICISDN, "ippp"},
-                {IANAIFTYPE_PROPVIRTUAL, "bond"}, /* Bonding driver find fastest slave */
-                {IANAIFTYPE_PROPVIRTUAL, "vad"},  /* ANS driver - ?speed? */
-                {0, NULL}                  /* end of list */
-            };
-
-            int             len;
-            register pmatch_if pm;
-            
-            for (pm = lmatch_if; pm->mi_name; pm++) {
-                len = strlen(pm->mi_name);
-                if (0 == strncmp(entry->name, pm->mi_name, len)) {
-                    entry->type = pm->mi_type;
-                    break;
-                }
-            }
-            if(NULL == pm->mi_name)
-                entry->type = IANAIFTYPE_OTHER;
-        }
-
-        /*
-         * interface identifier is specified based on physaddr and type
-         */
-        switch (entry->type) {
-        case IANAIFTYPE_ETHERNETCSMACD:
-        case IANAIFTYPE_ETHERNET3MBIT:
-        case IANAIFTYPE_FASTETHER:
-        case IANAIFTYPE_FASTETHERFX:
-        case IANAIFTYPE_GIGABITETHERNET:
-        case IANAIFTYPE_FDDI:
-        case IANAIFTYPE_ISO88025TOKENRING:
-            if (NULL != entry->paddr && ETH_ALEN != entry->paddr_len)
-                break;
-
-            entry->v6_if_id_len = entry->paddr_len + 2;
-            memcpy(entry->v6_if_id, entry->paddr, 3);
-            memcpy(entry->v6_if_id + 5, entry->paddr + 3, 3);
-            entry->v6_if_id[0] ^= 2;
-            entry->v6_if_id[3] = 0xFF;
-            entry->v6_if_id[4] = 0xFE;
-
-            entry->ns_flags |= NETSNMP_INTERFACE_FLAGS_HAS_V6_IFID;
-            break;
+        _arch_interface_type_fixup(entry);
 
-        case IANAIFTYPE_SOFTWARELOOPBACK:
-            entry->v6_if_id_len = 0;
-            entry->ns_flags |= NETSNMP_INTERFACE_FLAGS_HAS_V6_IFID;
-            break;
-        }
-
-        if (IANAIFTYPE_ETHERNETCSMACD == entry->type) {
-            unsigned long long speed;
-            unsigned long long defaultspeed = NOMINAL_LINK_SPEED;
-            if (!(entry->os_flags & IFF_RUNNING)) {
-                /*
-                 * use speed 0 if the if speed cannot be determined *and* the
-                 * interface is down
-                 */
-                defaultspeed = 0;
-            }
-            speed = netsnmp_linux_interface_get_if_speed(fd,
-                    entry->name, defaultspeed);
-            if (speed > 0xffffffffL) {
-                entry->speed = 0xffffffff;
-            } else
-                entry->speed = speed;
-            entry->speed_high = speed / 1000000LL;
-        }
-#ifdef APPLIED_PATCH_836390   /* xxx-rks ifspeed fixes */
-        else if (IANAIFTYPE_PROPVIRTUAL == entry->type)
-            entry->speed = _get_bonded_if_speed(entry);
-#endif
-        else
-            netsnmp_access_interface_entry_guess_speed(entry);
+        _arch_interface_speed_get(fd, entry);
         
         netsnmp_access_interface_ioctl_flags_get(fd, entry);
 
         netsnmp_access_interface_ioctl_mtu_get(fd, entry);
 
-        /*
-         * Zero speed means link problem.
-         * - i'm not sure this is always true...
-         */
-        if((entry->speed == 0) && (entry->os_flags & IFF_UP)) {
-            entry->os_flags &= ~IFF_RUNNING;
-        }
-
-        /*
-         * check for promiscuous mode.
-         *  NOTE: there are 2 ways to set promiscuous mode in Linux
-         *  (kernels later than 2.2.something) - using ioctls and
-         *  using setsockopt. The ioctl method tested here does not
-         *  detect if an interface was set using setsockopt. google
-         *  on IFF_PROMISC and linux to see lots of arguments about it.
-         */
-        if(entry->os_flags & IFF_PROMISC) {
-            entry->promiscuous = 1; /* boolean */
-        }
-
-        /*
-         * hardcoded max packet size
-         * (see ip_frag_reasm: if(len > 65535) goto out_oversize;)
-         */
-        entry->reasm_max_v4 = entry->reasm_max_v6 = 65535;
-        entry->ns_flags |= 
-            NETSNMP_INTERFACE_FLAGS_HAS_V4_REASMMAX |
-            NETSNMP_INTERFACE_FLAGS_HAS_V6_REASMMAX;
-
-        netsnmp_access_interface_entry_overrides(entry);
+        _arch_interface_entry_finish(entry);
 
         if (! (load_flags & NETSNMP_ACCESS_INTERFACE_LOAD_NO_STATS))
             _parse_stats(entry, stats, scan_expected);
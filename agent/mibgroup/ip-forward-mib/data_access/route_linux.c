@@ -203,6 +203,7 @@ _load_ipv6(netsnmp_container* container, u_long *index )
     FILE           *in;
     char            line[256];
     netsnmp_route_entry *entry = NULL;
+    int             fd;
 
     DEBUGMSGTL(("access:route:container",
                 "route_container_arch_load ipv6\n"));
@@ -216,6 +217,16 @@ _load_ipv6(netsnmp_container* container, u_long *index )
         DEBUGMSGTL(("9:access:route:container", "cannot open /proc/net/ipv6_route\n"));
         return -2;
     }
+
+    /*
+     * create socket for ioctls (see NOTE[1] in _load_ipv4)
+     */
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(fd < 0) {
+        snmp_log(LOG_ERR, "could not create socket\n");
+        fclose(in);
+        return -2;
+    }
     
     while (fgets(line, sizeof(line), in)) {
         char            c_name[IFNAMSIZ+1];
@@ -258,8 +269,13 @@ _load_ipv6(netsnmp_container* container, u_long *index )
          * temporary null terminated name
          */
         c_name[ sizeof(c_name)-1 ] = 0;
-        entry->if_index = se_find_value_in_slist("interfaces", c_name);
-        if(SE_DNE == entry->if_index) {
+        /*
+         * ask the kernel rather than the "interfaces" list, which only the
+         * main thread may read, as this also runs as a background reload
+         */
+        entry->if_index =
+            netsnmp_access_interface_ioctl_ifindex_get(fd, c_name);
+        if(0 == entry->if_index) {
             snmp_log(LOG_ERR,"unknown interface in /proc/net/ipv6_route "
                      "('%s')\n", c_name);
             netsnmp_access_route_entry_free(entry);
@@ -334,6 +350,7 @@ _load_ipv6(netsnmp_container* container, u_long *index )
     }
 
     fclose(in);
+    close(fd);
     return 0;
 }
 #endif
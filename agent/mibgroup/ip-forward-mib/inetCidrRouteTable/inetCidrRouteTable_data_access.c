@@ -130,6 +130,13 @@ inetCidrRouteTable_container_init(netsnmp_container **container_ptr_ptr,
      * cache->enabled to 0.
      */
     cache->timeout = INETCIDRROUTETABLE_CACHE_TIMEOUT;  /* seconds */
+
+#ifdef linux
+    /*
+     * keep answering from the old routes while the kernel's are reread
+     */
+    cache->flags |= NETSNMP_CACHE_BACKGROUND_LOAD;
+#endif
 }                               /* inetCidrRouteTable_container_init */
 
 /**
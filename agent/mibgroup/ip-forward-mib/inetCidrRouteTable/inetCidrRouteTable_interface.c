@@ -2241,6 +2241,61 @@ _cache_load(netsnmp_cache * cache, void *vmagic)
                                              magic);
 }                               /* _cache_load */
 
+/**
+ * @internal
+ * load the rows into a container of their own, leaving the one in use
+ * alone, so that this can run as a background reload
+ */
+static void    *
+_cache_build(netsnmp_cache * cache, void *vmagic)
+{
+    netsnmp_container *container;
+
+    DEBUGMSGTL(("internal:inetCidrRouteTable:_cache_build", "called\n"));
+
+    container = netsnmp_container_find("inetCidrRouteTable:table_container");
+    if (NULL == container)
+        return NULL;
+    netsnmp_binary_array_options_set(container, 1,
+                                     CONTAINER_KEY_ALLOW_DUPLICATES);
+
+    if (MFD_SUCCESS != inetCidrRouteTable_container_load(container)) {
+        _container_free(container);
+        CONTAINER_FREE(container);
+        return NULL;
+    }
+    return container;
+}                               /* _cache_build */
+
+/**
+ * @internal
+ */
+static void
+_container_item_move(inetCidrRouteTable_rowreq_ctx * rowreq_ctx,
+                     void *context)
+{
+    CONTAINER_INSERT((netsnmp_container *) context, rowreq_ctx);
+}                               /* _container_item_move */
+
+/**
+ * @internal
+ * replace the rows in use with the ones _cache_build() loaded
+ */
+static void
+_cache_swap(netsnmp_cache * cache, void *vmagic, void *snapshot)
+{
+    netsnmp_container *container = (netsnmp_container *) cache->magic;
+    netsnmp_container *loaded = (netsnmp_container *) snapshot;
+
+    DEBUGMSGTL(("internal:inetCidrRouteTable:_cache_swap", "called\n"));
+
+    _container_free(container);
+    CONTAINER_FOR_EACH(loaded,
+                       (netsnmp_container_obj_func *) _container_item_move,
+                       container);
+    CONTAINER_FREE(loaded);
+}                               /* _cache_swap */
+
 /**
  * @internal
  */
@@ -2330,6 +2385,8 @@ _inetCidrRouteTable_container_init(inetCidrRouteTable_interface_ctx *
     }
 
     if_ctx->cache->flags = NETSNMP_CACHE_DONT_INVALIDATE_ON_SET;
+    if_ctx->cache->build_cache = _cache_build;
+    if_ctx->cache->swap_cache = _cache_swap;
 
     inetCidrRouteTable_container_init(&if_ctx->container, if_ctx->cache);
     if (NULL == if_ctx->container) {
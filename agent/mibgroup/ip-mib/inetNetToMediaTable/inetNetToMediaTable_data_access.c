@@ -253,6 +253,16 @@ inetNetToMediaTable_container_init(netsnmp_container **container_ptr_ptr,
                  "unable to create arp access in inetNetToMediaTable_container_init\n");
         return;
     }
+
+#ifndef HAVE_LINUX_RTNETLINK_H
+    /*
+     * every load rereads the whole table, so keep answering from the old
+     * rows meanwhile.  (The netlink version follows the kernel's
+     * notifications, and only fetches the table again when it has lost
+     * track of them.)
+     */
+    cache->flags |= NETSNMP_CACHE_BACKGROUND_LOAD;
+#endif
 }                               /* inetNetToMediaTable_container_init */
 
 /**
@@ -333,6 +343,92 @@ inetNetToMediaTable_container_load(netsnmp_container *container)
     return MFD_SUCCESS;
 }                               /* inetNetToMediaTable_container_load */
 
+static void
+_arp_hook_collect(netsnmp_arp_access *access, netsnmp_arp_entry *entry)
+{
+    if (CONTAINER_INSERT((netsnmp_container *) access->magic, entry) != 0)
+        netsnmp_access_arp_entry_free(entry);
+}
+
+static void
+_arp_hook_collect_gc(netsnmp_arp_access *access)
+{
+}
+
+static void
+_arp_entry_release(netsnmp_arp_entry *entry, void *context)
+{
+    netsnmp_access_arp_entry_free(entry);
+}
+
+/**
+ * read the ARP table for a background reload
+ *
+ *  This uses an access of its own and leaves the rows in use alone, so
+ *  it may run in another thread.
+ *
+ * @retval the entries read, for inetNetToMediaTable_container_swap()
+ * @retval NULL : Can't access data source
+ */
+void           *
+inetNetToMediaTable_container_build(void)
+{
+    netsnmp_arp_access *access;
+    netsnmp_container *entries;
+    int             rc;
+
+    DEBUGMSGTL(("verbose:inetNetToMediaTable:inetNetToMediaTable_container_build", "called\n"));
+
+    entries = netsnmp_container_find("lifo");
+    if (NULL == entries)
+        return NULL;
+    access = netsnmp_access_arp_create(NETSNMP_ACCESS_ARP_CREATE_NOFLAGS,
+                                       _arp_hook_collect,
+                                       _arp_hook_collect_gc,
+                                       NULL, NULL, NULL);
+    if (NULL == access) {
+        CONTAINER_FREE(entries);
+        return NULL;
+    }
+    access->magic = entries;
+    rc = netsnmp_access_arp_load(access);
+    netsnmp_access_arp_delete(access);
+    if (rc < 0) {
+        CONTAINER_CLEAR(entries,
+                        (netsnmp_container_obj_func *) _arp_entry_release,
+                        NULL);
+        CONTAINER_FREE(entries);
+        return NULL;
+    }
+    return entries;
+}                               /* inetNetToMediaTable_container_build */
+
+/**
+ * update the rows in use from what inetNetToMediaTable_container_build()
+ * read, as a load would have
+ */
+void
+inetNetToMediaTable_container_swap(netsnmp_container *container,
+                                   void *snapshot)
+{
+    netsnmp_container *entries = (netsnmp_container *) snapshot;
+    netsnmp_arp_entry *entry;
+
+    DEBUGMSGTL(("verbose:inetNetToMediaTable:inetNetToMediaTable_container_swap", "called\n"));
+
+    arp_access->magic = container;
+    arp_access->generation++;
+    while (CONTAINER_SIZE(entries)) {
+        entry = (netsnmp_arp_entry *) CONTAINER_FIRST(entries);
+        CONTAINER_REMOVE(entries, NULL);
+        entry->generation = arp_access->generation;
+        arp_access->update_hook(arp_access, entry);
+    }
+    arp_access->gc_hook(arp_access);
+    arp_access->synchronized = 1;
+    CONTAINER_FREE(entries);
+}                               /* inetNetToMediaTable_container_swap */
+
 /**
  * container clean up
  *
@@ -58,6 +58,10 @@ extern          "C" {
                                                        *container);
     void            inetNetToMediaTable_container_free(netsnmp_container
                                                        *container);
+    void           *inetNetToMediaTable_container_build(void);
+    void            inetNetToMediaTable_container_swap(netsnmp_container
+                                                       *container,
+                                                       void *snapshot);
 
     int             inetNetToMediaTable_cache_load(netsnmp_container
                                                    *container);
@@ -1874,6 +1874,35 @@ _cache_load(netsnmp_cache * cache, void *vmagic)
                                               magic);
 }                               /* _cache_load */
 
+/**
+ * @internal
+ */
+static void    *
+_cache_build(netsnmp_cache * cache, void *vmagic)
+{
+    DEBUGMSGTL(("internal:inetNetToMediaTable:_cache_build", "called\n"));
+
+    /*
+     * call user code
+     */
+    return inetNetToMediaTable_container_build();
+}                               /* _cache_build */
+
+/**
+ * @internal
+ */
+static void
+_cache_swap(netsnmp_cache * cache, void *vmagic, void *snapshot)
+{
+    DEBUGMSGTL(("internal:inetNetToMediaTable:_cache_swap", "called\n"));
+
+    /*
+     * call user code
+     */
+    inetNetToMediaTable_container_swap((netsnmp_container *) cache->magic,
+                                       snapshot);
+}                               /* _cache_swap */
+
 /**
  * @internal
  */
@@ -1964,6 +1993,8 @@ _inetNetToMediaTable_container_init(inetNetToMediaTable_interface_ctx *
     }
 
     if_ctx->cache->flags = NETSNMP_CACHE_DONT_INVALIDATE_ON_SET;
+    if_ctx->cache->build_cache = _cache_build;
+    if_ctx->cache->swap_cache = _cache_swap;
 
     inetNetToMediaTable_container_init(&if_ctx->container, if_ctx->cache);
     if (NULL == if_ctx->container) {
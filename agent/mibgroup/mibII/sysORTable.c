@@ -238,7 +238,8 @@ init_sysORTable(void)
     sysORTable_reg =
         netsnmp_create_handler_registration(
             "mibII/sysORTable", sysORTable_handler,
-            sysORTable_oid, OID_LENGTH(sysORTable_oid), HANDLER_CAN_RONLY);
+            sysORTable_oid, OID_LENGTH(sysORTable_oid),
+            HANDLER_CAN_RONLY | HANDLER_CAN_GETBULK);
     netsnmp_container_table_register(sysORTable_reg, sysORTable_table_info,
                                      table, TABLE_CONTAINER_KEY_NETSNMP_INDEX);
 
@@ -327,7 +327,7 @@ init_system_mib(void)
         netsnmp_register_watched_scalar(
             netsnmp_create_handler_registration(
                 "mibII/sysDescr", NULL, sysDescr_oid, OID_LENGTH(sysDescr_oid),
-                HANDLER_CAN_RONLY),
+                HANDLER_CAN_RONLY | HANDLER_CAN_THREADSAFE),
             netsnmp_init_watcher_info(&sysDescr_winfo, version_descr, 0,
 				      ASN_OCTET_STR, WATCHER_SIZE_STRLEN));
     }
@@ -338,7 +338,7 @@ init_system_mib(void)
             netsnmp_create_handler_registration(
                 "mibII/sysObjectID", NULL,
                 sysObjectID_oid, OID_LENGTH(sysObjectID_oid),
-                HANDLER_CAN_RONLY),
+                HANDLER_CAN_RONLY | HANDLER_CAN_THREADSAFE),
             netsnmp_init_watcher_info6(
 		&sysObjectID_winfo, sysObjectID, 0, ASN_OBJECT_ID,
                 WATCHER_MAX_SIZE | WATCHER_SIZE_IS_PTR,
@@ -350,7 +350,7 @@ init_system_mib(void)
             netsnmp_create_handler_registration(
                 "mibII/sysUpTime", handle_sysUpTime,
                 sysUpTime_oid, OID_LENGTH(sysUpTime_oid),
-                HANDLER_CAN_RONLY));
+                HANDLER_CAN_RONLY | HANDLER_CAN_THREADSAFE));
     }
     {
         const oid sysContact_oid[] = { 1, 3, 6, 1, 2, 1, 1, 4 };
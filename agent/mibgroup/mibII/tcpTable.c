@@ -201,6 +201,7 @@ init_tcpTable(void)
     iinfo->get_first_data_point = tcpTable_first_entry;
     iinfo->get_next_data_point  = tcpTable_next_entry;
     iinfo->table_reginfo        = table_info;
+    iinfo->flags               |= NETSNMP_ITERATOR_FLAG_INDEX_CACHE;
 #if defined (WIN32) || defined (cygwin)
     iinfo->flags               |= NETSNMP_ITERATOR_FLAG_SORTED;
 #endif /* WIN32 || cygwin */
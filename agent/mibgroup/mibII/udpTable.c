@@ -121,6 +121,11 @@ struct netsnmp_inpcb_s {
 UDPTABLE_ENTRY_TYPE	*udp_head  = NULL;
 int                      udp_size  = 0;	/* Only used for table-based systems */
 
+#ifdef linux
+static NetsnmpCacheBuild udpTable_build;
+static NetsnmpCacheSwap  udpTable_swap;
+#endif
+
 
 	/*
 	 *
@@ -157,6 +162,7 @@ init_udpTable(void)
     netsnmp_table_registration_info *table_info;
     netsnmp_iterator_info           *iinfo;
     netsnmp_handler_registration    *reginfo;
+    netsnmp_mib_handler             *handler;
     int                              rc;
 
     DEBUGMSGTL(("mibII/udpTable", "Initialising UDP Table\n"));
@@ -184,6 +190,7 @@ init_udpTable(void)
     iinfo->get_first_data_point = udpTable_first_entry;
     iinfo->get_next_data_point  = udpTable_next_entry;
     iinfo->table_reginfo        = table_info;
+    iinfo->flags               |= NETSNMP_ITERATOR_FLAG_INDEX_CACHE;
 #if defined (WIN32) || defined (cygwin)
     iinfo->flags               |= NETSNMP_ITERATOR_FLAG_SORTED;
 #endif /* WIN32 || cygwin */
@@ -203,10 +210,22 @@ init_udpTable(void)
     /*
      * .... with a local cache
      */
-    netsnmp_inject_handler( reginfo,
-		    netsnmp_get_cache_handler(UDP_STATS_CACHE_TIMEOUT,
-			   		udpTable_load, udpTable_free,
-					udpTable_oid, OID_LENGTH(udpTable_oid)));
+    handler = netsnmp_get_cache_handler(UDP_STATS_CACHE_TIMEOUT,
+                                        udpTable_load, udpTable_free,
+                                        udpTable_oid, OID_LENGTH(udpTable_oid));
+#ifdef linux
+    /*
+     * keep answering from the old list while /proc/net/udp is reread
+     */
+    if (handler) {
+        netsnmp_cache *cache = (netsnmp_cache *) handler->myvoid;
+
+        cache->build_cache = udpTable_build;
+        cache->swap_cache = udpTable_swap;
+        cache->flags |= NETSNMP_CACHE_BACKGROUND_LOAD;
+    }
+#endif
+    netsnmp_inject_handler(reginfo, handler);
 }
 
 
@@ -503,18 +522,21 @@ udpTable_load(netsnmp_cache *cache, void *vmagic)
 }
 
 #elif defined(linux)
-int
-udpTable_load(netsnmp_cache *cache, void *vmagic)
+/*
+ * Read the table into a new list, leaving the one in use alone, so
+ * that this can run as a background reload.
+ */
+static void *
+udpTable_build(netsnmp_cache *cache, void *vmagic)
 {
     FILE           *in;
     char            line[256];
-
-    udpTable_free(cache, NULL);
+    struct inpcb  **snapshot, *head = NULL, *p;
 
     if (!(in = fopen("/proc/net/udp", "r"))) {
         DEBUGMSGTL(("mibII/udpTable", "Failed to load UDP Table (linux)\n"));
         NETSNMP_LOGONCE((LOG_ERR, "snmpd: cannot open /proc/net/udp ...\n"));
-        return -1;
+        return NULL;
     }
 
     /*
@@ -543,13 +565,44 @@ udpTable_load(netsnmp_cache *cache, void *vmagic)
         if (nnew == NULL)
             break;
         memcpy(nnew, &pcb, sizeof(struct inpcb));
-        nnew->inp_next = udp_head;
-        udp_head       = nnew;
+        nnew->inp_next = head;
+        head           = nnew;
     }
 
     fclose(in);
 
+    snapshot = (struct inpcb **) malloc(sizeof(*snapshot));
+    if (NULL == snapshot) {
+        while (head) {
+            p = head;
+            head = head->inp_next;
+            free(p);
+        }
+        return NULL;
+    }
+    *snapshot = head;
     DEBUGMSGTL(("mibII/udpTable", "Loaded UDP Table (linux)\n"));
+    return snapshot;
+}
+
+static void
+udpTable_swap(netsnmp_cache *cache, void *vmagic, void *snapshot)
+{
+    udpTable_free(cache, NULL);
+    udp_head = *(struct inpcb **) snapshot;
+    free(snapshot);
+}
+
+int
+udpTable_load(netsnmp_cache *cache, void *vmagic)
+{
+    void           *snapshot;
+
+    udpTable_free(cache, NULL);
+    snapshot = udpTable_build(cache, vmagic);
+    if (NULL == snapshot)
+        return -1;
+    udpTable_swap(cache, vmagic, snapshot);
     return 0;
 }
 
@@ -922,9 +922,11 @@ write_usmUserAuthKeyChange(int action,
         }
         uptr->authKeyLen = buflen;
     } else if (action == COMMIT) {
+        sc_keycache_forget(oldkey, oldkeylen);
         SNMP_FREE(oldkey);
     } else if (action == UNDO) {
         if ((uptr = usm_parse_user(name, name_len)) != NULL && resetOnFail) {
+            sc_keycache_forget(uptr->authKey, uptr->authKeyLen);
             SNMP_FREE(uptr->authKey);
             uptr->authKey = oldkey;
             uptr->authKeyLen = oldkeylen;
@@ -1213,9 +1215,11 @@ write_usmUserPrivKeyChange(int action,
         }
         uptr->privKeyLen = buflen;
     } else if (action == COMMIT) {
+        sc_keycache_forget(oldkey, oldkeylen);
         SNMP_FREE(oldkey);
     } else if (action == UNDO) {
         if ((uptr = usm_parse_user(name, name_len)) != NULL && resetOnFail) {
+            sc_keycache_forget(uptr->privKey, uptr->privKeyLen);
             SNMP_FREE(uptr->privKey);
             uptr->privKey = oldkey;
             uptr->privKeyLen = oldkeylen;
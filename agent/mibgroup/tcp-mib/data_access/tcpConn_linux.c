@@ -12,9 +12,16 @@
 #include "tcp-mib/tcpConnectionTable/tcpConnectionTable_constants.h"
 #include "tcp-mib/data_access/tcpConn_private.h"
 #include "mibgroup/util_funcs/get_pid_from_inode.h"
+#include "mibgroup/util_funcs/sock_diag.h"
 static int
 linux_states[12] = { 1, 5, 3, 4, 6, 7, 11, 1, 8, 9, 2, 10 };
 
+/* kernel state number of listening sockets */
+#define LINUX_TCP_LISTEN 10
+
+#ifdef NETSNMP_SOCK_DIAG
+static int _load_diag(netsnmp_container *container, u_int flags);
+#endif
 static int _load4(netsnmp_container *container, u_int flags);
 #if defined (NETSNMP_ENABLE_IPV6)
 static int _load6(netsnmp_container *container, u_int flags);
@@ -92,6 +99,11 @@ netsnmp_arch_tcpconn_container_load(netsnmp_container *container,
         return -1;
     }
 
+#ifdef NETSNMP_SOCK_DIAG
+    if (0 == _load_diag(container, load_flags))
+        return 0;
+#endif
+
     rc = _load4(container, load_flags);
 
 #if defined (NETSNMP_ENABLE_IPV6)
@@ -110,6 +122,88 @@ netsnmp_arch_tcpconn_container_load(netsnmp_container *container,
     return rc;
 }
 
+#ifdef NETSNMP_SOCK_DIAG
+/**
+ * @internal
+ * add one sock_diag record to the container
+ */
+static int
+_process_diag(const struct inet_diag_msg *r, void *context)
+{
+    netsnmp_container     *container = (netsnmp_container *) context;
+    netsnmp_tcpconn_entry *entry;
+    int                    addr_len;
+
+    addr_len = (AF_INET == r->idiag_family) ? 4 : 16;
+
+    entry = netsnmp_access_tcpconn_entry_create();
+    if (NULL == entry)
+        return -1;
+
+    entry->loc_port = ntohs(r->id.idiag_sport);
+    entry->rmt_port = ntohs(r->id.idiag_dport);
+    entry->tcpConnState = (r->idiag_state & 0xf) < 12 ?
+        linux_states[r->idiag_state & 0xf] : 2;
+    entry->pid = netsnmp_get_pid_from_inode(r->idiag_inode);
+
+    /** already in network order */
+    memcpy(entry->loc_addr, r->id.idiag_src, addr_len);
+    entry->loc_addr_len = addr_len;
+    memcpy(entry->rmt_addr, r->id.idiag_dst, addr_len);
+    entry->rmt_addr_len = addr_len;
+
+    entry->arbitrary_index = CONTAINER_SIZE(container) + 1;
+    CONTAINER_INSERT(container, entry);
+
+    return 0;
+}
+
+/**
+ * load both families with sock_diag, leaving the listen/non-listen
+ * filtering to the kernel.
+ *
+ * @retval  0 no errors
+ * @retval !0 errors, the container has been emptied
+ */
+static int
+_load_diag(netsnmp_container *container, u_int load_flags)
+{
+    u_int           states = NETSNMP_SOCK_DIAG_STATES_ALL;
+    int             rc;
+
+    if (load_flags & NETSNMP_ACCESS_TCPCONN_LOAD_NOLISTEN)
+        states &= ~NETSNMP_SOCK_DIAG_STATE(LINUX_TCP_LISTEN);
+    else if (load_flags & NETSNMP_ACCESS_TCPCONN_LOAD_ONLYLISTEN)
+        states = NETSNMP_SOCK_DIAG_STATE(LINUX_TCP_LISTEN);
+
+    rc = netsnmp_sock_diag_dump(AF_INET, IPPROTO_TCP, states,
+                                _process_diag, container);
+#if defined (NETSNMP_ENABLE_IPV6)
+    if ((0 == rc) && !(load_flags & NETSNMP_ACCESS_TCPCONN_LOAD_IPV4_ONLY)) {
+        /*
+         * ipv6 module might not be loaded, so ignore -2
+         */
+        rc = netsnmp_sock_diag_dump(AF_INET6, IPPROTO_TCP, states,
+                                    _process_diag, container);
+        if (-2 == rc)
+            rc = 0;
+    }
+#endif
+
+    if (0 != rc) {
+        DEBUGMSGTL(("access:tcpconn:container",
+                    "sock_diag load failed (%d), using /proc\n", rc));
+        netsnmp_access_tcpconn_container_free(container,
+                                    NETSNMP_ACCESS_TCPCONN_FREE_KEEP_CONTAINER);
+        return rc;
+    }
+
+    DEBUGMSGTL(("access:tcpconn:container", "loaded %d entries with sock_diag\n",
+                (int)CONTAINER_SIZE(container)));
+    return 0;
+}
+#endif /* NETSNMP_SOCK_DIAG */
+
 /**
  *
  * @retval  0 no errors
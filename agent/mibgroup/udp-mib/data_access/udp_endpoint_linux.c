@@ -19,6 +19,7 @@
 
 #include "udp-mib/udpEndpointTable/udpEndpointTable_constants.h"
 #include "mibgroup/util_funcs/get_pid_from_inode.h"
+#include "mibgroup/util_funcs/sock_diag.h"
 #include "udp_endpoint_private.h"
 
 #include <fcntl.h>
@@ -26,7 +27,13 @@
 netsnmp_feature_require(text_utils);
 netsnmp_feature_child_of(udp_endpoint_all, libnetsnmpmibs);
 netsnmp_feature_child_of(udp_endpoint_writable, udp_endpoint_all);
+#ifdef NETSNMP_SOCK_DIAG
+netsnmp_feature_require(udp_endpoint_entry_create);
+#endif
 
+#ifdef NETSNMP_SOCK_DIAG
+static int _load_diag(netsnmp_container *container, u_int flags);
+#endif
 static int _load4(netsnmp_container *container, u_int flags);
 #if defined (NETSNMP_ENABLE_IPV6)
 static int _load6(netsnmp_container *container, u_int flags);
@@ -97,6 +104,11 @@ netsnmp_arch_udp_endpoint_container_load(netsnmp_container *container,
     /* Setup the pid_from_inode table, and fill it.*/
     netsnmp_get_pid_from_inode_init();
 
+#ifdef NETSNMP_SOCK_DIAG
+    if (0 == _load_diag(container, load_flags))
+        return 0;
+#endif
+
     rc = _load4(container, load_flags);
     if(rc < 0) {
         u_int flags = NETSNMP_ACCESS_UDP_ENDPOINT_FREE_KEEP_CONTAINER;
@@ -116,6 +128,92 @@ netsnmp_arch_udp_endpoint_container_load(netsnmp_container *container,
     return 0;
 }
 
+#ifdef NETSNMP_SOCK_DIAG
+/**
+ * @internal
+ * add one sock_diag record to the container
+ */
+static int
+_process_diag(const struct inet_diag_msg *r, void *context)
+{
+    netsnmp_container          *container = (netsnmp_container *) context;
+    netsnmp_udp_endpoint_entry *ep;
+    int                         addr_len;
+
+    addr_len = (AF_INET == r->idiag_family) ? 4 : 16;
+
+    ep = netsnmp_access_udp_endpoint_entry_create();
+    if (NULL == ep)
+        return -1;
+
+    /** already in network order */
+    memcpy(ep->loc_addr, r->id.idiag_src, addr_len);
+    ep->loc_addr_len = addr_len;
+    ep->loc_port = ntohs(r->id.idiag_sport);
+    memcpy(ep->rmt_addr, r->id.idiag_dst, addr_len);
+    ep->rmt_addr_len = addr_len;
+    ep->rmt_port = ntohs(r->id.idiag_dport);
+    ep->state = r->idiag_state;
+
+    /*
+     * Use inode as instance value.
+     */
+    ep->instance = r->idiag_inode;
+    ep->pid = netsnmp_get_pid_from_inode(r->idiag_inode);
+
+    ep->index = CONTAINER_SIZE(container);
+    if (CONTAINER_INSERT(container, ep) != 0) {
+        netsnmp_access_udp_endpoint_entry_free(ep);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * load both families with sock_diag
+ *
+ * @retval  0 no errors
+ * @retval !0 errors, the container has been emptied
+ */
+static int
+_load_diag(netsnmp_container *container, u_int load_flags)
+{
+    int             rc;
+
+    if (NULL == container)
+        return -1;
+
+    rc = netsnmp_sock_diag_dump(AF_INET, IPPROTO_UDP,
+                                NETSNMP_SOCK_DIAG_STATES_ALL,
+                                _process_diag, container);
+#if defined (NETSNMP_ENABLE_IPV6)
+    if (0 == rc) {
+        /*
+         * ipv6 module might not be loaded, so ignore -2
+         */
+        rc = netsnmp_sock_diag_dump(AF_INET6, IPPROTO_UDP,
+                                    NETSNMP_SOCK_DIAG_STATES_ALL,
+                                    _process_diag, container);
+        if (-2 == rc)
+            rc = 0;
+    }
+#endif
+
+    if (0 != rc) {
+        DEBUGMSGTL(("access:udp_endpoint",
+                    "sock_diag load failed (%d), using /proc\n", rc));
+        netsnmp_access_udp_endpoint_container_free(container,
+                             NETSNMP_ACCESS_UDP_ENDPOINT_FREE_KEEP_CONTAINER);
+        return rc;
+    }
+
+    DEBUGMSGTL(("access:udp_endpoint", "loaded %d entries with sock_diag\n",
+                (int)CONTAINER_SIZE(container)));
+    return 0;
+}
+#endif /* NETSNMP_SOCK_DIAG */
+
 /**
  * @internal
  * process token value index line
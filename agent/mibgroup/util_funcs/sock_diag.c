@@ -0,0 +1,140 @@
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-includes.h>
+
+#include "sock_diag.h"
+
+#include <errno.h>
+#if HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#if HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef NETSNMP_SOCK_DIAG
+
+/*
+ * the kernel fills each read with as many records as fit, so a large
+ * buffer keeps the number of system calls per dump low
+ */
+#define SOCK_DIAG_BUFSIZE 65536
+
+/**
+ * Dump the sockets of one address family and protocol.
+ *
+ * The request carries the state mask, so the kernel skips sockets in
+ * other states instead of handing them to us. Records are passed to
+ * process() straight out of the receive buffer, in kernel order.
+ *
+ * @param family    AF_INET or AF_INET6
+ * @param protocol  IPPROTO_TCP or IPPROTO_UDP
+ * @param states    mask of NETSNMP_SOCK_DIAG_STATE() bits
+ *
+ * @retval  0 success
+ * @retval -1 process() failed
+ * @retval -2 the kernel cannot dump this family/protocol; the caller
+ *            should fall back to /proc
+ */
+int
+netsnmp_sock_diag_dump(int family, int protocol, u_int states,
+                       NetsnmpSockDiagProcess *process, void *context)
+{
+    struct {
+        struct nlmsghdr         nlh;
+        struct inet_diag_req_v2 req;
+    }               request;
+    struct sockaddr_nl nladdr;
+    struct nlmsghdr *h;
+    char           *buf;
+    int             sd, len, rc = -2, done = 0;
+
+    sd = socket(AF_NETLINK, SOCK_DGRAM, NETLINK_SOCK_DIAG);
+    if (sd < 0) {
+        DEBUGMSGTL(("sock_diag", "socket: %s\n", strerror(errno)));
+        return -2;
+    }
+
+    memset(&request, 0, sizeof(request));
+    request.nlh.nlmsg_len = sizeof(request);
+    request.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    request.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.nlh.nlmsg_seq = 1;
+    request.req.sdiag_family = family;
+    request.req.sdiag_protocol = protocol;
+    request.req.idiag_states = states;
+
+    memset(&nladdr, 0, sizeof(nladdr));
+    nladdr.nl_family = AF_NETLINK;
+    if (sendto(sd, &request, sizeof(request), 0,
+               (struct sockaddr *) &nladdr, sizeof(nladdr)) < 0) {
+        DEBUGMSGTL(("sock_diag", "sendto: %s\n", strerror(errno)));
+        close(sd);
+        return -2;
+    }
+
+    buf = (char *) malloc(SOCK_DIAG_BUFSIZE);
+    if (NULL == buf) {
+        close(sd);
+        return -2;
+    }
+
+    while (!done) {
+        len = recv(sd, buf, SOCK_DIAG_BUFSIZE, 0);
+        if (len < 0) {
+            if (EINTR == errno)
+                continue;
+            DEBUGMSGTL(("sock_diag", "recv: %s\n", strerror(errno)));
+            break;
+        }
+        if (0 == len)
+            break;
+
+        for (h = (struct nlmsghdr *) buf; NLMSG_OK(h, len);
+             h = NLMSG_NEXT(h, len)) {
+            if (NLMSG_DONE == h->nlmsg_type) {
+                rc = 0;
+                done = 1;
+                break;
+            }
+            if (NLMSG_ERROR == h->nlmsg_type) {
+                /*
+                 * e.g. ENOENT when the udp_diag module is not loaded
+                 */
+                struct nlmsgerr *err = (struct nlmsgerr *) NLMSG_DATA(h);
+                DEBUGMSGTL(("sock_diag", "family %d protocol %d: error %d\n",
+                            family, protocol, err->error));
+                done = 1;
+                break;
+            }
+            if (SOCK_DIAG_BY_FAMILY != h->nlmsg_type ||
+                h->nlmsg_len < NLMSG_LENGTH(sizeof(struct inet_diag_msg)))
+                continue;
+            if (process((struct inet_diag_msg *) NLMSG_DATA(h),
+                        context) < 0) {
+                rc = -1;
+                done = 1;
+                break;
+            }
+        }
+    }
+
+    free(buf);
+    close(sd);
+    return rc;
+}
+
+#else /* NETSNMP_SOCK_DIAG */
+
+int
+netsnmp_sock_diag_dump(int family, int protocol, u_int states,
+                       NetsnmpSockDiagProcess *process, void *context)
+{
+    return -2;
+}
+
+#endif /* NETSNMP_SOCK_DIAG */
@@ -0,0 +1,36 @@
+/*
+ * util_funcs/sock_diag.h:  utility function to dump the kernel's
+ * tcp and udp socket tables over a NETLINK_SOCK_DIAG socket on linux.
+ */
+#ifndef NETSNMP_MIBGROUP_UTIL_FUNCS_SOCK_DIAG_H
+#define NETSNMP_MIBGROUP_UTIL_FUNCS_SOCK_DIAG_H
+
+#ifndef linux
+config_error(sock_diag is only suppored on linux)
+#endif
+
+#if defined(HAVE_LINUX_INET_DIAG_H) && defined(HAVE_LINUX_SOCK_DIAG_H)
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+#define NETSNMP_SOCK_DIAG 1
+#endif
+
+struct inet_diag_msg;
+
+/*
+ * called once per socket record; a negative return aborts the dump
+ */
+typedef int (NetsnmpSockDiagProcess)(const struct inet_diag_msg *msg,
+                                     void *context);
+
+/*
+ * all tcp states, in kernel numbering
+ */
+#define NETSNMP_SOCK_DIAG_STATES_ALL    0xfff
+#define NETSNMP_SOCK_DIAG_STATE(s)      (1 << (s))
+
+int netsnmp_sock_diag_dump(int family, int protocol, u_int states,
+                           NetsnmpSockDiagProcess *process, void *context);
+
+#endif /* NETSNMP_MIBGROUP_UTIL_FUNCS_SOCK_DIAG_H */
@@ -83,6 +83,7 @@ SOFTWARE.
 #include <net-snmp/agent/net-snmp-agent-includes.h>
 #include <net-snmp/library/large_fd_set.h>
 #include <net-snmp/library/snmp_assert.h>
+#include <net-snmp/agent/stats_segment.h>
 #include "agent_global_vars.h"
 
 #if HAVE_SYSLOG_H
@@ -376,6 +377,286 @@ int             handle_set_loop(netsnmp_agent_session *asp);
 
 int             netsnmp_remove_from_delegated(netsnmp_agent_session *asp);
 
+#if defined(NETSNMP_REENTRANT) && defined(HAVE_PTHREAD_H)
+#define NETSNMP_AGENT_WORKERS 1
+#endif
+
+static int      _handle_var_requests_pass(netsnmp_agent_session *asp);
+
+#ifdef NETSNMP_AGENT_WORKERS
+
+/*
+ * Optional pool of threads running the handlers of read requests.  The
+ * main thread still receives, parses and answers every PDU.  A pass over
+ * the tree cache whose registrations are all flagged
+ * HANDLER_CAN_THREADSAFE is handed to a worker instead of being run
+ * inline; the agent session stays on the delegated list until the worker
+ * reports completion through a pipe watched by the main loop.
+ *
+ * The threads are only started by the first request, as snmpd forks
+ * into the background after init_master_agent() and threads do not
+ * survive fork().
+ */
+typedef struct agent_worker_job_s {
+    netsnmp_done_item done;     /* must be first */
+    netsnmp_agent_session *asp;
+    int             status;
+    struct agent_worker_job_s *next;
+} agent_worker_job;
+
+static pthread_t *_worker_threads = NULL;
+static int      _worker_count = 0;
+static int      _worker_started = 0;
+static int      _worker_stop = 0;
+static pthread_mutex_t _worker_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _worker_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t _worker_idle = PTHREAD_COND_INITIALIZER;
+static int      _worker_busy = 0;
+static agent_worker_job *_worker_todo_head = NULL;
+static agent_worker_job *_worker_todo_tail = NULL;
+static u_long   _worker_todo_count = 0;
+static netsnmp_done_queue _worker_done = NETSNMP_DONE_QUEUE_INITIALIZER;
+
+static void     _agent_workers_init(void);
+
+static void    *
+_agent_worker_run(void *arg)
+{
+    agent_worker_job *job;
+
+    for (;;) {
+        pthread_mutex_lock(&_worker_lock);
+        while (NULL == _worker_todo_head && !_worker_stop)
+            pthread_cond_wait(&_worker_cond, &_worker_lock);
+        if (_worker_stop) {
+            pthread_mutex_unlock(&_worker_lock);
+            break;
+        }
+        job = _worker_todo_head;
+        _worker_todo_head = job->next;
+        if (NULL == _worker_todo_head)
+            _worker_todo_tail = NULL;
+        _worker_todo_count--;
+        _worker_busy++;
+        if (netsnmp_stats_segment_get())
+            netsnmp_stats_segment_queue(&netsnmp_stats_segment_get()->workers,
+                                        _worker_todo_count);
+        pthread_mutex_unlock(&_worker_lock);
+
+        job->status = _handle_var_requests_pass(job->asp);
+        netsnmp_done_queue_push(&_worker_done, &job->done);
+
+        pthread_mutex_lock(&_worker_lock);
+        if (0 == --_worker_busy && NULL == _worker_todo_head)
+            pthread_cond_broadcast(&_worker_idle);
+        pthread_mutex_unlock(&_worker_lock);
+    }
+    return NULL;
+}
+
+/*
+ * main thread: pick up the sessions the workers have finished with
+ */
+static void
+_agent_worker_done(int fd, void *data)
+{
+    agent_worker_job *job;
+    netsnmp_agent_session *asp;
+
+    netsnmp_done_queue_ack(&_worker_done);
+
+    while ((job = (agent_worker_job *)
+            netsnmp_done_queue_pop(&_worker_done)) != NULL) {
+        asp = job->asp;
+        asp->flags &= ~SNMP_AGENT_FLAGS_IN_WORKER;
+        DEBUGMSGTL(("snmp_agent:worker", "asp %8p done, status %d\n",
+                    asp, job->status));
+        if (asp->flags & SNMP_AGENT_FLAGS_FREE_PENDING) {
+            free_agent_snmp_session(asp);
+        } else {
+            /*
+             * finish off what handle_pdu() would have done inline
+             */
+            if (SNMP_MSG_GET == asp->mode &&
+                SNMP_ERR_NOERROR == job->status)
+                snmp_replace_var_types(asp->pdu->variables, ASN_NULL,
+                                       SNMP_NOSUCHINSTANCE);
+            if (SNMP_ERR_NOERROR != job->status &&
+                SNMP_ERR_NOERROR == asp->status)
+                asp->status = job->status;
+        }
+        free(job);
+    }
+
+    netsnmp_check_outstanding_agent_requests();
+}
+
+/*
+ * SNMP_CALLBACK_PRE_READ_CONFIG: lets the passes in flight finish before
+ * a reconfiguration changes the data their handlers read
+ */
+static int
+_agent_workers_drain(int majorID, int minorID, void *serverarg,
+                     void *clientarg)
+{
+    pthread_mutex_lock(&_worker_lock);
+    while (_worker_todo_head || _worker_busy)
+        pthread_cond_wait(&_worker_idle, &_worker_lock);
+    pthread_mutex_unlock(&_worker_lock);
+    return SNMPERR_SUCCESS;
+}
+
+/*
+ * Hand the current pass of asp to the worker pool if possible.
+ *
+ * Returns 1 if a worker now owns asp, 0 if the caller must run the
+ * handlers itself.
+ */
+static int
+_agent_worker_dispatch(netsnmp_agent_session *asp)
+{
+    netsnmp_handler_registration *reginfo;
+    agent_worker_job *job;
+    int             i;
+
+    if (!_worker_started)
+        _agent_workers_init();
+    if (0 == _worker_count || asp->treecache_num < 0)
+        return 0;
+
+    /*
+     * SETs and the GET pass of AgentX INCLUSIVE getNexts stay here
+     */
+    if (asp->mode != asp->pdu->command)
+        return 0;
+    switch (asp->mode) {
+    case SNMP_MSG_GET:
+    case SNMP_MSG_GETNEXT:
+    case SNMP_MSG_GETBULK:
+        break;
+    default:
+        return 0;
+    }
+
+    for (i = 0; i <= asp->treecache_num; i++) {
+        reginfo = asp->treecache[i].subtree->reginfo;
+        if (NULL == reginfo || !(reginfo->modes & HANDLER_CAN_THREADSAFE))
+            return 0;
+    }
+
+    job = SNMP_MALLOC_TYPEDEF(agent_worker_job);
+    if (NULL == job)
+        return 0;
+    job->asp = asp;
+    asp->flags |= SNMP_AGENT_FLAGS_IN_WORKER;
+    DEBUGMSGTL(("snmp_agent:worker", "asp %8p handed to worker pool\n",
+                asp));
+
+    pthread_mutex_lock(&_worker_lock);
+    if (_worker_todo_tail)
+        _worker_todo_tail->next = job;
+    else
+        _worker_todo_head = job;
+    _worker_todo_tail = job;
+    _worker_todo_count++;
+    if (netsnmp_stats_segment_get())
+        netsnmp_stats_segment_queue(&netsnmp_stats_segment_get()->workers,
+                                    _worker_todo_count);
+    pthread_cond_signal(&_worker_cond);
+    pthread_mutex_unlock(&_worker_lock);
+
+    return 1;
+}
+
+static void
+_agent_workers_init(void)
+{
+    int             count, i;
+
+    _worker_started = 1;
+    count = netsnmp_ds_get_int(NETSNMP_DS_APPLICATION_ID,
+                               NETSNMP_DS_AGENT_WORKER_THREADS);
+    if (count <= 0 || _worker_count > 0)
+        return;
+
+    if (!netsnmp_done_queue_open(&_worker_done))
+        return;
+    if (register_readfd(_worker_done.fd[0], _agent_worker_done, NULL) != FD_REGISTERED_OK) {
+        snmp_log(LOG_ERR, "agentWorkerThreads: cannot watch completion pipe\n");
+        goto fail;
+    }
+
+    _worker_threads = (pthread_t *) calloc(count, sizeof(pthread_t));
+    if (NULL == _worker_threads)
+        goto fail;
+    _worker_stop = 0;
+    for (i = 0; i < count; i++) {
+        if (pthread_create(&_worker_threads[i], NULL, _agent_worker_run,
+                           NULL) != 0) {
+            snmp_log(LOG_ERR, "agentWorkerThreads: could only start %d of "
+                     "%d threads\n", i, count);
+            break;
+        }
+    }
+    _worker_count = i;
+    if (0 == _worker_count)
+        goto fail;
+    snmp_register_callback(SNMP_CALLBACK_LIBRARY,
+                           SNMP_CALLBACK_PRE_READ_CONFIG,
+                           _agent_workers_drain, NULL);
+    DEBUGMSGTL(("snmp_agent:worker", "started %d worker threads\n",
+                _worker_count));
+    return;
+
+  fail:
+    unregister_readfd(_worker_done.fd[0]);
+    netsnmp_done_queue_close(&_worker_done);
+    SNMP_FREE(_worker_threads);
+}
+
+static void
+_agent_workers_shutdown(void)
+{
+    agent_worker_job *job;
+    int             i;
+
+    _worker_started = 0;
+    if (0 == _worker_count)
+        return;
+
+    snmp_unregister_callback(SNMP_CALLBACK_LIBRARY,
+                             SNMP_CALLBACK_PRE_READ_CONFIG,
+                             _agent_workers_drain, NULL, 1);
+    pthread_mutex_lock(&_worker_lock);
+    _worker_stop = 1;
+    pthread_cond_broadcast(&_worker_cond);
+    pthread_mutex_unlock(&_worker_lock);
+    for (i = 0; i < _worker_count; i++)
+        pthread_join(_worker_threads[i], NULL);
+    _worker_count = 0;
+    SNMP_FREE(_worker_threads);
+
+    /*
+     * sessions still queued never started; those already done get freed
+     * with the rest of the agent sessions
+     */
+    while ((job = _worker_todo_head) != NULL) {
+        _worker_todo_head = job->next;
+        job->asp->flags &= ~SNMP_AGENT_FLAGS_IN_WORKER;
+        free(job);
+    }
+    _worker_todo_tail = NULL;
+    while ((job = (agent_worker_job *)
+            netsnmp_done_queue_pop(&_worker_done)) != NULL) {
+        job->asp->flags &= ~SNMP_AGENT_FLAGS_IN_WORKER;
+        free(job);
+    }
+
+    unregister_readfd(_worker_done.fd[0]);
+    netsnmp_done_queue_close(&_worker_done);
+}
+#endif /* NETSNMP_AGENT_WORKERS */
+
 
 int      netsnmp_running = 1;
 
@@ -1538,6 +1819,18 @@ init_master_agent(void)
     _pdu_stats_init();
 #endif /* NETSNMP_NO_PDU_STATS */
 
+    cptr = netsnmp_ds_get_string(NETSNMP_DS_APPLICATION_ID,
+                                 NETSNMP_DS_AGENT_STATS_SEGMENT);
+    if (cptr)
+        netsnmp_stats_segment_open(cptr);
+
+#ifndef NETSNMP_AGENT_WORKERS
+    if (netsnmp_ds_get_int(NETSNMP_DS_APPLICATION_ID,
+                           NETSNMP_DS_AGENT_WORKER_THREADS) > 0)
+        snmp_log(LOG_WARNING, "agentWorkerThreads ignored: the agent was "
+                 "built without --enable-reentrant\n");
+#endif /* !NETSNMP_AGENT_WORKERS */
+
     return 0;
 }
 
@@ -1553,6 +1846,12 @@ clear_nsap_list(void)
 void
 shutdown_master_agent(void)
 {
+#ifdef NETSNMP_AGENT_WORKERS
+    _agent_workers_shutdown();
+#endif /* NETSNMP_AGENT_WORKERS */
+
+    netsnmp_stats_segment_close();
+
     clear_nsap_list();
 
 #ifndef NETSNMP_NO_PDU_STATS
@@ -1561,11 +1860,150 @@ shutdown_master_agent(void)
 }
 
 
+/*
+ * Released agent sessions (and their reqinfo) are kept on a free list for
+ * the next request instead of being freed.  The request and tree cache
+ * arrays they used go onto small stacks of spare arrays of their own,
+ * since the subagent set cache moves those arrays between sessions.
+ * Pooling follows the library's PDU pool: a negative pduPoolSize turns it
+ * off.  Only the main loop allocates and releases agent sessions, so none
+ * of this needs locking.
+ */
+#ifndef NETSNMP_AGENT_SESSION_POOL_MAX
+#define NETSNMP_AGENT_SESSION_POOL_MAX 16
+#endif
+#define AGENT_SPARE_ARRAYS      8       /* arrays kept per stack */
+#define AGENT_SPARE_ARRAY_MAX   64      /* larger arrays are always freed */
+
+typedef struct agent_spare_array_s {
+    void           *array;
+    int             len;
+} agent_spare_array;
+
+static netsnmp_agent_session *_asp_pool = NULL;
+static int      _asp_pool_count = 0;
+static agent_spare_array _spare_requests[AGENT_SPARE_ARRAYS];
+static int      _spare_requests_count = 0;
+static agent_spare_array _spare_treecache[AGENT_SPARE_ARRAYS];
+static int      _spare_treecache_count = 0;
+
+static int
+_agent_pool_enabled(void)
+{
+    return netsnmp_ds_get_int(NETSNMP_DS_LIBRARY_ID,
+                              NETSNMP_DS_LIB_PDU_POOL_SIZE) >= 0;
+}
+
+/*
+ * Returns a zeroed array of at least len elements of the given size,
+ * reusing a spare one when possible; *alloced is set to its real length.
+ */
+static void    *
+_spare_array_get(agent_spare_array *stack, int *count, int len,
+                 size_t size, int *alloced)
+{
+    agent_spare_array *spare;
+
+    if (*count > 0) {
+        spare = &stack[--(*count)];
+        if (spare->len >= len) {
+            memset(spare->array, 0, spare->len * size);
+            if (alloced)
+                *alloced = spare->len;
+            return spare->array;
+        }
+        free(spare->array);
+    }
+    if (alloced)
+        *alloced = len;
+    return calloc(len, size);
+}
+
+static void
+_spare_array_put(agent_spare_array *stack, int *count, void *array, int len)
+{
+    if (NULL == array)
+        return;
+    if (*count >= AGENT_SPARE_ARRAYS || len <= 0 ||
+        len > AGENT_SPARE_ARRAY_MAX || !_agent_pool_enabled()) {
+        free(array);
+        return;
+    }
+    stack[*count].array = array;
+    stack[*count].len = len;
+    (*count)++;
+}
+
+static netsnmp_agent_session *
+_agent_session_alloc(void)
+{
+    netsnmp_agent_session *asp = _asp_pool;
+    netsnmp_agent_request_info *reqinfo;
+
+    if (NULL == asp) {
+        snmp_increment_statistic(STAT_POOL_AGENT_SESSION_MISSES);
+        asp = (netsnmp_agent_session *)
+            calloc(1, sizeof(netsnmp_agent_session));
+        if (asp)
+            asp->reqinfo = SNMP_MALLOC_TYPEDEF(netsnmp_agent_request_info);
+        return asp;
+    }
+
+    snmp_increment_statistic(STAT_POOL_AGENT_SESSION_HITS);
+    _asp_pool = asp->next;
+    _asp_pool_count--;
+    reqinfo = asp->reqinfo;
+    memset(asp, 0, sizeof(*asp));
+    if (reqinfo)
+        memset(reqinfo, 0, sizeof(*reqinfo));
+    else
+        reqinfo = SNMP_MALLOC_TYPEDEF(netsnmp_agent_request_info);
+    asp->reqinfo = reqinfo;
+    return asp;
+}
+
+static void
+_agent_session_release(netsnmp_agent_session *asp)
+{
+    if (_asp_pool_count >= NETSNMP_AGENT_SESSION_POOL_MAX ||
+        !_agent_pool_enabled()) {
+        netsnmp_free_agent_request_info(asp->reqinfo);
+        free(asp);
+        return;
+    }
+    if (asp->reqinfo && asp->reqinfo->agent_data) {
+        netsnmp_free_all_list_data(asp->reqinfo->agent_data);
+        asp->reqinfo->agent_data = NULL;
+    }
+    asp->next = _asp_pool;
+    _asp_pool = asp;
+    _asp_pool_count++;
+}
+
+/**
+ * Frees the agent sessions and arrays kept for reuse.
+ */
+void
+netsnmp_agent_session_pool_shutdown(void)
+{
+    netsnmp_agent_session *asp;
+
+    while ((asp = _asp_pool) != NULL) {
+        _asp_pool = asp->next;
+        netsnmp_free_agent_request_info(asp->reqinfo);
+        free(asp);
+    }
+    _asp_pool_count = 0;
+    while (_spare_requests_count > 0)
+        free(_spare_requests[--_spare_requests_count].array);
+    while (_spare_treecache_count > 0)
+        free(_spare_treecache[--_spare_treecache_count].array);
+}
+
 netsnmp_agent_session *
 init_agent_snmp_session(netsnmp_session * session, netsnmp_pdu *pdu)
 {
-    netsnmp_agent_session *asp = (netsnmp_agent_session *)
-        calloc(1, sizeof(netsnmp_agent_session));
+    netsnmp_agent_session *asp = _agent_session_alloc();
 
     if (asp == NULL) {
         return NULL;
@@ -1584,8 +2022,9 @@ init_agent_snmp_session(netsnmp_session * session, netsnmp_pdu *pdu)
     asp->oldmode = 0;
     asp->treecache_num = -1;
     asp->treecache_len = 0;
-    asp->reqinfo = SNMP_MALLOC_TYPEDEF(netsnmp_agent_request_info);
     asp->flags = SNMP_AGENT_FLAGS_NONE;
+    if (netsnmp_stats_segment_get())
+        netsnmp_get_monotonic_clock(&asp->stats_start);
     DEBUGMSGTL(("verbose:asp", "asp %p reqinfo %p created\n",
                 asp, asp->reqinfo));
 
@@ -1598,6 +2037,20 @@ free_agent_snmp_session(netsnmp_agent_session *asp)
     if (!asp)
         return;
 
+#ifdef NETSNMP_AGENT_WORKERS
+    if (asp->flags & SNMP_AGENT_FLAGS_IN_WORKER) {
+        /*
+         * a worker is still running handlers for it; _agent_worker_done()
+         * frees it once the worker lets go
+         */
+        DEBUGMSGTL(("snmp_agent","agent_session %8p release deferred\n",
+                    asp));
+        netsnmp_remove_from_delegated(asp);
+        asp->flags |= SNMP_AGENT_FLAGS_FREE_PENDING;
+        return;
+    }
+#endif /* NETSNMP_AGENT_WORKERS */
+
     DEBUGMSGTL(("snmp_agent","agent_session %8p released\n", asp));
 
     netsnmp_remove_from_delegated(asp);
@@ -1609,22 +2062,24 @@ free_agent_snmp_session(netsnmp_agent_session *asp)
         snmp_free_pdu(asp->orig_pdu);
     if (asp->pdu)
         snmp_free_pdu(asp->pdu);
-    if (asp->reqinfo)
-        netsnmp_free_agent_request_info(asp->reqinfo);
-    SNMP_FREE(asp->treecache);
+    _spare_array_put(_spare_treecache, &_spare_treecache_count,
+                     asp->treecache, asp->treecache_len);
+    asp->treecache = NULL;
     SNMP_FREE(asp->bulkcache);
     if (asp->requests) {
         int             i;
         for (i = 0; i < asp->vbcount; i++) {
             netsnmp_free_request_data_sets(&asp->requests[i]);
         }
-        SNMP_FREE(asp->requests);
+        _spare_array_put(_spare_requests, &_spare_requests_count,
+                         asp->requests, asp->vbcount);
+        asp->requests = NULL;
     }
     if (asp->cache_store) {
         netsnmp_free_cachemap(asp->cache_store);
         asp->cache_store = NULL;
     }
-    SNMP_FREE(asp);
+    _agent_session_release(asp);
 }
 
 int
@@ -1633,6 +2088,9 @@ netsnmp_check_for_delegated(netsnmp_agent_session *asp)
     int             i;
     netsnmp_request_info *request;
 
+    if (asp->flags & SNMP_AGENT_FLAGS_IN_WORKER)
+        return 1;
+
     if (NULL == asp->treecache)
         return 0;
 
@@ -1725,6 +2183,12 @@ netsnmp_remove_delegated_requests_for_session(netsnmp_session *sess)
         int i;
         int count = 0;
         netsnmp_request_info *request;
+
+        /*
+         * a worker only runs thread-safe handlers, never remote ones
+         */
+        if (asp->flags & SNMP_AGENT_FLAGS_IN_WORKER)
+            continue;
         for (i = 0; i <= asp->treecache_num; i++) {
             for (request = asp->treecache[i].requests_begin; request;
                  request = request->next) {
@@ -1885,6 +2349,9 @@ netsnmp_pdu_stats_process(netsnmp_agent_session *asp)
 int
 netsnmp_wrap_up_request(netsnmp_agent_session *asp, int status)
 {
+    if (netsnmp_stats_segment_get() && asp->pdu)
+        netsnmp_stats_segment_pdu(asp->pdu->command, &asp->stats_start);
+
 #ifndef NETSNMP_NO_PDU_STATS
     if (_pdu_stats_max > 0)
         netsnmp_pdu_stats_process(asp);
@@ -2589,9 +3056,10 @@ netsnmp_create_subtree_cache(netsnmp_agent_session *asp)
     DEBUGMSGTL(("msgMaxSize", "pdu max size %lu\n", asp->pdu->msgMaxSize));
 
     if (asp->treecache == NULL && asp->treecache_len == 0) {
-        asp->treecache_len = SNMP_MAX(1 + asp->vbcount / 4, 16);
-        asp->treecache =
-            (netsnmp_tree_cache *)calloc(asp->treecache_len, sizeof(netsnmp_tree_cache));
+        asp->treecache = (netsnmp_tree_cache *)
+            _spare_array_get(_spare_treecache, &_spare_treecache_count,
+                             SNMP_MAX(1 + asp->vbcount / 4, 16),
+                             sizeof(netsnmp_tree_cache), &asp->treecache_len);
         if (asp->treecache == NULL)
             return SNMP_ERR_GENERR;
     }
@@ -2710,8 +3178,7 @@ netsnmp_create_subtree_cache(netsnmp_agent_session *asp)
                     asp->bulkcache[bulkcount++] = vbptr;
 
                     for (i = 1; i < asp->pdu->errindex; i++) {
-                        vbptr->next_variable =
-                            SNMP_MALLOC_STRUCT(variable_list);
+                        vbptr->next_variable = netsnmp_varbind_alloc();
                         /*
                          * don't clone the oid as it's got to be
                          * overwritten anyway 
@@ -2979,14 +3446,33 @@ netsnmp_check_all_requests_status(netsnmp_agent_session *asp,
 
 int
 handle_var_requests(netsnmp_agent_session *asp)
+{
+    asp->reqinfo->asp = asp;
+    asp->reqinfo->mode = asp->mode;
+
+#ifdef NETSNMP_AGENT_WORKERS
+    /*
+     * if a worker takes it, asp looks delegated until the worker is done
+     */
+    if (_agent_worker_dispatch(asp))
+        return SNMP_ERR_NOERROR;
+#endif /* NETSNMP_AGENT_WORKERS */
+
+    return _handle_var_requests_pass(asp);
+}
+
+/*
+ * Calls the handlers for every subtree in the tree cache of asp.  This
+ * may run on a worker thread, so it must not touch any global agent
+ * state.
+ */
+static int
+_handle_var_requests_pass(netsnmp_agent_session *asp)
 {
     int             i, retstatus = SNMP_ERR_NOERROR,
         status = SNMP_ERR_NOERROR, final_status = SNMP_ERR_NOERROR;
     netsnmp_handler_registration *reginfo;
 
-    asp->reqinfo->asp = asp;
-    asp->reqinfo->mode = asp->mode;
-
     /*
      * now, have the subtrees in the cache go search for their results 
      */
@@ -3119,6 +3605,19 @@ void
 netsnmp_check_outstanding_agent_requests(void)
 {
     netsnmp_agent_session *asp;
+    netsnmp_stats_segment *seg = netsnmp_stats_segment_get();
+
+    if (seg) {
+        u_long          n = 0;
+
+        for (asp = agent_delegated_list; asp; asp = asp->next)
+            n++;
+        netsnmp_stats_segment_queue(&seg->delegated, n);
+        n = 0;
+        for (asp = netsnmp_agent_queued_list; asp; asp = asp->next)
+            n++;
+        netsnmp_stats_segment_queue(&seg->set_queued, n);
+    }
 
     /*
      * deal with delegated requests
@@ -3756,7 +4255,10 @@ handle_pdu(netsnmp_agent_session *asp)
     case SNMP_MSG_INTERNAL_SET_RESERVE1:
 #endif /* NETSNMP_NO_WRITE_SUPPORT */
         asp->vbcount = count_varbinds(asp->pdu->variables);
-        asp->requests = calloc(asp->vbcount, sizeof(netsnmp_request_info));
+        asp->requests = (netsnmp_request_info *)
+            _spare_array_get(_spare_requests, &_spare_requests_count,
+                             asp->vbcount, sizeof(netsnmp_request_info),
+                             NULL);
         /*
          * collect varbinds 
          */
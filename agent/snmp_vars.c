@@ -384,6 +384,7 @@ shutdown_agent(void) {
     clear_callback();
     shutdown_secmod();
     netsnmp_addrcache_destroy();
+    netsnmp_agent_session_pool_shutdown();
 #ifdef HAVE_KMEM
     free_kmem();
 #endif
@@ -1176,6 +1176,7 @@ receive(void)
     netsnmp_large_fd_set readfds, writefds, exceptfds;
     struct timeval  timeout, *tvp = &timeout;
     int             count, block, i;
+    int             use_epoll = 0;
 #ifdef	USING_SMUX_MODULE
     int             sd;
 #endif                          /* USING_SMUX_MODULE */
@@ -1189,6 +1190,20 @@ receive(void)
      */
     reconfig = 0;
 
+#ifndef NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER
+    use_epoll = (netsnmp_epoll_event_loop_init() == 0);
+#ifdef	USING_SMUX_MODULE
+    if (use_epoll && smux_listen_sd >= 0) {
+        /*
+         * SMUX peers are only watched by the select() loop
+         */
+        snmp_log(LOG_WARNING, "SMUX is enabled, using select\n");
+        netsnmp_epoll_event_loop_shutdown();
+        use_epoll = 0;
+    }
+#endif                          /* USING_SMUX_MODULE */
+#endif /* NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER */
+
 #if defined(WIN32)
     create_stdin_waiter_thread();
 #endif
@@ -1225,35 +1240,46 @@ receive(void)
         tvp->tv_usec = 0;
 
         numfds = 0;
-        NETSNMP_LARGE_FD_ZERO(&readfds);
-        NETSNMP_LARGE_FD_ZERO(&writefds);
-        NETSNMP_LARGE_FD_ZERO(&exceptfds);
         block = 0;
-        snmp_select_info2(&numfds, &readfds, tvp, &block);
+        if (use_epoll) {
+            /*
+             * the epoll set is kept up to date; only the timers are needed
+             */
+            snmp_sess_select_info2_flags(NULL, &numfds, NULL, tvp, &block,
+                                         NETSNMP_SELECT_NOFDS);
+        } else {
+            NETSNMP_LARGE_FD_ZERO(&readfds);
+            NETSNMP_LARGE_FD_ZERO(&writefds);
+            NETSNMP_LARGE_FD_ZERO(&exceptfds);
+            snmp_select_info2(&numfds, &readfds, tvp, &block);
+        }
         if (block == 1) {
             tvp = NULL;         /* block without timeout */
 	}
 
+        if (!use_epoll) {
 #ifdef	USING_SMUX_MODULE
-        if (smux_listen_sd >= 0) {
-            NETSNMP_LARGE_FD_SET(smux_listen_sd, &readfds);
-            numfds =
-                smux_listen_sd >= numfds ? smux_listen_sd + 1 : numfds;
-
-            for (i = 0; i < smux_snmp_select_list_get_length(); i++) {
-                sd = smux_snmp_select_list_get_SD_from_List(i);
-                if (sd != 0)
-                {
-                   NETSNMP_LARGE_FD_SET(sd, &readfds);
-                   numfds = sd >= numfds ? sd + 1 : numfds;
+            if (smux_listen_sd >= 0) {
+                NETSNMP_LARGE_FD_SET(smux_listen_sd, &readfds);
+                numfds =
+                    smux_listen_sd >= numfds ? smux_listen_sd + 1 : numfds;
+
+                for (i = 0; i < smux_snmp_select_list_get_length(); i++) {
+                    sd = smux_snmp_select_list_get_SD_from_List(i);
+                    if (sd != 0)
+                    {
+                       NETSNMP_LARGE_FD_SET(sd, &readfds);
+                       numfds = sd >= numfds ? sd + 1 : numfds;
+                    }
                 }
             }
-        }
 #endif                          /* USING_SMUX_MODULE */
 
 #ifndef NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER
-        netsnmp_external_event_info2(&numfds, &readfds, &writefds, &exceptfds);
+            netsnmp_external_event_info2(&numfds, &readfds, &writefds,
+                                         &exceptfds);
 #endif /* NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER */
+        }
 
     reselect:
 #ifndef NETSNMP_FEATURE_REMOVE_REGISTER_SIGNAL
@@ -1265,16 +1291,25 @@ receive(void)
         }
 #endif /* NETSNMP_FEATURE_REMOVE_REGISTER_SIGNAL */
 
-        DEBUGMSGTL(("snmpd/select", "select( numfds=%d, ..., tvp=%p)\n",
-                    numfds, tvp));
+        DEBUGMSGTL(("snmpd/select", "%s( numfds=%d, ..., tvp=%p)\n",
+                    use_epoll ? "epoll_wait" : "select", numfds, tvp));
         if (tvp)
             DEBUGMSGTL(("timer", "tvp %ld.%ld\n", (long) tvp->tv_sec,
                         (long) tvp->tv_usec));
+#ifndef NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER
+        if (use_epoll)
+            count = netsnmp_epoll_wait(tvp);
+        else
+#endif /* NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER */
         count = netsnmp_large_fd_set_select(numfds, &readfds, &writefds, &exceptfds,
 				     tvp);
         DEBUGMSGTL(("snmpd/select", "returned, count = %d\n", count));
 
-        if (count > 0) {
+        if (count > 0 && use_epoll) {
+#ifndef NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER
+            netsnmp_epoll_dispatch_events(&count);
+#endif /* NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER */
+        } else if (count > 0) {
 
 #ifdef USING_SMUX_MODULE
             /*
@@ -1349,6 +1384,10 @@ receive(void)
 
     }                           /* endwhile */
 
+#ifndef NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER
+    if (use_epoll)
+        netsnmp_epoll_event_loop_shutdown();
+#endif /* NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER */
     netsnmp_large_fd_set_cleanup(&readfds);
     netsnmp_large_fd_set_cleanup(&writefds);
     netsnmp_large_fd_set_cleanup(&exceptfds);
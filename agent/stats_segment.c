@@ -0,0 +1,362 @@
+/*
+ * stats_segment.c: the agent's own counters in a shared memory file
+ *
+ * See stats_segment.h for the layout and the rules a reader must follow.
+ */
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-includes.h>
+#include <net-snmp/agent/net-snmp-agent-includes.h>
+#include <net-snmp/agent/stats_segment.h>
+
+#include <errno.h>
+#if HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#if HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#define NETSNMP_STATS_SEGMENT 1
+#endif
+
+#if defined(NETSNMP_REENTRANT) && defined(HAVE_PTHREAD_H)
+#include <pthread.h>
+#define NETSNMP_STATS_SEGMENT_THREADS 1
+#endif
+
+/*
+ * Worker threads may update the same histogram at once, so counters are
+ * added to atomically where the compiler can.  max_usec is a plain
+ * store: a race may lose a maximum, but never corrupts a counter.
+ */
+#if defined(NETSNMP_STATS_SEGMENT_THREADS) && defined(__GNUC__)
+#define STATS_ADD(var, n)   __sync_fetch_and_add(&(var), (n))
+#else
+#define STATS_ADD(var, n)   ((var) += (n))
+#endif
+
+/**
+ * Adds a time of usec microseconds to a histogram.  This is also used
+ * for histograms kept outside the segment.
+ */
+void
+netsnmp_stats_hist_add(netsnmp_stats_hist *hist, u_long usec)
+{
+    u_long          limit = 100;
+    int             i;
+
+    STATS_ADD(hist->count, 1);
+    STATS_ADD(hist->total_usec, usec);
+    if (usec > hist->max_usec)
+        hist->max_usec = usec;
+    for (i = 0; i < NETSNMP_STATS_BUCKETS - 1 && usec >= limit; i++)
+        limit *= 10;
+    STATS_ADD(hist->buckets[i], 1);
+}
+
+#ifdef NETSNMP_STATS_SEGMENT
+
+static netsnmp_stats_segment *_segment = NULL;
+
+#ifdef NETSNMP_STATS_SEGMENT_THREADS
+/*
+ * only taken to give a new handler name a slot
+ */
+static pthread_mutex_t _segment_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static u_long
+_stats_elapsed_usec(const struct timeval *start)
+{
+    struct timeval  now, diff;
+
+    netsnmp_get_monotonic_clock(&now);
+    NETSNMP_TIMERSUB(&now, start, &diff);
+    return diff.tv_sec * 1000000 + diff.tv_usec;
+}
+
+/**
+ * Creates the segment file and maps it.  The file is built under a
+ * fresh name in the same directory and then renamed over path, so path
+ * itself is never opened (a link planted there cannot redirect the
+ * agent) and a reader still mapping an older file is not cut short.
+ *
+ * @return 0 on success, -1 on failure (logged)
+ */
+int
+netsnmp_stats_segment_open(const char *path)
+{
+    netsnmp_stats_segment *seg;
+    char           *tmp;
+    int             fd = -1;
+
+    netsnmp_stats_segment_close();
+
+    tmp = (char *) malloc(strlen(path) + sizeof(".XXXXXX"));
+    if (NULL == tmp) {
+        snmp_log(LOG_ERR, "statsSegment: out of memory\n");
+        return -1;
+    }
+    sprintf(tmp, "%s.XXXXXX", path);
+#ifdef HAVE_MKSTEMP
+    fd = mkstemp(tmp);
+#else
+    if (mktemp(tmp))
+        fd = open(tmp, O_RDWR | O_CREAT | O_EXCL
+#ifdef O_NOFOLLOW
+                  | O_NOFOLLOW
+#endif
+                  , 0600);
+#endif
+    if (fd < 0) {
+        snmp_log(LOG_ERR, "statsSegment: cannot create %s: %s\n", tmp,
+                 strerror(errno));
+        free(tmp);
+        return -1;
+    }
+    if (fchmod(fd, 0644) < 0 ||
+        ftruncate(fd, sizeof(netsnmp_stats_segment)) < 0) {
+        snmp_log(LOG_ERR, "statsSegment: cannot size %s: %s\n", tmp,
+                 strerror(errno));
+        goto fail;
+    }
+    seg = (netsnmp_stats_segment *) mmap(NULL, sizeof(netsnmp_stats_segment),
+                                         PROT_READ | PROT_WRITE, MAP_SHARED,
+                                         fd, 0);
+    if (MAP_FAILED == (void *) seg) {
+        snmp_log(LOG_ERR, "statsSegment: cannot map %s: %s\n", tmp,
+                 strerror(errno));
+        goto fail;
+    }
+    if (rename(tmp, path) < 0) {
+        snmp_log(LOG_ERR, "statsSegment: cannot replace %s: %s\n", path,
+                 strerror(errno));
+        munmap((void *) seg, sizeof(netsnmp_stats_segment));
+        goto fail;
+    }
+    close(fd);
+    free(tmp);
+
+    /*
+     * the file is all zeroes; fill in the header, magic last
+     */
+    seg->version = NETSNMP_STATS_SEGMENT_VERSION;
+    seg->size = sizeof(netsnmp_stats_segment);
+    seg->pid = (long) getpid();
+    seg->started = (long) time(NULL);
+    seg->magic = NETSNMP_STATS_SEGMENT_MAGIC;
+    _segment = seg;
+
+    DEBUGMSGTL(("stats:segment", "mapped %s, %lu bytes\n", path,
+                seg->size));
+    return 0;
+
+  fail:
+    close(fd);
+    unlink(tmp);
+    free(tmp);
+    return -1;
+}
+
+/**
+ * Marks the segment as no longer updated and unmaps it.  The file stays
+ * behind with the final counts.
+ */
+void
+netsnmp_stats_segment_close(void)
+{
+    netsnmp_stats_segment *seg = _segment;
+
+    if (NULL == seg)
+        return;
+    _segment = NULL;
+    seg->pid = 0;
+    munmap((void *) seg, sizeof(netsnmp_stats_segment));
+}
+
+/**
+ * @return the segment, or NULL if the agent is not keeping one
+ */
+netsnmp_stats_segment *
+netsnmp_stats_segment_get(void)
+{
+    return _segment;
+}
+
+/**
+ * Accounts for a request that took from start until now to answer.
+ */
+void
+netsnmp_stats_segment_pdu(int command, const struct timeval *start)
+{
+    int             i;
+
+    if (NULL == _segment)
+        return;
+    i = command - SNMP_MSG_GET;
+    if (i < 0 || i >= NETSNMP_STATS_PDU_OTHER)
+        i = NETSNMP_STATS_PDU_OTHER;
+    netsnmp_stats_hist_add(&_segment->pdus[i], _stats_elapsed_usec(start));
+}
+
+/*
+ * Finds the slot for a handler name, giving it one if it is new.  Slots
+ * are never given up, so a lookup that finds the name needs no lock.  A
+ * name is stored first character last, so an unlocked lookup racing with
+ * the store sees either an empty slot or the complete name.
+ */
+static netsnmp_stats_handler *
+_stats_handler_slot(const char *name)
+{
+    netsnmp_stats_handler *slot;
+    size_t          len;
+    u_int           hash, i;
+
+    len = strlen(name);
+    if (len >= NETSNMP_STATS_NAME_LEN)
+        len = NETSNMP_STATS_NAME_LEN - 1;
+    hash = netsnmp_hash_buf(name, len, NETSNMP_HASH_INIT);
+
+    for (i = 0; i < NETSNMP_STATS_HANDLERS; i++) {
+        slot = &_segment->handlers[(hash + i) % NETSNMP_STATS_HANDLERS];
+        if ('\0' == slot->name[0])
+            break;
+        if (strncmp(slot->name, name, len) == 0 && '\0' == slot->name[len])
+            return slot;
+    }
+    if (i == NETSNMP_STATS_HANDLERS)
+        return NULL;
+
+#ifdef NETSNMP_STATS_SEGMENT_THREADS
+    pthread_mutex_lock(&_segment_lock);
+#endif
+    for (; i < NETSNMP_STATS_HANDLERS; i++) {
+        slot = &_segment->handlers[(hash + i) % NETSNMP_STATS_HANDLERS];
+        if ('\0' == slot->name[0]) {
+            memcpy(slot->name + 1, name + 1, len - 1);
+            slot->name[len] = '\0';
+            slot->name[0] = name[0];
+            break;
+        }
+        if (strncmp(slot->name, name, len) == 0 && '\0' == slot->name[len])
+            break;
+    }
+#ifdef NETSNMP_STATS_SEGMENT_THREADS
+    pthread_mutex_unlock(&_segment_lock);
+#endif
+    return i < NETSNMP_STATS_HANDLERS ? slot : NULL;
+}
+
+/**
+ * Accounts for one call of the handlers of the registration name, which
+ * took usec microseconds.  This may be called from a worker thread.
+ */
+void
+netsnmp_stats_segment_handler(const char *name, u_long usec)
+{
+    netsnmp_stats_handler *slot = NULL;
+
+    if (NULL == _segment)
+        return;
+    if (name && *name)
+        slot = _stats_handler_slot(name);
+    if (slot)
+        netsnmp_stats_hist_add(&slot->time, usec);
+    else
+        STATS_ADD(_segment->handler_overflow, 1);
+}
+
+/**
+ * Accounts for one run of a cache load (or build) hook.
+ */
+void
+netsnmp_stats_segment_cache_load(u_long usec, int ok)
+{
+    if (NULL == _segment)
+        return;
+    netsnmp_stats_hist_add(&_segment->cache_loads, usec);
+    if (!ok)
+        STATS_ADD(_segment->cache_load_failures, 1);
+}
+
+/**
+ * Accounts for one request sent to an AgentX subagent, answered after
+ * usec microseconds, or given up on after that long if ok is 0.
+ */
+void
+netsnmp_stats_segment_agentx(u_long usec, int ok)
+{
+    if (NULL == _segment)
+        return;
+    netsnmp_stats_hist_add(&_segment->agentx, usec);
+    if (!ok)
+        STATS_ADD(_segment->agentx_timeouts, 1);
+}
+
+/**
+ * Records the current depth of one of the queues in the segment.
+ */
+void
+netsnmp_stats_segment_queue(netsnmp_stats_queue *queue, u_long depth)
+{
+    queue->depth = depth;
+    if (depth > queue->max_depth)
+        queue->max_depth = depth;
+}
+
+#else /* NETSNMP_STATS_SEGMENT */
+
+int
+netsnmp_stats_segment_open(const char *path)
+{
+    snmp_log(LOG_ERR, "statsSegment: not supported on this platform\n");
+    return -1;
+}
+
+void
+netsnmp_stats_segment_close(void)
+{
+}
+
+netsnmp_stats_segment *
+netsnmp_stats_segment_get(void)
+{
+    return NULL;
+}
+
+void
+netsnmp_stats_segment_pdu(int command, const struct timeval *start)
+{
+}
+
+void
+netsnmp_stats_segment_handler(const char *name, u_long usec)
+{
+}
+
+void
+netsnmp_stats_segment_cache_load(u_long usec, int ok)
+{
+}
+
+void
+netsnmp_stats_segment_agentx(u_long usec, int ok)
+{
+}
+
+void
+netsnmp_stats_segment_queue(netsnmp_stats_queue *queue, u_long depth)
+{
+}
+
+#endif /* NETSNMP_STATS_SEGMENT */
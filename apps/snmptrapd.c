@@ -98,6 +98,7 @@ SOFTWARE.
 #include <net-snmp/agent/net-snmp-agent-includes.h>
 #include <net-snmp/library/fd_event_manager.h>
 #include <net-snmp/agent/netsnmp_close_fds.h>
+#include <net-snmp/agent/stats_segment.h>
 #include "../snmplib/snmp_syslog.h"
 #include "../agent_global_vars.h"
 #include "../agent/mibgroup/snmpv3/snmpEngine.h"
@@ -151,6 +152,7 @@ char           *default_port = ddefault_port;
 #endif
 char           *trap1_fmt_str_remember = NULL;
 int             dofork = 1;
+static int      crypto_workers = 0;     /* cryptoWorkerThreads */
 
 /*
  * Include an extra Facility variable to allow command line adjustment of
@@ -341,6 +343,10 @@ snmptrapd_add_session(netsnmp_transport *t)
     session->callback_magic = (void *) t;
     session->authenticator = NULL;
     sess.isAuthoritative = SNMP_SESS_UNKNOWNAUTH;
+    /*
+     * only takes effect while cryptoWorkerThreads has a pool running
+     */
+    session->flags |= SNMP_FLAGS_PARSE_WORKERS;
 
     rc = snmp_add(session, t, pre_parse, NULL);
     if (rc == NULL) {
@@ -471,6 +477,73 @@ parse_config_agentgroup(const char *token, char *cptr)
 }
 #endif
 
+void
+parse_config_cryptoWorkerThreads(const char *token, char *cptr)
+{
+    crypto_workers = atoi(cptr);
+    if (crypto_workers < 0) {
+        config_perror("cryptoWorkerThreads must not be negative");
+        crypto_workers = 0;
+    }
+}
+
+void
+free_config_cryptoWorkerThreads(void)
+{
+    crypto_workers = 0;
+}
+
+static void
+snmptrapd_parse_workers_done(int fd, void *data)
+{
+    netsnmp_parse_workers_run();
+}
+
+/*
+ * Start the threads authenticating and decrypting SNMPv3 notifications.
+ * Called after forking, and again after each reconfiguration.
+ */
+static void
+snmptrapd_parse_workers_start(void)
+{
+    if (crypto_workers <= 0)
+        return;
+#ifdef NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER
+    snmp_log(LOG_WARNING, "cryptoWorkerThreads ignored: snmptrapd was "
+             "built without the fd event manager\n");
+#else
+    if (netsnmp_parse_workers_init(crypto_workers) <= 0) {
+#if defined(NETSNMP_REENTRANT) && defined(HAVE_PTHREAD_H)
+        snmp_log(LOG_WARNING, "cryptoWorkerThreads: no threads started, "
+                 "notifications will be parsed inline\n");
+#else
+        snmp_log(LOG_WARNING, "cryptoWorkerThreads ignored: snmptrapd was "
+                 "built without --enable-reentrant\n");
+#endif
+        return;
+    }
+    register_readfd(netsnmp_parse_workers_fd(), snmptrapd_parse_workers_done,
+                    NULL);
+#endif /* NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER */
+}
+
+/*
+ * Let the threads finish what they have queued and stop them.  The USM
+ * users must not change underneath them.
+ */
+static void
+snmptrapd_parse_workers_stop(void)
+{
+    int             fd = netsnmp_parse_workers_fd();
+
+    if (fd < 0)
+        return;
+#ifndef NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER
+    unregister_readfd(fd);
+#endif /* NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER */
+    netsnmp_parse_workers_shutdown();
+}
+
 void
 parse_config_doNotFork(const char *token, char *cptr)
 {
@@ -513,9 +586,29 @@ snmptrapd_main_loop(void)
     fd_set          readfds,writefds,exceptfds;
     struct timeval  timeout;
     NETSNMP_SELECT_TIMEVAL timeout2;
+    int             use_epoll = 0;
+    const char     *stats_segment;
+
+#ifndef NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER
+    use_epoll = (netsnmp_epoll_event_loop_init() == 0);
+#endif /* NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER */
+
+    stats_segment = netsnmp_ds_get_string(NETSNMP_DS_APPLICATION_ID,
+                                          NETSNMP_DS_AGENT_STATS_SEGMENT);
+    if (stats_segment)
+        netsnmp_stats_segment_open(stats_segment);
+
+    /*
+     * handlers may run on other threads, except while this one is busy
+     */
+    snmptrapd_handler_lock();
+    snmptrapd_parse_workers_start();
+    snmptrapd_handler_threads_start();
 
     while (netsnmp_running) {
         if (reconfig) {
+            snmptrapd_parse_workers_stop();
+            snmptrapd_handler_threads_stop();
                 /*
                  * If we are logging to a file, receipt of SIGHUP also
                  * indicates that the log file should be closed and
@@ -530,22 +623,47 @@ snmptrapd_main_loop(void)
                 parse_format( NULL, trap1_fmt_str_remember );
             }
             reconfig = 0;
+            snmptrapd_parse_workers_start();
+            snmptrapd_handler_threads_start();
         }
         numfds = 0;
-        FD_ZERO(&readfds);
-        FD_ZERO(&writefds);
-        FD_ZERO(&exceptfds);
         block = 0;
         timerclear(&timeout);
         timeout.tv_sec = 5;
+#ifndef NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER
+        if (use_epoll) {
+            snmp_sess_select_info2_flags(NULL, &numfds, NULL, &timeout,
+                                         &block, NETSNMP_SELECT_NOFDS);
+            snmptrapd_handler_unlock();
+            count = netsnmp_epoll_wait(!block ? &timeout : NULL);
+            snmptrapd_handler_lock();
+            if (count > 0)
+                netsnmp_epoll_dispatch_events(&count);
+            else if (count == 0)
+                snmp_timeout();
+            else if (errno == EINTR)
+                continue;
+            else {
+                snmp_log_perror("epoll_wait");
+                netsnmp_running = 0;
+            }
+            run_alarms();
+            continue;
+        }
+#endif /* NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER */
+        FD_ZERO(&readfds);
+        FD_ZERO(&writefds);
+        FD_ZERO(&exceptfds);
         snmp_select_info(&numfds, &readfds, &timeout, &block);
 #ifndef NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER
         netsnmp_external_event_info(&numfds, &readfds, &writefds, &exceptfds);
 #endif /* NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER */
         timeout2.tv_sec = timeout.tv_sec;
         timeout2.tv_usec = timeout.tv_usec;
+        snmptrapd_handler_unlock();
         count = select(numfds, &readfds, &writefds, &exceptfds,
                        !block ? &timeout2 : NULL);
+        snmptrapd_handler_lock();
         if (count > 0) {
 #ifndef NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER
             netsnmp_dispatch_external_events(&count, &readfds, &writefds,
@@ -574,6 +692,14 @@ snmptrapd_main_loop(void)
 	}
 	run_alarms();
     }
+    snmptrapd_parse_workers_stop();
+    snmptrapd_handler_threads_stop();
+    snmptrapd_handler_unlock();
+    netsnmp_stats_segment_close();
+#ifndef NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER
+    if (use_epoll)
+        netsnmp_epoll_event_loop_shutdown();
+#endif /* NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER */
 }
 
 /*******************************************************************-o-******
@@ -672,6 +798,10 @@ main(int argc, char *argv[])
                             parse_config_agentgroup, NULL, "groupid");
 #endif
     
+    register_config_handler("snmptrapd", "cryptoWorkerThreads",
+                            parse_config_cryptoWorkerThreads,
+                            free_config_cryptoWorkerThreads, "count");
+
     register_config_handler("snmptrapd", "doNotFork",
                             parse_config_doNotFork, NULL, "(1|yes|true|0|no|false)");
 
@@ -168,11 +168,23 @@ netsnmp_trapd_auth(netsnmp_pdu           *pdu,
 }
 
 /**
- * Checks to see if the pdu is authorized for a set of given action types.
+ * @returns the action types the last pdu passed to netsnmp_trapd_auth()
+ * was authorized for.  Handler threads check against this value, taken
+ * when the pdu was queued, rather than against the last lookup.
+ */
+int
+netsnmp_trapd_last_auth(void)
+{
+    return lastlookup;
+}
+
+/**
+ * Checks to see if a pdu authorized for the action types granted is
+ * authorized for a set of given action types.
  * @returns 1 if authorized, 0 if not.
  */
 int
-netsnmp_trapd_check_auth(int authtypes)
+netsnmp_trapd_check_auth_types(int authtypes, int granted)
 {
     if (netsnmp_ds_get_boolean(NETSNMP_DS_APPLICATION_ID,
                                NETSNMP_DS_APP_NO_AUTHORIZATION)) {
@@ -182,8 +194,18 @@ netsnmp_trapd_check_auth(int authtypes)
 
     DEBUGMSGTL(("snmptrapd:auth",
                 "Comparing auth types: result=%d, request=%d, result=%d\n",
-                lastlookup, authtypes,
-                ((authtypes & lastlookup) == authtypes)));
-    return ((authtypes & lastlookup) == authtypes);
+                granted, authtypes,
+                ((authtypes & granted) == authtypes)));
+    return ((authtypes & granted) == authtypes);
+}
+
+/**
+ * Checks to see if the pdu is authorized for a set of given action types.
+ * @returns 1 if authorized, 0 if not.
+ */
+int
+netsnmp_trapd_check_auth(int authtypes)
+{
+    return netsnmp_trapd_check_auth_types(authtypes, lastlookup);
 }
 
@@ -27,6 +27,7 @@
 #if HAVE_SYS_WAIT_H
 #include <sys/wait.h>
 #endif
+#include <errno.h>
 
 #include <net-snmp/config_api.h>
 #include <net-snmp/output_api.h>
@@ -35,12 +36,18 @@
 
 #include <net-snmp/net-snmp-includes.h>
 #include <net-snmp/agent/net-snmp-agent-includes.h>
+#include <net-snmp/agent/stats_segment.h>
 #include "utilities/execute.h"
 #include "snmptrapd_handlers.h"
 #include "snmptrapd_auth.h"
 #include "snmptrapd_log.h"
 #include "notification-log-mib/notification_log.h"
 
+#if defined(NETSNMP_REENTRANT) && defined(HAVE_PTHREAD_H)
+#include <pthread.h>
+#define NETSNMP_TRAPD_THREADS 1
+#endif
+
 netsnmp_feature_child_of(add_default_traphandler, snmptrapd);
 
 char *syslog_format1 = NULL;
@@ -53,6 +60,16 @@ char *exec_format2   = NULL;
 int   SyslogTrap = 0;
 int   dropauth = 0;
 
+#define TRAPD_OVERFLOW_BLOCK       0
+#define TRAPD_OVERFLOW_DROP_OLDEST 1
+#define TRAPD_OVERFLOW_DROP_NEWEST 2
+
+#define TRAPD_QUEUE_DEFAULT        1000
+
+static int trapd_threads   = 0;     /* trapHandlerThreads */
+static int trapd_queue_max = TRAPD_QUEUE_DEFAULT;  /* trapHandlerQueue */
+static int trapd_overflow  = TRAPD_OVERFLOW_BLOCK; /* trapHandlerOverflow */
+
 const char     *trap1_std_str = "%.4y-%.2m-%.2l %.2h:%.2j:%.2k %B [%b] (via %A [%a]): %N\n\t%W Trap (%q) Uptime: %#T\n%v\n";
 const char     *trap2_std_str = "%.4y-%.2m-%.2l %.2h:%.2j:%.2k %B [%b]:\n%v\n";
 
@@ -323,6 +340,40 @@ free_trap2_fmt(void)
 }
 
 
+static void
+parse_handler_threads(const char *token, char *line)
+{
+    if (!strcmp(token, "trapHandlerThreads")) {
+        trapd_threads = atoi(line);
+        if (trapd_threads < 0) {
+            config_perror("trapHandlerThreads must not be negative");
+            trapd_threads = 0;
+        }
+    } else if (!strcmp(token, "trapHandlerQueue")) {
+        trapd_queue_max = atoi(line);
+        if (trapd_queue_max <= 0) {
+            config_perror("trapHandlerQueue must be at least 1");
+            trapd_queue_max = TRAPD_QUEUE_DEFAULT;
+        }
+    } else if (!strcmp(line, "block")) {
+        trapd_overflow = TRAPD_OVERFLOW_BLOCK;
+    } else if (!strcmp(line, "dropOldest")) {
+        trapd_overflow = TRAPD_OVERFLOW_DROP_OLDEST;
+    } else if (!strcmp(line, "dropNewest")) {
+        trapd_overflow = TRAPD_OVERFLOW_DROP_NEWEST;
+    } else {
+        netsnmp_config_error("Unknown trapHandlerOverflow policy: %s", line);
+    }
+}
+
+static void
+free_handler_threads(void)
+{
+    trapd_threads   = 0;
+    trapd_queue_max = TRAPD_QUEUE_DEFAULT;
+    trapd_overflow  = TRAPD_OVERFLOW_BLOCK;
+}
+
 void
 snmptrapd_register_configs( void )
 {
@@ -339,6 +390,15 @@ snmptrapd_register_configs( void )
 			    "[print{,1,2}|syslog{,1,2}|execute{,1,2}] format");
     register_config_handler("snmptrapd", "forward",
                             parse_forward, NULL, "OID|\"default\" destination");
+    register_config_handler("snmptrapd", "trapHandlerThreads",
+                            parse_handler_threads, free_handler_threads,
+                            "count");
+    register_config_handler("snmptrapd", "trapHandlerQueue",
+                            parse_handler_threads, free_handler_threads,
+                            "length");
+    register_config_handler("snmptrapd", "trapHandlerOverflow",
+                            parse_handler_threads, free_handler_threads,
+                            "block|dropOldest|dropNewest");
 }
 
 
@@ -856,14 +916,18 @@ int   command_handler( netsnmp_pdu           *pdu,
             }
 	}
 
-        /*
-         *  and pass this formatted string to the command specified
-         */
-        run_shell_command(handler->token, (char*)rbuf, NULL, NULL);   /* Not interested in output */
         netsnmp_ds_set_boolean(NETSNMP_DS_LIBRARY_ID, 
                                NETSNMP_DS_LIB_QUICK_PRINT, oldquick);
         if (pdu->command == SNMP_MSG_TRAP)
             snmp_free_pdu(v2_pdu);
+
+        /*
+         *  and pass this formatted string to the command specified,
+         *  letting other handler threads on while it runs
+         */
+        snmptrapd_handler_unlock();
+        run_shell_command(handler->token, (char*)rbuf, NULL, NULL);   /* Not interested in output */
+        snmptrapd_handler_lock();
         free(rbuf);
     }
     return NETSNMPTRAPD_HANDLER_OK;
@@ -1069,6 +1133,473 @@ int   notification_handler(netsnmp_pdu           *pdu,
 }
 #endif 
 
+/*-----------------------------
+ *
+ * Handler threads
+ *
+ *-----------------------------*/
+
+/*
+ * With trapHandlerThreads, the main thread only receives notifications,
+ * runs the authorization handlers and queues what they let through.  A
+ * pool of threads runs the other handlers.  Every source address is
+ * always served by the same thread, so each handler still sees the
+ * notifications of one source in the order they arrived.  Notifications
+ * received over stream or tunneled transports, which may be closed while
+ * a notification waits, are still handled by the main thread.  Each thread
+ * has its own queue of at most trapHandlerQueue notifications;
+ * trapHandlerOverflow says whether a full queue makes the main thread
+ * wait, or throws away its oldest or the new notification.
+ *
+ * Most handlers were never written with threads in mind, so they run one
+ * at a time under the handler lock.  The main thread holds that lock
+ * except while it waits for input; a handler that blocks for a long time
+ * without touching shared state (such as a traphandle program) lets go
+ * of it while it waits.  The lock is taken in turn, so a busy main
+ * thread cannot starve the handler threads or the other way round.
+ */
+
+/*
+ * names for per-handler timings in the statistics segment
+ */
+static const struct {
+    Netsnmp_Trap_Handler *handler;
+    const char     *name;
+} trapd_handler_names[] = {
+    { netsnmp_trapd_auth, "trap:authorization" },
+    { syslog_handler, "trap:syslog" },
+    { print_handler, "trap:print" },
+    { command_handler, "trap:traphandle" },
+    { forward_handler, "trap:forward" },
+    { axforward_handler, "trap:forward" },
+#if defined(USING_NOTIFICATION_LOG_MIB_NOTIFICATION_LOG_MODULE) && defined(USING_AGENTX_SUBAGENT_MODULE) && !defined(NETSNMP_SNMPTRAPD_DISABLE_AGENTX)
+    { notification_handler, "trap:notificationLog" },
+#endif
+    { NULL, "trap:other" }
+};
+
+static u_long
+_trapd_elapsed_usec(const struct timeval *start)
+{
+    struct timeval  now, diff;
+
+    netsnmp_get_monotonic_clock(&now);
+    NETSNMP_TIMERSUB(&now, start, &diff);
+    return diff.tv_sec * 1000000 + diff.tv_usec;
+}
+
+/*
+ * Calls one handler, timing it if there is a statistics segment.
+ */
+static int
+_trapd_call_handler(netsnmp_trapd_handler *traph, netsnmp_pdu *pdu,
+                    netsnmp_transport *transport)
+{
+    struct timeval  start;
+    int             i, ret;
+
+    if (NULL == netsnmp_stats_segment_get())
+        return (*(traph->handler))(pdu, transport, traph);
+
+    netsnmp_get_monotonic_clock(&start);
+    ret = (*(traph->handler))(pdu, transport, traph);
+    for (i = 0; trapd_handler_names[i].handler; i++)
+        if (trapd_handler_names[i].handler == traph->handler)
+            break;
+    netsnmp_stats_segment_handler(trapd_handler_names[i].name,
+                                  _trapd_elapsed_usec(&start));
+    return ret;
+}
+
+/*
+ * Runs one list of handlers for a notification authorized for the
+ * action types granted.  The authorization handlers (the first list)
+ * are checked against the latest lookup instead, as they make it.
+ *
+ * @return NETSNMPTRAPD_HANDLER_FINISH if a handler stopped all further
+ * processing of the notification.
+ */
+static int
+_trapd_run_list(int idx, netsnmp_pdu *pdu, netsnmp_transport *transport,
+                oid *trapOid, int trapOidLen, int granted)
+{
+    netsnmp_trapd_handler *traph;
+    int             ret;
+
+    DEBUGMSGTL(("snmptrapd", "Running %s handlers\n", handlers[idx].descr));
+    if (NULL == handlers[idx].handler) /* specific */
+        traph = netsnmp_get_traphandler(trapOid, trapOidLen);
+    else
+        traph = *handlers[idx].handler;
+
+    for( ; traph; traph = traph->nexth) {
+        if (!netsnmp_trapd_check_auth_types(traph->authtypes,
+                                            0 == idx ?
+                                            netsnmp_trapd_last_auth() :
+                                            granted))
+            continue; /* we continue on and skip this one */
+
+        ret = _trapd_call_handler(traph, pdu, transport);
+        if(NETSNMPTRAPD_HANDLER_FINISH == ret)
+            return ret;
+        if (ret == NETSNMPTRAPD_HANDLER_BREAK)
+            break; /* move on to next type */
+    } /* traph */
+    return NETSNMPTRAPD_HANDLER_OK;
+}
+
+/*
+ * Runs the handler lists after the authorization handlers.
+ */
+static void
+_trapd_run_handlers(netsnmp_pdu *pdu, netsnmp_transport *transport,
+                    oid *trapOid, int trapOidLen, int granted,
+                    const struct timeval *received)
+{
+    netsnmp_stats_segment *seg;
+    int             idx;
+
+    for (idx = 1; handlers[idx].descr; ++idx)
+        if (NETSNMPTRAPD_HANDLER_FINISH ==
+            _trapd_run_list(idx, pdu, transport, trapOid, trapOidLen,
+                            granted))
+            break;
+
+    seg = netsnmp_stats_segment_get();
+    if (seg)
+        netsnmp_stats_hist_add(&seg->traps, _trapd_elapsed_usec(received));
+}
+
+#ifdef NETSNMP_TRAPD_THREADS
+
+typedef struct trapd_job_s {
+    netsnmp_pdu    *pdu;
+    netsnmp_transport *transport;
+    oid             trapOid[MAX_OID_LEN+2];
+    int             trapOidLen;
+    int             granted;            /* authorization */
+    struct timeval  received;
+    struct trapd_job_s *next;
+} trapd_job;
+
+typedef struct trapd_worker_s {
+    pthread_t       thread;
+    pthread_cond_t  cond;
+    trapd_job      *head;
+    trapd_job      *tail;
+    int             count;
+} trapd_worker;
+
+static trapd_worker *_trapd_workers = NULL;
+static int      _trapd_workers_count = 0;
+static int      _trapd_workers_stop = 0;
+static u_long   _trapd_queued = 0;      /* over all the threads */
+static pthread_mutex_t _trapd_queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _trapd_queue_space = PTHREAD_COND_INITIALIZER;
+
+/*
+ * the handler lock: a ticket lock, so that it is taken in turn
+ */
+static pthread_mutex_t _trapd_handler_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _trapd_handler_turn = PTHREAD_COND_INITIALIZER;
+static u_long   _trapd_handler_next = 0;
+static u_long   _trapd_handler_serving = 0;
+
+/**
+ * Waits for the turn of the calling thread to run handlers.  errno is
+ * left alone, so the main loop can take the lock straight after select().
+ */
+void
+snmptrapd_handler_lock(void)
+{
+    int             saved_errno = errno;
+    u_long          ticket;
+
+    pthread_mutex_lock(&_trapd_handler_mutex);
+    ticket = _trapd_handler_next++;
+    while (ticket != _trapd_handler_serving)
+        pthread_cond_wait(&_trapd_handler_turn, &_trapd_handler_mutex);
+    pthread_mutex_unlock(&_trapd_handler_mutex);
+    errno = saved_errno;
+}
+
+/**
+ * Hands the handler lock on to the next thread waiting for it.
+ */
+void
+snmptrapd_handler_unlock(void)
+{
+    int             saved_errno = errno;
+
+    pthread_mutex_lock(&_trapd_handler_mutex);
+    if (_trapd_handler_serving != _trapd_handler_next) {
+        _trapd_handler_serving++;
+        pthread_cond_broadcast(&_trapd_handler_turn);
+    }
+    pthread_mutex_unlock(&_trapd_handler_mutex);
+    errno = saved_errno;
+}
+
+static void
+_trapd_free_job(trapd_job *job)
+{
+    snmp_free_pdu(job->pdu);
+    free(job);
+}
+
+/*
+ * with _trapd_queue_lock held
+ */
+static void
+_trapd_queue_depth(void)
+{
+    netsnmp_stats_segment *seg = netsnmp_stats_segment_get();
+
+    if (seg)
+        netsnmp_stats_segment_queue(&seg->trap_queued, _trapd_queued);
+}
+
+static void    *
+_trapd_worker_run(void *arg)
+{
+    trapd_worker   *w = (trapd_worker *) arg;
+    trapd_job      *job;
+
+    for (;;) {
+        pthread_mutex_lock(&_trapd_queue_lock);
+        while (NULL == w->head && !_trapd_workers_stop)
+            pthread_cond_wait(&w->cond, &_trapd_queue_lock);
+        job = w->head;
+        if (NULL == job) {
+            /*
+             * stopping, and nothing left to do
+             */
+            pthread_mutex_unlock(&_trapd_queue_lock);
+            break;
+        }
+        w->head = job->next;
+        if (NULL == w->head)
+            w->tail = NULL;
+        w->count--;
+        _trapd_queued--;
+        _trapd_queue_depth();
+        pthread_cond_broadcast(&_trapd_queue_space);
+        pthread_mutex_unlock(&_trapd_queue_lock);
+
+        snmptrapd_handler_lock();
+        _trapd_run_handlers(job->pdu, job->transport, job->trapOid,
+                            job->trapOidLen, job->granted, &job->received);
+        snmptrapd_handler_unlock();
+        _trapd_free_job(job);
+    }
+    return NULL;
+}
+
+/*
+ * main thread: hands a notification to the thread serving its source
+ *
+ * @return 1 if it was queued (or thrown away), 0 if the caller should
+ * run the handlers itself
+ */
+static int
+_trapd_queue(netsnmp_pdu *pdu, netsnmp_transport *transport,
+             oid *trapOid, int trapOidLen, int granted,
+             const struct timeval *received)
+{
+    netsnmp_stats_segment *seg;
+    trapd_worker   *w;
+    trapd_job      *job, *dropped = NULL;
+    int             unlocked = 0;
+
+    if (0 == _trapd_workers_count)
+        return 0;
+    /*
+     * a stream transport may be closed before a queued job gets to it
+     */
+    if (transport && (transport->flags & (NETSNMP_TRANSPORT_FLAG_STREAM |
+                                          NETSNMP_TRANSPORT_FLAG_TUNNELED)))
+        return 0;
+
+    job = SNMP_MALLOC_TYPEDEF(trapd_job);
+    if (job)
+        job->pdu = snmp_clone_pdu(pdu);
+    if (NULL == job || NULL == job->pdu) {
+        SNMP_FREE(job);
+        return 0;
+    }
+    job->transport = transport;
+    memcpy(job->trapOid, trapOid, trapOidLen * sizeof(oid));
+    job->trapOidLen = trapOidLen;
+    job->granted = granted;
+    job->received = *received;
+
+    w = &_trapd_workers[(pdu->transport_data ?
+                         netsnmp_hash_buf(pdu->transport_data,
+                                          pdu->transport_data_length,
+                                          NETSNMP_HASH_INIT) : 0) %
+                        _trapd_workers_count];
+
+    pthread_mutex_lock(&_trapd_queue_lock);
+    while (w->count >= trapd_queue_max &&
+           TRAPD_OVERFLOW_BLOCK == trapd_overflow) {
+        if (!unlocked) {
+            /*
+             * the handler threads need the handler lock to make room
+             */
+            pthread_mutex_unlock(&_trapd_queue_lock);
+            snmptrapd_handler_unlock();
+            unlocked = 1;
+            pthread_mutex_lock(&_trapd_queue_lock);
+            continue;
+        }
+        pthread_cond_wait(&_trapd_queue_space, &_trapd_queue_lock);
+    }
+    if (w->count >= trapd_queue_max) {
+        if (TRAPD_OVERFLOW_DROP_NEWEST == trapd_overflow) {
+            dropped = job;
+            job = NULL;
+        } else {
+            dropped = w->head;
+            w->head = dropped->next;
+            if (NULL == w->head)
+                w->tail = NULL;
+            w->count--;
+            _trapd_queued--;
+        }
+    }
+    if (job) {
+        if (w->tail)
+            w->tail->next = job;
+        else
+            w->head = job;
+        w->tail = job;
+        w->count++;
+        _trapd_queued++;
+        pthread_cond_signal(&w->cond);
+    }
+    _trapd_queue_depth();
+    pthread_mutex_unlock(&_trapd_queue_lock);
+
+    if (unlocked)
+        snmptrapd_handler_lock();
+    if (dropped) {
+        NETSNMP_LOGONCE((LOG_WARNING, "trapHandlerQueue full: dropping "
+                         "notifications\n"));
+        DEBUGMSGTL(("snmptrapd:threads", "queue full, dropped a "
+                    "notification\n"));
+        seg = netsnmp_stats_segment_get();
+        if (seg)
+            seg->trap_drops++;
+        _trapd_free_job(dropped);
+    }
+    return 1;
+}
+
+/**
+ * Starts the handler threads (trapHandlerThreads).  Threads do not
+ * survive fork(), so this is called once snmptrapd is in the background,
+ * and again after each reconfiguration.
+ */
+void
+snmptrapd_handler_threads_start(void)
+{
+    int             i;
+
+    if (trapd_threads <= 0 || _trapd_workers_count > 0)
+        return;
+
+    _trapd_workers = (trapd_worker *) calloc(trapd_threads,
+                                             sizeof(trapd_worker));
+    if (NULL == _trapd_workers) {
+        snmp_log(LOG_ERR, "trapHandlerThreads: out of memory\n");
+        return;
+    }
+    _trapd_workers_stop = 0;
+    for (i = 0; i < trapd_threads; i++) {
+        pthread_cond_init(&_trapd_workers[i].cond, NULL);
+        if (pthread_create(&_trapd_workers[i].thread, NULL,
+                           _trapd_worker_run, &_trapd_workers[i]) != 0) {
+            pthread_cond_destroy(&_trapd_workers[i].cond);
+            snmp_log(LOG_ERR, "trapHandlerThreads: could only start %d of "
+                     "%d threads\n", i, trapd_threads);
+            break;
+        }
+    }
+    _trapd_workers_count = i;
+    if (0 == _trapd_workers_count) {
+        SNMP_FREE(_trapd_workers);
+        return;
+    }
+    DEBUGMSGTL(("snmptrapd:threads", "started %d handler threads\n",
+                _trapd_workers_count));
+}
+
+/**
+ * Lets the handler threads work through their queues and stops them.
+ * The caller holds the handler lock, which the threads need meanwhile.
+ */
+void
+snmptrapd_handler_threads_stop(void)
+{
+    int             i, count = _trapd_workers_count;
+
+    if (0 == count)
+        return;
+
+    pthread_mutex_lock(&_trapd_queue_lock);
+    _trapd_workers_stop = 1;
+    for (i = 0; i < count; i++)
+        pthread_cond_signal(&_trapd_workers[i].cond);
+    pthread_mutex_unlock(&_trapd_queue_lock);
+
+    snmptrapd_handler_unlock();
+    for (i = 0; i < count; i++)
+        pthread_join(_trapd_workers[i].thread, NULL);
+    snmptrapd_handler_lock();
+
+    for (i = 0; i < count; i++)
+        pthread_cond_destroy(&_trapd_workers[i].cond);
+    _trapd_workers_count = 0;
+    _trapd_workers_stop = 0;
+    SNMP_FREE(_trapd_workers);
+    DEBUGMSGTL(("snmptrapd:threads", "stopped %d handler threads\n", count));
+}
+
+#else /* !NETSNMP_TRAPD_THREADS */
+
+void
+snmptrapd_handler_lock(void)
+{
+}
+
+void
+snmptrapd_handler_unlock(void)
+{
+}
+
+static int
+_trapd_queue(netsnmp_pdu *pdu, netsnmp_transport *transport,
+             oid *trapOid, int trapOidLen, int granted,
+             const struct timeval *received)
+{
+    return 0;
+}
+
+void
+snmptrapd_handler_threads_start(void)
+{
+    if (trapd_threads > 0)
+        snmp_log(LOG_WARNING, "trapHandlerThreads ignored: snmptrapd was "
+                 "built without --enable-reentrant\n");
+}
+
+void
+snmptrapd_handler_threads_stop(void)
+{
+}
+
+#endif /* !NETSNMP_TRAPD_THREADS */
+
 /*-----------------------------
  *
  * Main driving code, to process an incoming trap
@@ -1086,9 +1617,9 @@ snmp_input(int op, netsnmp_session *session,
     oid trapOid[MAX_OID_LEN+2] = {0};
     int trapOidLen;
     netsnmp_variable_list *vars;
-    netsnmp_trapd_handler *traph;
     netsnmp_transport *transport = (netsnmp_transport *) magic;
-    int ret, idx;
+    struct timeval received = { 0, 0 };
+    int granted;
 
     switch (op) {
     case NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE:
@@ -1099,6 +1630,8 @@ snmp_input(int op, netsnmp_session *session,
             /* drop problem packets */
             return 1;
         }
+        if (netsnmp_stats_segment_get())
+            netsnmp_get_monotonic_clock(&received);
 
         /*
 	 * Determine the OID that identifies the trap being handled
@@ -1185,25 +1718,19 @@ t        *     d) any other global handlers
          *  OK - Enough waffling, let's get to work.....
 	 */
 
-        for( idx = 0; handlers[idx].descr; ++idx ) {
-            DEBUGMSGTL(("snmptrapd", "Running %s handlers\n",
-                        handlers[idx].descr));
-            if (NULL == handlers[idx].handler) /* specific */
-                traph = netsnmp_get_traphandler(trapOid, trapOidLen);
-            else
-                traph = *handlers[idx].handler;
-
-            for( ; traph; traph = traph->nexth) {
-                if (!netsnmp_trapd_check_auth(traph->authtypes))
-                    continue; /* we continue on and skip this one */
-
-                ret = (*(traph->handler))(pdu, transport, traph);
-                if(NETSNMPTRAPD_HANDLER_FINISH == ret)
-                    return 1;
-                if (ret == NETSNMPTRAPD_HANDLER_BREAK)
-                    break; /* move on to next type */
-            } /* traph */
-        } /* handlers */
+        if (NETSNMPTRAPD_HANDLER_FINISH ==
+            _trapd_run_list(0, pdu, transport, trapOid, trapOidLen, 0))
+            return 1;
+        granted = netsnmp_trapd_last_auth();
+
+        /*
+         *  With handler threads, the rest is left to them (and an
+         *  INFORM is acknowledged as soon as it is queued).
+         */
+        if (!_trapd_queue(pdu, transport, trapOid, trapOidLen, granted,
+                          &received))
+            _trapd_run_handlers(pdu, transport, trapOid, trapOidLen, granted,
+                                &received);
 
 
 	if (pdu->command == SNMP_MSG_INFORM) {
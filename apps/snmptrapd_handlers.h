@@ -67,4 +67,14 @@ int snmp_input(int op, netsnmp_session *session,
 
 void parse_format(const char *token, char *line);
 
+/*
+ * Handler threads (trapHandlerThreads).  Handlers run one at a time
+ * under the handler lock, which the main thread holds except while it
+ * waits for input; a handler may let go of it around a long wait.
+ */
+void snmptrapd_handler_threads_start(void);
+void snmptrapd_handler_threads_stop(void);
+void snmptrapd_handler_lock(void);
+void snmptrapd_handler_unlock(void);
+
 #endif                          /* SNMPTRAPD_HANDLERS_H */
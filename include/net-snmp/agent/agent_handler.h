@@ -87,6 +87,7 @@ typedef struct netsnmp_mib_handler_s {
 #define HANDLER_CAN_NOT_CREATE        0x08         /* auto set if ! CAN_SET */
 #define HANDLER_CAN_BABY_STEP         0x10
 #define HANDLER_CAN_STASH             0x20
+#define HANDLER_CAN_THREADSAFE        0x40 /* GET* may run on a worker thread */
 
 
 #define HANDLER_CAN_RONLY   (HANDLER_CAN_GETANDGETNEXT)
@@ -94,6 +95,23 @@ typedef struct netsnmp_mib_handler_s {
 #define HANDLER_CAN_SET_ONLY (HANDLER_CAN_SET | HANDLER_CAN_NOT_CREATE)
 #define HANDLER_CAN_DEFAULT (HANDLER_CAN_RONLY | HANDLER_CAN_NOT_CREATE)
 
+/*
+ * Time spent in the handlers of one registration ("handlerTiming" in
+ * snmpd.conf).  The histogram is log-linear: values below
+ * NETSNMP_HANDLER_TIMING_SUB microseconds have a bucket each, and every
+ * power of two above that is split into NETSNMP_HANDLER_TIMING_SUB
+ * buckets, so a bucket is never wider than 1/8 of the values it holds.
+ */
+#define NETSNMP_HANDLER_TIMING_SUB      8
+#define NETSNMP_HANDLER_TIMING_BUCKETS  240
+
+typedef struct netsnmp_handler_timing_s {
+        u_long          calls;
+        u_long          total_usec;
+        u_long          max_usec;
+        u_int           buckets[NETSNMP_HANDLER_TIMING_BUCKETS];
+} netsnmp_handler_timing;
+
 /** @typedef struct netsnmp_handler_registration_s netsnmp_handler_registration
  * Typedefs the netsnmp_handler_registration_s struct into netsnmp_handler_registration  */
 
@@ -136,6 +154,11 @@ typedef struct netsnmp_handler_registration_s {
          */
         void *          my_reg_void;
 
+        /**
+         * handler timing, allocated on the first timed call
+         */
+        netsnmp_handler_timing *timing;
+
 } netsnmp_handler_registration;
 
 /*
@@ -194,6 +217,9 @@ typedef int (Netsnmp_Node_Handler) (netsnmp_mib_handler *handler,
                                           netsnmp_agent_request_info
                                           *reqinfo,
                                           netsnmp_request_info *requests);
+    u_long          netsnmp_handler_timing_percentile(const
+                                                      netsnmp_handler_timing
+                                                      *timing, int percent);
     int             netsnmp_call_handler(netsnmp_mib_handler *next_handler,
                                          netsnmp_handler_registration
                                          *reginfo,
@@ -30,6 +30,13 @@ extern          "C" {
 
     typedef int  (NetsnmpCacheLoad)(netsnmp_cache *, void*);
     typedef void (NetsnmpCacheFree)(netsnmp_cache *, void*);
+    typedef void *(NetsnmpCacheBuild)(netsnmp_cache *, void*);
+    typedef void (NetsnmpCacheSwap)(netsnmp_cache *, void*, void*);
+
+/*
+ * Load time histogram buckets: < 1ms, < 10ms, < 100ms, < 1s, longer
+ */
+#define NETSNMP_CACHE_LOAD_BUCKETS 5
 
     struct netsnmp_cache_s {
 	/** Number of handlers whose myvoid member points at this structure. */
@@ -67,6 +74,31 @@ extern          "C" {
         oid *rootoid;
         int  rootoid_len;
 
+        /*
+         * Bumped on every successful load, so users of the cached
+         * data can tell when pointers into it have gone stale.
+         */
+        u_int    generation;
+
+        /*
+         * Optional hooks for NETSNMP_CACHE_BACKGROUND_LOAD.  build_cache
+         * returns a fresh snapshot (or NULL on failure) without touching
+         * the data currently served, and may run in another thread.
+         * swap_cache always runs in the main thread; it installs the
+         * snapshot and releases the previous data.
+         */
+        NetsnmpCacheBuild *build_cache;
+        NetsnmpCacheSwap  *swap_cache;
+        void             *bg_load;      /* reload in progress, if any */
+
+        /*
+         * Load statistics, reported by nsCacheTable
+         */
+        u_int    load_count;
+        u_int    load_failures;
+        u_int    load_background;
+        u_long   load_last_usec;        /* duration of the last load */
+        u_int    load_hist[NETSNMP_CACHE_LOAD_BUCKETS];
     };
 
 
@@ -120,6 +152,7 @@ extern          "C" {
 #define NETSNMP_CACHE_PRELOAD                               0x0010
 #define NETSNMP_CACHE_AUTO_RELOAD                           0x0020
 #define NETSNMP_CACHE_RESET_TIMER_ON_USE                    0x0040
+#define NETSNMP_CACHE_BACKGROUND_LOAD                       0x0080
 
 #define NETSNMP_CACHE_HINT_HANDLER_ARGS                     0x1000
 
@@ -40,6 +40,7 @@
 #define NETSNMP_DS_AGENT_DISKIO_NO_FD   18      /* 1 = don't report /dev/fd*   entries in diskIOTable */
 #define NETSNMP_DS_AGENT_DISKIO_NO_LOOP 19      /* 1 = don't report /dev/loop* entries in diskIOTable */
 #define NETSNMP_DS_AGENT_DISKIO_NO_RAM  20      /* 1 = don't report /dev/ram*  entries in diskIOTable */
+#define NETSNMP_DS_AGENT_HANDLER_TIMING 21      /* 1 = keep per-registration handler timing */
 
 /* WARNING: The trap receiver also uses DS flags and must not conflict with these!
  * If you define additional boolean entries, check in "apps/snmptrapd_ds.h" first */
@@ -55,6 +56,7 @@
 #define NETSNMP_DS_SMUX_SOCKET    5     /* ip:port socket addr */
 #define NETSNMP_DS_NOTIF_LOG_CTX  6     /* "" | "snmptrapd" */
 #define NETSNMP_DS_AGENT_TRAP_ADDR      7     /* used as v1 trap agent address */
+#define NETSNMP_DS_AGENT_STATS_SEGMENT  8     /* file for the statistics segment */
 
 /*
  * integers 
@@ -77,4 +79,6 @@
 #define NETSNMP_DS_AGENT_AVG_BULKVARBINDSIZE 15 /* avg varbind size estimate */
 #define NETSNMP_DS_AGENT_PDU_STATS_MAX       16 /* size of top N array*/
 #define NETSNMP_DS_AGENT_PDU_STATS_THRESHOLD 17 /* minimum threshold time */
+#define NETSNMP_DS_AGENT_WORKER_THREADS      18 /* read request worker pool */
+#define NETSNMP_DS_AGENT_AGENTX_WINDOW       19 /* agentx requests in flight per subagent */
 #endif
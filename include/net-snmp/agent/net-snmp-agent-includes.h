@@ -18,5 +18,6 @@
 #include <net-snmp/agent/agent_handler.h>
 #include <net-snmp/agent/all_helpers.h>
 #include <net-snmp/agent/var_struct.h>
+#include <net-snmp/agent/stats_segment.h>
 
 #endif                          /* NET_SNMP_AGENT_INCLUDES_H */
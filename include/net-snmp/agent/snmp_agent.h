@@ -37,6 +37,8 @@ extern          "C" {
 
 #define SNMP_AGENT_FLAGS_NONE                   0x0
 #define SNMP_AGENT_FLAGS_CANCEL_IN_PROGRESS     0x1
+#define SNMP_AGENT_FLAGS_IN_WORKER              0x2 /* owned by a worker */
+#define SNMP_AGENT_FLAGS_FREE_PENDING           0x4 /* free when worker done */
 
     /*
      * If non-zero, causes the addresses of peers to be logged when receptions
@@ -212,6 +214,7 @@ extern          "C" {
         netsnmp_cachemap *cache_store;
         int             vbcount;
         int             flags;
+        struct timeval  stats_start;    /* arrival, for the stats segment */
     } netsnmp_agent_session;
 
     /*
@@ -246,6 +249,7 @@ extern          "C" {
     void            dump_sess_list(void);
     int             init_master_agent(void);
     void            shutdown_master_agent(void);
+    void            netsnmp_agent_session_pool_shutdown(void);
     int             agent_check_and_process(int block);
     void            netsnmp_check_delegated_requests(void);
     void            netsnmp_check_outstanding_agent_requests(void);
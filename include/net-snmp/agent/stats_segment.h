@@ -0,0 +1,139 @@
+#ifndef NETSNMP_STATS_SEGMENT_H
+#define NETSNMP_STATS_SEGMENT_H
+
+/*
+ * The statistics segment is a file ("statsSegment FILE" in snmpd.conf)
+ * which the agent maps into memory and updates as it goes.  Monitoring
+ * tools map the same file read-only and see the agent's own counters
+ * without sending it a request.
+ *
+ * The agent never locks the segment.  Every field is a naturally aligned
+ * word that only the agent writes, so a reader always sees a value the
+ * agent stored, but two fields read one after the other may come from
+ * different moments.  Counters only ever grow; a reader wanting rates
+ * should take differences between two snapshots.
+ *
+ * magic is written last when the segment is set up: a reader should
+ * check it, version and size before looking at anything else.  pid is
+ * cleared when the agent shuts down.
+ */
+
+#ifdef __cplusplus
+extern          "C" {
+#endif
+
+#define NETSNMP_STATS_SEGMENT_MAGIC     0x4e535354      /* "NSST" */
+#define NETSNMP_STATS_SEGMENT_VERSION   3
+
+/*
+ * Latency histogram buckets: < 100us, < 1ms, < 10ms, < 100ms, < 1s, longer
+ */
+#define NETSNMP_STATS_BUCKETS           6
+
+/*
+ * PDU counters are indexed by command - SNMP_MSG_GET (GET, GETNEXT,
+ * RESPONSE, SET, TRAP, GETBULK, INFORM, TRAP2, REPORT); anything else,
+ * such as the internal SET phases of an AgentX subagent, counts as other.
+ */
+#define NETSNMP_STATS_PDU_TYPES         10
+#define NETSNMP_STATS_PDU_OTHER         9
+
+#define NETSNMP_STATS_HANDLERS          256
+#define NETSNMP_STATS_NAME_LEN          48
+
+    typedef struct netsnmp_stats_hist_s {
+        u_long          count;
+        u_long          total_usec;
+        u_long          max_usec;
+        u_long          buckets[NETSNMP_STATS_BUCKETS];
+    } netsnmp_stats_hist;
+
+    typedef struct netsnmp_stats_queue_s {
+        u_long          depth;          /* when last sampled */
+        u_long          max_depth;
+    } netsnmp_stats_queue;
+
+    /*
+     * time spent in the handlers of one registration, by handlerName;
+     * an empty name marks an unused slot
+     */
+    typedef struct netsnmp_stats_handler_s {
+        char            name[NETSNMP_STATS_NAME_LEN];
+        netsnmp_stats_hist time;
+    } netsnmp_stats_handler;
+
+    typedef struct netsnmp_stats_segment_s {
+        u_int           magic;
+        u_int           version;
+        u_long          size;           /* of the whole segment, in bytes */
+        long            pid;            /* 0 once the agent has shut down */
+        long            started;        /* time() the agent started */
+
+        /*
+         * from receiving a request to sending the response
+         */
+        netsnmp_stats_hist pdus[NETSNMP_STATS_PDU_TYPES];
+
+        /*
+         * netsnmp_cache load (or build) hooks
+         */
+        netsnmp_stats_hist cache_loads;
+        u_long          cache_load_failures;
+
+        /*
+         * requests waiting for delegated handlers, requests held back
+         * while a SET is processed, and passes waiting for a worker
+         * thread ("agentWorkerThreads")
+         */
+        netsnmp_stats_queue delegated;
+        netsnmp_stats_queue set_queued;
+        netsnmp_stats_queue workers;
+
+        /*
+         * requests the AgentX master sent to its subagents, from sending
+         * to the response (or timeout), and requests waiting for a free
+         * slot in their subagent's window ("agentxWindow")
+         */
+        netsnmp_stats_hist agentx;
+        u_long          agentx_timeouts;
+        netsnmp_stats_queue agentx_queued;
+
+        /*
+         * snmptrapd: notifications waiting for a handler thread
+         * ("trapHandlerThreads"), those thrown away because the queue
+         * was full, and the time from reading a notification to the end
+         * of its last handler
+         */
+        netsnmp_stats_queue trap_queued;
+        u_long          trap_drops;
+        netsnmp_stats_hist traps;
+
+        /*
+         * calls of handlers without a name, or with no slot left;
+         * snmptrapd's notification handlers are named "trap:print",
+         * "trap:traphandle" and so on
+         */
+        u_long          handler_overflow;
+        netsnmp_stats_handler handlers[NETSNMP_STATS_HANDLERS];
+    } netsnmp_stats_segment;
+
+    void            netsnmp_stats_hist_add(netsnmp_stats_hist *hist,
+                                           u_long usec);
+
+    int             netsnmp_stats_segment_open(const char *path);
+    void            netsnmp_stats_segment_close(void);
+    netsnmp_stats_segment *netsnmp_stats_segment_get(void);
+
+    void            netsnmp_stats_segment_pdu(int command,
+                                              const struct timeval *start);
+    void            netsnmp_stats_segment_handler(const char *name,
+                                                  u_long usec);
+    void            netsnmp_stats_segment_cache_load(u_long usec, int ok);
+    void            netsnmp_stats_segment_agentx(u_long usec, int ok);
+    void            netsnmp_stats_segment_queue(netsnmp_stats_queue *queue,
+                                                u_long depth);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* NETSNMP_STATS_SEGMENT_H */
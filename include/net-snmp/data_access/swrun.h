@@ -51,6 +51,12 @@ extern "C" {
          */
         int32_t         hrSWRunPerfCPU;
         int32_t         hrSWRunPerfMem;
+
+        /*
+         * for arch loaders which update rows in place
+         */
+        unsigned long long start_time;  /* 0: unknown, reread the row */
+        u_int           generation;     /* last load that saw the process */
         
     } netsnmp_swrun_entry;
 
@@ -83,6 +89,9 @@ extern "C" {
     netsnmp_swrun_entry *
     netsnmp_swrun_entry_create(int32_t swIndex);
 
+    netsnmp_swrun_entry *
+    netsnmp_swrun_entry_get_by_index(netsnmp_container *container, oid index);
+
     void netsnmp_swrun_entry_free(netsnmp_swrun_entry *entry);
 
     int  swrun_count_processes( int include_kthreads );
@@ -198,6 +198,9 @@ SOFTWARE.
     u_char         *asn_parse_string(u_char *, size_t *, u_char *,
                                      u_char *, size_t *);
     NETSNMP_IMPORT
+    u_char         *asn_parse_string_ref(u_char *, size_t *, u_char *,
+                                         u_char **, size_t *);
+    NETSNMP_IMPORT
     u_char         *asn_build_string(u_char *, size_t *, u_char,
                                      const u_char *, size_t);
     NETSNMP_IMPORT
@@ -36,7 +36,7 @@ extern          "C" {
 #endif
 
 #define NETSNMP_DS_MAX_IDS 3
-#define NETSNMP_DS_MAX_SUBIDS 48        /* needs to be a multiple of 8 */
+#define NETSNMP_DS_MAX_SUBIDS 56        /* needs to be a multiple of 8 */
 
     /*
      * begin storage definitions 
@@ -105,7 +105,9 @@ extern          "C" {
 #define NETSNMP_DS_LIB_DISABLE_V3          45 /* disable SNMPv3 */
 #define NETSNMP_DS_LIB_FILTER_SOURCE       46 /* filter pkt by source IP */
 #define NETSNMP_DS_LIB_ADD_FORWARDER_INFO  47 /* add info about forwarder to SNMP packets */
-#define NETSNMP_DS_LIB_MAX_BOOL_ID         48 /* match NETSNMP_DS_MAX_SUBIDS */
+#define NETSNMP_DS_LIB_ZERO_COPY_VARBINDS  48 /* values may point into a shared copy of the packet */
+#define NETSNMP_DS_LIB_MIB_CACHE           49 /* keep a compiled copy of the parsed MIBs */
+#define NETSNMP_DS_LIB_MAX_BOOL_ID         56 /* match NETSNMP_DS_MAX_SUBIDS */
 
     /*
      * library integers 
@@ -130,7 +132,10 @@ extern          "C" {
 #define NETSNMP_DS_LIB_RETRIES             15
 #define NETSNMP_DS_LIB_MSG_SEND_MAX        16 /* global max response size */
 #define NETSNMP_DS_LIB_FILTER_TYPE         17 /* 0=NONE, 1=whitelist, -1=blacklist */
-#define NETSNMP_DS_LIB_MAX_INT_ID          48 /* match NETSNMP_DS_MAX_SUBIDS */
+#define NETSNMP_DS_LIB_SERVER_BATCH        18 /* datagrams per syscall (server) */
+#define NETSNMP_DS_LIB_PDU_POOL_SIZE       19 /* free PDUs kept for reuse */
+#define NETSNMP_DS_LIB_VARBIND_POOL_SIZE   20 /* free varbinds kept for reuse */
+#define NETSNMP_DS_LIB_MAX_INT_ID          56 /* match NETSNMP_DS_MAX_SUBIDS */
     
     /*
      * special meanings for the default SNMP version slot (NETSNMP_DS_LIB_SNMPVERSION) 
@@ -183,7 +188,8 @@ extern          "C" {
 #define NETSNMP_DS_LIB_SSH_PUBKEY        33
 #define NETSNMP_DS_LIB_SSH_PRIVKEY       34
 #define NETSNMP_DS_LIB_OUTPUT_PRECISION  35
-#define NETSNMP_DS_LIB_MAX_STR_ID        48 /* match NETSNMP_DS_MAX_SUBIDS */
+#define NETSNMP_DS_LIB_EVENT_LOOP        36 /* "select" or "epoll" */
+#define NETSNMP_DS_LIB_MAX_STR_ID        56 /* match NETSNMP_DS_MAX_SUBIDS */
 
     /*
      * end storage definitions 
@@ -12,6 +12,11 @@
  *           callbacks for registered events.  See snmpd.c and snmptrapd.c 
  *           for examples.
  *
+ *           On systems with epoll(7), the event loop can instead be left to
+ *           netsnmp_epoll_wait() and netsnmp_epoll_dispatch_events(), which
+ *           keep persistent registrations for the registered FDs and for
+ *           the sockets of all open sessions.
+ *
  * LIMITATIONS:
  **************************************************************************/
 #ifndef FD_EVENT_MANAGER_H
@@ -128,6 +133,43 @@ void netsnmp_dispatch_external_events2(int *count,
                                        netsnmp_large_fd_set *readfds,
                                        netsnmp_large_fd_set *writefds,
                                        netsnmp_large_fd_set *exceptfds);
+
+/*
+ * epoll Event Loop
+ *
+ * Description:
+ *   An alternative to select() for applications with many sessions.  Call
+ *   netsnmp_epoll_event_loop_init() once the configuration has been read;
+ *   it succeeds only when the "eventLoop epoll" snmp.conf setting is present
+ *   and epoll is available.  From then on, the sockets of sessions that are
+ *   opened or closed and FDs that are (un)registered above are tracked
+ *   automatically, so there is no need for snmp_select_info(),
+ *   netsnmp_external_event_info() or snmp_read() in the loop.  Each pass
+ *   should instead:
+ *
+ *     - obtain the timeout with snmp_sess_select_info2_flags(NULL, ...,
+ *       NETSNMP_SELECT_NOFDS), which only looks at timers;
+ *     - call netsnmp_epoll_wait() with that timeout.  Like select(), it
+ *       returns the number of ready FDs, 0 on timeout or -1 on error;
+ *     - if there were ready FDs, call netsnmp_epoll_dispatch_events() to
+ *       invoke the registered callbacks and read the ready sessions,
+ *       otherwise call snmp_timeout();
+ *     - call run_alarms() as usual.
+ *
+ *   netsnmp_epoll_event_loop_shutdown() releases the epoll instance.
+ *
+ * Return Value:
+ *   netsnmp_epoll_event_loop_init() returns 0 if the epoll loop is to be
+ *   used and -1 if the application should keep using select().
+ */
+NETSNMP_IMPORT
+int  netsnmp_epoll_event_loop_init(void);
+NETSNMP_IMPORT
+void netsnmp_epoll_event_loop_shutdown(void);
+NETSNMP_IMPORT
+int  netsnmp_epoll_wait(struct timeval *timeout);
+NETSNMP_IMPORT
+void netsnmp_epoll_dispatch_events(int *count);
 #ifdef __cplusplus
 }
 #endif
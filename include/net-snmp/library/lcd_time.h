@@ -18,7 +18,7 @@ extern          "C" {
     /*
      * Macros and definitions.
      */
-#define ETIMELIST_SIZE	23
+#define ETIMELIST_SIZE	23      /* initial number of hash chains */
 
 
 
@@ -38,8 +38,14 @@ extern          "C" {
 #define MT_LIB_MESSAGEID   3
 #define MT_LIB_SESSIONID   4
 #define MT_LIB_TRANSID     5
+#define MT_LIB_POOL        6
+#define MT_LIB_KEYCACHE    7
+#define MT_LIB_ENGINETIME  8
+#define MT_LIB_LOCALTIME   9
+#define MT_LIB_MIBPRINT    10
+#define MT_LIB_TIMEOUTS    11
 
-#define MT_LIB_MAXIMUM     6    /* must be one greater than the last one */
+#define MT_LIB_MAXIMUM     12   /* must be one greater than the last one */
 
 
 #if defined(NETSNMP_REENTRANT) || defined(WIN32)
@@ -83,6 +89,46 @@ int             snmp_res_destroy_mutex(int groupID, int resourceID);
 
 #endif /*  NETSNMP_REENTRANT  */
 
+#if defined(NETSNMP_REENTRANT) && HAVE_PTHREAD_H
+/*
+ * Completion queue through which worker threads hand finished items back
+ * to the main thread.  The main thread watches fd[0] in its select loop;
+ * items start with a netsnmp_done_item and come out in the order they
+ * were pushed.
+ */
+typedef struct netsnmp_done_item_s {
+    struct netsnmp_done_item_s *next;
+} netsnmp_done_item;
+
+typedef struct netsnmp_done_queue_s {
+    int             fd[2];
+    pthread_mutex_t lock;
+    netsnmp_done_item *head;
+    netsnmp_done_item *tail;
+} netsnmp_done_queue;
+
+#define NETSNMP_DONE_QUEUE_INITIALIZER \
+    { { -1, -1 }, PTHREAD_MUTEX_INITIALIZER, NULL, NULL }
+
+NETSNMP_IMPORT
+int             netsnmp_done_queue_open(netsnmp_done_queue *q);
+NETSNMP_IMPORT
+void            netsnmp_done_queue_close(netsnmp_done_queue *q);
+NETSNMP_IMPORT
+void            netsnmp_done_queue_push(netsnmp_done_queue *q,
+                                        netsnmp_done_item *item);
+NETSNMP_IMPORT
+void            netsnmp_done_queue_ack(netsnmp_done_queue *q);
+NETSNMP_IMPORT
+netsnmp_done_item *netsnmp_done_queue_pop(netsnmp_done_queue *q);
+NETSNMP_IMPORT
+void            netsnmp_done_queue_purge(netsnmp_done_queue *q,
+                                         int (*match)(netsnmp_done_item *,
+                                                      void *),
+                                         void *arg,
+                                         void (*release)(netsnmp_done_item *));
+#endif /*  NETSNMP_REENTRANT && HAVE_PTHREAD_H  */
+
 #ifdef __cplusplus
 }
 #endif
@@ -227,6 +227,10 @@ SOFTWARE.
     NETSNMP_IMPORT
     struct module  *find_module(int);
     void            adopt_orphans(void);
+    int             netsnmp_mib_cache_load(const char *key);
+    int             netsnmp_mib_cache_save(const char *key,
+                                           const char *watch);
+    u_int           netsnmp_mib_tree_generation(void);
     NETSNMP_IMPORT
     char           *snmp_mib_toggle_options(char *options);
     NETSNMP_IMPORT
@@ -14,6 +14,7 @@ extern          "C" {
                              void **opaque, int *olength);
     int netsnmp_tcpbase_send(netsnmp_transport *t, const void *buf, int size,
                              void **opaque, int *olength);
+    void netsnmp_tcpbase_nodelay(int sock);
         
 #ifdef __cplusplus
 }
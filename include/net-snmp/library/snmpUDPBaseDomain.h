@@ -24,6 +24,21 @@ extern          "C" {
     int netsnmp_udpbase_send(netsnmp_transport *t, const void *buf, int size,
                              void **opaque, int *olength);
 
+/*
+ * Most datagrams moved by one recvmmsg()/sendmmsg() call
+ */
+#ifndef NETSNMP_UDPBASE_BATCH_MAX
+#define NETSNMP_UDPBASE_BATCH_MAX 64
+#endif
+#ifdef HAVE_RECVMMSG
+    int netsnmp_udpbase_recvm(netsnmp_transport *t,
+                              netsnmp_transport_msg *msgs, int count);
+#endif
+#ifdef HAVE_SENDMMSG
+    int netsnmp_udpbase_sendm(netsnmp_transport *t,
+                              netsnmp_transport_msg *msgs, int count);
+#endif
+
 #if defined(HAVE_IP_PKTINFO) || defined(HAVE_IP_RECVDSTADDR)
     int netsnmp_udpbase_recvfrom(int s, void *buf, int len,
                                  struct sockaddr *from, socklen_t *fromlen,
@@ -180,6 +180,7 @@ typedef struct request_list {
 
 #define SNMP_DETAIL_SIZE        512
 
+#define SNMP_FLAGS_PARSE_WORKERS   0x1000     /* parse in worker threads */
 #define SNMP_FLAGS_UDP_BROADCAST   0x800
 #define SNMP_FLAGS_RESP_CALLBACK   0x400      /* Additional callback on response */
 #define SNMP_FLAGS_USER_CREATED    0x200      /* USM user has been created */
@@ -315,6 +316,14 @@ typedef struct request_list {
 
     NETSNMP_IMPORT void snmp_free_var_internals(netsnmp_variable_list *);     /* frees contents only */
 
+    /*
+     * Zeroed PDU and varbind structures, taken from the free lists that
+     * snmp_free_pdu() and snmp_free_var() return them to (see the
+     * pduPoolSize and varbindPoolSize snmp.conf tokens).
+     */
+    NETSNMP_IMPORT netsnmp_pdu *netsnmp_pdu_alloc(void);
+    NETSNMP_IMPORT netsnmp_variable_list *netsnmp_varbind_alloc(void);
+
 
     /*
      * This routine must be supplied by the application:
@@ -408,6 +417,23 @@ typedef struct request_list {
     snmp_parse(struct session_list *slp, netsnmp_session *pss,
                netsnmp_pdu *pdu, u_char *data, size_t length);
 
+    /*
+     * Worker threads parsing (and so authenticating and decrypting) the
+     * datagrams received by sessions flagged SNMP_FLAGS_PARSE_WORKERS.
+     * The parsed PDUs are handed to the session callbacks by
+     * netsnmp_parse_workers_run(), which the application calls from its
+     * main loop whenever netsnmp_parse_workers_fd() becomes readable.
+     * Only available in --enable-reentrant builds; elsewhere init fails.
+     */
+    NETSNMP_IMPORT
+    int             netsnmp_parse_workers_init(int count);
+    NETSNMP_IMPORT
+    void            netsnmp_parse_workers_shutdown(void);
+    NETSNMP_IMPORT
+    int             netsnmp_parse_workers_fd(void);
+    NETSNMP_IMPORT
+    void            netsnmp_parse_workers_run(void);
+
     NETSNMP_IMPORT
     u_char         *snmp_pdu_build(netsnmp_pdu *, u_char *, size_t *);
 #ifdef NETSNMP_USE_REVERSE_ASNENCODING
@@ -550,6 +576,8 @@ struct netsnmp_transport_s;
     NETSNMP_IMPORT
     void            snmp_sess_transport_set(struct session_list *,
 					    struct netsnmp_transport_s *);
+    NETSNMP_IMPORT
+    void            snmp_sess_transport_close(struct session_list *);
 
     NETSNMP_IMPORT int
     netsnmp_sess_config_transport(struct netsnmp_container_s *transport_configuration,
@@ -743,9 +771,44 @@ struct netsnmp_transport_s;
 #define  STAT_TLSTM_STATS_START                 STAT_TLSTM_SNMPTLSTMSESSIONOPENS
 #define  STAT_TLSTM_STATS_END          STAT_TLSTM_SNMPTLSTMSESSIONINVALIDCACHES
 
+    /*
+     * object pool stats (not in any MIB): a hit is an allocation served
+     * from a free list, a miss one that had to go to malloc()
+     */
+#define  STAT_POOL_PDU_HITS                  57
+#define  STAT_POOL_PDU_MISSES                58
+#define  STAT_POOL_VARBIND_HITS              59
+#define  STAT_POOL_VARBIND_MISSES            60
+#define  STAT_POOL_AGENT_SESSION_HITS        61
+#define  STAT_POOL_AGENT_SESSION_MISSES      62
+
+#define  STAT_POOL_STATS_START               STAT_POOL_PDU_HITS
+#define  STAT_POOL_STATS_END                 STAT_POOL_AGENT_SESSION_MISSES
+
+    /*
+     * scapi keyed context cache stats (not in any MIB)
+     */
+#define  STAT_SC_KEYCACHE_HITS               63
+#define  STAT_SC_KEYCACHE_MISSES             64
+
+#define  STAT_SC_KEYCACHE_STATS_START        STAT_SC_KEYCACHE_HITS
+#define  STAT_SC_KEYCACHE_STATS_END          STAT_SC_KEYCACHE_MISSES
+
+    /*
+     * mib.c translation cache stats (not in any MIB): OIDs looked up to
+     * print them, and names looked up to parse them
+     */
+#define  STAT_MIB_OIDCACHE_HITS              65
+#define  STAT_MIB_OIDCACHE_MISSES            66
+#define  STAT_MIB_NAMECACHE_HITS             67
+#define  STAT_MIB_NAMECACHE_MISSES           68
+
+#define  STAT_MIB_CACHE_STATS_START          STAT_MIB_OIDCACHE_HITS
+#define  STAT_MIB_CACHE_STATS_END            STAT_MIB_NAMECACHE_MISSES
+
     /* this previously was end+1; don't know why the +1 is needed;
        XXX: check the code */
-#define  NETSNMP_STAT_MAX_STATS              (STAT_TLSTM_STATS_END+1)
+#define  NETSNMP_STAT_MAX_STATS              (STAT_MIB_CACHE_STATS_END+1)
 /** backwards compatability */
 #define MAX_STATS NETSNMP_STAT_MAX_STATS
 
@@ -759,6 +822,10 @@ struct netsnmp_transport_s;
        struct snmp_internal_session *internal;
     };
 
+    NETSNMP_IMPORT
+    void snmp_set_session_list_hook(void (*hook) (struct session_list *,
+                                                  int));
+
 #ifdef __cplusplus
 }
 #endif
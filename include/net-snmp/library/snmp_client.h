@@ -60,6 +60,10 @@ extern          "C" {
                                            u_char new_type);
     NETSNMP_IMPORT
     void            snmp_reset_var_buffers(netsnmp_variable_list * var);
+    NETSNMP_IMPORT
+    void            netsnmp_var_release_value(netsnmp_variable_list * var);
+    NETSNMP_IMPORT
+    netsnmp_rxbuf  *netsnmp_rxbuf_create(const u_char * data, size_t len);
     void            snmp_reset_var_types(netsnmp_variable_list * vbl,
                                          u_char new_type);
     NETSNMP_IMPORT
@@ -127,9 +127,19 @@ typedef struct netsnmp_tdomain_spec_s {
     struct netsnmp_container_s *transport_config; /* extra config */
 } netsnmp_tdomain_spec;
 
+/*  One datagram for the optional batched receive and send callbacks.  */
+
+typedef struct netsnmp_transport_msg_s {
+    void           *buf;
+    int             len;        /* recv: buffer size in, datagram size out */
+    void           *opaque;
+    int             olength;
+} netsnmp_transport_msg;
+
 /*  Structure which defines the transport-independent API.  */
 
 struct snmp_session;
+struct netsnmp_transport_batch_s; /* private to snmp_transport.c */
 
 typedef struct netsnmp_transport_s {
     /*  The transport domain object identifier.  */
@@ -217,6 +227,20 @@ typedef struct netsnmp_transport_s {
     void           (*f_get_taddr)(struct netsnmp_transport_s *t,
                                   void **addr, size_t *addr_len);
 
+    /*  Optional: receive up to count datagrams with one call.  Fills in
+        len, opaque and olength of each message and returns the number
+        received, or -1 on error.  */
+    int             (*f_recvm)(struct netsnmp_transport_s *,
+                               netsnmp_transport_msg *, int count);
+
+    /*  Optional: send count datagrams with as few calls as possible.
+        Returns the number sent.  */
+    int             (*f_sendm)(struct netsnmp_transport_s *,
+                               netsnmp_transport_msg *, int count);
+
+    /*  Buffers used by netsnmp_transport_recvm() and the send queue.  */
+    struct netsnmp_transport_batch_s *batch;
+
 } netsnmp_transport;
 
 typedef struct netsnmp_transport_list_s {
@@ -262,6 +286,15 @@ int netsnmp_transport_send(netsnmp_transport *t, const void *data, int len,
 int netsnmp_transport_recv(netsnmp_transport *t, void *data, int len,
                            void **opaque, int *olength);
 
+/*  Batched datagram I/O for transports providing f_recvm and f_sendm.  */
+
+int netsnmp_transport_recvm(netsnmp_transport *t,
+                            netsnmp_transport_msg **msgs);
+void netsnmp_transport_recvm_done(netsnmp_transport *t,
+                                  netsnmp_transport_msg *msgs, int count);
+void netsnmp_transport_cork(netsnmp_transport *t);
+int netsnmp_transport_uncork(netsnmp_transport *t);
+
 int netsnmp_transport_add_to_list(netsnmp_transport_list **transport_list,
 				  netsnmp_transport *transport);
 int netsnmp_transport_remove_from_list(netsnmp_transport_list **transport_list,
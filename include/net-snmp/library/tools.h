@@ -205,6 +205,10 @@ extern          "C" {
     NETSNMP_IMPORT
     void *netsnmp_memdup_nt(const void *from, size_t from_len, size_t *to_len);
 
+#define NETSNMP_HASH_INIT 2166136261U
+    NETSNMP_IMPORT
+    u_int           netsnmp_hash_buf(const void *buf, size_t len, u_int hash);
+
     void            netsnmp_check_definedness(const void *packet,
                                               size_t length);
 
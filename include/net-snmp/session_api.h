@@ -168,6 +168,7 @@ extern          "C" {
 
 #define NETSNMP_SELECT_NOFLAGS  0x00
 #define NETSNMP_SELECT_NOALARMS 0x01
+#define NETSNMP_SELECT_NOFDS    0x02
     NETSNMP_IMPORT
     int             snmp_sess_select_info_flags(struct session_list *, int *, fd_set *,
                                                 struct timeval *, int *, int);
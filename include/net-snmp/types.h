@@ -152,8 +152,25 @@ typedef struct variable_list {
    /** callback to free above */
    void            (*dataFreeHook)(void *);    
    int             index;
+   /** shared copy of received data that val may point into, or NULL */
+   struct netsnmp_rxbuf_s *val_rxbuf;
 } netsnmp_variable_list;
 
+/** @typedef struct netsnmp_rxbuf_s netsnmp_rxbuf
+ * Typedefs the netsnmp_rxbuf_s struct into netsnmp_rxbuf */
+/** @struct netsnmp_rxbuf_s
+ * A reference counted copy of received data.  When parsing with
+ * zeroCopyVarbinds, large string values point into one of these instead
+ * of being copied into memory of their own; each such variable holds a
+ * reference.
+ */
+typedef struct netsnmp_rxbuf_s {
+   /** the data, allocated along with this structure */
+   u_char         *data;
+   size_t          len;
+   int             refcount;
+} netsnmp_rxbuf;
+
 
 /** @typedef struct snmp_pdu to netsnmp_pdu
  * Typedefs the snmp_pdu struct into netsnmp_pdu */
@@ -916,6 +916,47 @@ u_char         *
 asn_parse_string(u_char * data,
                  size_t * datalength,
                  u_char * type, u_char * str, size_t * strlength)
+{
+    u_char         *value, *next;
+    size_t          maxlength;
+
+    if (NULL == str || NULL == strlength) {
+        ERROR_MSG("parse string: NULL pointer");
+        return NULL;
+    }
+
+    maxlength = *strlength;
+    next = asn_parse_string_ref(data, datalength, type, &value, strlength);
+    if (NULL == next)
+        return NULL;
+
+    memmove(str, value, *strlength);
+    if (maxlength > *strlength)
+        str[*strlength] = 0;
+    return next;
+}
+
+/**
+ * @internal
+ * asn_parse_string_ref - finds the contents of an ASN octet string type.
+ *
+ *  Same as asn_parse_string(), except that nothing is copied: "string" is
+ *  set to point to the contents of the string within "data".
+ *
+ * @param data        IN - pointer to start of object
+ * @param datalength  IN/OUT - number of valid bytes left in buffer
+ * @param type        OUT - asn type of object
+ * @param string      OUT - pointer to the contents of the string
+ * @param strlength   IN/OUT - maximum acceptable length / actual length
+ *
+ * @return  Returns a pointer to the first byte past the end
+ *          of this object (i.e. the start of the next object).
+ *          Returns NULL on any error.
+ */
+u_char         *
+asn_parse_string_ref(u_char * data,
+                     size_t * datalength,
+                     u_char * type, u_char ** str, size_t * strlength)
 {
     static const char *errpre = "parse string";
     u_char         *bufp = data;
@@ -953,9 +994,7 @@ asn_parse_string(u_char * data,
 
     DEBUGDUMPSETUP("recv", data, bufp - data + asn_length);
 
-    memmove(str, bufp, asn_length);
-    if (*strlength > asn_length)
-        str[asn_length] = 0;
+    *str = bufp;
     *strlength = asn_length;
     *datalength -= asn_length + (bufp - data);
 
@@ -964,7 +1003,7 @@ asn_parse_string(u_char * data,
         size_t          l = (buf != NULL) ? (1 + asn_length) : 0, ol = 0;
 
         if (sprint_realloc_asciistring
-            (&buf, &l, &ol, 1, str, asn_length)) {
+            (&buf, &l, &ol, 1, bufp, asn_length)) {
             DEBUGMSG(("dumpv_recv", "  String:\t%s\n", buf));
         } else {
             if (buf == NULL) {
@@ -3,6 +3,16 @@
 #ifdef HAVE_SYS_SELECT
 #include <sys/select.h>
 #endif
+#ifdef HAVE_EPOLL_CREATE1
+#include <sys/epoll.h>
+#endif
+#include <errno.h>
+#include <limits.h>
+#if HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
 #include <net-snmp/net-snmp-includes.h>
 #include <net-snmp/net-snmp-features.h>
 #include <net-snmp/library/snmp_api.h>
@@ -25,6 +35,189 @@ void   *external_exceptfd_data[NUM_EXTERNAL_FDS];
 
 static int external_fd_unregistered;
 
+#ifdef HAVE_EPOLL_CREATE1
+/*
+ * epoll(7) backend.
+ *
+ * Rather than rebuilding fd sets from every session and registration on
+ * each pass of the event loop, keep one persistent kernel registration per
+ * file descriptor.  It is updated as sessions enter and leave the session
+ * list (through the session list hook) and as fds are (un)registered below,
+ * so that a wait costs in proportion to the number of ready descriptors.
+ */
+#define EPOLL_FD_SESSION 0x01
+#define EPOLL_FD_READ    0x02
+#define EPOLL_FD_WRITE   0x04
+#define EPOLL_FD_EXCEPT  0x08
+
+#ifndef NETSNMP_EPOLL_MAX_EVENTS
+#define NETSNMP_EPOLL_MAX_EVENTS 256
+#endif
+
+struct epoll_fd_entry {
+    struct session_list *slp;   /* the session reading this fd, if only one */
+    int             nsessions;  /* number of sessions reading this fd */
+    int             armed;      /* EPOLL_FD_* registered with the kernel */
+    unsigned int    serial;     /* epoll_serial when last changed */
+};
+
+static int      epoll_fd = -1;
+static struct epoll_fd_entry *epoll_fds;
+static int      epoll_fds_len;
+static unsigned int epoll_serial, epoll_wait_serial;
+static struct epoll_event epoll_events[NETSNMP_EPOLL_MAX_EVENTS];
+static int      epoll_events_count;
+static netsnmp_large_fd_set epoll_readfds;
+
+static struct epoll_fd_entry *
+_epoll_entry(int fd, int create)
+{
+    struct epoll_fd_entry *fds;
+    int             len;
+
+    if (fd < 0)
+        return NULL;
+    if (fd >= epoll_fds_len) {
+        if (!create)
+            return NULL;
+        len = epoll_fds_len ? epoll_fds_len : 64;
+        while (len <= fd)
+            len *= 2;
+        fds = (struct epoll_fd_entry *)
+            realloc(epoll_fds, len * sizeof(*epoll_fds));
+        if (!fds) {
+            snmp_log(LOG_ERR, "epoll: out of memory for fd %d\n", fd);
+            return NULL;
+        }
+        memset(fds + epoll_fds_len, 0,
+               (len - epoll_fds_len) * sizeof(*epoll_fds));
+        epoll_fds = fds;
+        epoll_fds_len = len;
+    }
+    return &epoll_fds[fd];
+}
+
+/*
+ * Bring the kernel registration of fd in line with the sessions and
+ * external registrations that want it.
+ */
+static void
+_epoll_update(int fd)
+{
+    struct epoll_fd_entry *e;
+    struct epoll_event ev;
+    int             i, want = 0, op, rc;
+
+    if (epoll_fd < 0 || (e = _epoll_entry(fd, 1)) == NULL)
+        return;
+
+    if (e->nsessions > 0)
+        want |= EPOLL_FD_SESSION;
+    for (i = 0; i < external_readfdlen; i++)
+        if (external_readfd[i] == fd)
+            want |= EPOLL_FD_READ;
+    for (i = 0; i < external_writefdlen; i++)
+        if (external_writefd[i] == fd)
+            want |= EPOLL_FD_WRITE;
+    for (i = 0; i < external_exceptfdlen; i++)
+        if (external_exceptfd[i] == fd)
+            want |= EPOLL_FD_EXCEPT;
+    if (want == e->armed)
+        return;
+
+    memset(&ev, 0, sizeof(ev));
+    if (want & (EPOLL_FD_SESSION | EPOLL_FD_READ))
+        ev.events |= EPOLLIN;
+    if (want & EPOLL_FD_WRITE)
+        ev.events |= EPOLLOUT;
+    if (want & EPOLL_FD_EXCEPT)
+        ev.events |= EPOLLPRI;
+    ev.data.fd = fd;
+
+    op = !want ? EPOLL_CTL_DEL : e->armed ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    rc = epoll_ctl(epoll_fd, op, fd, &ev);
+    /*
+     * The kernel forgets an fd by itself once it is closed, so the number
+     * may since have been reused (or not) behind our back.
+     */
+    if (rc < 0 && op == EPOLL_CTL_MOD && errno == ENOENT)
+        rc = epoll_ctl(epoll_fd, op = EPOLL_CTL_ADD, fd, &ev);
+    else if (rc < 0 && op == EPOLL_CTL_ADD && errno == EEXIST)
+        rc = epoll_ctl(epoll_fd, op = EPOLL_CTL_MOD, fd, &ev);
+    if (rc < 0 && op != EPOLL_CTL_DEL) {
+        snmp_log(LOG_ERR, "epoll: can't watch fd %d: %s\n", fd,
+                 strerror(errno));
+        want = 0;
+    }
+    DEBUGMSGTL(("fd_event_manager:epoll", "fd %d: 0x%x -> 0x%x\n",
+                fd, e->armed, want));
+    e->armed = want;
+    e->serial = ++epoll_serial;
+}
+
+static void
+_epoll_session_hook(struct session_list *slp, int added)
+{
+    struct epoll_fd_entry *e;
+    int             fd = slp->transport ? slp->transport->sock : -1;
+
+    if (fd < 0 && !added) {
+        /*
+         * The socket was closed before the session was; find it by owner.
+         */
+        for (fd = 0; fd < epoll_fds_len; fd++)
+            if (epoll_fds[fd].slp == slp)
+                break;
+    }
+    if ((e = _epoll_entry(fd, added)) == NULL)
+        return;
+
+    if (added) {
+        e->slp = e->nsessions++ ? NULL : slp;
+    } else {
+        if (e->nsessions == 0 || (e->slp && e->slp != slp))
+            return;
+        e->nsessions--;
+        e->slp = NULL;
+    }
+    e->serial = ++epoll_serial;
+    _epoll_update(fd);
+}
+
+/*
+ * Let the session(s) behind a readable fd read from it.
+ */
+static void
+_epoll_read_sessions(int fd)
+{
+    struct session_list *slp = epoll_fds[fd].slp;
+    unsigned int    serial = epoll_fds[fd].serial;
+
+    NETSNMP_LARGE_FD_SET(fd, &epoll_readfds);
+    if (slp && epoll_fds[fd].nsessions == 1) {
+        snmp_res_lock(MT_LIBRARY_ID, MT_LIB_SESSION);
+        snmp_sess_read2(slp, &epoll_readfds);
+        /*
+         * A stream session whose peer went away has its socket closed
+         * here but stays on the session list until it is reaped.
+         */
+        if (epoll_fds[fd].serial == serial &&
+            (!slp->transport || slp->transport->sock != fd)) {
+            epoll_fds[fd].nsessions = 0;
+            epoll_fds[fd].slp = NULL;
+            _epoll_update(fd);
+        }
+        snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_SESSION);
+    } else {
+        /*
+         * Several sessions share the socket; let them all have a go.
+         */
+        snmp_read2(&epoll_readfds);
+    }
+    NETSNMP_LARGE_FD_CLR(fd, &epoll_readfds);
+}
+#endif /* HAVE_EPOLL_CREATE1 */
+
 /*
  * Register a given fd for read events.  Call callback when events
  * are received.
@@ -38,6 +231,9 @@ register_readfd(int fd, void (*func) (int, void *), void *data)
         external_readfd_data[external_readfdlen] = data;
         external_readfdlen++;
         DEBUGMSGTL(("fd_event_manager:register_readfd", "registered fd %d\n", fd));
+#ifdef HAVE_EPOLL_CREATE1
+        _epoll_update(fd);
+#endif
         return FD_REGISTERED_OK;
     } else {
         snmp_log(LOG_CRIT, "register_readfd: too many file descriptors\n");
@@ -58,6 +254,9 @@ register_writefd(int fd, void (*func) (int, void *), void *data)
         external_writefd_data[external_writefdlen] = data;
         external_writefdlen++;
         DEBUGMSGTL(("fd_event_manager:register_writefd", "registered fd %d\n", fd));
+#ifdef HAVE_EPOLL_CREATE1
+        _epoll_update(fd);
+#endif
         return FD_REGISTERED_OK;
     } else {
         snmp_log(LOG_CRIT,
@@ -79,6 +278,9 @@ register_exceptfd(int fd, void (*func) (int, void *), void *data)
         external_exceptfd_data[external_exceptfdlen] = data;
         external_exceptfdlen++;
         DEBUGMSGTL(("fd_event_manager:register_exceptfd", "registered fd %d\n", fd));
+#ifdef HAVE_EPOLL_CREATE1
+        _epoll_update(fd);
+#endif
         return FD_REGISTERED_OK;
     } else {
         snmp_log(LOG_CRIT,
@@ -105,6 +307,9 @@ unregister_readfd(int fd)
             }
             DEBUGMSGTL(("fd_event_manager:unregister_readfd", "unregistered fd %d\n", fd));
             external_fd_unregistered = 1;
+#ifdef HAVE_EPOLL_CREATE1
+            _epoll_update(fd);
+#endif
             return FD_UNREGISTERED_OK;
         }
     }
@@ -129,6 +334,9 @@ unregister_writefd(int fd)
             }
             DEBUGMSGTL(("fd_event_manager:unregister_writefd", "unregistered fd %d\n", fd));
             external_fd_unregistered = 1;
+#ifdef HAVE_EPOLL_CREATE1
+            _epoll_update(fd);
+#endif
             return FD_UNREGISTERED_OK;
         }
     }
@@ -154,6 +362,9 @@ unregister_exceptfd(int fd)
             DEBUGMSGTL(("fd_event_manager:unregister_exceptfd", "unregistered fd %d\n",
                         fd));
             external_fd_unregistered = 1;
+#ifdef HAVE_EPOLL_CREATE1
+            _epoll_update(fd);
+#endif
             return FD_UNREGISTERED_OK;
         }
     }
@@ -292,6 +503,146 @@ void netsnmp_dispatch_external_events2(int *count,
       }
   }
 }
+
+/*
+ * NET-SNMP epoll Event Loop
+ */
+int
+netsnmp_epoll_event_loop_init(void)
+{
+    const char     *loop = netsnmp_ds_get_string(NETSNMP_DS_LIBRARY_ID,
+                                                 NETSNMP_DS_LIB_EVENT_LOOP);
+#ifdef HAVE_EPOLL_CREATE1
+    int             i;
+#endif
+
+    if (!loop || strcmp(loop, "epoll") != 0) {
+        if (loop && strcmp(loop, "select") != 0)
+            snmp_log(LOG_WARNING, "unknown eventLoop \"%s\", using select\n",
+                     loop);
+        return -1;
+    }
+#ifdef HAVE_EPOLL_CREATE1
+    if (epoll_fd >= 0)
+        return 0;
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        snmp_log_perror("epoll_create1");
+        return -1;
+    }
+    netsnmp_large_fd_set_init(&epoll_readfds, FD_SETSIZE);
+
+    snmp_set_session_list_hook(_epoll_session_hook);
+    for (i = 0; i < external_readfdlen; i++)
+        _epoll_update(external_readfd[i]);
+    for (i = 0; i < external_writefdlen; i++)
+        _epoll_update(external_writefd[i]);
+    for (i = 0; i < external_exceptfdlen; i++)
+        _epoll_update(external_exceptfd[i]);
+
+    DEBUGMSGTL(("fd_event_manager:epoll", "using epoll fd %d\n", epoll_fd));
+    return 0;
+#else
+    snmp_log(LOG_WARNING, "eventLoop epoll is not available, using select\n");
+    return -1;
+#endif /* HAVE_EPOLL_CREATE1 */
+}
+
+void
+netsnmp_epoll_event_loop_shutdown(void)
+{
+#ifdef HAVE_EPOLL_CREATE1
+    if (epoll_fd < 0)
+        return;
+    snmp_set_session_list_hook(NULL);
+    close(epoll_fd);
+    epoll_fd = -1;
+    SNMP_FREE(epoll_fds);
+    epoll_fds_len = 0;
+    epoll_events_count = 0;
+    netsnmp_large_fd_set_cleanup(&epoll_readfds);
+#endif /* HAVE_EPOLL_CREATE1 */
+}
+
+int
+netsnmp_epoll_wait(struct timeval *timeout)
+{
+#ifdef HAVE_EPOLL_CREATE1
+    int             ms = -1, count;
+
+    if (epoll_fd < 0) {
+        errno = EBADF;
+        return -1;
+    }
+    if (timeout) {
+        if (timeout->tv_sec >= INT_MAX / 1000)
+            ms = INT_MAX;
+        else
+            ms = timeout->tv_sec * 1000 + (timeout->tv_usec + 999) / 1000;
+    }
+
+    epoll_events_count = 0;
+    count = epoll_wait(epoll_fd, epoll_events, NETSNMP_EPOLL_MAX_EVENTS, ms);
+    if (count > 0)
+        epoll_events_count = count;
+    epoll_wait_serial = epoll_serial;
+    return count;
+#else
+    errno = ENOSYS;
+    return -1;
+#endif /* HAVE_EPOLL_CREATE1 */
+}
+
+void
+netsnmp_epoll_dispatch_events(int *count)
+{
+#ifdef HAVE_EPOLL_CREATE1
+    unsigned int    events;
+    int             i, j, fd;
+
+    for (i = 0; *count > 0 && i < epoll_events_count; i++, (*count)--) {
+        fd = epoll_events[i].data.fd;
+        events = epoll_events[i].events;
+        if (events & (EPOLLERR | EPOLLHUP))
+            events |= EPOLLIN | EPOLLOUT;
+        external_fd_unregistered = 0;
+        DEBUGMSGTL(("fd_event_manager:epoll", "fd %d events 0x%x\n",
+                    fd, events));
+
+        /*
+         * Anything that changed since the wait is skipped: it may no longer
+         * be what woke us up, and level-triggered epoll will report it again
+         * if it is still ready.
+         */
+#define EPOLL_FD_READY(bit) \
+        (fd < epoll_fds_len && epoll_fds[fd].serial <= epoll_wait_serial && \
+         (epoll_fds[fd].armed & (bit)))
+
+        if ((events & EPOLLIN) && EPOLL_FD_READY(EPOLL_FD_READ)) {
+            for (j = 0; j < external_readfdlen && !external_fd_unregistered;
+                 j++)
+                if (external_readfd[j] == fd)
+                    external_readfdfunc[j] (fd, external_readfd_data[j]);
+        }
+        if ((events & EPOLLOUT) && EPOLL_FD_READY(EPOLL_FD_WRITE)) {
+            for (j = 0; j < external_writefdlen && !external_fd_unregistered;
+                 j++)
+                if (external_writefd[j] == fd)
+                    external_writefdfunc[j] (fd, external_writefd_data[j]);
+        }
+        if ((events & EPOLLPRI) && EPOLL_FD_READY(EPOLL_FD_EXCEPT)) {
+            for (j = 0; j < external_exceptfdlen && !external_fd_unregistered;
+                 j++)
+                if (external_exceptfd[j] == fd)
+                    external_exceptfdfunc[j] (fd, external_exceptfd_data[j]);
+        }
+        if ((events & EPOLLIN) && EPOLL_FD_READY(EPOLL_FD_SESSION))
+            _epoll_read_sessions(fd);
+#undef EPOLL_FD_READY
+    }
+    epoll_events_count = 0;
+#endif /* HAVE_EPOLL_CREATE1 */
+}
 #else  /*  !NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER */
 netsnmp_feature_unused(fd_event_manager);
 #endif /*  !NETSNMP_FEATURE_REMOVE_FD_EVENT_MANAGER */
@@ -56,11 +56,62 @@ netsnmp_feature_child_of(usm_lcd_time, usm_support);
 #ifndef NETSNMP_FEATURE_REMOVE_USM_LCD_TIME
 
 /*
- * Global static hashlist to contain Enginetime entries.
+ * Global static hashlist to contain Enginetime entries.  Protected by
+ * MT_LIB_ENGINETIME, as trap receivers may authenticate in several
+ * threads at once.
  *
  * New records are prepended to the appropriate list at the hash index.
+ * The list starts out with ETIMELIST_SIZE chains and doubles in size
+ * whenever it holds more than ETIMELIST_LOAD entries per chain, so that
+ * lookups stay short for trap receivers that hear from many engines.
  */
-static Enginetime etimelist[ETIMELIST_SIZE];
+#define ETIMELIST_LOAD 2
+
+static Enginetime etimelist_initial[ETIMELIST_SIZE];
+static Enginetime *etimelist = etimelist_initial;
+static u_int    etimelist_size = ETIMELIST_SIZE;
+static u_int    etimelist_count = 0;
+static u_int    etimelist_seed = 0;
+
+static u_int
+etimelist_hash(const u_char * engineID, u_int engineID_len)
+{
+    /*
+     * engineIDs come off the wire, so keep their chains unpredictable
+     */
+    if (0 == etimelist_seed)
+        etimelist_seed = (u_int) netsnmp_random() | 1;
+    return netsnmp_hash_buf(engineID, engineID_len,
+                            netsnmp_hash_buf(&etimelist_seed,
+                                             sizeof(etimelist_seed),
+                                             NETSNMP_HASH_INIT));
+}
+
+static void
+etimelist_grow(void)
+{
+    u_int           new_size = etimelist_size * 2 + 1, i, iindex;
+    Enginetime     *new_list, e, next;
+
+    new_list = (Enginetime *) calloc(new_size, sizeof(Enginetime));
+    if (NULL == new_list)
+        return;                 /* keep using the longer chains */
+
+    for (i = 0; i < etimelist_size; i++) {
+        for (e = etimelist[i]; e; e = next) {
+            next = e->next;
+            iindex = etimelist_hash(e->engineID, e->engineID_len) % new_size;
+            e->next = new_list[iindex];
+            new_list[iindex] = e;
+        }
+    }
+    if (etimelist != etimelist_initial)
+        free(etimelist);
+    etimelist = new_list;
+    etimelist_size = new_size;
+    DEBUGMSGTL(("lcd_set_enginetime", "etimelist grown to %u chains\n",
+                new_size));
+}
 
 
 
@@ -106,7 +157,7 @@ get_enginetime(const u_char * engineID,
      * Sanity check.
      */
     if (!engine_time || !engineboot) {
-        QUITFUN(SNMPERR_GENERR, get_enginetime_quit);
+        return SNMPERR_GENERR;
     }
 
 
@@ -117,9 +168,10 @@ get_enginetime(const u_char * engineID,
     *engine_time = *engineboot = 0;
 
     if (!engineID || (engineID_len <= 0)) {
-        QUITFUN(SNMPERR_GENERR, get_enginetime_quit);
+        return SNMPERR_GENERR;
     }
 
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_ENGINETIME);
     if (!(e = search_enginetime_list(engineID, engineID_len))) {
         QUITFUN(SNMPERR_GENERR, get_enginetime_quit);
     }
@@ -156,6 +208,7 @@ get_enginetime(const u_char * engineID,
               *engine_time));
 
   get_enginetime_quit:
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_ENGINETIME);
     return rval;
 
 }                               /* end get_enginetime() */
@@ -202,7 +255,7 @@ get_enginetime_ex(u_char * engineID,
      * Sanity check.
      */
     if (!engine_time || !engineboot || !last_engine_time) {
-        QUITFUN(SNMPERR_GENERR, get_enginetime_ex_quit);
+        return SNMPERR_GENERR;
     }
 
 
@@ -213,9 +266,10 @@ get_enginetime_ex(u_char * engineID,
     *last_engine_time = *engine_time = *engineboot = 0;
 
     if (!engineID || (engineID_len <= 0)) {
-        QUITFUN(SNMPERR_GENERR, get_enginetime_ex_quit);
+        return SNMPERR_GENERR;
     }
 
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_ENGINETIME);
     if (!(e = search_enginetime_list(engineID, engineID_len))) {
         QUITFUN(SNMPERR_GENERR, get_enginetime_ex_quit);
     }
@@ -252,6 +306,7 @@ get_enginetime_ex(u_char * engineID,
               *engineboot, *engine_time));
 
   get_enginetime_ex_quit:
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_ENGINETIME);
     return rval;
 
 }                               /* end get_enginetime_ex() */
@@ -259,21 +314,28 @@ get_enginetime_ex(u_char * engineID,
 
 void free_enginetime(unsigned char *engineID, size_t engineID_len)
 {
-    Enginetime      e = NULL;
+    Enginetime     *prevNext, e;
     int             rval = 0;
 
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_ENGINETIME);
     rval = hash_engineID(engineID, engineID_len);
-    if (rval < 0)
+    if (rval < 0) {
+        snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_ENGINETIME);
 	return;
+    }
 
-    e = etimelist[rval];
-
-    while (e != NULL) {
-	etimelist[rval] = e->next;
-	SNMP_FREE(e->engineID);
-	SNMP_FREE(e);
-	e = etimelist[rval];
+    for (prevNext = &etimelist[rval]; (e = *prevNext) != NULL;
+         prevNext = &e->next) {
+        if (e->engineID_len == engineID_len &&
+            !memcmp(e->engineID, engineID, engineID_len)) {
+            *prevNext = e->next;
+            SNMP_FREE(e->engineID);
+            SNMP_FREE(e);
+            etimelist_count--;
+            break;
+        }
     }
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_ENGINETIME);
 
 }
 
@@ -297,7 +359,8 @@ void free_etimelist(void)
      Enginetime e = NULL;
      Enginetime nextE = NULL;
 
-     for( ; index < ETIMELIST_SIZE; ++index)
+     snmp_res_lock(MT_LIBRARY_ID, MT_LIB_ENGINETIME);
+     for( ; index < (int)etimelist_size; ++index)
      {
            e = etimelist[index];
 
@@ -311,6 +374,12 @@ void free_etimelist(void)
 
            etimelist[index] = NULL;
      }
+     if (etimelist != etimelist_initial)
+           free(etimelist);
+     etimelist = etimelist_initial;
+     etimelist_size = ETIMELIST_SIZE;
+     etimelist_count = 0;
+     snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_ENGINETIME);
      return;
 }
 
@@ -359,7 +428,10 @@ set_enginetime(const u_char * engineID,
      * Store the given <engine_time, engineboot> tuple in the record
      * for engineID.  Create a new record if necessary.
      */
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_ENGINETIME);
     if (!(e = search_enginetime_list(engineID, engineID_len))) {
+        if (etimelist_count >= etimelist_size * ETIMELIST_LOAD)
+            etimelist_grow();
         if ((iindex = hash_engineID(engineID, engineID_len)) < 0) {
             QUITFUN(SNMPERR_GENERR, set_enginetime_quit);
         }
@@ -373,6 +445,7 @@ set_enginetime(const u_char * engineID,
         memcpy(e->engineID, engineID, engineID_len);
 
         e->engineID_len = engineID_len;
+        etimelist_count++;
     }
 #ifdef LCD_TIME_SYNC_OPT
     if (authenticated || !e->authenticatedFlag) {
@@ -393,6 +466,7 @@ set_enginetime(const u_char * engineID,
               engine_time));
 
   set_enginetime_quit:
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_ENGINETIME);
     SNMP_FREE(e);
 
     return rval;
@@ -471,59 +545,23 @@ search_enginetime_list(const u_char * engineID, u_int engineID_len)
  *	SNMPERR_GENERR		Error.
  *	
  * 
- * Use a cheap hash to build an index into the etimelist.  Method is 
- * to hash the engineID, then split the hash into u_int's and add them up
- * and modulo the size of the list.
+ * Use a cheap hash to build an index into the etimelist.  The engineID
+ * is run through a seeded FNV-1a hash, modulo the current size of the
+ * list.  (This used to be an MD5 or SHA-1 digest, which cost more than
+ * the rest of the lookup put together.)
  *
  */
 int
 hash_engineID(const u_char * engineID, u_int engineID_len)
 {
-    int             rval = SNMPERR_GENERR;
-    size_t          buf_len = SNMP_MAXBUF;
-    u_int           additive = 0;
-    u_char         *bufp, buf[SNMP_MAXBUF];
-    void           *context = NULL;
-
-
-
     /*
      * Sanity check.
      */
     if (!engineID || (engineID_len <= 0)) {
-        QUITFUN(SNMPERR_GENERR, hash_engineID_quit);
+        return SNMPERR_GENERR;
     }
 
-
-    /*
-     * Hash engineID into a list index.
-     */
-#ifndef NETSNMP_DISABLE_MD5
-    rval = sc_hash(usmHMACMD5AuthProtocol,
-                   sizeof(usmHMACMD5AuthProtocol) / sizeof(oid),
-                   engineID, engineID_len, buf, &buf_len);
-    if (rval == SNMPERR_SC_NOT_CONFIGURED) {
-        /* fall back to sha1 */
-        rval = sc_hash(usmHMACSHA1AuthProtocol,
-                   sizeof(usmHMACSHA1AuthProtocol) / sizeof(oid),
-                   engineID, engineID_len, buf, &buf_len);
-    }
-#else
-    rval = sc_hash(usmHMACSHA1AuthProtocol,
-                   sizeof(usmHMACSHA1AuthProtocol) / sizeof(oid),
-                   engineID, engineID_len, buf, &buf_len);
-#endif
-    QUITFUN(rval, hash_engineID_quit);
-
-    for (bufp = buf; (bufp - buf) < (int) buf_len; bufp += 4) {
-        additive += (u_int) * bufp;
-    }
-
-  hash_engineID_quit:
-    SNMP_FREE(context);
-    memset(buf, 0, SNMP_MAXBUF);
-
-    return (rval < 0) ? rval : (int)(additive % ETIMELIST_SIZE);
+    return (int)(etimelist_hash(engineID, engineID_len) % etimelist_size);
 
 }                               /* end hash_engineID() */
 
@@ -584,7 +622,7 @@ dump_etimelist(void)
 
     DEBUGMSGTL(("dump_etimelist", "\n"));
 
-    while (++iindex < ETIMELIST_SIZE) {
+    while (++iindex < (int)etimelist_size) {
         DEBUGMSG(("dump_etimelist", "[%d]", iindex));
 
         count = 0;
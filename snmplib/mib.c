@@ -127,6 +127,12 @@ static struct tree *_get_realloc_symbol(const oid * objid, size_t objidlen,
                                         int *buf_overflow,
                                         struct index_list *in_dices,
                                         size_t * end_of_known);
+static void     _get_realloc_index(const oid * objid, size_t objidlen,
+                                   struct tree *subtree,
+                                   u_char ** buf, size_t * buf_len,
+                                   size_t * out_len, int allow_realloc,
+                                   int *buf_overflow,
+                                   struct index_list *in_dices);
 
 static int      print_tree_node(u_char ** buf, size_t * buf_len,
                                 size_t * out_len, int allow_realloc,
@@ -263,10 +269,55 @@ static void
 sprint_char(char *buf, const u_char ch)
 {
     if (isprint(ch) || isspace(ch)) {
-        sprintf(buf, "%c", (int) ch);
+        buf[0] = ch;
     } else {
-        sprintf(buf, ".");
+        buf[0] = '.';
     }
+    buf[1] = '\0';
+}
+
+/**
+ * @internal
+ * Prints an unsigned number in decimal, without going through printf.
+ *
+ * @param buf Buffer to print to, has to be at least 21 Bytes large.
+ * @param val Value to print.
+ *
+ * @return The number of characters printed.
+ */
+static size_t
+sprint_ulong(char *buf, u_long val)
+{
+    char            tmp[24], *cp = tmp + sizeof(tmp);
+    size_t          len;
+
+    do {
+        *--cp = '0' + val % 10;
+        val /= 10;
+    } while (val);
+    len = tmp + sizeof(tmp) - cp;
+    memcpy(buf, cp, len);
+    buf[len] = '\0';
+    return len;
+}
+
+/**
+ * @internal
+ * Prints a signed number in decimal, without going through printf.
+ *
+ * @param buf Buffer to print to, has to be at least 22 Bytes large.
+ * @param val Value to print.
+ *
+ * @return The number of characters printed.
+ */
+static size_t
+sprint_long(char *buf, long val)
+{
+    if (val < 0) {
+        *buf = '-';
+        return sprint_ulong(buf + 1, 0 - (u_long) val) + 1;
+    }
+    return sprint_ulong(buf, val);
 }
 
 
@@ -294,9 +345,10 @@ int
 _sprint_hexstring_line(u_char ** buf, size_t * buf_len, size_t * out_len,
                        int allow_realloc, const u_char * cp, size_t line_len)
 {
+    static const char hexdigits[] = "0123456789ABCDEF";
     const u_char   *tp;
     const u_char   *cp2 = cp;
-    size_t          lenleft = line_len;
+    u_char         *op;
 
     /*
      * Make sure there's enough room for the hex output....
@@ -310,17 +362,13 @@ _sprint_hexstring_line(u_char ** buf, size_t * buf_len, size_t * out_len,
     /*
      * .... and display the hex values themselves....
      */
-    for (; lenleft >= 8; lenleft-=8) {
-        sprintf((char *) (*buf + *out_len),
-                "%02X %02X %02X %02X %02X %02X %02X %02X ", cp[0], cp[1],
-                cp[2], cp[3], cp[4], cp[5], cp[6], cp[7]);
-        *out_len += strlen((char *) (*buf + *out_len));
-        cp       += 8;
-    }
-    for (; lenleft > 0; lenleft--) {
-        sprintf((char *) (*buf + *out_len), "%02X ", *cp++);
-        *out_len += strlen((char *) (*buf + *out_len));
+    for (op = *buf + *out_len; cp < cp2 + line_len; cp++) {
+        *op++ = hexdigits[*cp >> 4];
+        *op++ = hexdigits[*cp & 0x0f];
+        *op++ = ' ';
     }
+    *op = '\0';
+    *out_len += line_len * 3;
 
     /*
      * .... plus (optionally) do the same for the ASCII equivalent.
@@ -1184,7 +1232,7 @@ sprint_realloc_timeticks(u_char ** buf, size_t * buf_len, size_t * out_len,
 
     if (netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_NUMERIC_TIMETICKS)) {
         char            str[32];
-        sprintf(str, "%lu", *(u_long *) var->val.integer);
+        sprint_ulong(str, *(u_long *) var->val.integer);
         if (!snmp_strcat
             (buf, buf_len, out_len, allow_realloc, (const u_char *) str)) {
             return 0;
@@ -1374,7 +1422,7 @@ sprint_realloc_integer(u_char ** buf, size_t * buf_len, size_t * out_len,
             }
         } else {
             char            str[32];
-            sprintf(str, "%ld", *var->val.integer);
+            sprint_long(str, *var->val.integer);
             if (!snmp_strcat
                 (buf, buf_len, out_len, allow_realloc,
                  (const u_char *) str)) {
@@ -1471,7 +1519,7 @@ sprint_realloc_uinteger(u_char ** buf, size_t * buf_len, size_t * out_len,
             }
         } else {
             char            str[32];
-            sprintf(str, "%lu", *var->val.integer);
+            sprint_ulong(str, *var->val.integer);
             if (!snmp_strcat
                 (buf, buf_len, out_len, allow_realloc,
                  (const u_char *) str)) {
@@ -1564,7 +1612,7 @@ sprint_realloc_gauge(u_char ** buf, size_t * buf_len, size_t * out_len,
             return 0;
         }
     } else {
-        sprintf(tmp, "%u", (unsigned int)(*var->val.integer & 0xffffffff));
+        sprint_ulong(tmp, *var->val.integer & 0xffffffff);
         if (!snmp_strcat
             (buf, buf_len, out_len, allow_realloc, (const u_char *) tmp)) {
             return 0;
@@ -1628,7 +1676,7 @@ sprint_realloc_counter(u_char ** buf, size_t * buf_len, size_t * out_len,
             return 0;
         }
     }
-    sprintf(tmp, "%u", (unsigned int)(*var->val.integer & 0xffffffff));
+    sprint_ulong(tmp, *var->val.integer & 0xffffffff);
     if (!snmp_strcat
         (buf, buf_len, out_len, allow_realloc, (const u_char *) tmp)) {
         return 0;
@@ -2495,6 +2543,8 @@ register_mib_handlers(void)
                        NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_MIB_WARNINGS);
     netsnmp_ds_register_premib(ASN_BOOLEAN, "snmp", "mibReplaceWithLatest",
                        NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_MIB_REPLACE);
+    netsnmp_ds_register_premib(ASN_BOOLEAN, "snmp", "mibCache",
+                       NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_MIB_CACHE);
 #endif
 
     netsnmp_ds_register_premib(ASN_BOOLEAN, "snmp", "printNumericEnums",
@@ -2680,30 +2730,89 @@ netsnmp_fixup_mib_directory(void)
 
 }
 
-/**
- * Initialises the mib reader.
- *
- * Reads in all settings from the environment.
+/*
+ * Adds the entries of the ENV_SEPARATOR separated @list to @watch.
  */
-void
-netsnmp_init_mib(void)
+static void
+_mib_cache_watch(char *watch, const char *list, int paths_only)
 {
-    const char     *prefix;
-    char           *env_var, *entry;
-    PrefixListPtr   pp = &mib_prefixes[0];
-    char           *st = NULL;
+    char           *copy, *entry, *st = NULL;
 
-    if (Mib)
+    if (list == NULL || (copy = strdup(list)) == NULL)
         return;
-    netsnmp_init_mib_internals();
+    for (entry = strtok_r(copy, ENV_SEPARATOR, &st); entry;
+         entry = strtok_r(NULL, ENV_SEPARATOR, &st)) {
+        if (*entry == '+' || *entry == '-')
+            entry++;
+        if (!*entry || (paths_only && strchr(entry, '/') == NULL))
+            continue;
+        if (*watch)
+            strcat(watch, ENV_SEPARATOR);
+        strcat(watch, entry);
+    }
+    free(copy);
+}
+
+/*
+ * Describes the settings that decide which MIBs netsnmp_init_mib() loads,
+ * as the key of the compiled MIB cache.  @watch is set to the MIB
+ * directories and explicitly named MIB files the result depends on.
+ */
+static char    *
+_mib_cache_key(char **watch)
+{
+    const char     *mibs, *mibfiles, *default_mibfiles = "";
+    char           *key = NULL;
+
+    mibs = netsnmp_getenv("MIBS");
+    if (mibs == NULL)
+        mibs = confmibs ? confmibs : NETSNMP_DEFAULT_MIBS;
+    mibfiles = netsnmp_getenv("MIBFILES");
+#ifdef NETSNMP_DEFAULT_MIBFILES
+    default_mibfiles = NETSNMP_DEFAULT_MIBFILES;
+#endif
+
+    *watch = (char *) calloc(1, strlen(netsnmp_get_mib_directory()) +
+                             strlen(mibs) + strlen(default_mibfiles) +
+                             (mibfiles ? strlen(mibfiles) : 0) + 4);
+    if (*watch == NULL)
+        return NULL;
+    _mib_cache_watch(*watch, netsnmp_get_mib_directory(), 0);
+    _mib_cache_watch(*watch, mibs, 1);
+    _mib_cache_watch(*watch, mibfiles, 0);
+    _mib_cache_watch(*watch, default_mibfiles, 0);
+
+    if (asprintf(&key, "mibdirs=%s\nmibs=%s\ndefault=%s\nmibfiles=%s\n"
+                 "default_mibfiles=%s\noptions=%d%d%d%d",
+                 netsnmp_get_mib_directory(), mibs, NETSNMP_DEFAULT_MIBS,
+                 mibfiles ? mibfiles : "", default_mibfiles,
+                 netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID,
+                                        NETSNMP_DS_LIB_MIB_PARSE_LABEL),
+                 netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID,
+                                        NETSNMP_DS_LIB_MIB_COMMENT_TERM),
+                 netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID,
+                                        NETSNMP_DS_LIB_SAVE_MIB_DESCRS),
+                 netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID,
+                                        NETSNMP_DS_LIB_MIB_REPLACE)) < 0) {
+        SNMP_FREE(*watch);
+        return NULL;
+    }
+    return key;
+}
+
+/*
+ * Scans the MIB directories and reads the MIB modules and files named
+ * by the environment and configuration.
+ */
+static int
+_init_mib_read(void)
+{
+    char           *env_var, *entry;
+    char           *st = NULL;
 
-    /*
-     * Initialise the MIB directory/ies 
-     */
-    netsnmp_fixup_mib_directory();
     env_var = strdup(netsnmp_get_mib_directory());
     if (!env_var)
-        return;
+        return -1;
 
     DEBUGMSGTL(("init_mib",
                 "Seen MIBDIRS: Looking in '%s' for mib dirs ...\n",
@@ -2749,7 +2858,7 @@ netsnmp_init_mib(void)
         if (!entry) {
             DEBUGMSGTL(("init_mib", "env mibs malloc failed"));
             SNMP_FREE(env_var);
-            return;
+            return -1;
         } else {
             if (*env_var == '+')
                 sprintf(entry, "%s%c%s", NETSNMP_DEFAULT_MIBS, ENV_SEPARATOR_CHAR,
@@ -2821,6 +2930,51 @@ netsnmp_init_mib(void)
         }
         SNMP_FREE(env_var);
     }
+    return 0;
+}
+
+/**
+ * Initialises the mib reader.
+ *
+ * Reads in all settings from the environment.
+ */
+void
+netsnmp_init_mib(void)
+{
+    const char     *prefix;
+    char           *env_var;
+    char           *cache_key = NULL, *cache_watch = NULL;
+    PrefixListPtr   pp = &mib_prefixes[0];
+
+    if (Mib)
+        return;
+    netsnmp_init_mib_internals();
+
+    /*
+     * Initialise the MIB directory/ies 
+     */
+    netsnmp_fixup_mib_directory();
+
+    /*
+     * Use the compiled copy of the same MIBs if there is a current one,
+     * unless warnings were asked for, which only a text parse prints.
+     */
+    if (netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID,
+                               NETSNMP_DS_LIB_MIB_CACHE) &&
+        !netsnmp_ds_get_int(NETSNMP_DS_LIBRARY_ID,
+                            NETSNMP_DS_LIB_MIB_WARNINGS))
+        cache_key = _mib_cache_key(&cache_watch);
+    if (cache_key == NULL || netsnmp_mib_cache_load(cache_key) != 0) {
+        if (_init_mib_read() != 0) {
+            SNMP_FREE(cache_key);
+            SNMP_FREE(cache_watch);
+            return;
+        }
+        if (cache_key)
+            netsnmp_mib_cache_save(cache_key, cache_watch);
+    }
+    SNMP_FREE(cache_key);
+    SNMP_FREE(cache_watch);
 
     prefix = netsnmp_getenv("PREFIX");
 
@@ -2880,6 +3034,13 @@ init_mib(void)
 void
 shutdown_mib(void)
 {
+#ifndef NETSNMP_FEATURE_REMOVE_STATISTICS
+    DEBUGMSGTL(("mib:cache", "oid %u hits %u misses, name %u hits %u misses\n",
+                snmp_get_statistic(STAT_MIB_OIDCACHE_HITS),
+                snmp_get_statistic(STAT_MIB_OIDCACHE_MISSES),
+                snmp_get_statistic(STAT_MIB_NAMECACHE_HITS),
+                snmp_get_statistic(STAT_MIB_NAMECACHE_MISSES)));
+#endif /* NETSNMP_FEATURE_REMOVE_STATISTICS */
     unload_all_mibs();
     if (tree_top) {
         if (tree_top->label)
@@ -3150,6 +3311,152 @@ netsnmp_sprint_realloc_objid_tree(u_char ** buf, size_t * buf_len,
                                  buf_overflow, objid, objidlen);
 }
 #else
+/*
+ * OIDs tend to be printed in runs which share everything up to the
+ * index: a walk prints every instance of a column, snmptable and trap
+ * logging print the same few columns for each row.  So the text for the
+ * part of an OID up to a MIB leaf is remembered, per output format, and
+ * the next instance of the same leaf only needs its index printed.  When
+ * the cache is full the least recently used leaf makes way.
+ */
+#define OID_PRINT_CACHE_SIZE    16
+#define OID_PRINT_CACHE_OIDS    32
+#define OID_PRINT_CACHE_TEXT    256
+
+struct oid_print_cache {
+    oid                 name[OID_PRINT_CACHE_OIDS];
+    size_t              name_len;       /* 0: unused */
+    int                 output_format;
+    u_int               used;           /* oid_print_cache_clock when last used */
+    struct tree        *tp;             /* the leaf at name */
+    struct index_list  *in_dices;       /* INDEX clause in effect below it */
+    char                text[OID_PRINT_CACHE_TEXT];
+};
+
+static struct oid_print_cache oid_print_cache[OID_PRINT_CACHE_SIZE];
+static u_int    oid_print_cache_generation;
+static u_int    oid_print_cache_clock;
+
+/**
+ * @internal
+ * Finds the cached leaf above an OID.  The caller must hold the
+ * MT_LIB_MIBPRINT lock for as long as it uses the entry.
+ *
+ * @param output_format the format the text is needed in, or -1 when
+ *                      only the tree node is of interest (entries stored
+ *                      with -1 carry no text)
+ */
+static struct oid_print_cache *
+_oid_print_cache_find(const oid * objid, size_t objidlen, int output_format)
+{
+    struct oid_print_cache *cache;
+    int             i;
+    size_t          j;
+
+    if (oid_print_cache_generation != netsnmp_mib_tree_generation()) {
+        /*
+         * the tree changed, so the node pointers may be stale
+         */
+        for (i = 0; i < OID_PRINT_CACHE_SIZE; i++)
+            oid_print_cache[i].name_len = 0;
+        oid_print_cache_generation = netsnmp_mib_tree_generation();
+        return NULL;
+    }
+
+    for (i = 0; i < OID_PRINT_CACHE_SIZE; i++) {
+        cache = &oid_print_cache[i];
+        if (cache->name_len == 0 || cache->name_len >= objidlen ||
+            (output_format >= 0 && cache->output_format != output_format))
+            continue;
+        /*
+         * compare from the end, where columns of the same table differ
+         */
+        for (j = cache->name_len; j > 0; j--)
+            if (cache->name[j - 1] != objid[j - 1])
+                break;
+        if (j == 0) {
+            cache->used = ++oid_print_cache_clock;
+            return cache;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @internal
+ * Remembers the text printed for the part of an OID up to the leaf tp.
+ * The text is the concatenation of mod (plus "::") and text_len bytes of
+ * text.
+ */
+static void
+_oid_print_cache_store(const oid * objid, size_t objidlen, int output_format,
+                       struct tree *tp, const char *mod,
+                       const u_char * text, size_t text_len)
+{
+    struct oid_print_cache *cache;
+    struct index_list *in_dices = NULL;
+    struct tree    *tp2, *tp3;
+    size_t          len = 0, mod_len = 0, i;
+    int             have_index = 0, j;
+
+    for (tp2 = tp; tp2; tp2 = tp2->parent)
+        len++;
+    if (len >= objidlen || len > OID_PRINT_CACHE_OIDS)
+        return;
+    if (mod)
+        mod_len = strlen(mod) + 2;
+    if (mod_len + text_len >= OID_PRINT_CACHE_TEXT)
+        return;
+
+    /*
+     * _get_realloc_symbol() uses the INDEX clause of the deepest node on
+     * the path which has one (or AUGMENTS another one)
+     */
+    for (tp2 = tp, i = len; tp2; tp2 = tp2->parent) {
+        if (tp2->subid != objid[--i])
+            return;
+        if (have_index)
+            continue;
+        if (tp2->indexes) {
+            in_dices = tp2->indexes;
+            have_index = 1;
+        } else if (tp2->augments) {
+            tp3 = find_tree_node(tp2->augments, -1);
+            if (tp3) {
+                in_dices = tp3->indexes;
+                have_index = 1;
+            }
+        }
+    }
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_MIBPRINT);
+    if (oid_print_cache_generation == netsnmp_mib_tree_generation()) {
+        cache = &oid_print_cache[0];
+        for (j = 1; j < OID_PRINT_CACHE_SIZE && cache->name_len; j++)
+            if (oid_print_cache[j].name_len == 0 ||
+                oid_print_cache[j].used < cache->used)
+                cache = &oid_print_cache[j];
+        memcpy(cache->name, objid, len * sizeof(oid));
+        cache->name_len = len;
+        cache->output_format = output_format;
+        cache->used = ++oid_print_cache_clock;
+        cache->tp = tp;
+        cache->in_dices = in_dices;
+        if (mod) {
+            memcpy(cache->text, mod, mod_len - 2);
+            memcpy(cache->text + mod_len - 2, "::", 2);
+        }
+        memcpy(cache->text + mod_len, text, text_len);
+        cache->text[mod_len + text_len] = '\0';
+        /*
+         * an extended index has replaced the '.' ending the known part
+         */
+        if (text_len)
+            cache->text[mod_len + text_len - 1] = '.';
+    }
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_MIBPRINT);
+}
+
 struct tree    *
 netsnmp_sprint_realloc_objid_tree(u_char ** buf, size_t * buf_len,
                                   size_t * out_len, int allow_realloc,
@@ -3162,6 +3469,50 @@ netsnmp_sprint_realloc_objid_tree(u_char ** buf, size_t * buf_len,
     size_t          midpoint_offset = 0;
     int             tbuf_overflow = 0;
     int             output_format;
+    struct oid_print_cache *cache;
+    struct index_list *in_dices = NULL;
+    u_char          text[OID_PRINT_CACHE_TEXT + 256], *tp = text;
+    size_t          text_len = sizeof(text), text_out = 0;
+    char            modbuf[256] = { 0 };
+    const char     *mod = NULL;
+    size_t          name_len = 0;
+
+    output_format = netsnmp_ds_get_int(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_OID_OUTPUT_FORMAT);
+    if (0 == output_format) {
+        output_format = NETSNMP_OID_OUTPUT_MODULE;
+    }
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_MIBPRINT);
+    cache = _oid_print_cache_find(objid, objidlen, output_format);
+    snmp_increment_statistic(cache ? STAT_MIB_OIDCACHE_HITS :
+                             STAT_MIB_OIDCACHE_MISSES);
+    if (cache) {
+        strcpy((char *) text, cache->text);
+        text_out = strlen(cache->text);
+        name_len = cache->name_len;
+        subtree = cache->tp;
+        in_dices = cache->in_dices;
+    }
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_MIBPRINT);
+
+    if (cache) {
+        /*
+         * print the index behind the cached text, on the stack; a long
+         * index takes the slow path below
+         */
+        _get_realloc_index(objid + name_len, objidlen - name_len, NULL,
+                           &tp, &text_len, &text_out, 0,
+                           &tbuf_overflow, in_dices);
+        if (!tbuf_overflow) {
+            if (!*buf_overflow &&
+                !snmp_strcat(buf, buf_len, out_len, allow_realloc, text)) {
+                *buf_overflow = 1;
+            }
+            return subtree;
+        }
+        tbuf_overflow = 0;
+        subtree = tree_head;
+    }
 
     if ((tbuf = (u_char *) calloc(tbuf_len, 1)) == NULL) {
         tbuf_overflow = 1;
@@ -3184,10 +3535,6 @@ netsnmp_sprint_realloc_objid_tree(u_char ** buf, size_t * buf_len,
         return subtree;
     }
 
-    output_format = netsnmp_ds_get_int(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_OID_OUTPUT_FORMAT);
-    if (0 == output_format) {
-        output_format = NETSNMP_OID_OUTPUT_MODULE;
-    }
     switch (output_format) {
     case NETSNMP_OID_OUTPUT_FULL:
     case NETSNMP_OID_OUTPUT_NUMERIC:
@@ -3220,8 +3567,7 @@ netsnmp_sprint_realloc_objid_tree(u_char ** buf, size_t * buf_len,
 
         if ((NETSNMP_OID_OUTPUT_MODULE == output_format)
             && cp > tbuf) {
-            char            modbuf[256] = { 0 }, *mod =
-                module_name(subtree->modid, modbuf);
+            mod = module_name(subtree->modid, modbuf);
 
             /*
              * Don't add the module ID if it's just numeric (i.e. we couldn't look
@@ -3271,6 +3617,17 @@ netsnmp_sprint_realloc_objid_tree(u_char ** buf, size_t * buf_len,
         !snmp_strcat(buf, buf_len, out_len, allow_realloc, cp)) {
         *buf_overflow = 1;
     }
+
+    /*
+     * remember what was printed up to a leaf, if the rest was an index
+     */
+    if (!*buf_overflow && midpoint_offset && subtree && !subtree->child_list &&
+        NETSNMP_OID_OUTPUT_UCD != output_format && cp &&
+        cp <= tbuf + midpoint_offset) {
+        _oid_print_cache_store(objid, objidlen, output_format, subtree,
+                               (mod && *mod != '#') ? mod : NULL,
+                               cp, tbuf + midpoint_offset - cp);
+    }
     SNMP_FREE(tbuf);
     return subtree;
 }
@@ -3327,10 +3684,25 @@ print_objid(const oid * objid, size_t objidlen)
 void
 fprint_objid(FILE * f, const oid * objid, size_t objidlen)
 {                               /* number of subidentifiers */
-    u_char         *buf = NULL;
-    size_t          buf_len = 256, out_len = 0;
+    u_char          sbuf[SPRINT_MAX_LEN];
+    u_char         *buf = sbuf;
+    size_t          buf_len = sizeof(sbuf), out_len = 0;
     int             buf_overflow = 0;
 
+    /*
+     * try the stack first, most names fit
+     */
+    netsnmp_sprint_realloc_objid_tree(&buf, &buf_len, &out_len, 0,
+                                      &buf_overflow, objid, objidlen);
+    if (!buf_overflow) {
+        fprintf(f, "%s\n", buf);
+        return;
+    }
+    buf = NULL;
+    buf_len = 256;
+    out_len = 0;
+    buf_overflow = 0;
+
     if ((buf = (u_char *) calloc(buf_len, 1)) == NULL) {
         fprintf(f, "[TRUNCATED]\n");
         return;
@@ -3485,8 +3857,21 @@ fprint_variable(FILE * f,
                 const oid * objid,
                 size_t objidlen, const netsnmp_variable_list * variable)
 {
-    u_char         *buf = NULL;
-    size_t          buf_len = 256, out_len = 0;
+    u_char          sbuf[SPRINT_MAX_LEN];
+    u_char         *buf = sbuf;
+    size_t          buf_len = sizeof(sbuf), out_len = 0;
+
+    /*
+     * try the stack first, and only allocate for the odd long value
+     */
+    if (sprint_realloc_variable(&buf, &buf_len, &out_len, 0,
+                                objid, objidlen, variable)) {
+        fprintf(f, "%s\n", buf);
+        return;
+    }
+    buf = NULL;
+    buf_len = 256;
+    out_len = 0;
 
     if ((buf = (u_char *) calloc(buf_len, 1)) == NULL) {
         fprintf(f, "[TRUNCATED]\n");
@@ -3524,8 +3909,21 @@ sprint_realloc_value(u_char ** buf, size_t * buf_len,
     } else {
 #ifndef NETSNMP_DISABLE_MIB_LOADING
         const char *units = NULL;
-        struct tree *subtree = tree_head;
-	subtree = get_tree(objid, objidlen, subtree);
+        struct tree *subtree;
+        struct oid_print_cache *cache;
+
+        snmp_res_lock(MT_LIBRARY_ID, MT_LIB_MIBPRINT);
+        cache = _oid_print_cache_find(objid, objidlen, -1);
+        subtree = cache ? cache->tp : NULL;
+        snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_MIBPRINT);
+        snmp_increment_statistic(subtree ? STAT_MIB_OIDCACHE_HITS :
+                                 STAT_MIB_OIDCACHE_MISSES);
+        if (!subtree) {
+            subtree = get_tree(objid, objidlen, tree_head);
+            if (subtree && !subtree->child_list)
+                _oid_print_cache_store(objid, objidlen, -1, subtree, NULL,
+                                       (const u_char *) "", 0);
+        }
         if (subtree && !netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID,
                                             NETSNMP_DS_LIB_DONT_PRINT_UNITS)) {
             units = subtree->units;
@@ -3580,8 +3978,21 @@ fprint_value(FILE * f,
              const oid * objid,
              size_t objidlen, const netsnmp_variable_list * variable)
 {
-    u_char         *buf = NULL;
-    size_t          buf_len = 256, out_len = 0;
+    u_char          sbuf[SPRINT_MAX_LEN];
+    u_char         *buf = sbuf;
+    size_t          buf_len = sizeof(sbuf), out_len = 0;
+
+    /*
+     * try the stack first, and only allocate for the odd long value
+     */
+    if (sprint_realloc_value(&buf, &buf_len, &out_len, 0,
+                             objid, objidlen, variable)) {
+        fprintf(f, "%s\n", buf);
+        return;
+    }
+    buf = NULL;
+    buf_len = 256;
+    out_len = 0;
 
     if ((buf = (u_char *) calloc(buf_len, 1)) == NULL) {
         fprintf(f, "[TRUNCATED]\n");
@@ -4154,6 +4565,7 @@ _oid_finish_printing(const oid * objid, size_t objidlen,
                      u_char ** buf, size_t * buf_len, size_t * out_len,
                      int allow_realloc, int *buf_overflow) {
     char            intbuf[64];
+    size_t          len;
     if (*buf != NULL && *(*buf + *out_len - 1) != '.') {
         if (!*buf_overflow && !snmp_strcat(buf, buf_len, out_len,
                                            allow_realloc,
@@ -4163,7 +4575,9 @@ _oid_finish_printing(const oid * objid, size_t objidlen,
     }
 
     while (objidlen-- > 0) {    /* output rest of name, uninterpreted */
-        sprintf(intbuf, "%" NETSNMP_PRIo "u.", *objid++);
+        len = sprint_ulong(intbuf, *objid++);
+        intbuf[len] = '.';
+        intbuf[len + 1] = '\0';
         if (!*buf_overflow && !snmp_strcat(buf, buf_len, out_len,
                                            allow_realloc,
                                            (const u_char *) intbuf)) {
@@ -4211,8 +4625,6 @@ _get_realloc_symbol(const oid * objid, size_t objidlen,
                     struct index_list *in_dices, size_t * end_of_known)
 {
     struct tree    *return_tree = NULL;
-    int             extended_index =
-        netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_EXTENDED_INDEX);
     int             output_format =
         netsnmp_ds_get_int(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_OID_OUTPUT_FORMAT);
     char            intbuf[64];
@@ -4238,7 +4650,7 @@ _get_realloc_symbol(const oid * objid, size_t objidlen,
 
             if (!strncmp(subtree->label, ANON, ANON_LEN) ||
                 (NETSNMP_OID_OUTPUT_NUMERIC == output_format)) {
-                sprintf(intbuf, "%lu", subtree->subid);
+                sprint_ulong(intbuf, subtree->subid);
                 if (!*buf_overflow && !snmp_strcat(buf, buf_len, out_len,
                                                    allow_realloc,
                                                    (const u_char *)
@@ -4284,8 +4696,33 @@ _get_realloc_symbol(const oid * objid, size_t objidlen,
     /*
      * Subtree not found.  
      */
+    _get_realloc_index(objid, objidlen, orgtree, buf, buf_len, out_len,
+                       allow_realloc, buf_overflow, in_dices);
+    return NULL;
+}
 
-    if (orgtree && in_dices && objidlen > 0) {
+/**
+ * @internal
+ * Prints the part of an OID beyond the known tree, broken down
+ * according to the INDEX clause in effect there.
+ *
+ * @param subtree  the peer list where the lookup stopped, NULL below a leaf
+ * @param in_dices the INDEX clause of the nearest table entry, may be NULL
+ */
+static void
+_get_realloc_index(const oid * objid, size_t objidlen,
+                   struct tree *subtree,
+                   u_char ** buf, size_t * buf_len, size_t * out_len,
+                   int allow_realloc, int *buf_overflow,
+                   struct index_list *in_dices)
+{
+    int             extended_index =
+        netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_EXTENDED_INDEX);
+    int             output_format =
+        netsnmp_ds_get_int(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_OID_OUTPUT_FORMAT);
+    char            intbuf[64];
+
+    if (subtree && in_dices && objidlen > 0) {
 	sprintf(intbuf, "%" NETSNMP_PRIo "u.", *objid);
 	if (!*buf_overflow
 	    && !snmp_strcat(buf, buf_len, out_len,
@@ -4473,7 +4910,7 @@ _get_realloc_symbol(const oid * objid, size_t objidlen,
                         *buf_overflow = 1;
                     }
                 } else {
-                    sprintf(intbuf, "%" NETSNMP_PRIo "u", *objid);
+                    sprint_ulong(intbuf, *objid);
                     if (!*buf_overflow
                         && !snmp_strcat(buf, buf_len, out_len,
                                         allow_realloc,
@@ -4482,7 +4919,7 @@ _get_realloc_symbol(const oid * objid, size_t objidlen,
                     }
                 }
             } else {
-                sprintf(intbuf, "%" NETSNMP_PRIo "u", *objid);
+                sprint_ulong(intbuf, *objid);
                 if (!*buf_overflow && !snmp_strcat(buf, buf_len, out_len,
                                                    allow_realloc,
                                                    (const u_char *)
@@ -4499,7 +4936,7 @@ _get_realloc_symbol(const oid * objid, size_t objidlen,
             if (extended_index) {
                 uptimeString( *objid, intbuf, sizeof( intbuf ) );
             } else {
-                sprintf(intbuf, "%" NETSNMP_PRIo "u", *objid);
+                sprint_ulong(intbuf, *objid);
             }   
             if (!*buf_overflow && !snmp_strcat(buf, buf_len, out_len,
                                                allow_realloc,
@@ -4622,7 +5059,6 @@ _get_realloc_symbol(const oid * objid, size_t objidlen,
     _oid_finish_printing(objid, objidlen,
                          buf, buf_len, out_len,
                          allow_realloc, buf_overflow);
-    return NULL;
 }
 
 struct tree    *
@@ -5170,6 +5606,128 @@ print_tree_node(u_char ** buf, size_t * buf_len,
     return 1;
 }
 
+/*
+ * Names are parsed in runs just like OIDs are printed: a set command or
+ * a script names the same few columns with a different index each time.
+ * So the node found for a module and the first component of a name is
+ * remembered, along with its OID, and a repeat skips the module and
+ * label lookups.  When the cache is full the least recently used name
+ * makes way.
+ */
+#define NAME_CACHE_SIZE         16
+#define NAME_CACHE_KEY          128
+#define NAME_CACHE_OIDS         32
+
+struct name_cache {
+    char                key[NAME_CACHE_KEY];    /* module, NUL, label */
+    size_t              key_len;                /* 0: unused */
+    u_int               used;   /* name_cache_clock when last used */
+    struct tree        *tp;
+    oid                 name[NAME_CACHE_OIDS];
+    size_t              name_len;
+};
+
+static struct name_cache name_cache[NAME_CACHE_SIZE];
+static u_int    name_cache_generation;
+static u_int    name_cache_clock;
+
+/**
+ * @internal
+ * Builds the name cache key for a module and the first component of a
+ * name, which ends at the first '.'.
+ *
+ * @return the length of the key, or 0 if it is too long to be cached.
+ */
+static size_t
+_name_cache_key(char *key, const char *module, const char *fname)
+{
+    size_t          mod_len, label_len;
+    const char     *cp;
+
+    mod_len = strlen(module);
+    cp = strchr(fname, '.');
+    label_len = cp ? (size_t) (cp - fname) : strlen(fname);
+    if (mod_len + label_len + 2 > NAME_CACHE_KEY)
+        return 0;
+    memcpy(key, module, mod_len + 1);
+    memcpy(key + mod_len + 1, fname, label_len);
+    key[mod_len + 1 + label_len] = '\0';
+    return mod_len + label_len + 2;
+}
+
+/**
+ * @internal
+ * Looks up a name cache key and copies the OID of its node to objid.
+ *
+ * @return the node, or NULL if the key is not cached or its OID does not
+ *         fit in *objidlen.
+ */
+static struct tree *
+_name_cache_find(const char *key, size_t key_len,
+                 oid * objid, size_t * objidlen)
+{
+    struct name_cache *cache;
+    struct tree    *tp = NULL;
+    int             i;
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_MIBPRINT);
+    if (name_cache_generation != netsnmp_mib_tree_generation()) {
+        for (i = 0; i < NAME_CACHE_SIZE; i++)
+            name_cache[i].key_len = 0;
+        name_cache_generation = netsnmp_mib_tree_generation();
+    } else {
+        for (i = 0; i < NAME_CACHE_SIZE; i++) {
+            cache = &name_cache[i];
+            if (cache->key_len != key_len ||
+                memcmp(cache->key, key, key_len) != 0)
+                continue;
+            if (cache->name_len <= *objidlen) {
+                cache->used = ++name_cache_clock;
+                memcpy(objid, cache->name, cache->name_len * sizeof(oid));
+                *objidlen = cache->name_len;
+                tp = cache->tp;
+            }
+            break;
+        }
+    }
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_MIBPRINT);
+
+    snmp_increment_statistic(tp ? STAT_MIB_NAMECACHE_HITS :
+                             STAT_MIB_NAMECACHE_MISSES);
+    return tp;
+}
+
+/**
+ * @internal
+ * Remembers the node and OID found for a name cache key.
+ */
+static void
+_name_cache_store(const char *key, size_t key_len, struct tree *tp,
+                  const oid * objid, size_t objidlen)
+{
+    struct name_cache *cache;
+    int             i;
+
+    if (key_len == 0 || objidlen > NAME_CACHE_OIDS)
+        return;
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_MIBPRINT);
+    if (name_cache_generation == netsnmp_mib_tree_generation()) {
+        cache = &name_cache[0];
+        for (i = 1; i < NAME_CACHE_SIZE && cache->key_len; i++)
+            if (name_cache[i].key_len == 0 ||
+                name_cache[i].used < cache->used)
+                cache = &name_cache[i];
+        memcpy(cache->key, key, key_len);
+        cache->key_len = key_len;
+        cache->used = ++name_cache_clock;
+        cache->tp = tp;
+        memcpy(cache->name, objid, objidlen * sizeof(oid));
+        cache->name_len = objidlen;
+    }
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_MIBPRINT);
+}
+
 int
 get_module_node(const char *fname,
                 const char *module, oid * objid, size_t * objidlen)
@@ -5177,6 +5735,26 @@ get_module_node(const char *fname,
     int             modid, rc = 0;
     struct tree    *tp;
     char           *name, *cp;
+    char            key[NAME_CACHE_KEY];
+    size_t          key_len, maxlen = *objidlen;
+
+    key_len = _name_cache_key(key, module, fname);
+    if (key_len &&
+        (tp = _name_cache_find(key, key_len, objid, objidlen)) != NULL) {
+        /*
+         * the module, if any, was read when the entry was made, and the
+         * tree has not changed since
+         */
+        cp = strchr(fname, '.');
+        if (cp == NULL)
+            return 1;
+        name = strdup(cp + 1);
+        if (name == NULL)
+            return 0;
+        rc = _add_strings_to_oid(tp, name, objid, objidlen, maxlen);
+        SNMP_FREE(name);
+        return rc;
+    }
 
     if (!strcmp(module, "ANY"))
         modid = -1;
@@ -5201,13 +5779,12 @@ get_module_node(const char *fname,
      */
     tp = find_tree_node(name, modid);
     if (tp) {
-        size_t          maxlen = *objidlen;
-
         /*
          * Set the first element of the object ID 
          */
         if (node_to_oid(tp, objid, objidlen)) {
             rc = 1;
+            _name_cache_store(key, key_len, tp, objid, *objidlen);
 
             /*
              * If the name requested was more than one element,
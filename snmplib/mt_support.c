@@ -11,6 +11,13 @@
 
 #include <net-snmp/net-snmp-config.h>
 #include <errno.h>
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#include <net-snmp/output_api.h>
 #include <net-snmp/library/mt_support.h>
 
 #ifdef __cplusplus
@@ -131,6 +138,136 @@ snmp_res_unlock(int groupID, int resourceID)
     return rc;
 }
 
+#if HAVE_PTHREAD_H
+/**
+ * Creates the wakeup pipe of a completion queue.  Both ends are
+ * non-blocking: workers never wait for the main thread, which empties
+ * the pipe in netsnmp_done_queue_ack().
+ *
+ * @return 1 on success, 0 on failure (which has been logged).
+ */
+int
+netsnmp_done_queue_open(netsnmp_done_queue *q)
+{
+    int             i, flags;
+
+    if (q->fd[0] >= 0)
+        return 1;
+    if (pipe(q->fd) < 0) {
+        snmp_log_perror("done queue: pipe");
+        q->fd[0] = q->fd[1] = -1;
+        return 0;
+    }
+    for (i = 0; i < 2; i++) {
+        flags = fcntl(q->fd[i], F_GETFL, 0);
+        fcntl(q->fd[i], F_SETFL, flags | O_NONBLOCK);
+    }
+    return 1;
+}
+
+/**
+ * Closes the wakeup pipe.  Items still queued are left to the caller.
+ */
+void
+netsnmp_done_queue_close(netsnmp_done_queue *q)
+{
+    if (q->fd[0] < 0)
+        return;
+    close(q->fd[0]);
+    close(q->fd[1]);
+    q->fd[0] = q->fd[1] = -1;
+}
+
+/**
+ * worker thread: queues a finished item and wakes the main thread up.
+ */
+void
+netsnmp_done_queue_push(netsnmp_done_queue *q, netsnmp_done_item *item)
+{
+    char            c = 0;
+
+    item->next = NULL;
+    pthread_mutex_lock(&q->lock);
+    if (q->tail)
+        q->tail->next = item;
+    else
+        q->head = item;
+    q->tail = item;
+    pthread_mutex_unlock(&q->lock);
+
+    /*
+     * a full pipe already guarantees a wakeup, so EAGAIN is fine
+     */
+    while (write(q->fd[1], &c, 1) < 0 && EINTR == errno)
+        ;
+}
+
+/**
+ * main thread: empties the wakeup pipe.  Call it before popping the
+ * items, so that an item pushed meanwhile leaves a fresh wakeup behind.
+ */
+void
+netsnmp_done_queue_ack(netsnmp_done_queue *q)
+{
+    char            buf[64];
+
+    if (q->fd[0] >= 0)
+        while (read(q->fd[0], buf, sizeof(buf)) > 0)
+            ;
+}
+
+/**
+ * main thread: takes the oldest finished item off the queue.
+ *
+ * @return the item, or NULL if the queue is empty.
+ */
+netsnmp_done_item *
+netsnmp_done_queue_pop(netsnmp_done_queue *q)
+{
+    netsnmp_done_item *item;
+
+    pthread_mutex_lock(&q->lock);
+    item = q->head;
+    if (item) {
+        q->head = item->next;
+        if (NULL == q->head)
+            q->tail = NULL;
+        item->next = NULL;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return item;
+}
+
+/**
+ * Removes the queued items for which match() returns non-zero, passing
+ * each of them to release() unless that is NULL.
+ */
+void
+netsnmp_done_queue_purge(netsnmp_done_queue *q,
+                         int (*match)(netsnmp_done_item *, void *),
+                         void *arg, void (*release)(netsnmp_done_item *))
+{
+    netsnmp_done_item *item, *prev = NULL;
+
+    pthread_mutex_lock(&q->lock);
+    while ((item = (prev ? prev->next : q->head)) != NULL) {
+        if (!match(item, arg)) {
+            prev = item;
+            continue;
+        }
+        if (prev)
+            prev->next = item->next;
+        else
+            q->head = item->next;
+        if (q->tail == item)
+            q->tail = prev;
+        if (release)
+            release(item);
+    }
+    pthread_mutex_unlock(&q->lock);
+}
+#endif /*  HAVE_PTHREAD_H  */
+
 #else  /*  NETSNMP_REENTRANT  */
 #ifdef WIN32
 
@@ -77,10 +77,17 @@ SOFTWARE.
 #if HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#if HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#endif
 
 #include <errno.h>
 
 #include <net-snmp/types.h>
+#include <net-snmp/version.h>
 #include <net-snmp/output_api.h>
 #include <net-snmp/config_api.h>
 #include <net-snmp/utilities.h>
@@ -537,6 +544,11 @@ static struct module *module_head = NULL;
 static struct node *orphan_nodes = NULL;
 NETSNMP_IMPORT struct tree *tree_head;
 struct tree        *tree_head = NULL;
+/*
+ * bumped whenever nodes are linked into or out of the tree, so that
+ * callers holding on to tree pointers know when to drop them
+ */
+static u_int    tree_generation = 0;
 
 #define	NUMBER_OF_ROOT_NODES	3
 static struct module_import root_imports[NUMBER_OF_ROOT_NODES];
@@ -844,6 +856,7 @@ unlink_tree(struct tree *tp)
 {
     struct tree    *otp = NULL, *ntp = tp->parent;
 
+    tree_generation++;
     if (!ntp) {                 /* this tree has no parent */
         DEBUGMSGTL(("unlink_tree", "Tree node %s has no parent\n",
                     tp->label));
@@ -873,6 +886,8 @@ free_partial_tree(struct tree *tp, int keep_label)
     if (!tp)
         return;
 
+    tree_generation++;
+
     /*
      * remove the data from this tree node 
      */
@@ -1488,6 +1503,8 @@ do_subtree(struct tree *root, struct node **nodes)
     int             hash;
     int            *int_p;
 
+    tree_generation++;
+
     while (xroot->next_peer && xroot->next_peer->subid == root->subid) {
 #if 0
         printf("xroot: %s.%s => %s\n", xroot->parent->label, xroot->label,
@@ -3768,6 +3785,16 @@ module_name(int modid, char *cp)
     return (cp);
 }
 
+/*
+ * netsnmp_mib_tree_generation - a number which changes whenever nodes
+ * are added to or removed from the tree
+ */
+u_int
+netsnmp_mib_tree_generation(void)
+{
+    return tree_generation;
+}
+
 /*
  *  Backwards compatability
  *  Read newer modules that replace the one specified:-
@@ -5681,4 +5708,966 @@ tree_from_node(struct tree *tp, struct node *np)
     set_function(tp);
 }
 
+
+/*
+ * Compiled MIB cache.
+ *
+ * Tokenizing the MIB files is by far the most expensive part of starting
+ * most applications.  With "mibCache" set, the module list, textual
+ * conventions and tree built by a clean parse are written to a binary
+ * snapshot under the persistent directory, and later processes using the
+ * same MIB settings map that snapshot and rebuild the tree from it instead
+ * of scanning and parsing the MIB directories.  The snapshot records the
+ * modification time and size of every MIB directory and module file it
+ * was built from, and is ignored as soon as any of them changes.
+ */
+#define MIB_CACHE_MAGIC         0x434d534eU     /* "NSMC" */
+#define MIB_CACHE_VERSION       1
+#define MIB_CACHE_ORDER         0x01020304U
+#define MIB_CACHE_NULL          0xffffffffU
+#define MIB_CACHE_STAMP_LEN     5
+
+static int      mib_cache_errors = 0;
+
+struct mib_cache_out {
+    u_char         *buf;
+    size_t          buf_len;
+    size_t          out_len;
+    struct tree   **nodes;
+    u_int           nodes_len;
+    int             failed;
+    int             racy;
+};
+
+struct mib_cache_in {
+    const u_char   *cp;
+    const u_char   *end;
+    int             failed;
+};
+
+struct mib_cache_ref {
+    struct tree    *tp;
+    u_int           idx;
+};
+
+static char    *
+mib_cache_file(const char *key)
+{
+    char           *file = NULL;
+
+    if (asprintf(&file, "%s/mib_cache/%08x.cache",
+                 get_persistent_directory(),
+                 netsnmp_hash_buf(key, strlen(key), NETSNMP_HASH_INIT)) < 0)
+        return NULL;
+    return file;
+}
+
+/*
+ * Fills @stamp with the existence, modification time and size of @path,
+ * and returns the modification time.
+ */
+static time_t
+mib_cache_stamp(const char *path, u_int *stamp)
+{
+    struct stat     sb;
+
+    memset(stamp, 0, MIB_CACHE_STAMP_LEN * sizeof(u_int));
+    if (stat(path, &sb) != 0)
+        return 0;
+    stamp[0] = 1;
+    stamp[1] = (u_int) sb.st_mtime;
+    stamp[2] = (u_int) (sb.st_mtime / 65536 / 65536);
+    stamp[3] = (u_int) sb.st_size;
+    stamp[4] = (u_int) (sb.st_size / 65536 / 65536);
+    return sb.st_mtime;
+}
+
+static void
+mib_cache_put(struct mib_cache_out *out, const void *data, size_t len)
+{
+    u_char         *new_buf;
+    size_t          new_len;
+
+    if (out->failed)
+        return;
+    if (out->out_len + len > out->buf_len) {
+        new_len = out->buf_len ? out->buf_len : 65536;
+        while (new_len < out->out_len + len)
+            new_len *= 2;
+        new_buf = (u_char *) realloc(out->buf, new_len);
+        if (new_buf == NULL) {
+            out->failed = 1;
+            return;
+        }
+        out->buf = new_buf;
+        out->buf_len = new_len;
+    }
+    memcpy(out->buf + out->out_len, data, len);
+    out->out_len += len;
+}
+
+static void
+mib_cache_put_int(struct mib_cache_out *out, u_int val)
+{
+    mib_cache_put(out, &val, sizeof(val));
+}
+
+static void
+mib_cache_put_str(struct mib_cache_out *out, const char *str)
+{
+    size_t          len;
+
+    if (str == NULL) {
+        mib_cache_put_int(out, MIB_CACHE_NULL);
+        return;
+    }
+    len = strlen(str);
+    mib_cache_put_int(out, len);
+    mib_cache_put(out, str, len);
+}
+
+static void
+mib_cache_put_dep(struct mib_cache_out *out, const char *path)
+{
+    u_int           stamp[MIB_CACHE_STAMP_LEN];
+
+    /*
+     * A change within the same second would go unnoticed, so don't trust
+     * anything modified that recently.
+     */
+    if (mib_cache_stamp(path, stamp) >= time(NULL) - 1)
+        out->racy = 1;
+    mib_cache_put_str(out, path);
+    mib_cache_put(out, stamp, sizeof(stamp));
+}
+
+static void
+mib_cache_put_enums(struct mib_cache_out *out, const struct enum_list *ep)
+{
+    const struct enum_list *e;
+    u_int           count = 0;
+
+    for (e = ep; e; e = e->next)
+        count++;
+    mib_cache_put_int(out, count);
+    for (e = ep; e; e = e->next) {
+        mib_cache_put_int(out, e->value);
+        mib_cache_put_str(out, e->label);
+    }
+}
+
+static void
+mib_cache_put_ranges(struct mib_cache_out *out, const struct range_list *rp)
+{
+    const struct range_list *r;
+    u_int           count = 0;
+
+    for (r = rp; r; r = r->next)
+        count++;
+    mib_cache_put_int(out, count);
+    for (r = rp; r; r = r->next) {
+        mib_cache_put_int(out, r->low);
+        mib_cache_put_int(out, r->high);
+    }
+}
+
+static void
+mib_cache_put_peers(struct mib_cache_out *out, struct tree *first)
+{
+    struct tree    *tp, **new_nodes;
+    struct index_list *ip;
+    struct varbind_list *vp;
+    u_int           count;
+    int             i;
+
+    for (count = 0, tp = first; tp; tp = tp->next_peer)
+        count++;
+    mib_cache_put_int(out, count);
+
+    for (tp = first; tp && !out->failed; tp = tp->next_peer) {
+        if ((out->nodes_len & 1023) == 0) {
+            new_nodes = (struct tree **) realloc(out->nodes,
+                        (out->nodes_len + 1024) * sizeof(struct tree *));
+            if (new_nodes == NULL) {
+                out->failed = 1;
+                return;
+            }
+            out->nodes = new_nodes;
+        }
+        out->nodes[out->nodes_len++] = tp;
+
+        mib_cache_put_str(out, tp->label);
+        mib_cache_put_int(out, tp->subid);
+        mib_cache_put_int(out, tp->modid);
+        mib_cache_put_int(out, tp->number_modules);
+        if (tp->module_list == &tp->modid)
+            mib_cache_put_int(out, 0);
+        else {
+            mib_cache_put_int(out, 1);
+            for (i = 0; i < tp->number_modules; i++)
+                mib_cache_put_int(out, tp->module_list[i]);
+        }
+        mib_cache_put_int(out, tp->tc_index);
+        mib_cache_put_int(out, tp->type);
+        mib_cache_put_int(out, tp->access);
+        mib_cache_put_int(out, tp->status);
+        mib_cache_put_enums(out, tp->enums);
+        mib_cache_put_ranges(out, tp->ranges);
+        for (count = 0, ip = tp->indexes; ip; ip = ip->next)
+            count++;
+        mib_cache_put_int(out, count);
+        for (ip = tp->indexes; ip; ip = ip->next) {
+            mib_cache_put_str(out, ip->ilabel);
+            mib_cache_put_int(out, ip->isimplied);
+        }
+        mib_cache_put_str(out, tp->augments);
+        for (count = 0, vp = tp->varbinds; vp; vp = vp->next)
+            count++;
+        mib_cache_put_int(out, count);
+        for (vp = tp->varbinds; vp; vp = vp->next)
+            mib_cache_put_str(out, vp->vblabel);
+        mib_cache_put_str(out, tp->hint);
+        mib_cache_put_str(out, tp->units);
+        mib_cache_put_str(out, tp->description);
+        mib_cache_put_str(out, tp->reference);
+        mib_cache_put_str(out, tp->defaultValue);
+
+        mib_cache_put_peers(out, tp->child_list);
+    }
+}
+
+static int
+mib_cache_refcmp(const void *a, const void *b)
+{
+    const struct mib_cache_ref *r1 = a, *r2 = b;
+
+    if (r1->tp == r2->tp)
+        return 0;
+    return r1->tp < r2->tp ? -1 : 1;
+}
+
+/*
+ * Writes the hash chains as lists of node numbers, so that lookups by
+ * name find duplicate labels in the same order as after a text parse.
+ */
+static void
+mib_cache_put_buckets(struct mib_cache_out *out)
+{
+    struct mib_cache_ref *refs, key, *ref;
+    struct tree    *tp;
+    u_int           i, count, total = 0;
+
+    refs = (struct mib_cache_ref *) malloc((out->nodes_len + 1) *
+                                           sizeof(struct mib_cache_ref));
+    if (refs == NULL) {
+        out->failed = 1;
+        return;
+    }
+    for (i = 0; i < out->nodes_len; i++) {
+        refs[i].tp = out->nodes[i];
+        refs[i].idx = i;
+    }
+    qsort(refs, out->nodes_len, sizeof(struct mib_cache_ref),
+          mib_cache_refcmp);
+
+    for (i = 0; i < NHASHSIZE; i++) {
+        for (count = 0, tp = tbuckets[i]; tp; tp = tp->next)
+            count++;
+        mib_cache_put_int(out, count);
+        total += count;
+        for (tp = tbuckets[i]; tp; tp = tp->next) {
+            key.tp = tp;
+            ref = (struct mib_cache_ref *) bsearch(&key, refs,
+                      out->nodes_len, sizeof(struct mib_cache_ref),
+                      mib_cache_refcmp);
+            if (ref == NULL) {
+                out->failed = 1;
+                break;
+            }
+            mib_cache_put_int(out, ref->idx);
+        }
+    }
+    if (total != out->nodes_len)
+        out->failed = 1;
+    free(refs);
+}
+
+static u_int
+mib_cache_count(struct tree *first)
+{
+    struct tree    *tp;
+    u_int           count = 0;
+
+    for (tp = first; tp; tp = tp->next_peer)
+        count += 1 + mib_cache_count(tp->child_list);
+    return count;
+}
+
+/**
+ * Saves the MIBs loaded so far as the compiled cache for @key.
+ *
+ * Nothing is written when the text parse reported errors or left orphan
+ * nodes, so that later runs still show the diagnostics.
+ *
+ * @param key   the MIB settings the tree was loaded with
+ * @param watch ENV_SEPARATOR separated list of MIB directories and files
+ *              the cache depends on, besides the module files themselves
+ *
+ * @return 0 when the cache was written, -1 otherwise
+ */
+int
+netsnmp_mib_cache_save(const char *key, const char *watch)
+{
+    struct mib_cache_out out;
+    struct module  *mp;
+    struct tc      *tcp;
+    char           *file, *tmpfile = NULL, *list, *entry, *st = NULL;
+    FILE           *fp;
+    u_int           count;
+    int             i, rc = -1;
+
+    if (netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID,
+                               NETSNMP_DS_LIB_DONT_PERSIST_STATE) ||
+        netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID,
+                               NETSNMP_DS_LIB_DISABLE_PERSISTENT_SAVE))
+        return -1;
+    if (erroneousMibs != mib_cache_errors || orphan_nodes ||
+        gpMibErrorString || tree_head == NULL) {
+        DEBUGMSGTL(("mib_cache", "not saving MIBs that had errors\n"));
+        return -1;
+    }
+
+    memset(&out, 0, sizeof(out));
+    count = MIB_CACHE_MAGIC;
+    mib_cache_put(&out, &count, sizeof(count));
+    mib_cache_put_int(&out, MIB_CACHE_VERSION);
+    mib_cache_put_int(&out, MIB_CACHE_ORDER);
+    mib_cache_put_int(&out, sizeof(u_long));
+    mib_cache_put_str(&out, netsnmp_get_version());
+    mib_cache_put_str(&out, key);
+
+    /*
+     * what the cache was built from 
+     */
+    for (count = 0, mp = module_head; mp; mp = mp->next)
+        count++;
+    list = watch ? strdup(watch) : NULL;
+    for (entry = list ? strtok_r(list, ENV_SEPARATOR, &st) : NULL; entry;
+         entry = strtok_r(NULL, ENV_SEPARATOR, &st))
+        count++;
+    SNMP_FREE(list);
+    mib_cache_put_int(&out, count);
+    list = watch ? strdup(watch) : NULL;
+    for (entry = list ? strtok_r(list, ENV_SEPARATOR, &st) : NULL; entry;
+         entry = strtok_r(NULL, ENV_SEPARATOR, &st))
+        mib_cache_put_dep(&out, entry);
+    SNMP_FREE(list);
+    for (mp = module_head; mp; mp = mp->next)
+        mib_cache_put_dep(&out, mp->file);
+
+    mib_cache_put_int(&out, max_module);
+    mib_cache_put_int(&out, current_module);
+    mib_cache_put_int(&out, anonymous);
+    for (i = 0; i < NUMBER_OF_ROOT_NODES; i++) {
+        mib_cache_put_str(&out, root_imports[i].label);
+        mib_cache_put_int(&out, root_imports[i].modid);
+    }
+
+    for (count = 0, mp = module_head; mp; mp = mp->next)
+        count++;
+    mib_cache_put_int(&out, count);
+    for (mp = module_head; mp; mp = mp->next) {
+        mib_cache_put_str(&out, mp->name);
+        mib_cache_put_str(&out, mp->file);
+        mib_cache_put_int(&out, mp->modid);
+        mib_cache_put_int(&out, mp->no_imports);
+        if (mp->imports == NULL || mp->no_imports <= 0)
+            mib_cache_put_int(&out, 0);
+        else if (mp->imports == root_imports)
+            mib_cache_put_int(&out, 1);
+        else {
+            mib_cache_put_int(&out, 2);
+            for (i = 0; i < mp->no_imports; i++) {
+                mib_cache_put_str(&out, mp->imports[i].label);
+                mib_cache_put_int(&out, mp->imports[i].modid);
+            }
+        }
+    }
+
+    for (count = 0, i = 0, tcp = tclist; i < tc_alloc; i++, tcp++)
+        if (tcp->type != 0)
+            count++;
+    mib_cache_put_int(&out, tc_alloc);
+    mib_cache_put_int(&out, count);
+    for (i = 0, tcp = tclist; i < tc_alloc; i++, tcp++) {
+        if (tcp->type == 0)
+            continue;
+        mib_cache_put_int(&out, i);
+        mib_cache_put_int(&out, tcp->type);
+        mib_cache_put_int(&out, tcp->modid);
+        mib_cache_put_str(&out, tcp->descriptor);
+        mib_cache_put_str(&out, tcp->hint);
+        mib_cache_put_str(&out, tcp->description);
+        mib_cache_put_enums(&out, tcp->enums);
+        mib_cache_put_ranges(&out, tcp->ranges);
+    }
+
+    mib_cache_put_int(&out, mib_cache_count(tree_head));
+    mib_cache_put_peers(&out, tree_head);
+    mib_cache_put_buckets(&out);
+    count = MIB_CACHE_MAGIC;
+    mib_cache_put(&out, &count, sizeof(count));
+
+    file = mib_cache_file(key);
+    if (out.racy) {
+        DEBUGMSGTL(("mib_cache", "MIB files changed too recently to save\n"));
+        goto done;
+    }
+    if (out.failed || file == NULL ||
+        asprintf(&tmpfile, "%s.%ld", file, (long) getpid()) < 0) {
+        DEBUGMSGTL(("mib_cache", "failed to build the MIB cache\n"));
+        tmpfile = NULL;
+        goto done;
+    }
+    if (mkdirhier(tmpfile, NETSNMP_AGENT_DIRECTORY_MODE, 1) ||
+        (fp = fopen(tmpfile, "wb")) == NULL) {
+        DEBUGMSGTL(("mib_cache", "cannot create %s\n", tmpfile));
+        goto done;
+    }
+    if (fwrite(out.buf, 1, out.out_len, fp) != out.out_len) {
+        fclose(fp);
+        unlink(tmpfile);
+        goto done;
+    }
+    if (fclose(fp) != 0 || rename(tmpfile, file) != 0) {
+        unlink(tmpfile);
+        goto done;
+    }
+    DEBUGMSGTL(("mib_cache", "saved %u nodes (%lu bytes) to %s\n",
+                out.nodes_len, (unsigned long) out.out_len, file));
+    rc = 0;
+
+  done:
+    free(tmpfile);
+    free(file);
+    free(out.nodes);
+    free(out.buf);
+    return rc;
+}
+
+static u_int
+mib_cache_get_int(struct mib_cache_in *in)
+{
+    u_int           val;
+
+    if (in->failed || (size_t) (in->end - in->cp) < sizeof(val)) {
+        in->failed = 1;
+        return 0;
+    }
+    memcpy(&val, in->cp, sizeof(val));
+    in->cp += sizeof(val);
+    return val;
+}
+
+/*
+ * Checks that at least @count more items of @size bytes are left, to
+ * bound allocations made from counts read from the file.
+ */
+static int
+mib_cache_has(struct mib_cache_in *in, u_int count, size_t size)
+{
+    if (in->failed || (size_t) (in->end - in->cp) / size < count) {
+        in->failed = 1;
+        return 0;
+    }
+    return 1;
+}
+
+static char    *
+mib_cache_get_str(struct mib_cache_in *in)
+{
+    u_int           len;
+    char           *str;
+
+    len = mib_cache_get_int(in);
+    if (in->failed || len == MIB_CACHE_NULL)
+        return NULL;
+    if (!mib_cache_has(in, len, 1) || (str = (char *) malloc(len + 1)) == NULL) {
+        in->failed = 1;
+        return NULL;
+    }
+    memcpy(str, in->cp, len);
+    str[len] = '\0';
+    in->cp += len;
+    return str;
+}
+
+static int
+mib_cache_match_str(struct mib_cache_in *in, const char *str)
+{
+    u_int           len;
+
+    len = mib_cache_get_int(in);
+    if (in->failed || len != strlen(str) || !mib_cache_has(in, len, 1) ||
+        memcmp(in->cp, str, len) != 0)
+        return 0;
+    in->cp += len;
+    return 1;
+}
+
+static struct enum_list *
+mib_cache_get_enums(struct mib_cache_in *in)
+{
+    struct enum_list *head = NULL, **epp = &head;
+    u_int           count;
+
+    count = mib_cache_get_int(in);
+    while (count-- > 0 && !in->failed) {
+        *epp = (struct enum_list *) calloc(1, sizeof(struct enum_list));
+        if (*epp == NULL) {
+            in->failed = 1;
+            break;
+        }
+        (*epp)->value = mib_cache_get_int(in);
+        (*epp)->label = mib_cache_get_str(in);
+        if ((*epp)->label == NULL)
+            in->failed = 1;
+        epp = &(*epp)->next;
+    }
+    return head;
+}
+
+static struct range_list *
+mib_cache_get_ranges(struct mib_cache_in *in)
+{
+    struct range_list *head = NULL, **rpp = &head;
+    u_int           count;
+
+    count = mib_cache_get_int(in);
+    while (count-- > 0 && !in->failed) {
+        *rpp = (struct range_list *) calloc(1, sizeof(struct range_list));
+        if (*rpp == NULL) {
+            in->failed = 1;
+            break;
+        }
+        (*rpp)->low = mib_cache_get_int(in);
+        (*rpp)->high = mib_cache_get_int(in);
+        rpp = &(*rpp)->next;
+    }
+    return head;
+}
+
+static struct tree *
+mib_cache_get_peers(struct mib_cache_in *in, struct tree *parent,
+                    struct tree **nodes, u_int nodes_len, u_int *seen)
+{
+    struct tree    *first = NULL, **tpp = &first, *tp;
+    struct index_list **ipp;
+    struct varbind_list **vpp;
+    u_int           count, n;
+    int             i;
+
+    count = mib_cache_get_int(in);
+    while (count-- > 0 && !in->failed) {
+        if (*seen >= nodes_len ||
+            (tp = (struct tree *) calloc(1, sizeof(struct tree))) == NULL) {
+            in->failed = 1;
+            break;
+        }
+        nodes[(*seen)++] = tp;
+        *tpp = tp;
+        tpp = &tp->next_peer;
+
+        tp->parent = parent;
+        tp->label = mib_cache_get_str(in);
+        tp->subid = mib_cache_get_int(in);
+        tp->modid = mib_cache_get_int(in);
+        tp->number_modules = mib_cache_get_int(in);
+        tp->module_list = &tp->modid;
+        if (mib_cache_get_int(in)) {
+            if (tp->number_modules < 1 ||
+                !mib_cache_has(in, tp->number_modules, sizeof(u_int)) ||
+                (tp->module_list = (int *) malloc(tp->number_modules *
+                                                  sizeof(int))) == NULL) {
+                tp->module_list = &tp->modid;
+                in->failed = 1;
+                break;
+            }
+            for (i = 0; i < tp->number_modules; i++)
+                tp->module_list[i] = mib_cache_get_int(in);
+        }
+        tp->tc_index = mib_cache_get_int(in);
+        tp->type = mib_cache_get_int(in);
+        tp->access = mib_cache_get_int(in);
+        tp->status = mib_cache_get_int(in);
+        tp->enums = mib_cache_get_enums(in);
+        tp->ranges = mib_cache_get_ranges(in);
+        n = mib_cache_get_int(in);
+        for (ipp = &tp->indexes; n-- > 0 && !in->failed;
+             ipp = &(*ipp)->next) {
+            *ipp = (struct index_list *) calloc(1, sizeof(struct index_list));
+            if (*ipp == NULL) {
+                in->failed = 1;
+                break;
+            }
+            (*ipp)->ilabel = mib_cache_get_str(in);
+            (*ipp)->isimplied = mib_cache_get_int(in);
+            if ((*ipp)->ilabel == NULL)
+                in->failed = 1;
+        }
+        tp->augments = mib_cache_get_str(in);
+        n = mib_cache_get_int(in);
+        for (vpp = &tp->varbinds; n-- > 0 && !in->failed;
+             vpp = &(*vpp)->next) {
+            *vpp = (struct varbind_list *)
+                calloc(1, sizeof(struct varbind_list));
+            if (*vpp == NULL) {
+                in->failed = 1;
+                break;
+            }
+            (*vpp)->vblabel = mib_cache_get_str(in);
+            if ((*vpp)->vblabel == NULL)
+                in->failed = 1;
+        }
+        tp->hint = mib_cache_get_str(in);
+        tp->units = mib_cache_get_str(in);
+        tp->description = mib_cache_get_str(in);
+        tp->reference = mib_cache_get_str(in);
+        tp->defaultValue = mib_cache_get_str(in);
+        if (tp->label == NULL)
+            in->failed = 1;
+
+        tp->child_list = mib_cache_get_peers(in, tp, nodes, nodes_len, seen);
+    }
+    return first;
+}
+
+static void
+mib_cache_free_modules(struct module *mp)
+{
+    struct module  *next;
+    int             i;
+
+    for (; mp; mp = next) {
+        next = mp->next;
+        if (mp->imports && mp->imports != root_imports) {
+            for (i = 0; i < mp->no_imports; i++)
+                free(mp->imports[i].label);
+            free(mp->imports);
+        }
+        free(mp->name);
+        free(mp->file);
+        free(mp);
+    }
+}
+
+static void
+mib_cache_free_tcs(struct tc *tcs, int len)
+{
+    int             i;
+
+    for (i = 0; i < len; i++) {
+        free_enums(&tcs[i].enums);
+        free_ranges(&tcs[i].ranges);
+        free(tcs[i].descriptor);
+        free(tcs[i].hint);
+        free(tcs[i].description);
+    }
+    free(tcs);
+}
+
+#if !defined(HAVE_MMAP) || !defined(HAVE_SYS_MMAN_H)
+static u_char  *
+mib_cache_read_file(int fd, size_t len)
+{
+    u_char         *data;
+    size_t          got = 0;
+    ssize_t         rc;
+
+    data = (u_char *) malloc(len);
+    if (data == NULL)
+        return NULL;
+    while (got < len) {
+        rc = read(fd, data + got, len - got);
+        if (rc < 0 && errno == EINTR)
+            continue;
+        if (rc <= 0) {
+            free(data);
+            return NULL;
+        }
+        got += rc;
+    }
+    return data;
+}
+#endif
+
+/**
+ * Loads the MIBs from the compiled cache for @key, in place of scanning
+ * the MIB directories and parsing the modules.
+ *
+ * Must be called before any module has been read.  The cache is only
+ * used if it was built by this library version with the same MIB
+ * settings, and none of the directories and files it was built from
+ * have changed since.
+ *
+ * @param key the MIB settings the tree is to be loaded with
+ *
+ * @return 0 when the MIBs were loaded from the cache, -1 when they must
+ *         be parsed as usual
+ */
+int
+netsnmp_mib_cache_load(const char *key)
+{
+    struct mib_cache_in in;
+    struct module  *modules = NULL, **mpp = &modules, *mp;
+    struct module_import roots[NUMBER_OF_ROOT_NODES];
+    struct tc      *tcs = NULL;
+    struct tree    **nodes = NULL, *first = NULL, *tp, *next;
+    struct tree    *heads[NHASHSIZE], **tails[NHASHSIZE];
+    u_int           stamp[MIB_CACHE_STAMP_LEN];
+    u_char         *data = NULL, *linked = NULL;
+    char           *file, *path;
+    size_t          len = 0;
+    u_int           count, i, j, idx, seen = 0, nodes_len = 0;
+    int             tcs_len = 0, fd, nmax = 0, ncurrent = 0, nanon = 0;
+    struct stat     sb;
+
+    mib_cache_errors = erroneousMibs;
+    memset(roots, 0, sizeof(roots));
+
+    if (netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID,
+                               NETSNMP_DS_LIB_DISABLE_PERSISTENT_LOAD))
+        return -1;
+    if (module_head != NULL || tree_head == NULL)
+        return -1;
+    for (tp = tree_head; tp; tp = tp->next_peer)
+        if (tp->child_list)
+            return -1;
+
+    file = mib_cache_file(key);
+    if (file == NULL)
+        return -1;
+    fd = open(file, O_RDONLY);
+    if (fd < 0) {
+        DEBUGMSGTL(("mib_cache", "no cache in %s\n", file));
+        free(file);
+        return -1;
+    }
+    if (fstat(fd, &sb) == 0 && sb.st_size > 0) {
+        len = sb.st_size;
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+        data = (u_char *) mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == (u_char *) MAP_FAILED)
+            data = NULL;
+#else
+        data = mib_cache_read_file(fd, len);
+#endif
+    }
+    close(fd);
+    if (data == NULL) {
+        free(file);
+        return -1;
+    }
+
+    in.cp = data;
+    in.end = data + len;
+    in.failed = 0;
+    if (mib_cache_get_int(&in) != MIB_CACHE_MAGIC ||
+        mib_cache_get_int(&in) != MIB_CACHE_VERSION ||
+        mib_cache_get_int(&in) != MIB_CACHE_ORDER ||
+        mib_cache_get_int(&in) != sizeof(u_long) ||
+        !mib_cache_match_str(&in, netsnmp_get_version()) ||
+        !mib_cache_match_str(&in, key)) {
+        DEBUGMSGTL(("mib_cache", "%s is not for these settings\n", file));
+        goto fail;
+    }
+
+    count = mib_cache_get_int(&in);
+    while (count-- > 0 && !in.failed) {
+        path = mib_cache_get_str(&in);
+        if (path == NULL || !mib_cache_has(&in, 1, sizeof(stamp)))
+            in.failed = 1;
+        else {
+            mib_cache_stamp(path, stamp);
+            if (memcmp(in.cp, stamp, sizeof(stamp)) != 0) {
+                DEBUGMSGTL(("mib_cache", "%s is stale: %s changed\n",
+                            file, path));
+                in.failed = 1;
+            }
+            in.cp += sizeof(stamp);
+        }
+        free(path);
+    }
+
+    nmax = mib_cache_get_int(&in);
+    ncurrent = mib_cache_get_int(&in);
+    nanon = mib_cache_get_int(&in);
+    for (i = 0; i < NUMBER_OF_ROOT_NODES; i++) {
+        roots[i].label = mib_cache_get_str(&in);
+        roots[i].modid = mib_cache_get_int(&in);
+    }
+
+    count = mib_cache_get_int(&in);
+    while (count-- > 0 && !in.failed) {
+        mp = (struct module *) calloc(1, sizeof(struct module));
+        if (mp == NULL) {
+            in.failed = 1;
+            break;
+        }
+        *mpp = mp;
+        mpp = &mp->next;
+        mp->name = mib_cache_get_str(&in);
+        mp->file = mib_cache_get_str(&in);
+        mp->modid = mib_cache_get_int(&in);
+        mp->no_imports = mib_cache_get_int(&in);
+        switch (mib_cache_get_int(&in)) {
+        case 0:
+            break;
+        case 1:
+            mp->imports = root_imports;
+            break;
+        case 2:
+            if (mp->no_imports <= 0 ||
+                !mib_cache_has(&in, mp->no_imports, 2 * sizeof(u_int)) ||
+                (mp->imports = (struct module_import *)
+                 calloc(mp->no_imports, sizeof(struct module_import))) ==
+                NULL) {
+                mp->no_imports = 0;
+                in.failed = 1;
+                break;
+            }
+            for (j = 0; j < (u_int) mp->no_imports; j++) {
+                mp->imports[j].label = mib_cache_get_str(&in);
+                mp->imports[j].modid = mib_cache_get_int(&in);
+            }
+            break;
+        default:
+            in.failed = 1;
+        }
+        if (mp->name == NULL || mp->file == NULL)
+            in.failed = 1;
+    }
+
+    tcs_len = mib_cache_get_int(&in);
+    if (in.failed || tcs_len < TC_INCR ||
+        (tcs = (struct tc *) calloc(tcs_len, sizeof(struct tc))) == NULL) {
+        tcs_len = 0;
+        goto fail;
+    }
+    count = mib_cache_get_int(&in);
+    while (count-- > 0 && !in.failed) {
+        idx = mib_cache_get_int(&in);
+        if (idx >= (u_int) tcs_len || tcs[idx].type != 0) {
+            in.failed = 1;
+            break;
+        }
+        tcs[idx].type = mib_cache_get_int(&in);
+        tcs[idx].modid = mib_cache_get_int(&in);
+        tcs[idx].descriptor = mib_cache_get_str(&in);
+        tcs[idx].hint = mib_cache_get_str(&in);
+        tcs[idx].description = mib_cache_get_str(&in);
+        tcs[idx].enums = mib_cache_get_enums(&in);
+        tcs[idx].ranges = mib_cache_get_ranges(&in);
+        if (tcs[idx].type == 0 || tcs[idx].descriptor == NULL)
+            in.failed = 1;
+    }
+
+    nodes_len = mib_cache_get_int(&in);
+    if (!mib_cache_has(&in, nodes_len, sizeof(u_int)) || nodes_len == 0 ||
+        (nodes = (struct tree **) calloc(nodes_len,
+                                         sizeof(struct tree *))) == NULL ||
+        (linked = (u_char *) calloc(nodes_len, 1)) == NULL)
+        goto fail;
+    first = mib_cache_get_peers(&in, NULL, nodes, nodes_len, &seen);
+    if (in.failed || seen != nodes_len)
+        goto fail;
+    for (i = 0; i < nodes_len; i++)
+        if (nodes[i]->tc_index < -1 || nodes[i]->tc_index >= tcs_len)
+            goto fail;
+
+    for (i = 0; i < NHASHSIZE && !in.failed; i++) {
+        heads[i] = NULL;
+        tails[i] = &heads[i];
+        count = mib_cache_get_int(&in);
+        while (count-- > 0 && !in.failed) {
+            idx = mib_cache_get_int(&in);
+            if (idx >= nodes_len || linked[idx] ||
+                NBUCKET(name_hash(nodes[idx]->label)) != (int) i) {
+                in.failed = 1;
+                break;
+            }
+            linked[idx] = 1;
+            *tails[i] = nodes[idx];
+            tails[i] = &nodes[idx]->next;
+        }
+    }
+    if (mib_cache_get_int(&in) != MIB_CACHE_MAGIC || in.cp != in.end)
+        goto fail;
+    for (i = 0; i < nodes_len; i++)
+        if (!linked[i])
+            goto fail;
+
+    /*
+     * Everything checks out: replace the bare roots set up by
+     * netsnmp_init_mib_internals() with the cached tree.
+     */
+    for (tp = tree_head; tp; tp = next) {
+        next = tp->next_peer;
+        free(tp->label);
+        free(tp);
+    }
+    for (i = 0; i < NUMBER_OF_ROOT_NODES; i++) {
+        free(root_imports[i].label);
+        root_imports[i] = roots[i];
+    }
+    mib_cache_free_tcs(tclist, tc_alloc);
+    tclist = tcs;
+    tc_alloc = tcs_len;
+    module_head = modules;
+    max_module = nmax;
+    current_module = ncurrent;
+    anonymous = nanon;
+    for (i = 0; i < NHASHSIZE; i++) {
+        *tails[i] = NULL;
+        tbuckets[i] = heads[i];
+    }
+    for (i = 0; i < nodes_len; i++)
+        set_function(nodes[i]);
+    tree_head = first;
+    tree_generation++;
+
+    DEBUGMSGTL(("mib_cache", "loaded %u nodes from %s\n", nodes_len, file));
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+    munmap(data, len);
+#else
+    free(data);
+#endif
+    free(linked);
+    free(nodes);
+    free(file);
+    return 0;
+
+  fail:
+    DEBUGMSGTL(("mib_cache", "not using %s\n", file));
+    for (i = 0; i < seen; i++) {
+        free_partial_tree(nodes[i], FALSE);
+        if (nodes[i]->module_list != &nodes[i]->modid)
+            free(nodes[i]->module_list);
+        free(nodes[i]);
+    }
+    mib_cache_free_tcs(tcs, tcs_len);
+    mib_cache_free_modules(modules);
+    for (i = 0; i < NUMBER_OF_ROOT_NODES; i++)
+        free(roots[i].label);
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+    munmap(data, len);
+#else
+    free(data);
+#endif
+    free(linked);
+    free(nodes);
+    free(file);
+    return -1;
+}
+
 #endif /* NETSNMP_DISABLE_MIB_LOADING */
@@ -89,6 +89,10 @@ netsnmp_feature_child_of(usm_scapi, usm_support);
 #ifdef HAVE_AES
 #include <openssl/aes.h>
 #endif
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#endif
 
 #ifndef NETSNMP_DISABLE_DES
 #ifdef HAVE_STRUCT_DES_KS_STRUCT_WEAK_KEY
@@ -693,6 +697,292 @@ sc_get_openssl_privfn(int priv_type)
 }
 #endif /* openssl */
 
+#if defined(NETSNMP_USE_OPENSSL) && defined(HAVE_HMAC_CTX_NEW)
+#define NETSNMP_SC_KEYCACHE 1
+/*
+ * Keyed context cache.
+ *
+ * Setting up an HMAC or cipher context from a raw key (finding the
+ * digest, hashing the key pads, expanding the key schedule) costs about
+ * as much as processing a whole message, while a USM user keeps using
+ * the same localized keys for every message it sends or receives.  So
+ * pre-keyed contexts are kept in a small set-associative cache, indexed
+ * by transform and key bytes, and each message works on a copy of the
+ * cached context.
+ *
+ * Since the key bytes are the index, a changed key can never hit an old
+ * context; sc_keycache_forget() is called when a user key is replaced
+ * or freed anyway so that no copies of old keys are left behind.
+ */
+#define SC_KEYCACHE_SETS    16
+#define SC_KEYCACHE_WAYS    4
+#define SC_KEYCACHE_MAXKEY  64
+
+#define SC_KEYCACHE_HMAC    1
+#define SC_KEYCACHE_ENCRYPT 2
+#define SC_KEYCACHE_DECRYPT 3
+
+typedef struct sc_keycache_entry_s {
+    int             kind;       /* SC_KEYCACHE_*, 0 if the slot is free */
+    int             type;       /* auth or priv type */
+    u_int           keylen;
+    u_char          key[SC_KEYCACHE_MAXKEY];
+    u_int           used;       /* LRU stamp */
+    void           *ctx;        /* sc_hmac_ctx or EVP_CIPHER_CTX */
+} sc_keycache_entry;
+
+static sc_keycache_entry sc_keycache[SC_KEYCACHE_SETS][SC_KEYCACHE_WAYS];
+static u_int    sc_keycache_clock;
+
+/*
+ * OpenSSL 3 deprecates HMAC_CTX in favour of EVP_MAC; the one-shot HMAC()
+ * used without the cache is still fine with both.
+ */
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+typedef EVP_MAC_CTX sc_hmac_ctx;
+
+static sc_hmac_ctx *
+_hmac_ctx_new(const EVP_MD *hashfn, const u_char *key, u_int keylen)
+{
+    EVP_MAC        *mac;
+    EVP_MAC_CTX    *ctx;
+    OSSL_PARAM      params[2];
+
+    mac = EVP_MAC_fetch(NULL, "HMAC", NULL);
+    if (mac == NULL)
+        return NULL;
+    ctx = EVP_MAC_CTX_new(mac);
+    EVP_MAC_free(mac);          /* ctx keeps its own reference */
+    if (ctx == NULL)
+        return NULL;
+    params[0] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST,
+                    NETSNMP_REMOVE_CONST(char *, EVP_MD_get0_name(hashfn)), 0);
+    params[1] = OSSL_PARAM_construct_end();
+    if (EVP_MAC_init(ctx, key, keylen, params) != 1) {
+        EVP_MAC_CTX_free(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+#define _hmac_ctx_dup(ctx)          EVP_MAC_CTX_dup(ctx)
+#define _hmac_ctx_free(ctx)         EVP_MAC_CTX_free(ctx)
+#define _hmac_update(ctx, msg, len) EVP_MAC_update(ctx, msg, len)
+
+static int
+_hmac_final(sc_hmac_ctx *ctx, u_char *buf, unsigned int *buf_len)
+{
+    size_t          len;
+
+    if (EVP_MAC_final(ctx, buf, &len, *buf_len) != 1)
+        return 0;
+    *buf_len = len;
+    return 1;
+}
+#else
+typedef HMAC_CTX sc_hmac_ctx;
+
+static sc_hmac_ctx *
+_hmac_ctx_new(const EVP_MD *hashfn, const u_char *key, u_int keylen)
+{
+    HMAC_CTX       *ctx = HMAC_CTX_new();
+
+    if (ctx != NULL && HMAC_Init_ex(ctx, key, keylen, hashfn, NULL) != 1) {
+        HMAC_CTX_free(ctx);
+        ctx = NULL;
+    }
+    return ctx;
+}
+
+static sc_hmac_ctx *
+_hmac_ctx_dup(sc_hmac_ctx *ctx)
+{
+    HMAC_CTX       *copy = HMAC_CTX_new();
+
+    if (copy != NULL && HMAC_CTX_copy(copy, ctx) != 1) {
+        HMAC_CTX_free(copy);
+        copy = NULL;
+    }
+    return copy;
+}
+
+#define _hmac_ctx_free(ctx)         HMAC_CTX_free(ctx)
+#define _hmac_update(ctx, msg, len) HMAC_Update(ctx, msg, len)
+#define _hmac_final(ctx, buf, lenp) HMAC_Final(ctx, buf, lenp)
+#endif /* OPENSSL_VERSION_NUMBER >= 0x30000000L */
+
+static void
+_keycache_release(sc_keycache_entry *e)
+{
+    if (e->kind == SC_KEYCACHE_HMAC)
+        _hmac_ctx_free((sc_hmac_ctx *) e->ctx);
+    else if (e->kind != 0)
+        EVP_CIPHER_CTX_free((EVP_CIPHER_CTX *) e->ctx);
+    memset(e, 0, sizeof(*e));
+}
+
+/*
+ * Returns the entry for KIND/TYPE/KEY.  If it is not cached the least
+ * recently used slot of its set is emptied and returned with kind 0 for
+ * the caller to fill in.  Returns NULL if the key is too long to cache.
+ * Must be called with MT_LIB_KEYCACHE held.
+ */
+static sc_keycache_entry *
+_keycache_find(int kind, int type, const u_char *key, u_int keylen)
+{
+    sc_keycache_entry *set, *victim;
+    int             i;
+
+    if (keylen > SC_KEYCACHE_MAXKEY)
+        return NULL;
+
+    set = sc_keycache[netsnmp_hash_buf(key, keylen, NETSNMP_HASH_INIT ^ kind)
+                      % SC_KEYCACHE_SETS];
+    victim = &set[0];
+    for (i = 0; i < SC_KEYCACHE_WAYS; i++) {
+        if (set[i].kind == kind && set[i].type == type &&
+            set[i].keylen == keylen && memcmp(set[i].key, key, keylen) == 0) {
+            set[i].used = ++sc_keycache_clock;
+            snmp_increment_statistic(STAT_SC_KEYCACHE_HITS);
+            return &set[i];
+        }
+        if (victim->kind != 0 &&
+            (set[i].kind == 0 || set[i].used < victim->used))
+            victim = &set[i];
+    }
+
+    snmp_increment_statistic(STAT_SC_KEYCACHE_MISSES);
+    _keycache_release(victim);
+    return victim;
+}
+
+static void
+_keycache_fill(sc_keycache_entry *e, int kind, int type,
+               const u_char *key, u_int keylen, void *ctx)
+{
+    e->kind = kind;
+    e->type = type;
+    e->keylen = keylen;
+    memcpy(e->key, key, keylen);
+    e->used = ++sc_keycache_clock;
+    e->ctx = ctx;
+}
+
+/*
+ * Returns a private copy of the HMAC context keyed with KEY, or NULL if
+ * there is none; the caller frees it with _hmac_ctx_free().
+ */
+static sc_hmac_ctx *
+_keycache_hmac(int auth_type, const EVP_MD *hashfn,
+               const u_char *key, u_int keylen)
+{
+    sc_keycache_entry *e;
+    sc_hmac_ctx    *ctx, *copy = NULL;
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_KEYCACHE);
+    e = _keycache_find(SC_KEYCACHE_HMAC, auth_type, key, keylen);
+    if (e != NULL && e->kind == 0) {
+        ctx = _hmac_ctx_new(hashfn, key, keylen);
+        if (ctx != NULL)
+            _keycache_fill(e, SC_KEYCACHE_HMAC, auth_type, key, keylen, ctx);
+    }
+    if (e != NULL && e->kind != 0)
+        copy = _hmac_ctx_dup((sc_hmac_ctx *) e->ctx);
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_KEYCACHE);
+
+    return copy;
+}
+
+#ifdef HAVE_AES
+/*
+ * Returns a private copy of the KIND (SC_KEYCACHE_ENCRYPT or _DECRYPT)
+ * cipher context keyed with KEY, set up to start with IV, or NULL if
+ * there is none; the caller frees it with EVP_CIPHER_CTX_free().
+ */
+static EVP_CIPHER_CTX *
+_keycache_cipher(int kind, int priv_type, const EVP_CIPHER *cipher,
+                 const u_char *key, u_int keylen, const u_char *iv)
+{
+    sc_keycache_entry *e;
+    EVP_CIPHER_CTX *ctx, *copy = NULL;
+    int             enc = (kind == SC_KEYCACHE_ENCRYPT);
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_KEYCACHE);
+    e = _keycache_find(kind, priv_type, key, keylen);
+    if (e != NULL && e->kind == 0) {
+        ctx = EVP_CIPHER_CTX_new();
+        if (ctx != NULL &&
+            EVP_CipherInit_ex(ctx, cipher, NULL, key, NULL, enc) == 1)
+            _keycache_fill(e, kind, priv_type, key, keylen, ctx);
+        else
+            EVP_CIPHER_CTX_free(ctx);
+    }
+    if (e != NULL && e->kind != 0) {
+        copy = EVP_CIPHER_CTX_new();
+        if (copy != NULL &&
+            EVP_CIPHER_CTX_copy(copy, (EVP_CIPHER_CTX *) e->ctx) != 1) {
+            EVP_CIPHER_CTX_free(copy);
+            copy = NULL;
+        }
+    }
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_KEYCACHE);
+
+    if (copy != NULL && EVP_CipherInit_ex(copy, NULL, NULL, NULL, iv, enc) != 1) {
+        EVP_CIPHER_CTX_free(copy);
+        copy = NULL;
+    }
+    return copy;
+}
+#endif /* HAVE_AES */
+#endif /* NETSNMP_USE_OPENSSL && HAVE_HMAC_CTX_NEW */
+
+/**
+ * Drops every cached context that was keyed with KEY.  Called when a
+ * localized key is replaced or freed.
+ */
+void
+sc_keycache_forget(const u_char *key, size_t keylen)
+{
+#ifdef NETSNMP_SC_KEYCACHE
+    int             i, j;
+
+    if (key == NULL || keylen == 0 || keylen > SC_KEYCACHE_MAXKEY)
+        return;
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_KEYCACHE);
+    for (i = 0; i < SC_KEYCACHE_SETS; i++)
+        for (j = 0; j < SC_KEYCACHE_WAYS; j++)
+            if (sc_keycache[i][j].kind != 0 &&
+                sc_keycache[i][j].keylen == keylen &&
+                memcmp(sc_keycache[i][j].key, key, keylen) == 0)
+                _keycache_release(&sc_keycache[i][j]);
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_KEYCACHE);
+#endif
+}
+
+/**
+ * Drops all cached contexts.
+ */
+void
+sc_keycache_clear(void)
+{
+#ifdef NETSNMP_SC_KEYCACHE
+    int             i, j;
+
+#ifndef NETSNMP_FEATURE_REMOVE_STATISTICS
+    DEBUGMSGTL(("scapi:keycache", "%u hits %u misses\n",
+                snmp_get_statistic(STAT_SC_KEYCACHE_HITS),
+                snmp_get_statistic(STAT_SC_KEYCACHE_MISSES)));
+#endif /* NETSNMP_FEATURE_REMOVE_STATISTICS */
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_KEYCACHE);
+    for (i = 0; i < SC_KEYCACHE_SETS; i++)
+        for (j = 0; j < SC_KEYCACHE_WAYS; j++)
+            _keycache_release(&sc_keycache[i][j]);
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_KEYCACHE);
+#endif
+}
+
 
 /*******************************************************************-o-******
  * sc_generate_keyed_hash
@@ -737,6 +1027,9 @@ sc_generate_keyed_hash(const oid * authtypeOID, size_t authtypeOIDlen,
 #endif
 #ifdef NETSNMP_USE_OPENSSL
     const EVP_MD   *hashfn;
+#ifdef NETSNMP_SC_KEYCACHE
+    sc_hmac_ctx    *hctx;
+#endif
 #elif defined(NETSNMP_USE_PKCS11)
     u_long          ck_type;
 #endif
@@ -781,6 +1074,17 @@ sc_generate_keyed_hash(const oid * authtypeOID, size_t authtypeOIDlen,
         QUITFUN(SNMPERR_GENERR, sc_generate_keyed_hash_quit);
     }
 
+#ifdef NETSNMP_SC_KEYCACHE
+    hctx = _keycache_hmac(auth_type, hashfn, key, keylen);
+    if (hctx != NULL) {
+        if (_hmac_update(hctx, message, msglen) != 1 ||
+            _hmac_final(hctx, buf, &buf_len) != 1) {
+            _hmac_ctx_free(hctx);
+            QUITFUN(SNMPERR_GENERR, sc_generate_keyed_hash_quit);
+        }
+        _hmac_ctx_free(hctx);
+    } else
+#endif
     HMAC(hashfn, key, keylen, message, msglen, buf, &buf_len);
     if (buf_len != properlength) {
         QUITFUN(rval, sc_generate_keyed_hash_quit);
@@ -1318,16 +1622,23 @@ sc_encrypt(const oid * privtype, size_t privtypelen,
         /*
          * encrypt the data 
          */
-        ctx = EVP_CIPHER_CTX_new();
+        ctx = NULL;
+#ifdef NETSNMP_SC_KEYCACHE
+        ctx = _keycache_cipher(SC_KEYCACHE_ENCRYPT, pai->type, cipher,
+                               key, keylen, my_iv);
+#endif
         if (!ctx) {
-            DEBUGMSGTL(("scapi:encrypt", "openssl error: ctx_new\n"));
-            QUITFUN(SNMPERR_GENERR, sc_encrypt_quit);
-        }
-        rc = EVP_EncryptInit(ctx, cipher, key, my_iv);
-        if (rc != 1) {
-            DEBUGMSGTL(("scapi:encrypt", "openssl error: init\n"));
-            EVP_CIPHER_CTX_free(ctx);
-            QUITFUN(SNMPERR_GENERR, sc_encrypt_quit);
+            ctx = EVP_CIPHER_CTX_new();
+            if (!ctx) {
+                DEBUGMSGTL(("scapi:encrypt", "openssl error: ctx_new\n"));
+                QUITFUN(SNMPERR_GENERR, sc_encrypt_quit);
+            }
+            rc = EVP_EncryptInit(ctx, cipher, key, my_iv);
+            if (rc != 1) {
+                DEBUGMSGTL(("scapi:encrypt", "openssl error: init\n"));
+                EVP_CIPHER_CTX_free(ctx);
+                QUITFUN(SNMPERR_GENERR, sc_encrypt_quit);
+            }
         }
         rc = EVP_EncryptUpdate(ctx, ciphertext, &len, plaintext, ptlen);
         if (rc != 1) {
@@ -1540,14 +1851,21 @@ sc_decrypt(const oid * privtype, size_t privtypelen,
         /*
          * decrypt the data
          */
-        ctx = EVP_CIPHER_CTX_new();
+        ctx = NULL;
+#ifdef NETSNMP_SC_KEYCACHE
+        ctx = _keycache_cipher(SC_KEYCACHE_DECRYPT, pai->type, cipher,
+                               key, keylen, my_iv);
+#endif
         if (!ctx) {
-            QUITFUN(SNMPERR_GENERR, sc_decrypt_quit);
-        }
-        rc = EVP_DecryptInit(ctx, cipher, key, my_iv);
-        if (rc != 1) {
-            EVP_CIPHER_CTX_free(ctx);
-            QUITFUN(SNMPERR_GENERR, sc_decrypt_quit);
+            ctx = EVP_CIPHER_CTX_new();
+            if (!ctx) {
+                QUITFUN(SNMPERR_GENERR, sc_decrypt_quit);
+            }
+            rc = EVP_DecryptInit(ctx, cipher, key, my_iv);
+            if (rc != 1) {
+                EVP_CIPHER_CTX_free(ctx);
+                QUITFUN(SNMPERR_GENERR, sc_decrypt_quit);
+            }
         }
         rc = EVP_DecryptUpdate(ctx, plaintext, &len, ciphertext, ctlen);
         if (rc != 1) {
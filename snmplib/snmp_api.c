@@ -150,6 +150,11 @@ static void     _init_snmp(void);
 
 static int      _snmp_store_needed = 0;
 
+#if defined(NETSNMP_REENTRANT) && defined(HAVE_PTHREAD_H)
+#define NETSNMP_PARSE_WORKERS 1
+static void     _parse_workers_forget(struct session_list *slp);
+#endif
+
 #include "../agent/mibgroup/agentx/protocol.h"
 #include <net-snmp/library/transform_oids.h>
 #ifndef timercmp
@@ -215,6 +220,8 @@ struct snmp_internal_session {
     size_t        obuf_size;    /* size of buffer for packet data */
     u_char       *opacket;      /* send packet data (within obuf) */
     size_t        opacket_len;  /* length of data */
+
+    int           listed;       /* on the Sessions list */
 };
 
 /*
@@ -329,6 +336,32 @@ int             snmp_errno = 0;
  * END MTCRITICAL_RESOURCE
  */
 
+/*
+ * Told about every session entering or leaving the Sessions list
+ */
+static void   (*session_list_hook) (struct session_list *, int);
+
+/*
+ * The outstanding requests of the sessions on the Sessions list, in a
+ * binary heap ordered by expiry time, so that the next timeout can be
+ * found without visiting every session and request.  Requests are
+ * allocated as request_entry, which remembers the place in the heap.
+ * MT_LIB_TIMEOUTS guards the heap and is never held while taking
+ * another lock.
+ */
+typedef struct request_entry_s {
+    netsnmp_request_list rl;        /* first, so the entry is freed as rl */
+    int             heap_index;     /* -1 when not in the heap */
+} request_entry;
+
+static request_entry **request_heap = NULL;     /* MT_LIB_TIMEOUTS */
+static int      request_heap_len = 0;
+static int      request_heap_size = 0;
+static int      request_heap_failed = 0;  /* out of memory: always scan */
+
+static int      sessions_count = 0;     /* on the Sessions list */
+static int      sessions_closing = 0;   /* transports closed under them */
+
 /*
  * global error detail storage
  */
@@ -349,6 +382,7 @@ static int      snmp_resend_request(struct session_list *slp,
                                     netsnmp_request_list *rp,
                                     int incr_retries);
 static void     register_default_handlers(void);
+static void     _pools_shutdown(void);
 static struct session_list *snmp_sess_copy(netsnmp_session * pss);
 
 /*
@@ -776,6 +810,14 @@ register_default_handlers(void)
 		      NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_REVERSE_ENCODE);
     netsnmp_ds_register_config(ASN_INTEGER, "snmp", "defaultPort",
 		      NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_DEFAULT_PORT);
+    netsnmp_ds_register_config(ASN_OCTET_STR, "snmp", "eventLoop",
+		      NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_EVENT_LOOP);
+    netsnmp_ds_register_config(ASN_BOOLEAN, "snmp", "zeroCopyVarbinds",
+		      NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_ZERO_COPY_VARBINDS);
+    netsnmp_ds_register_config(ASN_INTEGER, "snmp", "pduPoolSize",
+		      NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_PDU_POOL_SIZE);
+    netsnmp_ds_register_config(ASN_INTEGER, "snmp", "varbindPoolSize",
+		      NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_VARBIND_POOL_SIZE);
 #ifndef NETSNMP_FEATURE_REMOVE_RUNTIME_DISABLE_VERSION
     netsnmp_ds_register_config(ASN_BOOLEAN, "snmp", "disableSNMPv3",
                       NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_DISABLE_V3);
@@ -977,12 +1019,166 @@ snmp_shutdown(const char *type)
     shutdown_secmod();
     shutdown_snmp_transport();
     shutdown_data_list();
+    _pools_shutdown();
     snmp_debug_shutdown();    /* should be done last */
 
     init_snmp_init_done  = 0;
     _init_snmp_init_done = 0;
 }
 
+static void
+_request_heap_set(int i, request_entry *e)
+{
+    request_heap[i] = e;
+    e->heap_index = i;
+}
+
+/*
+ * Moves the entry at i up or down to its place.
+ */
+static void
+_request_heap_fix(int i)
+{
+    request_entry  *e = request_heap[i];
+    int             child;
+
+    while (i > 0 && timercmp(&e->rl.expireM,
+                             &request_heap[(i - 1) / 2]->rl.expireM, <)) {
+        _request_heap_set(i, request_heap[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    while ((child = 2 * i + 1) < request_heap_len) {
+        if (child + 1 < request_heap_len &&
+            timercmp(&request_heap[child + 1]->rl.expireM,
+                     &request_heap[child]->rl.expireM, <))
+            child++;
+        if (!timercmp(&request_heap[child]->rl.expireM, &e->rl.expireM, <))
+            break;
+        _request_heap_set(i, request_heap[child]);
+        i = child;
+    }
+    _request_heap_set(i, e);
+}
+
+static void
+_request_heap_add(netsnmp_request_list *rp)
+{
+    request_entry  *e = (request_entry *) rp;
+    request_entry **heap;
+    int             size;
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_TIMEOUTS);
+    if (request_heap_len == request_heap_size) {
+        size = request_heap_size ? 2 * request_heap_size : 64;
+        heap = (request_entry **) realloc(request_heap, size * sizeof(*heap));
+        if (NULL == heap) {
+            request_heap_failed = 1;
+            snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_TIMEOUTS);
+            return;
+        }
+        request_heap = heap;
+        request_heap_size = size;
+    }
+    _request_heap_set(request_heap_len++, e);
+    _request_heap_fix(e->heap_index);
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_TIMEOUTS);
+}
+
+static void
+_request_heap_remove(netsnmp_request_list *rp)
+{
+    request_entry  *e = (request_entry *) rp;
+    int             i;
+
+    if (e->heap_index < 0)
+        return;
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_TIMEOUTS);
+    i = e->heap_index;
+    e->heap_index = -1;
+    if (i < --request_heap_len) {
+        _request_heap_set(i, request_heap[request_heap_len]);
+        _request_heap_fix(i);
+    }
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_TIMEOUTS);
+}
+
+/*
+ * after rp->expireM has changed
+ */
+static void
+_request_heap_update(netsnmp_request_list *rp)
+{
+    request_entry  *e = (request_entry *) rp;
+
+    if (e->heap_index < 0)
+        return;
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_TIMEOUTS);
+    _request_heap_fix(e->heap_index);
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_TIMEOUTS);
+}
+
+/*
+ * Finds the earliest expiry of the requests of the sessions on the
+ * Sessions list.
+ *
+ * @return 0 if the sessions must be visited instead, as some are waiting
+ * to be closed (or the heap ran out of memory)
+ */
+static int
+_request_heap_earliest(struct timeval *earliest, int *requests, int *active)
+{
+    int             rc = 0;
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_TIMEOUTS);
+    if (sessions_closing || request_heap_failed) {
+        sessions_closing = 0;
+    } else {
+        if (request_heap_len > 0) {
+            *earliest = request_heap[0]->rl.expireM;
+            *requests = 1;
+        }
+        *active = sessions_count;
+        rc = 1;
+    }
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_TIMEOUTS);
+    return rc;
+}
+
+/*
+ * Closes the transport of a session, which the next full pass of
+ * snmp_sess_select_info2_flags() will notice and close the session.
+ */
+static void
+_sess_close_transport(netsnmp_transport *transport)
+{
+    transport->f_close(transport);
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_TIMEOUTS);
+    sessions_closing++;
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_TIMEOUTS);
+}
+
+/*
+ * Adds the requests of a session joining the Sessions list to the heap,
+ * or takes those of one leaving it out.  With MT_LIB_SESSION held.
+ */
+static void
+_session_list_requests(struct session_list *slp, int listed)
+{
+    struct snmp_internal_session *isp = slp->internal;
+    netsnmp_request_list *rp;
+
+    sessions_count += listed ? 1 : -1;
+    if (NULL == isp)
+        return;
+    isp->listed = listed;
+    for (rp = isp->requests; rp; rp = rp->next_request) {
+        if (listed)
+            _request_heap_add(rp);
+        else
+            _request_heap_remove(rp);
+    }
+}
+
 /*
  * inserts session into session list
  */
@@ -994,6 +1190,30 @@ void  snmp_session_insert(struct session_list *slp)
     snmp_res_lock(MT_LIBRARY_ID, MT_LIB_SESSION);
     slp->next = Sessions;
     Sessions = slp;
+    _session_list_requests(slp, 1);
+    if (session_list_hook)
+        (*session_list_hook) (slp, 1);
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_SESSION);
+}
+
+/*
+ * Sets the function called with (slp, 1) after a session has been added to
+ * the session list and with (slp, 0) just before one is removed from it and
+ * closed.  This lets an event loop that keeps its own registrations (such
+ * as the epoll one in fd_event_manager.c) follow the list without scanning
+ * it.  A new hook is first called for each session already on the list.
+ * Only one hook is supported; pass NULL to remove it.
+ */
+void
+snmp_set_session_list_hook(void (*hook) (struct session_list *, int))
+{
+    struct session_list *slp;
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_SESSION);
+    session_list_hook = hook;
+    if (hook)
+        for (slp = Sessions; slp; slp = slp->next)
+            (*hook) (slp, 1);
     snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_SESSION);
 }
 
@@ -1934,6 +2154,11 @@ snmp_sess_close(struct session_list *slp)
         return 0;
     }
 
+#ifdef NETSNMP_PARSE_WORKERS
+    if (slp->session && (slp->session->flags & SNMP_FLAGS_PARSE_WORKERS))
+        _parse_workers_forget(slp);
+#endif
+
     if (slp->session != NULL &&
         (sptr = find_sec_mod(slp->session->securityModel)) != NULL &&
         sptr->session_close != NULL) {
@@ -1955,6 +2180,7 @@ snmp_sess_close(struct session_list *slp)
         while (rp) {
             orp = rp;
             rp = rp->next_request;
+            _request_heap_remove(orp);
             if (orp->callback) {
                 orp->callback(NETSNMP_CALLBACK_OP_TIMED_OUT,
                               slp->session, orp->pdu->reqid,
@@ -2022,6 +2248,11 @@ snmp_close(netsnmp_session * session)
                 oslp = slp;
             }
         }
+        if (slp) {
+            _session_list_requests(slp, 0);
+            if (session_list_hook)
+                (*session_list_hook) (slp, 0);
+        }
         snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_SESSION);
     }                           /*END MTCRITICAL_RESOURCE */
     if (slp == NULL) {
@@ -2039,6 +2270,9 @@ snmp_close_sessions(void)
     while (Sessions) {
         slp = Sessions;
         Sessions = Sessions->next;
+        _session_list_requests(slp, 0);
+        if (session_list_hook)
+            (*session_list_hook) (slp, 0);
         snmp_sess_close(slp);
     }
     snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_SESSION);
@@ -4224,6 +4458,162 @@ snmpv3_get_report_type(netsnmp_pdu *pdu)
     return rpt_type;
 }
 
+/*
+ * Completes the processing of an SNMPv3 message once snmpv3_parse() has
+ * returned result for it: reports security errors and answers RFC5343
+ * context engineID probes.  Returns the (possibly updated) result.
+ */
+static int
+_snmpv3_parse_done(struct session_list *slp, netsnmp_session *session,
+                   netsnmp_pdu *pdu, int result)
+{
+    static oid      snmpEngineIDoid[]   = { 1,3,6,1,6,3,10,2,1,1,0};
+    static size_t   snmpEngineIDoid_len = 11;
+
+    static char     ourEngineID[SNMP_SEC_PARAM_BUF_SIZE];
+    static size_t   ourEngineID_len = sizeof(ourEngineID);
+
+    netsnmp_pdu    *pdu2 = NULL;
+
+    DEBUGMSGTL(("snmp_parse",
+                "Parsed SNMPv3 message (secName:%s, secLevel:%s): %s\n",
+                pdu->securityName, secLevelName[pdu->securityLevel],
+                snmp_api_errstring(result)));
+
+    if (result) {
+        struct snmp_secmod_def *secmod =
+            find_sec_mod(pdu->securityModel);
+        if (!slp) {
+            session->s_snmp_errno = result;
+        } else {
+            /*
+             * Call the security model to special handle any errors
+             */
+
+            if (secmod && secmod->handle_report) {
+                (*secmod->handle_report)(slp, slp->transport, session,
+                                         result, pdu);
+            }
+        }
+        free_securityStateRef(pdu);
+    }
+
+    /* Implement RFC5343 here for two reasons:
+       1) From a security perspective it handles this otherwise
+          always approved request earlier.  It bypasses the need
+          for authorization to the snmpEngineID scalar, which is
+          what is what RFC3415 appendix A species as ok.  Note
+          that we haven't bypassed authentication since if there
+          was an authentication eror it would have been handled
+          above in the if(result) part at the lastet.
+       2) From an application point of view if we let this request
+          get all the way to the application, it'd require that
+          all application types supporting discovery also fire up
+          a minimal agent in order to handle just this request
+          which seems like overkill.  Though there is no other
+          application types that currently need discovery (NRs
+          accept notifications from contextEngineIDs that derive
+          from the NO not the NR).  Also a lame excuse for doing
+          it here.
+       3) Less important technically, but the net-snmp agent
+          doesn't currently handle registrations of different
+          engineIDs either and it would have been a lot more work
+          to implement there since we'd need to support that
+          first. :-/ Supporting multiple context engineIDs should
+          be done anyway, so it's not a valid excuse here.
+       4) There is a lot less to do if we trump the agent at this
+          point; IE, the agent does a lot more unnecessary
+          processing when the only thing that should ever be in
+          this context by definition is the single scalar.
+    */
+
+    /* special RFC5343 engineID discovery engineID check */
+    if (!netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID,
+                                NETSNMP_DS_LIB_NO_DISCOVERY) &&
+        SNMP_MSG_RESPONSE       != pdu->command &&
+        NULL                    != pdu->contextEngineID &&
+        pdu->contextEngineIDLen == 5 &&
+        pdu->contextEngineID[0] == 0x80 &&
+        pdu->contextEngineID[1] == 0x00 &&
+        pdu->contextEngineID[2] == 0x00 &&
+        pdu->contextEngineID[3] == 0x00 &&
+        pdu->contextEngineID[4] == 0x06) {
+
+        /* define a result so it doesn't get past us at this point
+           and gets dropped by future parts of the stack */
+        result = SNMPERR_JUST_A_CONTEXT_PROBE;
+
+        DEBUGMSGTL(("snmpv3_contextid", "starting context ID discovery\n"));
+        /* ensure exactly one variable */
+        if (NULL != pdu->variables &&
+            NULL == pdu->variables->next_variable &&
+
+            /* if it's a GET, match it exactly */
+            ((SNMP_MSG_GET == pdu->command &&
+              snmp_oid_compare(snmpEngineIDoid,
+                               snmpEngineIDoid_len,
+                               pdu->variables->name,
+                               pdu->variables->name_length) == 0)
+             /* if it's a GETNEXT ensure it's less than the engineID oid */
+             ||
+             (SNMP_MSG_GETNEXT == pdu->command &&
+              snmp_oid_compare(snmpEngineIDoid,
+                               snmpEngineIDoid_len,
+                               pdu->variables->name,
+                               pdu->variables->name_length) > 0)
+                )) {
+
+            DEBUGMSGTL(("snmpv3_contextid",
+                        "  One correct variable found\n"));
+
+            /* Note: we're explictly not handling a GETBULK.  Deal. */
+
+            /* set up the response */
+            pdu2 = snmp_clone_pdu(pdu);
+
+            /* free the current varbind */
+            snmp_free_varbind(pdu2->variables);
+
+            /* set the variables */
+            pdu2->variables = NULL;
+            pdu2->command = SNMP_MSG_RESPONSE;
+            pdu2->errstat = 0;
+            pdu2->errindex = 0;
+
+            ourEngineID_len =
+                snmpv3_get_engineID((u_char*)ourEngineID, ourEngineID_len);
+            if (0 != ourEngineID_len) {
+
+                DEBUGMSGTL(("snmpv3_contextid",
+                            "  responding with our engineID\n"));
+
+                snmp_pdu_add_variable(pdu2,
+                                      snmpEngineIDoid, snmpEngineIDoid_len,
+                                      ASN_OCTET_STR,
+                                      ourEngineID, ourEngineID_len);
+                
+                /* send the response */
+                if (0 == snmp_sess_send(slp, pdu2)) {
+
+                    DEBUGMSGTL(("snmpv3_contextid",
+                                "  sent it off!\n"));
+
+                    snmp_free_pdu(pdu2);
+                    
+                    snmp_log(LOG_ERR, "sending a response to the context engineID probe failed\n");
+                }
+            } else {
+                snmp_log(LOG_ERR, "failed to get our own engineID!\n");
+            }
+        } else {
+            snmp_log(LOG_WARNING,
+                     "received an odd context engineID probe\n");
+        }
+    }
+
+    return result;
+}
+
 /*
  * Parses the packet received on the input session, and places the data into
  * the input pdu.  length is the length of the input packet.
@@ -4241,14 +4631,6 @@ _snmp_parse(struct session_list *slp,
 #endif
     int             result = -1;
 
-    static oid      snmpEngineIDoid[]   = { 1,3,6,1,6,3,10,2,1,1,0};
-    static size_t   snmpEngineIDoid_len = 11;
-
-    static char     ourEngineID[SNMP_SEC_PARAM_BUF_SIZE];
-    static size_t   ourEngineID_len = sizeof(ourEngineID);
-
-    netsnmp_pdu    *pdu2 = NULL;
-
     session->s_snmp_errno = 0;
     session->s_errno = 0;
 
@@ -4345,142 +4727,7 @@ _snmp_parse(struct session_list *slp,
     case SNMP_VERSION_3:
         NETSNMP_RUNTIME_PROTOCOL_CHECK_V3(SNMP_VERSION_3,unsupported_version);
         result = snmpv3_parse(pdu, data, &length, NULL, session);
-        DEBUGMSGTL(("snmp_parse",
-                    "Parsed SNMPv3 message (secName:%s, secLevel:%s): %s\n",
-                    pdu->securityName, secLevelName[pdu->securityLevel],
-                    snmp_api_errstring(result)));
-
-        if (result) {
-            struct snmp_secmod_def *secmod =
-                find_sec_mod(pdu->securityModel);
-            if (!slp) {
-                session->s_snmp_errno = result;
-            } else {
-                /*
-                 * Call the security model to special handle any errors
-                 */
-
-                if (secmod && secmod->handle_report) {
-                    (*secmod->handle_report)(slp, slp->transport, session,
-                                             result, pdu);
-                }
-            }
-            free_securityStateRef(pdu);
-        }
-
-        /* Implement RFC5343 here for two reasons:
-           1) From a security perspective it handles this otherwise
-              always approved request earlier.  It bypasses the need
-              for authorization to the snmpEngineID scalar, which is
-              what is what RFC3415 appendix A species as ok.  Note
-              that we haven't bypassed authentication since if there
-              was an authentication eror it would have been handled
-              above in the if(result) part at the lastet.
-           2) From an application point of view if we let this request
-              get all the way to the application, it'd require that
-              all application types supporting discovery also fire up
-              a minimal agent in order to handle just this request
-              which seems like overkill.  Though there is no other
-              application types that currently need discovery (NRs
-              accept notifications from contextEngineIDs that derive
-              from the NO not the NR).  Also a lame excuse for doing
-              it here.
-           3) Less important technically, but the net-snmp agent
-              doesn't currently handle registrations of different
-              engineIDs either and it would have been a lot more work
-              to implement there since we'd need to support that
-              first. :-/ Supporting multiple context engineIDs should
-              be done anyway, so it's not a valid excuse here.
-           4) There is a lot less to do if we trump the agent at this
-              point; IE, the agent does a lot more unnecessary
-              processing when the only thing that should ever be in
-              this context by definition is the single scalar.
-        */
-
-        /* special RFC5343 engineID discovery engineID check */
-        if (!netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID,
-                                    NETSNMP_DS_LIB_NO_DISCOVERY) &&
-            SNMP_MSG_RESPONSE       != pdu->command &&
-            NULL                    != pdu->contextEngineID &&
-            pdu->contextEngineIDLen == 5 &&
-            pdu->contextEngineID[0] == 0x80 &&
-            pdu->contextEngineID[1] == 0x00 &&
-            pdu->contextEngineID[2] == 0x00 &&
-            pdu->contextEngineID[3] == 0x00 &&
-            pdu->contextEngineID[4] == 0x06) {
-
-            /* define a result so it doesn't get past us at this point
-               and gets dropped by future parts of the stack */
-            result = SNMPERR_JUST_A_CONTEXT_PROBE;
-
-            DEBUGMSGTL(("snmpv3_contextid", "starting context ID discovery\n"));
-            /* ensure exactly one variable */
-            if (NULL != pdu->variables &&
-                NULL == pdu->variables->next_variable &&
-
-                /* if it's a GET, match it exactly */
-                ((SNMP_MSG_GET == pdu->command &&
-                  snmp_oid_compare(snmpEngineIDoid,
-                                   snmpEngineIDoid_len,
-                                   pdu->variables->name,
-                                   pdu->variables->name_length) == 0)
-                 /* if it's a GETNEXT ensure it's less than the engineID oid */
-                 ||
-                 (SNMP_MSG_GETNEXT == pdu->command &&
-                  snmp_oid_compare(snmpEngineIDoid,
-                                   snmpEngineIDoid_len,
-                                   pdu->variables->name,
-                                   pdu->variables->name_length) > 0)
-                    )) {
-
-                DEBUGMSGTL(("snmpv3_contextid",
-                            "  One correct variable found\n"));
-
-                /* Note: we're explictly not handling a GETBULK.  Deal. */
-
-                /* set up the response */
-                pdu2 = snmp_clone_pdu(pdu);
-
-                /* free the current varbind */
-                snmp_free_varbind(pdu2->variables);
-
-                /* set the variables */
-                pdu2->variables = NULL;
-                pdu2->command = SNMP_MSG_RESPONSE;
-                pdu2->errstat = 0;
-                pdu2->errindex = 0;
-
-                ourEngineID_len =
-                    snmpv3_get_engineID((u_char*)ourEngineID, ourEngineID_len);
-                if (0 != ourEngineID_len) {
-
-                    DEBUGMSGTL(("snmpv3_contextid",
-                                "  responding with our engineID\n"));
-
-                    snmp_pdu_add_variable(pdu2,
-                                          snmpEngineIDoid, snmpEngineIDoid_len,
-                                          ASN_OCTET_STR,
-                                          ourEngineID, ourEngineID_len);
-                    
-                    /* send the response */
-                    if (0 == snmp_sess_send(slp, pdu2)) {
-
-                        DEBUGMSGTL(("snmpv3_contextid",
-                                    "  sent it off!\n"));
-
-                        snmp_free_pdu(pdu2);
-                        
-                        snmp_log(LOG_ERR, "sending a response to the context engineID probe failed\n");
-                    }
-                } else {
-                    snmp_log(LOG_ERR, "failed to get our own engineID!\n");
-                }
-            } else {
-                snmp_log(LOG_WARNING,
-                         "received an odd context engineID probe\n");
-            }
-        }
-
+        result = _snmpv3_parse_done(slp, session, pdu, result);
         break;
     case SNMPERR_BAD_VERSION:
         ERROR_MSG("error parsing snmp message version");
@@ -4538,6 +4785,13 @@ snmp_parse(struct session_list *slp, netsnmp_session *pss,
     return rc;
 }
 
+/*
+ * With zeroCopyVarbinds set, string values too large for the built-in
+ * buffer of their variable point into a single copy of the varbind list
+ * (a netsnmp_rxbuf) that is shared by all the variables of the PDU,
+ * instead of each being copied into memory of its own.  The copy is freed
+ * along with the last variable that refers to it.
+ */
 int
 snmp_pdu_parse(netsnmp_pdu *pdu, u_char * data, size_t * length)
 {
@@ -4549,6 +4803,11 @@ snmp_pdu_parse(netsnmp_pdu *pdu, u_char * data, size_t * length)
     netsnmp_variable_list *vp = NULL, *vplast = NULL;
     oid             objid[MAX_OID_LEN];
     u_char         *p;
+    u_char         *varbinds_end, *rxbuf_base = NULL;
+    netsnmp_rxbuf  *rxbuf = NULL;
+    int             zero_copy =
+        netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID,
+                               NETSNMP_DS_LIB_ZERO_COPY_VARBINDS);
 
     /*
      * Get the PDU type 
@@ -4683,12 +4942,13 @@ snmp_pdu_parse(netsnmp_pdu *pdu, u_char * data, size_t * length)
                               "varbinds");
     if (data == NULL)
         goto fail;
+    varbinds_end = data + *length;
 
     /*
      * get each varBind sequence 
      */
     while ((int) *length > 0) {
-        vp = SNMP_MALLOC_TYPEDEF(netsnmp_variable_list);
+        vp = netsnmp_varbind_alloc();
         if (NULL == vp)
             goto fail;
 
@@ -4773,6 +5033,30 @@ snmp_pdu_parse(netsnmp_pdu *pdu, u_char * data, size_t * length)
         case ASN_OCTET_STR:
         case ASN_OPAQUE:
         case ASN_NSAP:
+            if (vp->val_len >= sizeof(vp->buf) && zero_copy) {
+                if (NULL == rxbuf) {
+                    /*
+                     * everything from here on will be in the copy
+                     */
+                    rxbuf_base = var_val;
+                    rxbuf = netsnmp_rxbuf_create(var_val,
+                                                 varbinds_end - var_val);
+                    if (NULL == rxbuf)
+                        goto fail;
+                    DEBUGMSGTL(("snmp_pdu_parse",
+                                "sharing %" NETSNMP_PRIz "d bytes of varbinds\n",
+                                rxbuf->len));
+                }
+                len = rxbuf->len - (var_val - rxbuf_base);
+                p = asn_parse_string_ref(rxbuf->data + (var_val - rxbuf_base),
+                                         &len, &vp->type, &vp->val.string,
+                                         &vp->val_len);
+                if (!p)
+                    goto fail;
+                rxbuf->refcount++;
+                vp->val_rxbuf = rxbuf;
+                break;
+            }
             if (vp->val_len < sizeof(vp->buf)) {
                 vp->val.string = (u_char *) vp->buf;
             } else {
@@ -4792,9 +5076,14 @@ snmp_pdu_parse(netsnmp_pdu *pdu, u_char * data, size_t * length)
             if (!p)
                 goto fail;
             vp->val_len *= sizeof(oid);
-            vp->val.objid = netsnmp_memdup(objid, vp->val_len);
-            if (vp->val.objid == NULL)
-                goto fail;
+            if (vp->val_len <= sizeof(vp->buf)) {
+                vp->val.objid = (oid *) vp->buf;
+                memmove(vp->val.objid, objid, vp->val_len);
+            } else {
+                vp->val.objid = netsnmp_memdup(objid, vp->val_len);
+                if (vp->val.objid == NULL)
+                    goto fail;
+            }
             break;
         case SNMP_NOSUCHOBJECT:
         case SNMP_NOSUCHINSTANCE:
@@ -4833,6 +5122,9 @@ snmp_pdu_parse(netsnmp_pdu *pdu, u_char * data, size_t * length)
         const char *errstr = snmp_api_errstring(SNMPERR_SUCCESS);
         DEBUGMSGTL(("recv", "error while parsing VarBindList:%s\n", errstr));
     }
+    /** drop the shared copy if no variable got to use it */
+    if (rxbuf && rxbuf->refcount == 0)
+        free(rxbuf);
     /** if we were parsing a var, remove it from the pdu and free it */
     if (vp)
         snmp_free_var(vp);
@@ -5340,12 +5632,12 @@ _sess_async_send(struct session_list *slp,
         netsnmp_request_list *rp;
         struct timeval  tv;
 
-        rp = (netsnmp_request_list *) calloc(1,
-                                             sizeof(netsnmp_request_list));
+        rp = (netsnmp_request_list *) calloc(1, sizeof(request_entry));
         if (rp == NULL) {
             session->s_snmp_errno = SNMPERR_GENERR;
             return 0;
         }
+        ((request_entry *) rp)->heap_index = -1;
 
         netsnmp_get_monotonic_clock(&tv);
         rp->pdu = pdu;
@@ -5378,6 +5670,8 @@ _sess_async_send(struct session_list *slp,
             isp->requests = rp;
             isp->requestsEnd = rp;
         }
+        if (isp->listed)
+            _request_heap_add(rp);
         snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_SESSION);
     } else {
         /*
@@ -5429,6 +5723,139 @@ snmp_sess_async_send(struct session_list *slp,
 }
 
 
+/*
+ * Free lists of PDU and varbind structures, so that a steady stream of
+ * requests does not call malloc() and free() for each of them.  A list
+ * keeps at most pduPoolSize/varbindPoolSize entries (0 selects the
+ * default below, a negative value disables the pool); anything beyond
+ * that goes back to free().  Pooled structures are plain malloc()ed
+ * memory, so code that still allocates or releases them by hand mixes
+ * freely with the pools.
+ */
+#ifndef NETSNMP_PDU_POOL_DEFAULT
+#define NETSNMP_PDU_POOL_DEFAULT     32
+#endif
+#ifndef NETSNMP_VARBIND_POOL_DEFAULT
+#define NETSNMP_VARBIND_POOL_DEFAULT 512
+#endif
+
+struct netsnmp_pool_entry_s {
+    struct netsnmp_pool_entry_s *next;
+};
+
+typedef struct netsnmp_pool_s {
+    struct netsnmp_pool_entry_s *free_list;
+    int             count;
+    size_t          size;
+    int             ds_max;     /* library integer holding the limit */
+    int             def_max;
+    int             hit_stat, miss_stat;
+} netsnmp_pool;
+
+static netsnmp_pool pdu_pool = {
+    NULL, 0, sizeof(netsnmp_pdu), NETSNMP_DS_LIB_PDU_POOL_SIZE,
+    NETSNMP_PDU_POOL_DEFAULT, STAT_POOL_PDU_HITS, STAT_POOL_PDU_MISSES
+};
+static netsnmp_pool varbind_pool = {
+    NULL, 0, sizeof(netsnmp_variable_list), NETSNMP_DS_LIB_VARBIND_POOL_SIZE,
+    NETSNMP_VARBIND_POOL_DEFAULT, STAT_POOL_VARBIND_HITS,
+    STAT_POOL_VARBIND_MISSES
+};
+
+static void    *
+_pool_get(netsnmp_pool *pool)
+{
+    struct netsnmp_pool_entry_s *entry;
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_POOL);
+    entry = pool->free_list;
+    if (entry) {
+        pool->free_list = entry->next;
+        pool->count--;
+        snmp_increment_statistic(pool->hit_stat);
+    } else
+        snmp_increment_statistic(pool->miss_stat);
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_POOL);
+
+    if (NULL == entry)
+        return calloc(1, pool->size);
+    memset(entry, 0, pool->size);
+    return entry;
+}
+
+static void
+_pool_put(netsnmp_pool *pool, void *ptr)
+{
+    struct netsnmp_pool_entry_s *entry = (struct netsnmp_pool_entry_s *) ptr;
+    int             max;
+
+    if (NULL == ptr)
+        return;
+    max = netsnmp_ds_get_int(NETSNMP_DS_LIBRARY_ID, pool->ds_max);
+    if (0 == max)
+        max = pool->def_max;
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_POOL);
+    if (pool->count < max) {
+        entry->next = pool->free_list;
+        pool->free_list = entry;
+        pool->count++;
+        entry = NULL;
+    }
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_POOL);
+
+    free(entry);
+}
+
+static void
+_pool_drain(netsnmp_pool *pool)
+{
+    struct netsnmp_pool_entry_s *entry;
+
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_POOL);
+    while ((entry = pool->free_list) != NULL) {
+        pool->free_list = entry->next;
+        free(entry);
+    }
+    pool->count = 0;
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_POOL);
+}
+
+static void
+_pools_shutdown(void)
+{
+#ifndef NETSNMP_FEATURE_REMOVE_STATISTICS
+    DEBUGMSGTL(("snmp_api:pool",
+                "pdu %u hits %u misses, varbind %u hits %u misses\n",
+                snmp_get_statistic(STAT_POOL_PDU_HITS),
+                snmp_get_statistic(STAT_POOL_PDU_MISSES),
+                snmp_get_statistic(STAT_POOL_VARBIND_HITS),
+                snmp_get_statistic(STAT_POOL_VARBIND_MISSES)));
+#endif /* NETSNMP_FEATURE_REMOVE_STATISTICS */
+    _pool_drain(&pdu_pool);
+    _pool_drain(&varbind_pool);
+}
+
+/**
+ * Returns a zeroed PDU structure, from the PDU pool if it has one.
+ * Release it with snmp_free_pdu().
+ */
+netsnmp_pdu    *
+netsnmp_pdu_alloc(void)
+{
+    return (netsnmp_pdu *) _pool_get(&pdu_pool);
+}
+
+/**
+ * Returns a zeroed varbind structure, from the varbind pool if it has
+ * one.  Release it with snmp_free_var().
+ */
+netsnmp_variable_list *
+netsnmp_varbind_alloc(void)
+{
+    return (netsnmp_variable_list *) _pool_get(&varbind_pool);
+}
+
 /*
  * Frees the variable and any malloc'd data associated with it.
  */
@@ -5440,8 +5867,8 @@ snmp_free_var_internals(netsnmp_variable_list * var)
 
     if (var->name != var->name_loc)
         SNMP_FREE(var->name);
-    if (var->val.string != var->buf)
-        SNMP_FREE(var->val.string);
+    if (var->val.string != var->buf || var->val_rxbuf)
+        netsnmp_var_release_value(var);
     if (var->data) {
         if (var->dataFreeHook) {
             var->dataFreeHook(var->data);
@@ -5456,7 +5883,7 @@ void
 snmp_free_var(netsnmp_variable_list * var)
 {
     snmp_free_var_internals(var);
-    free((char *) var);
+    _pool_put(&varbind_pool, var);
 }
 
 void
@@ -5495,14 +5922,14 @@ snmp_free_pdu(netsnmp_pdu *pdu)
     free(pdu->contextName);
     free(pdu->securityName);
     free(pdu->transport_data);
-    free(pdu);
+    _pool_put(&pdu_pool, pdu);
 }
 
 netsnmp_pdu    *
 snmp_create_sess_pdu(netsnmp_transport *transport, void *opaque,
                      size_t olength)
 {
-    netsnmp_pdu *pdu = (netsnmp_pdu *)calloc(1, sizeof(netsnmp_pdu));
+    netsnmp_pdu *pdu = netsnmp_pdu_alloc();
     if (pdu == NULL) {
         DEBUGMSGTL(("sess_process_packet", "can't malloc space for PDU\n"));
         return NULL;
@@ -5522,17 +5949,17 @@ snmp_create_sess_pdu(netsnmp_transport *transport, void *opaque,
 
 
 /*
- * This function parses a packet into a PDU
+ * This function filters a received packet and creates the PDU it is to be
+ * parsed into
  */
 static netsnmp_pdu *
-_sess_process_packet_parse_pdu(struct session_list *slp, netsnmp_session * sp,
-                               struct snmp_internal_session *isp,
-                               netsnmp_transport *transport,
-                               void *opaque, int olength,
-                               u_char * packetptr, int length)
+_sess_process_packet_create_pdu(struct session_list *slp, netsnmp_session * sp,
+                                struct snmp_internal_session *isp,
+                                netsnmp_transport *transport,
+                                void *opaque, int olength,
+                                u_char * packetptr, int length)
 {
   netsnmp_pdu    *pdu;
-  int             ret = 0;
   int             dump = 0, filter = 0;
 
   debug_indent_reset();
@@ -5615,12 +6042,18 @@ _sess_process_packet_parse_pdu(struct session_list *slp, netsnmp_session * sp,
       pdu->flags |= UCD_MSG_FLAG_TUNNELED;
   }
 
-  if (isp->hook_parse) {
-    ret = isp->hook_parse(sp, pdu, packetptr, length);
-  } else {
-    ret = snmp_parse(slp, sp, pdu, packetptr, length);
-  }
+  return pdu;
+}
 
+/*
+ * This function finishes a PDU whose packet was parsed with result ret.
+ * The PDU is freed and NULL returned if parsing failed.
+ */
+static netsnmp_pdu *
+_sess_process_packet_parse_done(struct session_list *slp, netsnmp_session * sp,
+                                struct snmp_internal_session *isp,
+                                netsnmp_pdu *pdu, int length, int ret)
+{
   DEBUGMSGTL(("sess_process_packet", "received message id#%ld reqid#%ld len "
               "%u\n", pdu->msgid, pdu->reqid, length));
 
@@ -5643,6 +6076,33 @@ _sess_process_packet_parse_pdu(struct session_list *slp, netsnmp_session * sp,
   return pdu;
 }
 
+/*
+ * This function parses a packet into a PDU
+ */
+static netsnmp_pdu *
+_sess_process_packet_parse_pdu(struct session_list *slp, netsnmp_session * sp,
+                               struct snmp_internal_session *isp,
+                               netsnmp_transport *transport,
+                               void *opaque, int olength,
+                               u_char * packetptr, int length)
+{
+  netsnmp_pdu    *pdu;
+  int             ret;
+
+  pdu = _sess_process_packet_create_pdu(slp, sp, isp, transport, opaque,
+                                        olength, packetptr, length);
+  if (pdu == NULL)
+    return NULL;
+
+  if (isp->hook_parse) {
+    ret = isp->hook_parse(sp, pdu, packetptr, length);
+  } else {
+    ret = snmp_parse(slp, sp, pdu, packetptr, length);
+  }
+
+  return _sess_process_packet_parse_done(slp, sp, isp, pdu, length, ret);
+}
+
 /* Remove request @rp from session @isp. @orp is the request before @rp. */
 static void
 remove_request(struct snmp_internal_session *isp,
@@ -5654,6 +6114,7 @@ remove_request(struct snmp_internal_session *isp,
         isp->requests = rp->next_request;
     if (isp->requestsEnd == rp)
         isp->requestsEnd = orp;
+    _request_heap_remove(rp);
     snmp_free_pdu(rp->pdu);
 }
 
@@ -5825,6 +6286,406 @@ _sess_process_packet_handle_pdu(struct session_list *slp, netsnmp_session * sp,
   return 0;
 }
 
+static int      _sess_process_packet_dispatch(struct session_list *slp,
+                                              netsnmp_session * sp,
+                                              struct snmp_internal_session
+                                              *isp,
+                                              netsnmp_transport *transport,
+                                              netsnmp_pdu *pdu);
+
+#ifdef NETSNMP_PARSE_WORKERS
+
+/*
+ * Optional pool of threads that parse the datagrams received by sessions
+ * flagged SNMP_FLAGS_PARSE_WORKERS, taking the SNMPv3 security processing
+ * (usm_process_in_msg(), i.e. authentication and decryption) off the main
+ * thread.  The main thread still receives each datagram, filters it and
+ * creates its PDU, and it still reports security errors and runs the
+ * session callbacks once the worker is done.
+ *
+ * Every source address is always served by the same worker, and the
+ * parsed PDUs come back through a single FIFO, so the datagrams of one
+ * source reach the callbacks in the order they arrived.  Community based
+ * messages take the same path (they are parsed on the main thread) for
+ * the sake of that ordering.
+ *
+ * The USM user list is only read by the workers; applications must shut
+ * the pool down around anything that reconfigures it.
+ */
+typedef struct parse_worker_job_s {
+    netsnmp_done_item done;     /* must be first */
+    struct session_list *slp;
+    netsnmp_pdu    *pdu;
+    u_char         *packet;
+    size_t          length;
+    int             result;
+    int             decoded;
+    struct parse_worker_job_s *next;
+} parse_worker_job;
+
+typedef struct parse_worker_s {
+    pthread_t       thread;
+    pthread_cond_t  cond;
+    parse_worker_job *todo_head;
+    parse_worker_job *todo_tail;
+    parse_worker_job *busy;
+} parse_worker;
+
+static parse_worker *_parse_workers = NULL;
+static int      _parse_workers_count = 0;
+static int      _parse_workers_stop = 0;
+static pthread_mutex_t _parse_workers_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _parse_workers_idle = PTHREAD_COND_INITIALIZER;
+static netsnmp_done_queue _parse_workers_done =
+    NETSNMP_DONE_QUEUE_INITIALIZER;
+
+static void
+_parse_workers_free_job(parse_worker_job *job)
+{
+    snmp_free_pdu(job->pdu);
+    free(job->packet);
+    free(job);
+}
+
+/*
+ * worker thread: the part of _snmp_parse() that needs no session state
+ */
+static void
+_parse_worker_decode(parse_worker_job *job)
+{
+    netsnmp_session *sp = job->slp->session;
+    size_t          length = job->length;
+
+    if (sp->version == SNMP_DEFAULT_VERSION) {
+        if (snmp_parse_version(job->packet, length) != SNMP_VERSION_3)
+            return;
+    } else if (sp->version != SNMP_VERSION_3)
+        return;
+    if (NETSNMP_RUNTIME_PROTOCOL_SKIP_V3(SNMP_VERSION_3))
+        return;
+
+    job->pdu->version = SNMP_VERSION_3;
+    job->result = snmpv3_parse(job->pdu, job->packet, &length, NULL, sp);
+    job->decoded = 1;
+}
+
+static void    *
+_parse_worker_run(void *arg)
+{
+    parse_worker   *w = (parse_worker *) arg;
+    parse_worker_job *job;
+
+    for (;;) {
+        pthread_mutex_lock(&_parse_workers_lock);
+        while (NULL == w->todo_head && !_parse_workers_stop)
+            pthread_cond_wait(&w->cond, &_parse_workers_lock);
+        job = w->todo_head;
+        if (NULL == job) {
+            /*
+             * stopping, and nothing left to do
+             */
+            pthread_mutex_unlock(&_parse_workers_lock);
+            break;
+        }
+        w->todo_head = job->next;
+        if (NULL == w->todo_head)
+            w->todo_tail = NULL;
+        w->busy = job;
+        pthread_mutex_unlock(&_parse_workers_lock);
+
+        _parse_worker_decode(job);
+
+        /*
+         * queued before it stops being busy, so that
+         * _parse_workers_forget() always finds it somewhere
+         */
+        netsnmp_done_queue_push(&_parse_workers_done, &job->done);
+
+        pthread_mutex_lock(&_parse_workers_lock);
+        w->busy = NULL;
+        pthread_cond_broadcast(&_parse_workers_idle);
+        pthread_mutex_unlock(&_parse_workers_lock);
+    }
+    return NULL;
+}
+
+/*
+ * main thread: finish off what _sess_process_packet() would have done
+ */
+static void
+_parse_workers_finish(parse_worker_job *job)
+{
+    struct session_list *slp = job->slp;
+    netsnmp_session *sp = slp->session;
+    struct snmp_internal_session *isp = slp->internal;
+    netsnmp_pdu    *pdu = job->pdu;
+    int             ret;
+
+    job->pdu = NULL;
+    if (job->decoded) {
+        sp->s_snmp_errno = 0;
+        sp->s_errno = 0;
+        pdu->transid = snmp_get_next_transid();
+        ret = _snmpv3_parse_done(slp, sp, pdu, job->result);
+        if (ret) {
+            if (!sp->s_snmp_errno)
+                sp->s_snmp_errno = SNMPERR_BAD_PARSE;
+            SET_SNMP_ERROR(sp->s_snmp_errno);
+        }
+    } else {
+        ret = snmp_parse(slp, sp, pdu, job->packet, job->length);
+    }
+
+    pdu = _sess_process_packet_parse_done(slp, sp, isp, pdu, job->length,
+                                          ret);
+    if (pdu)
+        _sess_process_packet_dispatch(slp, sp, isp, slp->transport, pdu);
+    _parse_workers_free_job(job);
+}
+
+/*
+ * main thread: hand a received datagram to the worker serving its source
+ */
+static int
+_parse_workers_queue(struct session_list *slp, netsnmp_session * sp,
+                     struct snmp_internal_session *isp,
+                     netsnmp_transport *transport,
+                     void *opaque, int olength,
+                     u_char * packetptr, int length)
+{
+    netsnmp_pdu    *pdu;
+    parse_worker_job *job;
+    parse_worker   *w;
+    int             ret;
+
+    pdu = _sess_process_packet_create_pdu(slp, sp, isp, transport, opaque,
+                                          olength, packetptr, length);
+    if (NULL == pdu)
+        return -1;
+
+    job = SNMP_MALLOC_TYPEDEF(parse_worker_job);
+    if (job)
+        job->packet = netsnmp_memdup(packetptr, length);
+    if (NULL == job || NULL == job->packet) {
+        SNMP_FREE(job);
+        ret = snmp_parse(slp, sp, pdu, packetptr, length);
+        pdu = _sess_process_packet_parse_done(slp, sp, isp, pdu, length, ret);
+        if (NULL == pdu)
+            return -1;
+        return _sess_process_packet_dispatch(slp, sp, isp, transport, pdu);
+    }
+    job->slp = slp;
+    job->pdu = pdu;
+    job->length = length;
+
+    w = &_parse_workers[(pdu->transport_data ?
+                         netsnmp_hash_buf(pdu->transport_data,
+                                          pdu->transport_data_length,
+                                          NETSNMP_HASH_INIT) : 0) %
+                        _parse_workers_count];
+
+    pthread_mutex_lock(&_parse_workers_lock);
+    if (w->todo_tail)
+        w->todo_tail->next = job;
+    else
+        w->todo_head = job;
+    w->todo_tail = job;
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&_parse_workers_lock);
+
+    return 0;
+}
+
+static int
+_parse_workers_done_match(netsnmp_done_item *item, void *slp)
+{
+    return ((parse_worker_job *) item)->slp == slp;
+}
+
+static void
+_parse_workers_done_free(netsnmp_done_item *item)
+{
+    _parse_workers_free_job((parse_worker_job *) item);
+}
+
+static void
+_parse_workers_purge(parse_worker_job **head, parse_worker_job **tail,
+                     struct session_list *slp)
+{
+    parse_worker_job *job, *prev = NULL;
+
+    while ((job = (prev ? prev->next : *head)) != NULL) {
+        if (job->slp != slp) {
+            prev = job;
+            continue;
+        }
+        if (prev)
+            prev->next = job->next;
+        else
+            *head = job->next;
+        if (*tail == job)
+            *tail = prev;
+        _parse_workers_free_job(job);
+    }
+}
+
+/*
+ * main thread: drop whatever the pool still holds for a closing session
+ */
+static void
+_parse_workers_forget(struct session_list *slp)
+{
+    int             i, busy;
+
+    if (0 == _parse_workers_count && NULL == _parse_workers_done.head)
+        return;
+
+    pthread_mutex_lock(&_parse_workers_lock);
+    do {
+        busy = 0;
+        for (i = 0; i < _parse_workers_count; i++)
+            if (_parse_workers[i].busy && _parse_workers[i].busy->slp == slp)
+                busy = 1;
+        if (busy)
+            pthread_cond_wait(&_parse_workers_idle, &_parse_workers_lock);
+    } while (busy);
+    for (i = 0; i < _parse_workers_count; i++)
+        _parse_workers_purge(&_parse_workers[i].todo_head,
+                             &_parse_workers[i].todo_tail, slp);
+    pthread_mutex_unlock(&_parse_workers_lock);
+    netsnmp_done_queue_purge(&_parse_workers_done, _parse_workers_done_match,
+                             slp, _parse_workers_done_free);
+}
+
+/**
+ * Starts count threads parsing the datagrams of the sessions flagged
+ * SNMP_FLAGS_PARSE_WORKERS.  Threads do not survive fork(), so daemons
+ * should call this once they are in the background.
+ *
+ * @return the number of threads running.
+ */
+int
+netsnmp_parse_workers_init(int count)
+{
+    int             i;
+
+    if (count <= 0 || _parse_workers_count > 0)
+        return _parse_workers_count;
+
+    if (!netsnmp_done_queue_open(&_parse_workers_done))
+        return 0;
+
+    _parse_workers = (parse_worker *) calloc(count, sizeof(parse_worker));
+    if (NULL == _parse_workers)
+        goto fail;
+    _parse_workers_stop = 0;
+    for (i = 0; i < count; i++) {
+        pthread_cond_init(&_parse_workers[i].cond, NULL);
+        if (pthread_create(&_parse_workers[i].thread, NULL,
+                           _parse_worker_run, &_parse_workers[i]) != 0) {
+            pthread_cond_destroy(&_parse_workers[i].cond);
+            snmp_log(LOG_ERR, "parse workers: could only start %d of %d "
+                     "threads\n", i, count);
+            break;
+        }
+    }
+    _parse_workers_count = i;
+    if (0 == _parse_workers_count)
+        goto fail;
+    DEBUGMSGTL(("snmp_api:workers", "started %d parse threads\n",
+                _parse_workers_count));
+    return _parse_workers_count;
+
+  fail:
+    netsnmp_done_queue_close(&_parse_workers_done);
+    SNMP_FREE(_parse_workers);
+    return 0;
+}
+
+/**
+ * Stops the parse threads once they have worked through their queues,
+ * and hands the last parsed PDUs to their sessions.
+ */
+void
+netsnmp_parse_workers_shutdown(void)
+{
+    int             i, count = _parse_workers_count;
+
+    if (0 == count)
+        return;
+
+    pthread_mutex_lock(&_parse_workers_lock);
+    _parse_workers_stop = 1;
+    for (i = 0; i < count; i++)
+        pthread_cond_signal(&_parse_workers[i].cond);
+    pthread_mutex_unlock(&_parse_workers_lock);
+    for (i = 0; i < count; i++) {
+        pthread_join(_parse_workers[i].thread, NULL);
+        pthread_cond_destroy(&_parse_workers[i].cond);
+    }
+    _parse_workers_count = 0;
+    SNMP_FREE(_parse_workers);
+
+    netsnmp_parse_workers_run();
+
+    netsnmp_done_queue_close(&_parse_workers_done);
+    _parse_workers_stop = 0;
+    DEBUGMSGTL(("snmp_api:workers", "stopped %d parse threads\n", count));
+}
+
+/**
+ * @return the descriptor that becomes readable when parsed PDUs are
+ * waiting for netsnmp_parse_workers_run(), or -1 without a pool.
+ */
+int
+netsnmp_parse_workers_fd(void)
+{
+    return _parse_workers_done.fd[0];
+}
+
+/**
+ * Hands the PDUs parsed by the worker threads to their sessions.
+ */
+void
+netsnmp_parse_workers_run(void)
+{
+    parse_worker_job *job;
+
+    netsnmp_done_queue_ack(&_parse_workers_done);
+
+    /*
+     * one at a time, as a callback may close a session with jobs queued
+     */
+    while ((job = (parse_worker_job *)
+            netsnmp_done_queue_pop(&_parse_workers_done)) != NULL)
+        _parse_workers_finish(job);
+}
+
+#else /* !NETSNMP_PARSE_WORKERS */
+
+int
+netsnmp_parse_workers_init(int count)
+{
+    return 0;
+}
+
+void
+netsnmp_parse_workers_shutdown(void)
+{
+}
+
+int
+netsnmp_parse_workers_fd(void)
+{
+    return -1;
+}
+
+void
+netsnmp_parse_workers_run(void)
+{
+}
+#endif /* !NETSNMP_PARSE_WORKERS */
+
 /*
  * This function processes a complete (according to asn_check_packet or the
  * AgentX equivalent) packet, parsing it into a PDU and calling the relevant
@@ -5842,13 +6703,36 @@ _sess_process_packet(struct session_list *slp, netsnmp_session * sp,
                      u_char * packetptr, int length)
 {
     netsnmp_pdu         *pdu;
-    int                  rc;
+
+#ifdef NETSNMP_PARSE_WORKERS
+    if ((sp->flags & SNMP_FLAGS_PARSE_WORKERS) && !isp->hook_parse &&
+        !(transport->flags & (NETSNMP_TRANSPORT_FLAG_STREAM |
+                              NETSNMP_TRANSPORT_FLAG_TUNNELED)) &&
+        _parse_workers_count > 0)
+        return _parse_workers_queue(slp, sp, isp, transport, opaque, olength,
+                                    packetptr, length);
+#endif /* NETSNMP_PARSE_WORKERS */
 
     pdu = _sess_process_packet_parse_pdu(slp, sp, isp, transport, opaque,
                                          olength, packetptr, length);
     if (NULL == pdu)
         return -1;
 
+    return _sess_process_packet_dispatch(slp, sp, isp, transport, pdu);
+}
+
+/*
+ * This function hands a parsed PDU to the session it belongs to, trying
+ * the other sessions sharing its socket if need be.  Return codes as for
+ * _sess_process_packet().
+ */
+static int
+_sess_process_packet_dispatch(struct session_list *slp, netsnmp_session * sp,
+                              struct snmp_internal_session *isp,
+                              netsnmp_transport *transport, netsnmp_pdu *pdu)
+{
+    int                  rc;
+
     /*
      * find session to process pdu. usually that will be the current session,
      * but with the introduction of shared transports, another session may
@@ -6058,6 +6942,51 @@ _sess_read_dgram_packet(struct session_list *slp, netsnmp_large_fd_set * fdset,
     return 0;
 }
 
+/*
+ * Drain up to serverBatchSize datagrams with one receive call and process
+ * them in turn, holding back the responses so that they can leave with one
+ * send call as well.
+ * returns the result for the last packet, -1 if the receive failed, or
+ * -2 if the transport can't batch (use _sess_read_dgram_packet() instead)
+ */
+static int
+_sess_read_dgram_batch(struct session_list *slp, netsnmp_large_fd_set * fdset)
+{
+    netsnmp_session *sp = slp->session;
+    struct snmp_internal_session *isp = slp->internal;
+    netsnmp_transport *transport = slp->transport;
+    netsnmp_transport_msg *msgs = NULL;
+    int             count, i, rc = 0;
+
+    count = netsnmp_transport_recvm(transport, &msgs);
+    if (0 == count)
+        return -2;
+    if (count < 0) {
+        sp->s_snmp_errno = SNMPERR_BAD_RECVFROM;
+        sp->s_errno = errno;
+        snmp_set_detail(strerror(errno));
+        return -1;
+    }
+
+    /** clear so any other sess sharing this socket won't try reading again */
+    NETSNMP_LARGE_FD_CLR(transport->sock, fdset);
+
+    DEBUGMSGTL(("sess_read", "processing %d datagrams from fd %d\n",
+                count, transport->sock));
+    netsnmp_transport_cork(transport);
+    for (i = 0; i < count; i++) {
+        rc = _sess_process_packet(slp, sp, isp, transport,
+                                  msgs[i].opaque, msgs[i].olength,
+                                  (u_char *) msgs[i].buf, msgs[i].len);
+        /** opaque is freed in _sess_process_packet */
+        msgs[i].opaque = NULL;
+    }
+    netsnmp_transport_uncork(transport);
+    netsnmp_transport_recvm_done(transport, msgs, count);
+
+    return rc;
+}
+
 /*
  * Same as snmp_read, but works just one session. 
  * returns 0 if success, -1 if fail 
@@ -6105,6 +7034,13 @@ _sess_read(struct session_list *slp, netsnmp_large_fd_set * fdset)
         snmp_rcv_packet rcvp;
         memset(&rcvp, 0x0, sizeof(rcvp));
 
+        /** read a batch of packets, if the transport supports it */
+        if (transport->f_recvm) {
+            rc = _sess_read_dgram_batch(slp, fdset);
+            if (-2 != rc)
+                return rc;
+        }
+
         /** read the packet */
         rc = _sess_read_dgram_packet(slp, fdset, &rcvp);
         if (-1 == rc) /* protocol error */
@@ -6193,7 +7129,7 @@ _sess_read(struct session_list *slp, netsnmp_large_fd_set * fdset)
          * Close socket and mark session for deletion.  
          */
         DEBUGMSGTL(("sess_read", "fd %d closed\n", transport->sock));
-        transport->f_close(transport);
+        _sess_close_transport(transport);
         SNMP_FREE(isp->packet);
         SNMP_FREE(opaque);
         return -1;
@@ -6234,7 +7170,7 @@ _sess_read(struct session_list *slp, netsnmp_large_fd_set * fdset)
 				     sp, 0, NULL, sp->callback_magic);
 		}
 		DEBUGMSGTL(("sess_read", "fd %d closed\n", transport->sock));
-                transport->f_close(transport);
+                _sess_close_transport(transport);
                 SNMP_FREE(opaque);
                 /** XXX-rks: why no SNMP_FREE(isp->packet); ?? */
                 return -1;
@@ -6314,7 +7250,7 @@ _sess_read(struct session_list *slp, netsnmp_large_fd_set * fdset)
                      "too large packet_len = %" NETSNMP_PRIz
                      "u, dropping connection %d\n",
                      isp->packet_len, transport->sock);
-            transport->f_close(transport);
+            _sess_close_transport(transport);
             /** XXX-rks: why no SNMP_FREE(isp->packet); ?? */
             return -1;
         } else if (isp->packet_len == 0) {
@@ -6499,7 +7435,12 @@ snmp_sess_select_info2(struct session_list *slp, int *numfds, netsnmp_large_fd_s
  * @param[in,out] block   On input, whether the caller prefers to block forever
  *   when no alarms are active. On output, 0 means that no alarms are active
  *   nor that there is a timeout pending for any of the processed sessions.
- * @param[in]     flags   Either 0 or NETSNMP_SELECT_NOALARMS.
+ * @param[in]     flags   0 or a combination of NETSNMP_SELECT_NOALARMS and
+ *   NETSNMP_SELECT_NOFDS. The latter leaves *numfds and *fdset alone, for
+ *   callers that only need the timeout (fdset may then be NULL).  For all
+ *   sessions, it also takes the earliest request timeout from a heap
+ *   instead of visiting every session, unless a session is waiting to be
+ *   closed.
  *
  * @return Number of sessions processed by this function.
  *
@@ -6519,6 +7460,10 @@ snmp_sess_select_info2_flags(struct session_list *sessp, int *numfds,
 
     timerclear(&earliest);
 
+    if (NULL == sessp && (flags & NETSNMP_SELECT_NOFDS) &&
+        _request_heap_earliest(&earliest, &requests, &active))
+        goto timers;
+
     /*
      * For each session examined, add its socket to the fdset,
      * and if it is the earliest timeout to expire, mark it as lowest.
@@ -6555,11 +7500,13 @@ snmp_sess_select_info2_flags(struct session_list *sessp, int *numfds,
         }
 
         DEBUGMSG(("sess_select", "%d ", slp->transport->sock));
-        if ((slp->transport->sock + 1) > *numfds) {
-            *numfds = (slp->transport->sock + 1);
-        }
+        if (!(flags & NETSNMP_SELECT_NOFDS)) {
+            if ((slp->transport->sock + 1) > *numfds) {
+                *numfds = (slp->transport->sock + 1);
+            }
 
-        NETSNMP_LARGE_FD_SET(slp->transport->sock, fdset);
+            NETSNMP_LARGE_FD_SET(slp->transport->sock, fdset);
+        }
         if (slp->internal != NULL && slp->internal->requests) {
             /*
              * Found another session with outstanding requests.  
@@ -6586,6 +7533,7 @@ snmp_sess_select_info2_flags(struct session_list *sessp, int *numfds,
     }
     DEBUGMSG(("sess_select", "\n"));
 
+  timers:
     netsnmp_get_monotonic_clock(&now);
 
     if (netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID,
@@ -6737,6 +7685,7 @@ snmp_resend_request(struct session_list *slp, netsnmp_request_list *orp,
         tv.tv_sec += tv.tv_usec / 1000000L;
         tv.tv_usec %= 1000000L;
         rp->expireM = tv;
+        _request_heap_update(rp);
         if (rp->callback)
             rp->callback(NETSNMP_CALLBACK_OP_RESEND, sp,
                          rp->pdu->reqid, rp->pdu, rp->cb_data);
@@ -7188,7 +8137,7 @@ snmp_varlist_add_variable(netsnmp_variable_list ** varlist,
     if (varlist == NULL)
         return NULL;
 
-    vars = SNMP_MALLOC_TYPEDEF(netsnmp_variable_list);
+    vars = netsnmp_varbind_alloc();
     if (vars == NULL)
         return NULL;
 
@@ -7832,6 +8781,20 @@ snmp_sess_transport_set(struct session_list *slp, netsnmp_transport *t)
 }
 
 
+/*
+ * snmp_sess_transport_close: closes the transport of the session pointer
+ * slp, leaving the session itself to be closed by the event loop.
+ */
+
+void
+snmp_sess_transport_close(struct session_list *slp)
+{
+    if (slp != NULL && slp->transport != NULL) {
+        _sess_close_transport(slp->transport);
+    }
+}
+
+
 /*
  * snmp_duplicate_objid: duplicates (mallocs) an objid based on the
  * input objid 
@@ -7856,23 +8819,29 @@ snmp_duplicate_objid(const oid * objToCopy, size_t objToCopyLen)
  */
 static u_int    statistics[NETSNMP_STAT_MAX_STATS];
 
+/*
+ * Parse worker threads count errors too, so counters are added to
+ * atomically where the compiler can.
+ */
+#if defined(NETSNMP_REENTRANT) && defined(__GNUC__)
+#define STATISTIC_ADD(var, n)   __sync_add_and_fetch(&(var), (n))
+#else
+#define STATISTIC_ADD(var, n)   ((var) += (n))
+#endif
+
 u_int
 snmp_increment_statistic(int which)
 {
-    if (which >= 0 && which < NETSNMP_STAT_MAX_STATS) {
-        statistics[which]++;
-        return statistics[which];
-    }
+    if (which >= 0 && which < NETSNMP_STAT_MAX_STATS)
+        return STATISTIC_ADD(statistics[which], 1);
     return 0;
 }
 
 u_int
 snmp_increment_statistic_by(int which, int count)
 {
-    if (which >= 0 && which < NETSNMP_STAT_MAX_STATS) {
-        statistics[which] += count;
-        return statistics[which];
-    }
+    if (which >= 0 && which < NETSNMP_STAT_MAX_STATS)
+        return STATISTIC_ADD(statistics[which], count);
     return 0;
 }
 
@@ -131,7 +131,7 @@ snmp_pdu_create(int command)
 {
     netsnmp_pdu    *pdu;
 
-    pdu = (netsnmp_pdu *) calloc(1, sizeof(netsnmp_pdu));
+    pdu = netsnmp_pdu_alloc();
     if (pdu) {
         pdu->version = SNMP_DEFAULT_VERSION;
         pdu->command = command;
@@ -260,6 +260,7 @@ snmp_clone_var(netsnmp_variable_list * var, netsnmp_variable_list * newvar)
     newvar->data = NULL;
     newvar->dataFreeHook = NULL;
     newvar->index = 0;
+    newvar->val_rxbuf = NULL;
 
     /*
      * Clone the object identifier and the value.
@@ -336,16 +337,63 @@ snmp_reset_var_buffers(netsnmp_variable_list * var)
             var->name = var->name_loc;
             var->name_length = 0;
         }
-        if (var->val.string != var->buf) {
-            if (NULL != var->val.string)
-                free(var->val.string);
-            var->val.string = var->buf;
+        if (var->val.string != var->buf || var->val_rxbuf) {
+            netsnmp_var_release_value(var);
             var->val_len = 0;
         }
         var = var->next_variable;
     }
 }
 
+/*
+ * Allocates a copy of received data for variables to point into.  It
+ * starts with no references; each variable pointing into it must take one
+ * by incrementing refcount and setting val_rxbuf.
+ */
+netsnmp_rxbuf *
+netsnmp_rxbuf_create(const u_char * data, size_t len)
+{
+    netsnmp_rxbuf  *rxbuf;
+
+    rxbuf = (netsnmp_rxbuf *) malloc(sizeof(netsnmp_rxbuf) + len);
+    if (NULL == rxbuf)
+        return NULL;
+    rxbuf->data = (u_char *) (rxbuf + 1);
+    rxbuf->len = len;
+    rxbuf->refcount = 0;
+    memcpy(rxbuf->data, data, len);
+    return rxbuf;
+}
+
+/*
+ * Disposes of the value of a variable: frees it if it was allocated for
+ * this variable, or drops the variable's reference to the shared receive
+ * buffer it points into.  val is left pointing to the built-in buffer, so
+ * that the value can be replaced.  This is the copy-on-write step for
+ * shared values; code that changes a value through snmp_set_var_value()
+ * (or frees it with snmp_free_var()) never needs to know the difference.
+ */
+void
+netsnmp_var_release_value(netsnmp_variable_list * var)
+{
+    netsnmp_rxbuf  *rxbuf = var->val_rxbuf;
+    int             shared = 0;
+
+    if (rxbuf) {
+        /*
+         * the value may have been replaced without dropping the reference
+         */
+        shared = var->val.string >= rxbuf->data &&
+            var->val.string < rxbuf->data + rxbuf->len;
+        var->val_rxbuf = NULL;
+        if (--rxbuf->refcount <= 0)
+            free(rxbuf);
+    }
+    if (!shared && var->val.string != var->buf)
+        SNMP_FREE(var->val.string);
+    var->val.string = var->buf;
+}
+
 /*
  * Creates and allocates a clone of the input PDU,
  * but does NOT copy the variables.
@@ -366,9 +414,10 @@ _clone_pdu_header(netsnmp_pdu *pdu)
     if (!pdu)
         return NULL;
 
-    newpdu = netsnmp_memdup(pdu, sizeof(netsnmp_pdu));
+    newpdu = netsnmp_pdu_alloc();
     if (!newpdu)
         return NULL;
+    memcpy(newpdu, pdu, sizeof(netsnmp_pdu));
 
     /*
      * reset copied pointers if copy fails 
@@ -443,8 +492,7 @@ _copy_varlist(netsnmp_variable_list * var,      /* source varList */
         /*
          * clone the next variable. Cleanup if alloc fails 
          */
-        newvar = (netsnmp_variable_list *)
-            malloc(sizeof(netsnmp_variable_list));
+        newvar = netsnmp_varbind_alloc();
         if (snmp_clone_var(var, newvar)) {
             if (newvar)
                 free((char *) newvar);
@@ -802,9 +850,7 @@ snmp_set_var_value(netsnmp_variable_list * vars,
      * xxx-rks: why the unconditional free? why not use existing
      * memory, if len < vars->val_len ?
      */
-    if (vars->val.string && vars->val.string != vars->buf) {
-        free(vars->val.string);
-    }
+    netsnmp_var_release_value(vars);
     vars->val.string = NULL;
     vars->val_len = 0;
 
@@ -109,6 +109,27 @@ size_t          netsnmpIPXDomain_len = OID_LENGTH(netsnmpIPXDomain);
 
 static netsnmp_container *_container = NULL;
 
+/*
+ * Datagrams moved per system call by transports with f_recvm/f_sendm,
+ * unless overridden by serverBatchSize.
+ */
+#ifndef NETSNMP_TRANSPORT_BATCH_DEFAULT
+#define NETSNMP_TRANSPORT_BATCH_DEFAULT 16
+#endif
+
+typedef struct netsnmp_transport_batch_s {
+    int             max;        /* datagrams per call */
+    int             busy;       /* receive buffers handed out */
+    int             corked;     /* queue sends instead of sending them */
+    int             queued;
+    size_t          bufsize;
+    u_char         *rbuf;       /* max receive buffers of bufsize bytes */
+    netsnmp_transport_msg *rmsgs;
+    netsnmp_transport_msg *smsgs;
+} netsnmp_transport_batch;
+
+static int      _transport_flush(netsnmp_transport *t);
+
 
 static void     netsnmp_tdomain_dump(void);
 
@@ -126,6 +147,10 @@ init_snmp_transport(void)
                                "snmp", "dontLoadHostConfig",
                                NETSNMP_DS_LIBRARY_ID,
                                NETSNMP_DS_LIB_DONT_LOAD_HOST_FILES);
+    netsnmp_ds_register_config(ASN_INTEGER,
+                               "snmp", "serverBatchSize",
+                               NETSNMP_DS_LIBRARY_ID,
+                               NETSNMP_DS_LIB_SERVER_BATCH);
 #ifndef NETSNMP_FEATURE_REMOVE_FILTER_SOURCE
     register_app_config_handler("sourceFilterType",
                                 netsnmp_transport_parse_filterType,
@@ -210,6 +235,8 @@ netsnmp_transport_copy(const netsnmp_transport *t)
     n->f_accept = t->f_accept;
     n->f_recv = t->f_recv;
     n->f_send = t->f_send;
+    n->f_recvm = t->f_recvm;
+    n->f_sendm = t->f_sendm;
     n->f_close = t->f_close;
     n->f_copy = t->f_copy;
     n->f_config = t->f_config;
@@ -242,6 +269,12 @@ netsnmp_transport_free(netsnmp_transport *t)
     SNMP_FREE(t->local);
     SNMP_FREE(t->remote);
     SNMP_FREE(t->data);
+    if (t->batch) {
+        SNMP_FREE(t->batch->rbuf);
+        SNMP_FREE(t->batch->rmsgs);
+        SNMP_FREE(t->batch->smsgs);
+        SNMP_FREE(t->batch);
+    }
     netsnmp_transport_free(t->base_transport);
 
     SNMP_FREE(t);
@@ -426,6 +459,30 @@ netsnmp_transport_send(netsnmp_transport *t, const void *packet, int length,
     if (dumpPacket)
         xdump(packet, length, "");
 
+    if (t->batch && t->batch->corked) {
+        netsnmp_transport_batch *b = t->batch;
+        netsnmp_transport_msg *m;
+
+        if (b->queued == b->max)
+            _transport_flush(t);
+        m = &b->smsgs[b->queued];
+        m->buf = netsnmp_memdup(packet, length);
+        m->len = length;
+        m->opaque = NULL;
+        m->olength = 0;
+        if (opaque && *opaque && olength && *olength > 0) {
+            m->opaque = netsnmp_memdup(*opaque, *olength);
+            m->olength = *olength;
+        }
+        if (m->buf && (m->opaque || !m->olength)) {
+            b->queued++;
+            return length;
+        }
+        /* out of memory: send it right away */
+        SNMP_FREE(m->buf);
+        SNMP_FREE(m->opaque);
+    }
+
     return t->f_send(t, packet, length, opaque, olength);
 }
 
@@ -461,6 +518,148 @@ netsnmp_transport_recv(netsnmp_transport *t, void *packet, int length,
     return length;
 }
 
+static netsnmp_transport_batch *
+_transport_batch(netsnmp_transport *t)
+{
+    netsnmp_transport_batch *b;
+    int             max;
+
+    if (t->batch)
+        return t->batch;
+
+    max = netsnmp_ds_get_int(NETSNMP_DS_LIBRARY_ID,
+                             NETSNMP_DS_LIB_SERVER_BATCH);
+    if (max <= 0)
+        max = NETSNMP_TRANSPORT_BATCH_DEFAULT;
+    if (max == 1)
+        return NULL;
+
+    b = SNMP_MALLOC_TYPEDEF(netsnmp_transport_batch);
+    if (NULL == b)
+        return NULL;
+    b->max = max;
+    b->bufsize = t->msgMaxSize ? t->msgMaxSize : SNMP_MAX_RCV_MSG_SIZE;
+    b->rbuf = (u_char *) malloc(max * b->bufsize);
+    b->rmsgs = (netsnmp_transport_msg *)
+        calloc(max, sizeof(netsnmp_transport_msg));
+    b->smsgs = (netsnmp_transport_msg *)
+        calloc(max, sizeof(netsnmp_transport_msg));
+    if (NULL == b->rbuf || NULL == b->rmsgs || NULL == b->smsgs) {
+        SNMP_FREE(b->rbuf);
+        SNMP_FREE(b->rmsgs);
+        SNMP_FREE(b->smsgs);
+        free(b);
+        return NULL;
+    }
+    DEBUGMSGTL(("transport:batch", "%d datagrams per call on fd %d\n",
+                max, t->sock));
+    t->batch = b;
+    return b;
+}
+
+/*
+ * netsnmp_transport_recvm
+ *
+ * Receive as many datagrams as are waiting, up to serverBatchSize, with a
+ * single call into the transport.  On success *msgs points to the received
+ * messages, which stay valid until netsnmp_transport_recvm_done(); any
+ * opaque left in them is freed there.
+ *
+ * Returns the number of datagrams received, -1 on error, or 0 if the
+ * transport can't batch right now and netsnmp_transport_recv() should be
+ * used instead.
+ */
+int
+netsnmp_transport_recvm(netsnmp_transport *t, netsnmp_transport_msg **msgs)
+{
+    netsnmp_transport_batch *b;
+    int             i, count;
+
+    if (NULL == t || NULL == t->f_recvm || NULL == msgs)
+        return 0;
+    b = _transport_batch(t);
+    if (NULL == b || b->busy)
+        return 0;
+
+    for (i = 0; i < b->max; i++) {
+        b->rmsgs[i].buf = b->rbuf + i * b->bufsize;
+        b->rmsgs[i].len = b->bufsize;
+        b->rmsgs[i].opaque = NULL;
+        b->rmsgs[i].olength = 0;
+    }
+    count = t->f_recvm(t, b->rmsgs, b->max);
+    if (count <= 0)
+        return count < 0 ? -1 : 0;
+
+    b->busy = 1;
+    DEBUGIF("transport:recv") {
+        for (i = 0; i < count; i++) {
+            char *str = netsnmp_transport_peer_string(t, b->rmsgs[i].opaque,
+                                                      b->rmsgs[i].olength);
+            DEBUGMSGT_NC(("transport:recv","%d bytes from %s (%d/%d)\n",
+                          b->rmsgs[i].len, str, i + 1, count));
+            SNMP_FREE(str);
+        }
+    }
+    *msgs = b->rmsgs;
+    return count;
+}
+
+void
+netsnmp_transport_recvm_done(netsnmp_transport *t,
+                             netsnmp_transport_msg *msgs, int count)
+{
+    int             i;
+
+    for (i = 0; i < count; i++)
+        SNMP_FREE(msgs[i].opaque);
+    if (t && t->batch)
+        t->batch->busy = 0;
+}
+
+/*
+ * Between netsnmp_transport_cork() and netsnmp_transport_uncork(), packets
+ * given to netsnmp_transport_send() are copied to a queue which is handed
+ * to f_sendm in one go when it fills up or the transport is uncorked.
+ * Calls nest; transports without f_sendm are not affected.
+ */
+void
+netsnmp_transport_cork(netsnmp_transport *t)
+{
+    if (t && t->f_sendm && _transport_batch(t))
+        t->batch->corked++;
+}
+
+static int
+_transport_flush(netsnmp_transport *t)
+{
+    netsnmp_transport_batch *b = t->batch;
+    int             i, sent;
+
+    if (0 == b->queued)
+        return 0;
+
+    sent = t->f_sendm(t, b->smsgs, b->queued);
+    DEBUGMSGTL(("transport:batch", "sent %d of %d queued datagrams\n",
+                sent, b->queued));
+    for (i = 0; i < b->queued; i++) {
+        SNMP_FREE(b->smsgs[i].buf);
+        SNMP_FREE(b->smsgs[i].opaque);
+    }
+    b->queued = 0;
+    return sent;
+}
+
+int
+netsnmp_transport_uncork(netsnmp_transport *t)
+{
+    netsnmp_transport_batch *b = t ? t->batch : NULL;
+
+    if (NULL == b || 0 == b->corked || --b->corked > 0)
+        return 0;
+    return _transport_flush(t);
+}
+
 
 
 #ifndef NETSNMP_FEATURE_REMOVE_TDOMAIN_SUPPORT
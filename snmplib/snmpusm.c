@@ -228,6 +228,19 @@ static struct usmUser *noNameUser = NULL;
  * Local storage (LCD) of the default user list.
  */
 static struct usmUser *userList = NULL;
+static struct usmUser *userListTail = NULL;
+
+/*
+ * userList is kept sorted for the usmUserTable.  userHash indexes the
+ * same users by (engineID, name) for the lookup done on every incoming
+ * message: an open addressing table with linear probing, at most half
+ * full, whose size is always a power of two.
+ */
+#define USM_USER_HASH_MIN 64
+
+static struct usmUser **userHash = NULL;
+static size_t   userHashSize = 0;
+static size_t   userHashCount = 0;
 
 /*
  * Set a given field of the secStateRef.
@@ -463,6 +476,128 @@ emergency_print(u_char * field, u_int length)
 }                               /* end emergency_print() */
 #endif                          /* NETSNMP_ENABLE_TESTING_CODE */
 
+static u_int
+usm_user_hash(const u_char * engineID, size_t engineIDLen, const char *name)
+{
+    u_int           hash;
+
+    hash = netsnmp_hash_buf(engineID, engineID ? engineIDLen : 0,
+                            NETSNMP_HASH_INIT);
+    return netsnmp_hash_buf(name, name ? strlen(name) : 0, hash);
+}
+
+static int
+usm_user_matches(const struct usmUser *user, const u_char * engineID,
+                 size_t engineIDLen, const char *name)
+{
+    return user->name && !strcmp(user->name, name) &&
+        user->engineIDLen == engineIDLen &&
+        ((user->engineID == NULL && engineID == NULL) ||
+         (user->engineID != NULL && engineID != NULL &&
+          memcmp(user->engineID, engineID, engineIDLen) == 0));
+}
+
+static struct usmUser *
+usm_user_hash_find(const u_char * engineID, size_t engineIDLen,
+                   const char *name)
+{
+    size_t          mask = userHashSize - 1, i;
+
+    if (0 == userHashCount)
+        return NULL;
+    for (i = usm_user_hash(engineID, engineIDLen, name) & mask;
+         userHash[i] != NULL; i = (i + 1) & mask)
+        if (usm_user_matches(userHash[i], engineID, engineIDLen, name))
+            return userHash[i];
+    return NULL;
+}
+
+static void
+usm_user_hash_insert(struct usmUser *user)
+{
+    size_t          mask = userHashSize - 1, i;
+
+    for (i = usm_user_hash(user->engineID, user->engineIDLen,
+                           user->name) & mask;
+         userHash[i] != NULL; i = (i + 1) & mask)
+        ;
+    userHash[i] = user;
+    userHashCount++;
+}
+
+static void
+usm_user_hash_add(struct usmUser *user)
+{
+    if ((userHashCount + 1) * 2 > userHashSize) {
+        struct usmUser **old = userHash;
+        size_t          oldSize = userHashSize, i;
+        size_t          newSize =
+            userHashSize ? userHashSize * 2 : USM_USER_HASH_MIN;
+        struct usmUser **newHash =
+            (struct usmUser **) calloc(newSize, sizeof(struct usmUser *));
+
+        if (NULL == newHash) {
+            if (userHashCount + 1 < userHashSize)
+                goto insert;    /* fuller than we'd like, but still works */
+            snmp_log(LOG_ERR, "usm: cannot grow the user index\n");
+            return;
+        }
+        userHash = newHash;
+        userHashSize = newSize;
+        userHashCount = 0;
+        for (i = 0; i < oldSize; i++)
+            if (old[i])
+                usm_user_hash_insert(old[i]);
+        free(old);
+    }
+  insert:
+    usm_user_hash_insert(user);
+}
+
+static void
+usm_user_hash_remove(struct usmUser *user)
+{
+    size_t          mask = userHashSize - 1, i, j, home;
+
+    if (0 == userHashCount)
+        return;
+    for (i = usm_user_hash(user->engineID, user->engineIDLen,
+                           user->name) & mask;
+         userHash[i] != user; i = (i + 1) & mask)
+        if (NULL == userHash[i])
+            return;             /* not indexed */
+
+    /*
+     * close the gap, moving back any later entry of the probe sequence
+     * whose home slot is not between the gap and itself
+     */
+    for (;;) {
+        userHash[i] = NULL;
+        for (j = (i + 1) & mask;; j = (j + 1) & mask) {
+            if (NULL == userHash[j]) {
+                userHashCount--;
+                return;
+            }
+            home = usm_user_hash(userHash[j]->engineID,
+                                 userHash[j]->engineIDLen,
+                                 userHash[j]->name) & mask;
+            if (i <= j ? (i < home && home <= j) : (i < home || home <= j))
+                continue;
+            break;
+        }
+        userHash[i] = userHash[j];
+        i = j;
+    }
+}
+
+static void
+usm_user_hash_clear(void)
+{
+    SNMP_FREE(userHash);
+    userHashSize = 0;
+    userHashCount = 0;
+}
+
 static struct usmUser *
 usm_get_user_from_list(u_char * engineID, size_t engineIDLen,
                        char *name, struct usmUser *puserList,
@@ -472,6 +607,19 @@ usm_get_user_from_list(u_char * engineID, size_t engineIDLen,
     char            noName[] = "";
     if (name == NULL)
         name = noName;
+    if (puserList == userList) {
+        ptr = usm_user_hash_find(engineID, engineIDLen, name);
+        if (ptr) {
+            DEBUGMSGTL(("usm", "match on user %s\n", ptr->name));
+            return ptr;
+        }
+        DEBUGMSGTL(("usm", "no match on user %s, engineID (", name));
+        if (engineID) {
+            DEBUGMSGHEX(("usm", engineID, engineIDLen));
+        }
+        DEBUGMSG(("usm", ")\n"));
+        puserList = NULL;
+    }
     for (ptr = puserList; ptr != NULL; ptr = ptr->next) {
         if (ptr->name && !strcmp(ptr->name, name)) {
           DEBUGMSGTL(("usm", "match on user %s\n", ptr->name));
@@ -619,13 +767,60 @@ usm_add_user_to_list(struct usmUser *user, struct usmUser *puserList)
  * returns the head of the list (which could change due to this add).
  */
 
+/*
+ * Whether user belongs after last in the sort order of the user list
+ * (only answers for the common case of users with engineIDs and names).
+ */
+static int
+usm_user_sorts_after(const struct usmUser *user,
+                     const struct usmUser *last)
+{
+    int             rc;
+    size_t          len, lastLen;
+
+    if (!user->engineID || !last->engineID || !user->name || !last->name)
+        return 0;
+    if (user->engineIDLen != last->engineIDLen)
+        return user->engineIDLen > last->engineIDLen;
+    rc = memcmp(user->engineID, last->engineID, user->engineIDLen);
+    if (rc)
+        return rc > 0;
+    len = strlen(user->name);
+    lastLen = strlen(last->name);
+    if (len != lastLen)
+        return len > lastLen;
+    return strcmp(user->name, last->name) > 0;
+}
+
 struct usmUser *
 usm_add_user(struct usmUser *user)
 {
     struct usmUser *uptr;
-    uptr = usm_add_user_to_list(user, userList);
+
+    /*
+     * a user with the same engineID and name is replaced (and freed) by
+     * usm_add_user_to_list(), so drop it from the index first
+     */
+    uptr = usm_user_hash_find(user->engineID, user->engineIDLen,
+                              user->name ? user->name : "");
+    if (uptr && uptr != user)
+        usm_user_hash_remove(uptr);
+
+    if (userListTail && usm_user_sorts_after(user, userListTail)) {
+        /*
+         * users read back from the persistent store arrive in order
+         */
+        user->prev = userListTail;
+        user->next = NULL;
+        userListTail->next = user;
+        uptr = userList;
+    } else
+        uptr = usm_add_user_to_list(user, userList);
     if (uptr != NULL)
         userList = uptr;
+    if (user->next == NULL)
+        userListTail = user;
+    usm_user_hash_add(user);
     return uptr;
 }
 
@@ -678,6 +873,11 @@ usm_remove_usmUser_from_list(struct usmUser *user, struct usmUser **ppuserList)
     if (nptr == *ppuserList)    /* we're the head of the list, need to change
                                  * * the head to the next user */
         *ppuserList = nptr->next;
+    if (ppuserList == &userList) {
+        usm_user_hash_remove(nptr);
+        if (nptr == userListTail)
+            userListTail = pptr;
+    }
     return SNMPERR_SUCCESS;
 }                               /* end usm_remove_usmUser_from_list() */
 
@@ -738,11 +938,13 @@ usm_free_user(struct usmUser *user)
     SNMP_FREE(user->privProtocol);
 
     if (user->authKey != NULL) {
+        sc_keycache_forget(user->authKey, user->authKeyLen);
         SNMP_ZERO(user->authKey, user->authKeyLen);
         SNMP_FREE(user->authKey);
     }
 
     if (user->privKey != NULL) {
+        sc_keycache_forget(user->privKey, user->privKeyLen);
         SNMP_ZERO(user->privKey, user->privKeyLen);
         SNMP_FREE(user->privKey);
     }
@@ -3788,6 +3990,8 @@ clear_user_list(void)
 	tmp = next;
     }
     userList = NULL;
+    userListTail = NULL;
+    usm_user_hash_clear();
 
 }
 
@@ -4280,6 +4484,7 @@ usm_set_user_password(struct usmUser *user, const char *token, char *line)
         /*
          * (destroy and) free the old key 
          */
+        sc_keycache_forget(*key, *keyLen);
         memset(*key, 0, *keyLen);
         SNMP_FREE(*key);
     }
@@ -4999,4 +5204,5 @@ shutdown_usm(void)
 {
     free_etimelist();
     clear_user_list();
+    sc_keycache_clear();
 }
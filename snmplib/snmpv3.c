@@ -1240,6 +1240,10 @@ snmpv3_generate_engineID(size_t * length)
  *
  * @note It is assumed that this function is called at least once every
  *   2**31 seconds.
+ *
+ * The clock is read under MT_LIB_LOCALTIME: threads checking the
+ * timeliness of messages at once must not see one another's later time
+ * as the counter wrapping around.
  */
 u_long
 snmpv3_local_snmpEngineTime(void)
@@ -1248,15 +1252,17 @@ snmpv3_local_snmpEngineTime(void)
     netsnmp_feature_require(calculate_sectime_diff)
 #endif /* NETSNMP_FEATURE_CHECKING */
 
-    static uint32_t last_engineTime;
+    static uint32_t last_engineTime;    /* MT_LIB_LOCALTIME */
     struct timeval  now;
     uint32_t engineTime;
 
+    snmp_res_lock(MT_LIBRARY_ID, MT_LIB_LOCALTIME);
     netsnmp_get_monotonic_clock(&now);
     engineTime = calculate_sectime_diff(&now, &snmpv3starttime) & 0x7fffffffL;
     if (engineTime < last_engineTime)
         engineBoots++;
     last_engineTime = engineTime;
+    snmp_res_unlock(MT_LIBRARY_ID, MT_LIB_LOCALTIME);
     return engineTime;
 }
 
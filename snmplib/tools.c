@@ -195,6 +195,8 @@ int
 snmp_strcat(u_char ** buf, size_t * buf_len, size_t * out_len,
             int allow_realloc, const u_char * s)
 {
+    size_t          len;
+
     if (buf == NULL || buf_len == NULL || out_len == NULL) {
         return 0;
     }
@@ -206,7 +208,8 @@ snmp_strcat(u_char ** buf, size_t * buf_len, size_t * out_len,
         return 1;
     }
 
-    while ((*out_len + strlen((const char *) s) + 1) >= *buf_len) {
+    len = strlen((const char *) s);
+    while ((*out_len + len + 1) >= *buf_len) {
         if (!(allow_realloc && snmp_realloc(buf, buf_len))) {
             return 0;
         }
@@ -215,8 +218,8 @@ snmp_strcat(u_char ** buf, size_t * buf_len, size_t * out_len,
     if (!*buf)
         return 0;
 
-    strcpy((char *) (*buf + *out_len), (const char *) s);
-    *out_len += strlen((char *) (*buf + *out_len));
+    memcpy(*buf + *out_len, s, len + 1);
+    *out_len += len;
     return 1;
 }
 
@@ -321,6 +324,30 @@ void *netsnmp_memdup_nt(const void *from, size_t from_size, size_t *to_size)
     return to;
 }                               /* end netsnmp_memdupNT() */
 
+/**
+ * Hashes a block of memory (32-bit FNV-1a), continuing from a previous
+ * result so that a key made of several fields can be hashed one field at
+ * a time.  Start with NETSNMP_HASH_INIT, or for keys chosen by remote
+ * parties with NETSNMP_HASH_INIT mixed with a per-process random value.
+ *
+ * @param[in] buf Pointer to the data to hash.
+ * @param[in] len Length of the data.
+ * @param[in] hash Starting value, or the result for the previous field.
+ *
+ * @return The updated hash value.
+ */
+u_int
+netsnmp_hash_buf(const void *buf, size_t len, u_int hash)
+{
+    const u_char   *cp = (const u_char *) buf;
+
+    while (len-- > 0) {
+        hash ^= *cp++;
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
 #ifndef NETSNMP_FEATURE_REMOVE_NETSNMP_CHECK_DEFINEDNESS
 /**
  * When running under Valgrind, check whether all bytes in the range [packet,
@@ -1501,6 +1501,8 @@ _transport_common(netsnmp_transport *t, int local)
 
     t->f_recv          = netsnmp_dtlsudp_recv;
     t->f_send          = netsnmp_dtlsudp_send;
+    t->f_recvm         = NULL;
+    t->f_sendm         = NULL;
     t->f_close         = netsnmp_dtlsudp_close;
     t->f_config        = netsnmp_tlsbase_config;
     t->f_setup_session = netsnmp_tlsbase_session_init;
@@ -24,6 +24,9 @@
 #if HAVE_NETINET_IN_H
 #include <netinet/in.h>
 #endif
+#if HAVE_NETINET_TCP_H
+#include <netinet/tcp.h>
+#endif
 #if HAVE_ARPA_INET_H
 #include <arpa/inet.h>
 #endif
@@ -36,6 +39,24 @@
 
 #include <net-snmp/library/snmp_transport.h>
 
+/*
+ * Sends each message as soon as it is written.  A peer which sends
+ * several requests before reading the responses (an AgentX subagent
+ * registering a batch of subtrees, say) would otherwise see the last of
+ * them held back until a delayed acknowledgement arrives.
+ */
+void netsnmp_tcpbase_nodelay(int sock)
+{
+#ifdef TCP_NODELAY
+    int one = 1;
+
+    if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (void *)&one,
+                   sizeof(one)) < 0)
+        DEBUGMSGTL(("netsnmp_tcpbase", "couldn't set TCP_NODELAY on fd %d\n",
+                    sock));
+#endif
+}
+
 /*
  * You can write something into opaque that will subsequently get passed back 
  * to your send function if you like.  For instance, you might want to
@@ -121,6 +121,7 @@ netsnmp_tcp6_accept(netsnmp_transport *t)
          */
         netsnmp_sock_buffer_set(newsock, SO_SNDBUF, 1, 0);
         netsnmp_sock_buffer_set(newsock, SO_RCVBUF, 1, 0);
+        netsnmp_tcpbase_nodelay(newsock);
 
         return newsock;
     } else {
@@ -290,6 +291,7 @@ netsnmp_tcp6_transport(const struct netsnmp_ep *ep, int local)
          */
         netsnmp_sock_buffer_set(t->sock, SO_SNDBUF, local, 0);
         netsnmp_sock_buffer_set(t->sock, SO_RCVBUF, local, 0);
+        netsnmp_tcpbase_nodelay(t->sock);
     }
 
     /*
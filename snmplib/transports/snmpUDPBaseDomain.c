@@ -133,6 +133,39 @@ static LPFN_WSARECVMSG pfWSARecvMsg;
 static LPFN_WSASENDMSG pfWSASendMsg;
 #endif
 
+#if !defined(WIN32)
+/*
+ * Pick the destination (local) address and interface out of the control
+ * messages of a received datagram.
+ */
+static void
+_udpbase_recv_cmsg(struct msghdr *msg, struct sockaddr *dstip, int *if_index)
+{
+    struct cmsghdr *cm;
+
+    for (cm = CMSG_FIRSTHDR(msg); cm != NULL; cm = CMSG_NXTHDR(msg, cm)) {
+#if defined(HAVE_IP_PKTINFO)
+        if (cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_PKTINFO) {
+            struct in_pktinfo* src = (struct in_pktinfo *)CMSG_DATA(cm);
+            netsnmp_assert(dstip->sa_family == AF_INET);
+            ((struct sockaddr_in*)dstip)->sin_addr = src->ipi_addr;
+            *if_index = src->ipi_ifindex;
+            DEBUGMSGTL(("udpbase:recv",
+                        "got destination (local) addr %s, iface %d\n",
+                        inet_ntoa(src->ipi_addr), *if_index));
+        }
+#elif defined(HAVE_IP_RECVDSTADDR)
+        if (cm->cmsg_level == IPPROTO_IP && cm->cmsg_type == IP_RECVDSTADDR) {
+            struct in_addr* src = (struct in_addr *)CMSG_DATA(cm);
+            ((struct sockaddr_in*)dstip)->sin_addr = *src;
+            DEBUGMSGTL(("netsnmp_udp", "got destination (local) addr %s\n",
+                        inet_ntoa(*src)));
+        }
+#endif
+    }
+}
+#endif /* !defined(WIN32) */
+
 int
 netsnmp_udpbase_recvfrom(int s, void *buf, int len, struct sockaddr *from,
                          socklen_t *fromlen, struct sockaddr *dstip,
@@ -142,7 +175,6 @@ netsnmp_udpbase_recvfrom(int s, void *buf, int len, struct sockaddr *from,
 #if !defined(WIN32)
     struct iovec iov;
     char cmsg[CMSG_SPACE(cmsg_data_size)];
-    struct cmsghdr *cm;
     struct msghdr msg;
 
     iov.iov_base = buf;
@@ -198,26 +230,7 @@ netsnmp_udpbase_recvfrom(int s, void *buf, int len, struct sockaddr *from,
     }
 
 #if !defined(WIN32)
-    for (cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm)) {
-#if defined(HAVE_IP_PKTINFO)
-        if (cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_PKTINFO) {
-            struct in_pktinfo* src = (struct in_pktinfo *)CMSG_DATA(cm);
-            netsnmp_assert(dstip->sa_family == AF_INET);
-            ((struct sockaddr_in*)dstip)->sin_addr = src->ipi_addr;
-            *if_index = src->ipi_ifindex;
-            DEBUGMSGTL(("udpbase:recv",
-                        "got destination (local) addr %s, iface %d\n",
-                        inet_ntoa(src->ipi_addr), *if_index));
-        }
-#elif defined(HAVE_IP_RECVDSTADDR)
-        if (cm->cmsg_level == IPPROTO_IP && cm->cmsg_type == IP_RECVDSTADDR) {
-            struct in_addr* src = (struct in_addr *)CMSG_DATA(cm);
-            ((struct sockaddr_in*)dstip)->sin_addr = *src;
-            DEBUGMSGTL(("netsnmp_udp", "got destination (local) addr %s\n",
-                        inet_ntoa(*src)));
-        }
-#endif
-    }
+    _udpbase_recv_cmsg(&msg, dstip, if_index);
 #else /* !defined(WIN32) */
     for (cm = WSA_CMSG_FIRSTHDR(&msg); cm; cm = WSA_CMSG_NXTHDR(&msg, cm)) {
         if (cm->cmsg_level == IPPROTO_IP && cm->cmsg_type == IP_PKTINFO) {
@@ -477,6 +490,23 @@ netsnmp_udpbase_recv(netsnmp_transport *t, void *buf, int size,
 
 
 
+/*
+ * Where a packet goes: the address the request came from, if known,
+ * otherwise the remote end of the transport.
+ */
+static const netsnmp_indexed_addr_pair *
+_udpbase_addr_pair(netsnmp_transport *t, const void *opaque, int olength)
+{
+    if (opaque != NULL &&
+        (olength == sizeof(netsnmp_indexed_addr_pair) ||
+         olength == sizeof(struct sockaddr_in)))
+        return (const netsnmp_indexed_addr_pair *) opaque;
+    if (t != NULL && t->data != NULL &&
+        t->data_length == sizeof(netsnmp_indexed_addr_pair))
+        return (const netsnmp_indexed_addr_pair *) t->data;
+    return NULL;
+}
+
 int
 netsnmp_udpbase_send(netsnmp_transport *t, const void *buf, int size,
                      void **opaque, int *olength)
@@ -485,14 +515,9 @@ netsnmp_udpbase_send(netsnmp_transport *t, const void *buf, int size,
     const netsnmp_indexed_addr_pair *addr_pair = NULL;
     const struct sockaddr *to = NULL;
 
-    if (opaque != NULL && *opaque != NULL && NULL != olength &&
-        ((*olength == sizeof(netsnmp_indexed_addr_pair) ||
-          (*olength == sizeof(struct sockaddr_in))))) {
-        addr_pair = (const netsnmp_indexed_addr_pair *) (*opaque);
-    } else if (t != NULL && t->data != NULL &&
-                t->data_length == sizeof(netsnmp_indexed_addr_pair)) {
-        addr_pair = (netsnmp_indexed_addr_pair *) (t->data);
-    } else {
+    addr_pair = _udpbase_addr_pair(t, opaque ? *opaque : NULL,
+                                   olength ? *olength : 0);
+    if (NULL == addr_pair) {
         int len = -1;
         if (opaque != NULL && *opaque != NULL && NULL != olength)
             len = *olength;
@@ -530,6 +555,184 @@ netsnmp_udpbase_send(netsnmp_transport *t, const void *buf, int size,
     return rc;
 }
 
+#if defined(HAVE_RECVMMSG) && !defined(WIN32)
+/*
+ * Batched counterpart of netsnmp_udpbase_recv(): a single recvmmsg() call
+ * picks up every datagram waiting on the socket, up to count.
+ */
+int
+netsnmp_udpbase_recvm(netsnmp_transport *t, netsnmp_transport_msg *msgs,
+                      int count)
+{
+    struct mmsghdr  mm[NETSNMP_UDPBASE_BATCH_MAX];
+    struct iovec    iov[NETSNMP_UDPBASE_BATCH_MAX];
+    netsnmp_sockaddr_storage from[NETSNMP_UDPBASE_BATCH_MAX];
+#ifdef netsnmp_udpbase_recvfrom_sendto_defined
+    char            cmsg[NETSNMP_UDPBASE_BATCH_MAX][CMSG_SPACE(cmsg_data_size)];
+    netsnmp_sockaddr_storage local;
+    socklen_t       local_len = sizeof(local);
+#endif
+    netsnmp_indexed_addr_pair *addr_pair;
+    int             i, rc;
+
+    if (NULL == t || t->sock < 0)
+        return -1;
+    if (count > NETSNMP_UDPBASE_BATCH_MAX)
+        count = NETSNMP_UDPBASE_BATCH_MAX;
+
+    memset(mm, 0, count * sizeof(mm[0]));
+    for (i = 0; i < count; i++) {
+        iov[i].iov_base = msgs[i].buf;
+        iov[i].iov_len = msgs[i].len;
+        mm[i].msg_hdr.msg_name = &from[i];
+        mm[i].msg_hdr.msg_namelen = sizeof(from[i]);
+        mm[i].msg_hdr.msg_iov = &iov[i];
+        mm[i].msg_hdr.msg_iovlen = 1;
+#ifdef netsnmp_udpbase_recvfrom_sendto_defined
+        mm[i].msg_hdr.msg_control = cmsg[i];
+        mm[i].msg_hdr.msg_controllen = sizeof(cmsg[i]);
+#endif
+    }
+
+    do {
+        rc = recvmmsg(t->sock, mm, count, MSG_DONTWAIT, NULL);
+    } while (rc < 0 && EINTR == errno);
+    if (rc < 0) {
+        DEBUGMSGTL(("netsnmp_udp", "recvmmsg fd %d err %d (\"%s\")\n",
+                    t->sock, errno, strerror(errno)));
+        return -1;
+    }
+
+#ifdef netsnmp_udpbase_recvfrom_sendto_defined
+    /* the local port is the same for the whole batch */
+    if (getsockname(t->sock, &local.sa, &local_len) != 0)
+        memset(&local, 0, sizeof(local));
+#endif
+
+    for (i = 0; i < rc; i++) {
+        addr_pair = SNMP_MALLOC_TYPEDEF(netsnmp_indexed_addr_pair);
+        if (NULL == addr_pair)
+            break;              /* the rest of the batch is dropped */
+        memcpy(&addr_pair->remote_addr, &from[i],
+               SNMP_MIN(mm[i].msg_hdr.msg_namelen, sizeof(from[i])));
+#ifdef netsnmp_udpbase_recvfrom_sendto_defined
+        memcpy(&addr_pair->local_addr, &local, sizeof(local));
+        _udpbase_recv_cmsg(&mm[i].msg_hdr, &addr_pair->local_addr.sa,
+                           &addr_pair->if_index);
+#endif
+        msgs[i].len = mm[i].msg_len;
+        msgs[i].opaque = addr_pair;
+        msgs[i].olength = sizeof(netsnmp_indexed_addr_pair);
+    }
+    DEBUGMSGTL(("netsnmp_udp", "recvmmsg fd %d got %d datagrams\n",
+                t->sock, i));
+    return i;
+}
+#endif /* HAVE_RECVMMSG && !WIN32 */
+
+#if defined(HAVE_SENDMMSG) && !defined(WIN32)
+/*
+ * Batched counterpart of netsnmp_udpbase_send().  Datagrams that sendmmsg()
+ * refuses go through netsnmp_udpbase_send(), which knows how to retry
+ * them.
+ */
+int
+netsnmp_udpbase_sendm(netsnmp_transport *t, netsnmp_transport_msg *msgs,
+                      int count)
+{
+    struct mmsghdr  mm[NETSNMP_UDPBASE_BATCH_MAX];
+    struct iovec    iov[NETSNMP_UDPBASE_BATCH_MAX];
+#if defined(HAVE_IP_PKTINFO) && defined(HAVE_STRUCT_IN_PKTINFO_IPI_SPEC_DST)
+    char            cmsg[NETSNMP_UDPBASE_BATCH_MAX][CMSG_SPACE(sizeof(struct in_pktinfo))];
+    int             use_srcip = TRUE;
+#endif
+    const netsnmp_indexed_addr_pair *addr_pair;
+    int             i, n, rc, done = 0, sent = 0;
+
+    if (NULL == t || t->sock < 0)
+        return 0;
+
+#if defined(HAVE_IP_PKTINFO) && defined(HAVE_STRUCT_IN_PKTINFO_IPI_SPEC_DST)
+#ifdef HAVE_SO_BINDTODEVICE
+    {
+        /* see netsnmp_udpbase_sendto_unix(): don't override a VRF binding */
+        char            iface[IFNAMSIZ];
+        socklen_t       ifacelen = IFNAMSIZ;
+
+        if (getsockopt(t->sock, SOL_SOCKET, SO_BINDTODEVICE, iface,
+                       &ifacelen) == 0 && ifacelen > 0)
+            use_srcip = FALSE;
+    }
+#endif /* HAVE_SO_BINDTODEVICE */
+#endif
+
+    while (done < count) {
+        n = SNMP_MIN(count - done, NETSNMP_UDPBASE_BATCH_MAX);
+        memset(mm, 0, n * sizeof(mm[0]));
+        for (i = 0; i < n; i++) {
+            netsnmp_transport_msg *m = &msgs[done + i];
+
+            addr_pair = _udpbase_addr_pair(t, m->opaque, m->olength);
+            if (NULL == addr_pair)
+                break;
+            iov[i].iov_base = m->buf;
+            iov[i].iov_len = m->len;
+            mm[i].msg_hdr.msg_name =
+                NETSNMP_REMOVE_CONST(void *, &addr_pair->remote_addr.sa);
+            mm[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+            mm[i].msg_hdr.msg_iov = &iov[i];
+            mm[i].msg_hdr.msg_iovlen = 1;
+#if defined(HAVE_IP_PKTINFO) && defined(HAVE_STRUCT_IN_PKTINFO_IPI_SPEC_DST)
+            if (use_srcip &&
+                addr_pair->local_addr.sin.sin_addr.s_addr != INADDR_ANY) {
+                struct in_pktinfo ipi;
+                struct cmsghdr *cm;
+
+                memset(cmsg[i], 0, sizeof(cmsg[i]));
+                mm[i].msg_hdr.msg_control = cmsg[i];
+                mm[i].msg_hdr.msg_controllen = sizeof(cmsg[i]);
+                cm = CMSG_FIRSTHDR(&mm[i].msg_hdr);
+                cm->cmsg_len = CMSG_LEN(sizeof(ipi));
+                cm->cmsg_level = SOL_IP;
+                cm->cmsg_type = IP_PKTINFO;
+                memset(&ipi, 0, sizeof(ipi));
+                ipi.ipi_spec_dst = addr_pair->local_addr.sin.sin_addr;
+                memcpy(CMSG_DATA(cm), &ipi, sizeof(ipi));
+            }
+#endif
+        }
+
+        rc = 0;
+        if (i > 0) {
+            do {
+                rc = sendmmsg(t->sock, mm, i, MSG_DONTWAIT);
+            } while (rc < 0 && EINTR == errno);
+            if (rc < 0) {
+                DEBUGMSGTL(("netsnmp_udp", "sendmmsg fd %d err %d\n",
+                            t->sock, errno));
+                rc = 0;
+            }
+        }
+        sent += rc;
+        done += rc;
+
+        if (rc < n) {
+            /* msgs[done] was refused or couldn't be set up */
+            void           *opaque = msgs[done].opaque;
+            int             olength = msgs[done].olength;
+
+            if (netsnmp_udpbase_send(t, msgs[done].buf, msgs[done].len,
+                                     &opaque, &olength) >= 0)
+                sent++;
+            done++;
+        }
+    }
+    DEBUGMSGTL(("netsnmp_udp", "sendmmsg fd %d sent %d of %d datagrams\n",
+                t->sock, sent, count));
+    return sent;
+}
+#endif /* HAVE_SENDMMSG && !WIN32 */
+
 void
 netsnmp_udp_base_ctor(void)
 {
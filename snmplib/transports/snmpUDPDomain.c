@@ -121,7 +121,7 @@ int netsnmp_udp_sendto(int fd, const struct in_addr *srcip, int if_index,
  */
 
 static netsnmp_transport *
-netsnmp_udp_transport_base(netsnmp_transport *t)
+netsnmp_udp_transport_base(netsnmp_transport *t, int local)
 {
     if (NULL == t) {
         return NULL;
@@ -146,6 +146,18 @@ netsnmp_udp_transport_base(netsnmp_transport *t)
     t->f_fmtaddr  = netsnmp_udp_fmtaddr;
     t->f_get_taddr = netsnmp_ipv4_get_taddr;
 
+    /*
+     * servers drain and answer their socket in batches
+     */
+    if (local) {
+#ifdef HAVE_RECVMMSG
+        t->f_recvm = netsnmp_udpbase_recvm;
+#endif
+#ifdef HAVE_SENDMMSG
+        t->f_sendm = netsnmp_udpbase_sendm;
+#endif
+    }
+
     return t;
 }
 
@@ -161,7 +173,7 @@ netsnmp_udp_transport(const struct netsnmp_ep *ep, int local)
 
     t = netsnmp_udpipv4base_transport(ep, local);
     if (NULL != t) {
-        netsnmp_udp_transport_base(t);
+        netsnmp_udp_transport_base(t, local);
     }
     return t;
 }
@@ -181,7 +193,7 @@ netsnmp_udp_transport_with_source(const struct netsnmp_ep *ep, int local,
 
     t = netsnmp_udpipv4base_transport_with_source(ep, local, src_addr);
     if (NULL != t) {
-        netsnmp_udp_transport_base(t);
+        netsnmp_udp_transport_base(t, local);
     }
     return t;
 }
@@ -619,7 +631,7 @@ netsnmp_udp_create_tspec(netsnmp_tdomain_spec *tspec)
 {
     netsnmp_transport *t = netsnmp_udpipv4base_tspec_transport(tspec);
     if (NULL != t) {
-        netsnmp_udp_transport_base(t);
+        netsnmp_udp_transport_base(t, tspec->flags & NETSNMP_TSPEC_LOCAL);
     }
     return t;
 
@@ -58,6 +58,7 @@
 #include <net-snmp/config_api.h>
 
 #include <net-snmp/library/snmp_impl.h>
+#include <net-snmp/library/snmpUDPBaseDomain.h>
 #include <net-snmp/library/snmp_transport.h>
 #include <net-snmp/library/snmpSocketBaseDomain.h>
 #include <net-snmp/library/tools.h>
@@ -172,6 +173,122 @@ netsnmp_udp6_send(netsnmp_transport *t, const void *buf, int size,
     return rc;
 }
 
+#ifdef HAVE_RECVMMSG
+/*
+ * Batched counterpart of netsnmp_udp6_recv()
+ */
+static int
+netsnmp_udp6_recvm(netsnmp_transport *t, netsnmp_transport_msg *msgs,
+                   int count)
+{
+    struct mmsghdr  mm[NETSNMP_UDPBASE_BATCH_MAX];
+    struct iovec    iov[NETSNMP_UDPBASE_BATCH_MAX];
+    struct sockaddr_in6 from[NETSNMP_UDPBASE_BATCH_MAX];
+    int             i, rc;
+
+    if (NULL == t || t->sock < 0)
+        return -1;
+    if (count > NETSNMP_UDPBASE_BATCH_MAX)
+        count = NETSNMP_UDPBASE_BATCH_MAX;
+
+    memset(mm, 0, count * sizeof(mm[0]));
+    memset(from, 0, count * sizeof(from[0]));
+    for (i = 0; i < count; i++) {
+        iov[i].iov_base = msgs[i].buf;
+        iov[i].iov_len = msgs[i].len;
+        mm[i].msg_hdr.msg_name = &from[i];
+        mm[i].msg_hdr.msg_namelen = sizeof(from[i]);
+        mm[i].msg_hdr.msg_iov = &iov[i];
+        mm[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    do {
+        rc = recvmmsg(t->sock, mm, count, MSG_DONTWAIT, NULL);
+    } while (rc < 0 && EINTR == errno);
+    if (rc < 0) {
+        DEBUGMSGTL(("netsnmp_udp6", "recvmmsg fd %d err %d (\"%s\")\n",
+                    t->sock, errno, strerror(errno)));
+        return -1;
+    }
+
+    for (i = 0; i < rc; i++) {
+        msgs[i].opaque = netsnmp_memdup(&from[i], sizeof(from[i]));
+        if (NULL == msgs[i].opaque)
+            break;              /* the rest of the batch is dropped */
+        msgs[i].olength = sizeof(struct sockaddr_in6);
+        msgs[i].len = mm[i].msg_len;
+    }
+    DEBUGMSGTL(("netsnmp_udp6", "recvmmsg fd %d got %d datagrams\n",
+                t->sock, i));
+    return i;
+}
+#endif /* HAVE_RECVMMSG */
+
+#ifdef HAVE_SENDMMSG
+/*
+ * Batched counterpart of netsnmp_udp6_send()
+ */
+static int
+netsnmp_udp6_sendm(netsnmp_transport *t, netsnmp_transport_msg *msgs,
+                   int count)
+{
+    struct mmsghdr  mm[NETSNMP_UDPBASE_BATCH_MAX];
+    struct iovec    iov[NETSNMP_UDPBASE_BATCH_MAX];
+    const struct sockaddr *to;
+    int             i, n, rc, done = 0, sent = 0;
+
+    if (NULL == t || t->sock < 0)
+        return 0;
+
+    while (done < count) {
+        n = SNMP_MIN(count - done, NETSNMP_UDPBASE_BATCH_MAX);
+        memset(mm, 0, n * sizeof(mm[0]));
+        for (i = 0; i < n; i++) {
+            netsnmp_transport_msg *m = &msgs[done + i];
+
+            if (m->opaque && m->olength == sizeof(struct sockaddr_in6))
+                to = (const struct sockaddr *) m->opaque;
+            else
+                break;
+            iov[i].iov_base = m->buf;
+            iov[i].iov_len = m->len;
+            mm[i].msg_hdr.msg_name = NETSNMP_REMOVE_CONST(void *, to);
+            mm[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in6);
+            mm[i].msg_hdr.msg_iov = &iov[i];
+            mm[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        rc = 0;
+        if (i > 0) {
+            do {
+                rc = sendmmsg(t->sock, mm, i, MSG_DONTWAIT);
+            } while (rc < 0 && EINTR == errno);
+            if (rc < 0) {
+                DEBUGMSGTL(("netsnmp_udp6", "sendmmsg fd %d err %d\n",
+                            t->sock, errno));
+                rc = 0;
+            }
+        }
+        sent += rc;
+        done += rc;
+
+        if (rc < n) {
+            /* msgs[done] was refused or has no address of its own */
+            void           *opaque = msgs[done].opaque;
+            int             olength = msgs[done].olength;
+
+            if (netsnmp_udp6_send(t, msgs[done].buf, msgs[done].len,
+                                  &opaque, &olength) >= 0)
+                sent++;
+            done++;
+        }
+    }
+    DEBUGMSGTL(("netsnmp_udp6", "sendmmsg fd %d sent %d of %d datagrams\n",
+                t->sock, sent, count));
+    return sent;
+}
+#endif /* HAVE_SENDMMSG */
+
 
 /*
  * Initialize a UDP/IPv6-based transport for SNMP.  Local is TRUE if addr is the
@@ -254,6 +371,14 @@ netsnmp_udp6_transport_init(const struct netsnmp_ep *ep, int flags)
     t->f_accept   = NULL;
     t->f_fmtaddr  = netsnmp_udp6_fmtaddr;
     t->f_get_taddr = netsnmp_ipv6_get_taddr;
+    if (local) {
+#ifdef HAVE_RECVMMSG
+        t->f_recvm = netsnmp_udp6_recvm;
+#endif
+#ifdef HAVE_SENDMMSG
+        t->f_sendm = netsnmp_udp6_sendm;
+#endif
+    }
 
     t->domain = netsnmp_UDPIPv6Domain;
     t->domain_length =
@@ -175,6 +175,8 @@ _transport_common(netsnmp_transport *t)
 
     t->f_recv          = _udpshared_recv;
     t->f_send          = _udpshared_send;
+    t->f_recvm         = NULL;
+    t->f_sendm         = NULL;
     t->f_close         = _udpshared_close;
     t->f_fmtaddr       = _udpshared_fmtaddr;
     t->f_setup_session = _setup_session;
@@ -0,0 +1,111 @@
+/*
+ * HEADER Testing the SCAPI keyed context cache
+ */
+
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-includes.h>
+#include <net-snmp/library/testing.h>
+
+#if defined(NETSNMP_USE_OPENSSL) && defined(HAVE_HMAC_CTX_NEW) && \
+    !defined(NETSNMP_FEATURE_REMOVE_STATISTICS)
+#define CHECK_STATS 1
+#endif
+
+int
+main(int argc, char **argv)
+{
+    u_char          buf[] = "wes hardaker";
+    u_char          sha1key[20] = "55555555555555555555";
+    u_char          sha1proper[12] = { 0x4a, 0x55, 0x2f, 0x65, 0x79, 0x3a,
+                                       0x49, 0x35, 0x37, 0x91, 0x51, 0x1d };
+    u_char          MAC[20];
+    size_t          MAC_LEN;
+    int             i, same;
+#ifdef CHECK_STATS
+    u_int           hits, misses;
+#endif
+#if defined(NETSNMP_USE_OPENSSL) && defined(HAVE_AES) && \
+    defined(NETSNMP_ENABLE_SCAPI_AUTHPRIV)
+    u_char          aeskey[16] = "0123456789abcdef";
+    u_char          iv1[16] = "iviviviviviviv01";
+    u_char          iv2[16] = "iviviviviviviv02";
+    u_char          pt[] = "the quick brown fox jumps over the lazy dog";
+    u_char          ct1[64], ct2[64], ct3[64], out[64];
+    size_t          ct1len, ct2len, ct3len, outlen;
+#endif
+
+    same = 0;
+    for (i = 0; i < 3; i++) {
+        MAC_LEN = sizeof(MAC);
+        memset(MAC, 0, sizeof(MAC));
+        if (sc_generate_keyed_hash(usmHMACSHA1AuthProtocol,
+                                   OID_LENGTH(usmHMACSHA1AuthProtocol),
+                                   sha1key, sizeof(sha1key),
+                                   buf, sizeof(buf) - 1,
+                                   MAC, &MAC_LEN) == SNMPERR_SUCCESS &&
+            memcmp(MAC, sha1proper, sizeof(sha1proper)) == 0)
+            same++;
+    }
+    OKF(same == 3, ("repeated keyed hashes are correct (%d of 3)", same));
+    OK(sc_check_keyed_hash(usmHMACSHA1AuthProtocol,
+                           OID_LENGTH(usmHMACSHA1AuthProtocol),
+                           sha1key, sizeof(sha1key),
+                           buf, sizeof(buf) - 1,
+                           sha1proper, sizeof(sha1proper)) == 0,
+       "cached keyed hash check succeeds");
+
+#ifdef CHECK_STATS
+    hits = snmp_get_statistic(STAT_SC_KEYCACHE_HITS);
+    misses = snmp_get_statistic(STAT_SC_KEYCACHE_MISSES);
+    OKF(hits == 3 && misses == 1,
+        ("one setup for four hashes (%u hits %u misses)", hits, misses));
+
+    sc_keycache_forget(sha1key, sizeof(sha1key));
+    MAC_LEN = sizeof(MAC);
+    sc_generate_keyed_hash(usmHMACSHA1AuthProtocol,
+                           OID_LENGTH(usmHMACSHA1AuthProtocol),
+                           sha1key, sizeof(sha1key),
+                           buf, sizeof(buf) - 1, MAC, &MAC_LEN);
+    OKF(snmp_get_statistic(STAT_SC_KEYCACHE_MISSES) == misses + 1,
+        ("a forgotten key is set up again"));
+#endif
+
+#if defined(NETSNMP_USE_OPENSSL) && defined(HAVE_AES) && \
+    defined(NETSNMP_ENABLE_SCAPI_AUTHPRIV)
+    ct1len = sizeof(ct1);
+    ct2len = sizeof(ct2);
+    ct3len = sizeof(ct3);
+    OK(sc_encrypt(usmAESPrivProtocol, USM_PRIV_PROTO_AES_LEN,
+                  aeskey, sizeof(aeskey), iv1, sizeof(iv1),
+                  pt, sizeof(pt), ct1, &ct1len) == SNMPERR_SUCCESS &&
+       sc_encrypt(usmAESPrivProtocol, USM_PRIV_PROTO_AES_LEN,
+                  aeskey, sizeof(aeskey), iv2, sizeof(iv2),
+                  pt, sizeof(pt), ct2, &ct2len) == SNMPERR_SUCCESS &&
+       sc_encrypt(usmAESPrivProtocol, USM_PRIV_PROTO_AES_LEN,
+                  aeskey, sizeof(aeskey), iv1, sizeof(iv1),
+                  pt, sizeof(pt), ct3, &ct3len) == SNMPERR_SUCCESS,
+       "AES encryption with a cached key succeeds");
+    OK(ct1len == sizeof(pt) && ct3len == ct1len &&
+       memcmp(ct1, ct3, ct1len) == 0 && memcmp(ct1, ct2, ct1len) != 0,
+       "every message starts from its own IV");
+
+    outlen = sizeof(out);
+    OK(sc_decrypt(usmAESPrivProtocol, USM_PRIV_PROTO_AES_LEN,
+                  aeskey, sizeof(aeskey), iv2, sizeof(iv2),
+                  ct2, ct2len, out, &outlen) == SNMPERR_SUCCESS &&
+       outlen == sizeof(pt) && memcmp(out, pt, outlen) == 0,
+       "AES decryption with a cached key round-trips");
+    outlen = sizeof(out);
+    OK(sc_decrypt(usmAESPrivProtocol, USM_PRIV_PROTO_AES_LEN,
+                  aeskey, sizeof(aeskey), iv1, sizeof(iv1),
+                  ct1, ct1len, out, &outlen) == SNMPERR_SUCCESS &&
+       outlen == sizeof(pt) && memcmp(out, pt, outlen) == 0,
+       "a second decryption with the same key round-trips");
+#endif
+
+    sc_keycache_clear();
+
+    if (__did_plan == 0)
+        PLAN(__test_counter);
+    return 0;
+}
@@ -0,0 +1,49 @@
+/* HEADER Testing indexed subtree lookups in the agent registry */
+
+static oid base[] = { 1, 3, 6, 1, 4, 1, 8072, 9999, 0, 0 };
+netsnmp_handler_registration *reg[64];
+netsnmp_subtree *first, *indexed, *linear;
+oid probe[12];
+size_t probe_len;
+int i, j, k, mismatches;
+
+init_snmp("snmp");
+
+for (i = 0; i < 64; i++) {
+    base[8] = 1 + i / 8;
+    base[9] = 1 + 3 * (i % 8);
+    reg[i] = netsnmp_create_handler_registration("subtree-index", NULL,
+                                                 base, OID_LENGTH(base),
+                                                 HANDLER_CAN_RONLY);
+    if (netsnmp_register_instance(reg[i]) != MIB_REGISTERED_OK)
+        break;
+}
+OKF(i == 64, ("Registered %d instances", i));
+
+for (k = 0; k < 2; k++) {
+    mismatches = 0;
+    first = netsnmp_subtree_find_first("");
+    for (i = 0; i < 12; i++) {
+        for (j = 0; j < 30; j++) {
+            memcpy(probe, base, 8 * sizeof(oid));
+            probe[8] = i;
+            probe[9] = j;
+            probe[10] = j % 3;
+            for (probe_len = 7; probe_len <= 11; probe_len++) {
+                indexed = netsnmp_subtree_find_prev(probe, probe_len, NULL, "");
+                linear = netsnmp_subtree_find_prev(probe, probe_len, first, "");
+                if (indexed != linear)
+                    mismatches++;
+            }
+        }
+    }
+    OKF(mismatches == 0, ("Pass %d: indexed and linear lookups agree"
+                          " (%d mismatches)", k, mismatches));
+
+    /* Remove every other registration so the index has to be rebuilt. */
+    if (k == 0)
+        for (i = 0; i < 64; i += 2)
+            netsnmp_unregister_handler(reg[i]);
+}
+
+snmp_shutdown("snmp");
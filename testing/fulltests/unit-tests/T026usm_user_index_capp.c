@@ -0,0 +1,133 @@
+/*
+ * HEADER Testing the USM user and engine time indexes
+ */
+
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-includes.h>
+#include <net-snmp/library/snmpusm.h>
+#include <net-snmp/library/lcd_time.h>
+#include <net-snmp/library/testing.h>
+
+#define NUSERS 600
+
+int
+main(int argc, char *argv[])
+{
+    struct usmUser *user, *prev;
+    u_char engineID[4][6] = {
+        { 0x80, 0, 0x1f, 0x88, 0x80, 1 },
+        { 0x80, 0, 0x1f, 0x88, 0x80, 2 },
+        { 0x80, 0, 0x1f, 0x88, 0x80, 3 },
+        { 0x80, 0, 0x1f, 0x88, 0x80, 4 },
+    };
+    u_char eid[8];
+    char name[32];
+    int i, j, count, missing, unordered, found;
+    u_int boots, etime;
+
+    /* add the users in a scrambled order */
+    for (i = 0; i < NUSERS; i++) {
+        j = (i * 7919) % NUSERS;
+        user = usm_create_user();
+        user->engineID = netsnmp_memdup(engineID[j % 4], 6);
+        user->engineIDLen = 6;
+        snprintf(name, sizeof(name), "user%d", j);
+        user->name = strdup(name);
+        user->secName = strdup(name);
+        usm_add_user(user);
+    }
+
+    missing = 0;
+    for (j = 0; j < NUSERS; j++) {
+        snprintf(name, sizeof(name), "user%d", j);
+        user = usm_get_user(engineID[j % 4], 6, name);
+        if (!user || strcmp(user->name, name) ||
+            memcmp(user->engineID, engineID[j % 4], 6))
+            missing++;
+    }
+    OKF(missing == 0, ("all %d users found (%d missing)", NUSERS, missing));
+    strcpy(name, "user0");
+    OK(usm_get_user(engineID[1], 6, name) == NULL,
+       "user0 is not found under another engineID");
+
+    /* the list must still be sorted for the usmUserTable */
+    count = unordered = 0;
+    for (prev = NULL, user = usm_get_userList(); user; user = user->next) {
+        if (prev && (memcmp(prev->engineID, user->engineID, 6) > 0 ||
+                     (!memcmp(prev->engineID, user->engineID, 6) &&
+                      (strlen(prev->name) > strlen(user->name) ||
+                       (strlen(prev->name) == strlen(user->name) &&
+                        strcmp(prev->name, user->name) >= 0)))))
+            unordered++;
+        prev = user;
+        count++;
+    }
+    OKF(count == NUSERS && unordered == 0,
+        ("user list holds %d users, %d out of order", count, unordered));
+
+    /* replacing a user must leave just the new entry reachable */
+    user = usm_create_user();
+    user->engineID = netsnmp_memdup(engineID[2], 6);
+    user->engineIDLen = 6;
+    user->name = strdup("user2");
+    user->secName = strdup("replaced");
+    usm_add_user(user);
+    strcpy(name, "user2");
+    user = usm_get_user(engineID[2], 6, name);
+    OK(user && !strcmp(user->secName, "replaced"), "replaced user is found");
+
+    /* remove every third user */
+    for (j = 0; j < NUSERS; j += 3) {
+        snprintf(name, sizeof(name), "user%d", j);
+        user = usm_get_user(engineID[j % 4], 6, name);
+        if (user) {
+            usm_remove_user(user);
+            user->next = user->prev = NULL;
+            usm_free_user(user);
+        }
+    }
+    missing = found = 0;
+    for (j = 0; j < NUSERS; j++) {
+        snprintf(name, sizeof(name), "user%d", j);
+        user = usm_get_user(engineID[j % 4], 6, name);
+        if (j % 3 == 0 && user)
+            found++;
+        else if (j % 3 != 0 && !user)
+            missing++;
+    }
+    OKF(found == 0 && missing == 0,
+        ("after removal: %d removed users found, %d kept users missing",
+         found, missing));
+
+    /* engine times for many engines, then forget one of them */
+    for (i = 0; i < 1000; i++) {
+        memcpy(eid, engineID[0], 6);
+        eid[6] = i >> 8;
+        eid[7] = i & 0xff;
+        set_enginetime(eid, 8, i, i * 2, 1);
+    }
+    missing = 0;
+    for (i = 0; i < 1000; i++) {
+        memcpy(eid, engineID[0], 6);
+        eid[6] = i >> 8;
+        eid[7] = i & 0xff;
+        if (get_enginetime(eid, 8, &boots, &etime, 0) != SNMPERR_SUCCESS ||
+            boots != (u_int) i)
+            missing++;
+    }
+    OKF(missing == 0, ("all 1000 engine times found (%d missing)", missing));
+
+    eid[6] = 0;
+    eid[7] = 7;
+    free_enginetime(eid, 8);
+    OK(search_enginetime_list(eid, 8) == NULL, "freed engine time is gone");
+    eid[7] = 8;
+    OK(search_enginetime_list(eid, 8) != NULL, "other engine times are kept");
+
+    free_etimelist();
+
+    if (__did_plan == 0) {
+        PLAN(__test_counter);
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+/* HEADER Printing the same OIDs repeatedly */
+
+static oid ifDescr7[] = { 1, 3, 6, 1, 2, 1, 2, 2, 1, 2, 7 };
+static oid ifType8[] = { 1, 3, 6, 1, 2, 1, 2, 2, 1, 3, 8 };
+static oid vacmGroupName[] = {
+    1, 3, 6, 1, 6, 3, 16, 1, 2, 1, 3, 3, 6, 112, 117, 98, 108, 105, 99
+};
+struct repeat_data { int format; int extended; oid *oid; int len; const char *str; };
+static const struct repeat_data repeat_array[] = {
+    { NETSNMP_OID_OUTPUT_MODULE, 0, ifDescr7, OID_LENGTH(ifDescr7),
+      "IF-MIB::ifDescr.7" },
+    { NETSNMP_OID_OUTPUT_MODULE, 0, ifType8, OID_LENGTH(ifType8),
+      "IF-MIB::ifType.8" },
+    { NETSNMP_OID_OUTPUT_MODULE, 0, vacmGroupName, OID_LENGTH(vacmGroupName),
+      "SNMP-VIEW-BASED-ACM-MIB::vacmGroupName.3.\"public\"" },
+    { NETSNMP_OID_OUTPUT_MODULE, 1, vacmGroupName, OID_LENGTH(vacmGroupName),
+      "SNMP-VIEW-BASED-ACM-MIB::vacmGroupName[3][STRING: public]" },
+    { NETSNMP_OID_OUTPUT_SUFFIX, 0, ifDescr7, OID_LENGTH(ifDescr7),
+      "ifDescr.7" },
+    { NETSNMP_OID_OUTPUT_NUMERIC, 0, ifDescr7, OID_LENGTH(ifDescr7),
+      ".1.3.6.1.2.1.2.2.1.2.7" },
+    { NETSNMP_OID_OUTPUT_FULL, 0, ifType8, OID_LENGTH(ifType8),
+      ".iso.org.dod.internet.mgmt.mib-2.interfaces.ifTable.ifEntry.ifType.8" },
+};
+char *buf;
+size_t buf_len, out_len;
+int buf_overflow, i, pass;
+char mibdir[PATH_MAX];
+
+snprintf(mibdir, sizeof(mibdir), "%s/%s", ABS_SRCDIR, "mibs");
+netsnmp_ds_set_string(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_MIBDIRS, mibdir);
+
+init_snmp("T027");
+
+/* the second pass is printed from what the first one looked up */
+for (pass = 0; pass < 2; pass++) {
+    for (i = 0; i < sizeof(repeat_array) / sizeof(repeat_array[0]); i++) {
+        netsnmp_ds_set_int(NETSNMP_DS_LIBRARY_ID,
+                           NETSNMP_DS_LIB_OID_OUTPUT_FORMAT,
+                           repeat_array[i].format);
+        netsnmp_ds_set_boolean(NETSNMP_DS_LIBRARY_ID,
+                               NETSNMP_DS_LIB_EXTENDED_INDEX,
+                               repeat_array[i].extended);
+        buf = NULL;
+        buf_len = out_len = buf_overflow = 0;
+        netsnmp_sprint_realloc_objid_tree((u_char **) &buf, &buf_len,
+                                          &out_len, 1, &buf_overflow,
+                                          repeat_array[i].oid,
+                                          repeat_array[i].len);
+        OKF(buf && strcmp(repeat_array[i].str, buf) == 0,
+            ("pass %d: expected %s but got %s", pass, repeat_array[i].str,
+             buf ? buf : "(NULL)"));
+        free(buf);
+    }
+}
+
+/* a name must not outlive the module it came from */
+netsnmp_ds_set_int(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_OID_OUTPUT_FORMAT,
+                   NETSNMP_OID_OUTPUT_MODULE);
+netsnmp_ds_set_boolean(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_EXTENDED_INDEX, 0);
+for (pass = 0; pass < 3; pass++) {
+    if (pass == 1)
+        netsnmp_unload_module("IF-MIB");
+    if (pass == 2)
+        netsnmp_read_module("IF-MIB");
+    buf = NULL;
+    buf_len = out_len = buf_overflow = 0;
+    netsnmp_sprint_realloc_objid_tree((u_char **) &buf, &buf_len, &out_len,
+                                      1, &buf_overflow,
+                                      ifDescr7, OID_LENGTH(ifDescr7));
+    OKF(buf && (strcmp(buf, "IF-MIB::ifDescr.7") == 0) == (pass != 1),
+        ("%s: got %s",
+         pass == 0 ? "loaded" : pass == 1 ? "unloaded" : "reloaded",
+         buf ? buf : "(NULL)"));
+    free(buf);
+}
+
+snmp_shutdown("T027");
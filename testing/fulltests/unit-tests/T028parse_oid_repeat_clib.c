@@ -0,0 +1,68 @@
+/* HEADER Parsing the same names repeatedly */
+
+static oid ifDescr7[] = { 1, 3, 6, 1, 2, 1, 2, 2, 1, 2, 7 };
+static oid vacmGroupName[] = {
+    1, 3, 6, 1, 6, 3, 16, 1, 2, 1, 3, 3, 6, 112, 117, 98, 108, 105, 99
+};
+static oid sysDescr0[] = { 1, 3, 6, 1, 2, 1, 1, 1, 0 };
+struct repeat_data { const char *str; oid *oid; int len; };
+static const struct repeat_data repeat_array[] = {
+    { "IF-MIB::ifDescr.7", ifDescr7, OID_LENGTH(ifDescr7) },
+    { "ifDescr.7", ifDescr7, OID_LENGTH(ifDescr7) },
+    { "SNMP-VIEW-BASED-ACM-MIB::vacmGroupName.3.\"public\"",
+      vacmGroupName, OID_LENGTH(vacmGroupName) },
+    { "SNMPv2-MIB::sysDescr.0", sysDescr0, OID_LENGTH(sysDescr0) },
+};
+oid name[MAX_OID_LEN];
+size_t name_len;
+int i, pass;
+char mibdir[PATH_MAX];
+#ifndef NETSNMP_FEATURE_REMOVE_STATISTICS
+u_int hits, misses;
+#endif
+
+snprintf(mibdir, sizeof(mibdir), "%s/%s", ABS_SRCDIR, "mibs");
+netsnmp_ds_set_string(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_MIBDIRS, mibdir);
+
+init_snmp("T028");
+
+/* the second pass is served from what the first one looked up */
+for (pass = 0; pass < 2; pass++) {
+#ifndef NETSNMP_FEATURE_REMOVE_STATISTICS
+    hits = snmp_get_statistic(STAT_MIB_NAMECACHE_HITS);
+    misses = snmp_get_statistic(STAT_MIB_NAMECACHE_MISSES);
+#endif
+    for (i = 0; i < sizeof(repeat_array) / sizeof(repeat_array[0]); i++) {
+        name_len = MAX_OID_LEN;
+        OKF(snmp_parse_oid(repeat_array[i].str, name, &name_len) &&
+            snmp_oid_compare(name, name_len, repeat_array[i].oid,
+                             repeat_array[i].len) == 0,
+            ("pass %d: %s", pass, repeat_array[i].str));
+    }
+#ifndef NETSNMP_FEATURE_REMOVE_STATISTICS
+    hits = snmp_get_statistic(STAT_MIB_NAMECACHE_HITS) - hits;
+    misses = snmp_get_statistic(STAT_MIB_NAMECACHE_MISSES) - misses;
+    OKF(pass == 0 ? misses == 4 : hits == 4 && misses == 0,
+        ("pass %d: %u hits %u misses", pass, hits, misses));
+#endif
+}
+
+/* an OID too long for the caller's buffer is not copied from the cache */
+name_len = 5;
+OK(snmp_parse_oid("IF-MIB::ifDescr.7", name, &name_len) == NULL,
+   "a short buffer is rejected");
+
+/* a name must not outlive the module it came from */
+for (pass = 0; pass < 3; pass++) {
+    if (pass == 1)
+        netsnmp_unload_module("IF-MIB");
+    if (pass == 2)
+        netsnmp_read_module("IF-MIB");
+    name_len = MAX_OID_LEN;
+    OKF((get_node("ifDescr.7", name, &name_len) &&
+         snmp_oid_compare(name, name_len, ifDescr7,
+                          OID_LENGTH(ifDescr7)) == 0) == (pass != 1),
+        ("%s", pass == 0 ? "loaded" : pass == 1 ? "unloaded" : "reloaded"));
+}
+
+snmp_shutdown("T028");
@@ -0,0 +1,67 @@
+/* HEADER Testing the agent statistics segment */
+
+netsnmp_stats_segment seg;
+struct timeval start;
+char path[256];
+FILE *fp;
+size_t len;
+int i, ok;
+
+sprintf(path, "/tmp/snmp-stats-segment-unit-test-%ld", (long)getpid());
+
+OK(netsnmp_stats_segment_open(path) == 0 && netsnmp_stats_segment_get(),
+   "the segment is mapped");
+
+netsnmp_get_monotonic_clock(&start);
+netsnmp_stats_segment_pdu(SNMP_MSG_GET, &start);
+netsnmp_stats_segment_pdu(SNMP_MSG_GET, &start);
+netsnmp_stats_segment_pdu(SNMP_MSG_GETBULK, &start);
+netsnmp_stats_segment_pdu(SNMP_MSG_INTERNAL_SET_BEGIN, &start);
+for (i = 0; i < 3; i++)
+    netsnmp_stats_segment_handler("ifTable", 10);
+netsnmp_stats_segment_handler("a handler name much longer than a slot can hold",
+                              10);
+netsnmp_stats_segment_handler("a handler name much longer than a slot can hold",
+                              10);
+netsnmp_stats_segment_handler(NULL, 10);
+netsnmp_stats_segment_cache_load(50, 1);
+netsnmp_stats_segment_cache_load(20000, 0);
+netsnmp_stats_segment_queue(&netsnmp_stats_segment_get()->delegated, 4);
+netsnmp_stats_segment_queue(&netsnmp_stats_segment_get()->delegated, 1);
+
+/* read it back the way another process would */
+memset(&seg, 0, sizeof(seg));
+fp = fopen(path, "r");
+len = fp ? fread(&seg, 1, sizeof(seg), fp) : 0;
+if (fp)
+    fclose(fp);
+OKF(len == sizeof(seg) && seg.magic == NETSNMP_STATS_SEGMENT_MAGIC &&
+    seg.version == NETSNMP_STATS_SEGMENT_VERSION && seg.size == sizeof(seg) &&
+    seg.pid == (long)getpid(), ("header (%d bytes)", (int)len));
+OK(seg.pdus[0].count == 2 && seg.pdus[SNMP_MSG_GETBULK - SNMP_MSG_GET].count == 1 &&
+   seg.pdus[NETSNMP_STATS_PDU_OTHER].count == 1, "PDUs counted by type");
+for (ok = 0, i = 0; i < NETSNMP_STATS_HANDLERS; i++) {
+    if (strcmp(seg.handlers[i].name, "ifTable") == 0)
+        ok += seg.handlers[i].time.count == 3;
+    else if (strncmp(seg.handlers[i].name, "a handler name",
+                     strlen("a handler name")) == 0)
+        ok += seg.handlers[i].time.count == 2 &&
+              strlen(seg.handlers[i].name) == NETSNMP_STATS_NAME_LEN - 1;
+}
+OKF(ok == 2 && seg.handler_overflow == 1,
+    ("handlers timed by name (%d, %lu without a slot)", ok,
+     seg.handler_overflow));
+OK(seg.cache_loads.count == 2 && seg.cache_load_failures == 1 &&
+   seg.cache_loads.buckets[0] == 1 && seg.cache_loads.buckets[3] == 1 &&
+   seg.cache_loads.max_usec == 20000, "cache loads");
+OK(seg.delegated.depth == 1 && seg.delegated.max_depth == 4,
+   "queue depth and high-water mark");
+
+netsnmp_stats_segment_close();
+fp = fopen(path, "r");
+len = fp ? fread(&seg, 1, sizeof(seg), fp) : 0;
+if (fp)
+    fclose(fp);
+OK(len == sizeof(seg) && seg.pid == 0 && netsnmp_stats_segment_get() == NULL,
+   "a closed segment keeps its counts and clears the pid");
+unlink(path);
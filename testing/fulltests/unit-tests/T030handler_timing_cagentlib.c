@@ -0,0 +1,54 @@
+/* HEADER Testing handler timing */
+
+static oid timed_oid[] = { 1, 3, 6, 1, 4, 1, 8072, 9999, 1 };
+netsnmp_handler_registration *reginfo;
+netsnmp_agent_request_info reqinfo;
+netsnmp_request_info request;
+netsnmp_variable_list var;
+netsnmp_handler_timing timing;
+int i;
+
+reginfo = netsnmp_create_handler_registration("timed", netsnmp_null_handler,
+                                              timed_oid,
+                                              OID_LENGTH(timed_oid),
+                                              HANDLER_CAN_RONLY);
+memset(&reqinfo, 0, sizeof(reqinfo));
+memset(&request, 0, sizeof(request));
+memset(&var, 0, sizeof(var));
+var.name = timed_oid;
+var.name_length = OID_LENGTH(timed_oid);
+request.requestvb = &var;
+reqinfo.mode = MODE_GETNEXT;
+
+netsnmp_call_handlers(reginfo, &reqinfo, &request);
+OK(reginfo->timing == NULL, "calls are not timed by default");
+
+netsnmp_ds_set_boolean(NETSNMP_DS_APPLICATION_ID,
+                       NETSNMP_DS_AGENT_HANDLER_TIMING, 1);
+for (i = 0; i < 3; i++)
+    netsnmp_call_handlers(reginfo, &reqinfo, &request);
+OKF(reginfo->timing && reginfo->timing->calls == 3,
+    ("calls are timed when enabled (%lu)",
+     reginfo->timing ? reginfo->timing->calls : 0));
+netsnmp_ds_set_boolean(NETSNMP_DS_APPLICATION_ID,
+                       NETSNMP_DS_AGENT_HANDLER_TIMING, 0);
+netsnmp_handler_registration_free(reginfo);
+
+/*
+ * 99 calls of 5us, which have a bucket of their own, and one of 1000us,
+ * which falls into the bucket for 960..1023us
+ */
+memset(&timing, 0, sizeof(timing));
+OK(netsnmp_handler_timing_percentile(&timing, 50) == 0, "no calls");
+timing.calls = 100;
+timing.total_usec = 99 * 5 + 1000;
+timing.max_usec = 1000;
+timing.buckets[5] = 99;
+timing.buckets[NETSNMP_HANDLER_TIMING_SUB * 7 + 7] = 1;
+OK(netsnmp_handler_timing_percentile(&timing, 50) == 5, "median");
+OK(netsnmp_handler_timing_percentile(&timing, 99) == 5, "99th percentile");
+OK(netsnmp_handler_timing_percentile(&timing, 100) == 1000,
+   "the top percentile is no more than the longest call");
+timing.max_usec = 2000;
+OK(netsnmp_handler_timing_percentile(&timing, 100) == 1023,
+   "otherwise it is the upper bound of its bucket");